@@ -231,6 +231,48 @@ static inline block_t *block_Duplicate( const block_t *p_block )
     return p_dup;
 }
 
+/**
+ * Shares a block.
+ *
+ * Creates a number of references to the payload of a block, without copying
+ * it. Each reference carries its own copy of the block properties and payload
+ * bounds, and must be released with block_Release() independently of the
+ * others. The payload is released along with the last reference.
+ *
+ * The payload of a shared block is read-only. block_Realloc() and
+ * block_TryRealloc() transparently copy it if the payload is expanded.
+ * Code modifying a payload in place must call block_MakeWritable() first.
+ *
+ * @param block block to share (must not be chained) [IN]
+ * @param refs table of the references to create [OUT]
+ * @param count number of references to create (at least one)
+ *
+ * @retval VLC_SUCCESS on success; the block is then consumed.
+ * @retval VLC_ENOMEM on memory error; the block is then left untouched.
+ */
+VLC_API int block_Share(block_t *block, block_t **refs, unsigned count)
+VLC_USED;
+
+/**
+ * Checks whether the payload of a block can be modified in place.
+ *
+ * @return false if the payload is shared with other blocks (see
+ * block_Share()), true otherwise.
+ */
+VLC_API bool block_IsWritable(const block_t *block) VLC_USED;
+
+/**
+ * Makes the payload of a block writable.
+ *
+ * If the payload is shared with other blocks, it is copied to a new block
+ * with the same properties, and the input block is released. Otherwise, the
+ * input block is returned as is.
+ *
+ * @return a block with a writable payload, or NULL on memory error (the
+ * input block is released in that case).
+ */
+VLC_API block_t *block_MakeWritable(block_t *block) VLC_USED;
+
 /**
  * Wraps heap in a block.
  *
@@ -135,12 +135,33 @@ typedef struct httpd_redirect_t httpd_redirect_t;
 VLC_API httpd_redirect_t * httpd_RedirectNew( httpd_host_t *, const char *psz_url_dst, const char *psz_url_src ) VLC_USED;
 VLC_API void httpd_RedirectDelete( httpd_redirect_t * );
 
+typedef struct httpd_block_t httpd_block_t;
+/**
+ * Serves an immutable block of data at the given URL.
+ *
+ * The data is sent from the block to the clients, without copying it.
+ *
+ * \param p_block data to serve, a single block (ownership is transferred,
+ *                even on error)
+ */
+VLC_API httpd_block_t * httpd_BlockNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const httpd_header *, size_t, block_t *p_block ) VLC_USED;
+VLC_API void httpd_BlockDelete( httpd_block_t * );
+
 
 typedef struct httpd_stream_t httpd_stream_t;
 VLC_API httpd_stream_t * httpd_StreamNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password ) VLC_USED;
 VLC_API void httpd_StreamDelete( httpd_stream_t * );
 VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
 VLC_API int httpd_StreamSend( httpd_stream_t *, const block_t *p_block );
+/**
+ * Sends a block to the stream clients, without copying it.
+ *
+ * The block is shared by all clients, and released once it has been sent
+ * to all of them, or dropped from the stream buffer.
+ *
+ * \param p_block block to send (ownership is transferred)
+ */
+VLC_API int httpd_StreamSendBlock( httpd_stream_t *, block_t *p_block );
 VLC_API int httpd_StreamSetHTTPHeaders(httpd_stream_t *, const httpd_header *, size_t);
 
 /* Msg functions facilities */
@@ -521,10 +521,15 @@ struct input_stats_t
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    int64_t i_judder_pictures; /* not presented on their refresh */
 
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Clock */
+    int64_t i_pts_delay; /* current caching, as a vlc_tick_t */
+    int64_t i_clock_underruns; /* late clock references */
 };
 
 /**
@@ -68,6 +68,23 @@ VLC_API picture_pool_t * picture_pool_New(unsigned count,
 VLC_API picture_pool_t * picture_pool_NewFromFormat(const video_format_t *fmt,
                                                     unsigned count) VLC_USED;
 
+/**
+ * Allocates pictures from the heap and creates a picture pool that grows on
+ * demand.
+ * This works like picture_pool_NewFromFormat(), except that more pictures are
+ * allocated when all are in use: immediately by picture_pool_Get(), and by
+ * picture_pool_WaitOrGrow() if the caller is starved.
+ * This avoids stalling consumers that hold more pictures than expected, such
+ * as decoders with deep reordering.
+ * @param fmt video format of pictures to allocate from the heap
+ * @param count number of pictures to allocate initially
+ * @param max maximum number of pictures (capped to an internal limit)
+ * @return a pointer to the new pool on success, NULL on error
+ */
+VLC_API picture_pool_t *picture_pool_NewGrowable(const video_format_t *fmt,
+                                                 unsigned count,
+                                                 unsigned max) VLC_USED;
+
 /**
  * Releases a pool created by picture_pool_New()
  * or picture_pool_NewFromFormat().
@@ -104,6 +121,24 @@ VLC_API picture_t * picture_pool_Get( picture_pool_t * ) VLC_USED;
  */
 VLC_API picture_t *picture_pool_Wait(picture_pool_t *) VLC_USED;
 
+/**
+ * Obtains a picture from a growable pool, growing it if the caller is starved.
+ *
+ * This works like picture_pool_Wait(), except that while all pictures are in
+ * use, the starved callback is checked, once per wake-up and periodically.
+ * If it returns true, no picture can come back without one more, and the pool
+ * grows, up to its maximum.
+ *
+ * @param starved callback telling whether the caller is starved
+ * @param opaque data for the callback
+ * @return a picture or NULL on memory error
+ *
+ * @note This function is thread-safe.
+ */
+VLC_API picture_t *picture_pool_WaitOrGrow(picture_pool_t *,
+                                           bool (*starved)(void *),
+                                           void *opaque) VLC_USED;
+
 /**
  * Cancel the picture pool.
  *
@@ -132,6 +167,7 @@ VLC_USED;
 
 /**
  * @return the total number of pictures in the given pool
+ * (which may increase over time for growable pools)
  * @note This function is thread-safe.
  */
 VLC_API unsigned picture_pool_GetSize(const picture_pool_t *);
@@ -120,6 +120,12 @@ struct vlc_tls_operations
      * if there is one. See also \ref vlc_tls_SessionDelete().
      */
     void (*close)(struct vlc_tls *);
+
+    /** Callback for checking session resumption (optional).
+     *
+     * See \ref vlc_tls_SessionIsResumed().
+     */
+    bool (*is_resumed)(struct vlc_tls *);
 };
 
 /**
@@ -382,6 +388,20 @@ static inline int vlc_tls_Shutdown(vlc_tls_t *tls, bool duplex)
     return tls->ops->shutdown(tls, duplex);
 }
 
+/**
+ * Checks whether a TLS session was resumed.
+ *
+ * This is only meaningful once the TLS handshake is complete.
+ *
+ * @retval true the handshake resumed a previous session
+ * @retval false the handshake was a full one, or the session is not a TLS
+ *               session
+ */
+static inline bool vlc_tls_SessionIsResumed(vlc_tls_t *tls)
+{
+    return tls->ops->is_resumed != NULL && tls->ops->is_resumed(tls);
+}
+
 /**
  * Closes a connection and its underlying resources.
  *
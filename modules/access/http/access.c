@@ -32,6 +32,8 @@
 
 #include <vlc_common.h>
 #include <vlc_access.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
 #include <vlc_keystore.h>
 #include <vlc_plugin.h>
 #include <vlc_url.h>
@@ -40,11 +42,17 @@
 #include "resource.h"
 #include "file.h"
 #include "live.h"
+#include "ranges.h"
+#include "cache.h"
 
 typedef struct
 {
     struct vlc_http_mgr *manager;
     struct vlc_http_resource *resource;
+    struct vlc_http_ranges *ranges;
+    struct vlc_http_cache *cache;
+    uint64_t size;
+    char *type;
 } access_sys_t;
 
 static block_t *FileRead(stream_t *access, bool *restrict eof)
@@ -113,6 +121,72 @@ static int FileControl(stream_t *access, int query, va_list args)
     return VLC_SUCCESS;
 }
 
+static block_t *RangesRead(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    block_t *b = vlc_http_ranges_read(sys->ranges);
+    if (b == NULL)
+        *eof = true;
+    return b;
+}
+
+static int RangesSeek(stream_t *access, uint64_t pos)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (vlc_http_ranges_seek(sys->ranges, pos))
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+static int RangesControl(stream_t *access, int query, va_list args)
+{
+    access_sys_t *sys = access->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg(args, bool *) = true;
+            break;
+
+        case STREAM_CAN_FASTSEEK:
+            *va_arg(args, bool *) = false;
+            break;
+
+        case STREAM_GET_SIZE:
+            *va_arg(args, uint64_t *) = sys->size;
+            break;
+
+        case STREAM_GET_PTS_DELAY:
+            *va_arg(args, vlc_tick_t *) = VLC_TICK_FROM_MS(
+                var_InheritInteger(access, "network-caching") );
+            break;
+
+        case STREAM_GET_CONTENT_TYPE:
+        {
+            char *type = NULL;
+            if (sys->type != NULL)
+            {
+                type = strdup(sys->type);
+                if (unlikely(type == NULL))
+                    return VLC_ENOMEM;
+            }
+            *va_arg(args, char **) = type;
+            break;
+        }
+
+        case STREAM_SET_PAUSE_STATE:
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 static block_t *LiveRead(stream_t *access, bool *restrict eof)
 {
     access_sys_t *sys = access->p_sys;
@@ -162,6 +236,9 @@ static int Open(vlc_object_t *obj)
 
     sys->manager = NULL;
     sys->resource = NULL;
+    sys->ranges = NULL;
+    sys->cache = NULL;
+    sys->type = NULL;
 
     void *jar = NULL;
     if (var_InheritBool(obj, "http-forward-cookies"))
@@ -194,6 +271,27 @@ static int Open(vlc_object_t *obj)
         vlc_http_res_set_login(sys->resource,
                                crd.psz_username, crd.psz_password);
 
+    if (!live && var_InheritBool(obj, "http-cache"))
+    {
+        char *cachedir = config_GetUserDir(VLC_CACHE_DIR);
+        char *dir;
+
+        if (cachedir != NULL
+         && asprintf(&dir, "%s" DIR_SEP "http", cachedir) != -1)
+        {
+            uintmax_t max = var_InheritInteger(obj, "http-cache-size");
+
+            sys->cache = vlc_http_cache_open(dir, access->psz_url, max << 20);
+            free(dir);
+        }
+        free(cachedir);
+
+        if (sys->cache != NULL)
+            vlc_http_file_set_cache(sys->resource, sys->cache);
+        else
+            msg_Warn(access, "cannot open HTTP cache");
+    }
+
     ret = VLC_EGENERIC;
 
     int status = vlc_http_res_get_status(sys->resource);
@@ -242,6 +340,28 @@ static int Open(vlc_object_t *obj)
     vlc_credential_clean(&crd);
     vlc_UrlClean(&crd_url);
 
+    if (!live)
+    {
+        unsigned parallel = var_InheritInteger(obj, "http-parallel-ranges");
+        uintmax_t size = vlc_http_file_get_size(sys->resource);
+
+        /* The disk cache and parallel ranges are mutually exclusive. */
+        if (sys->cache == NULL && parallel > 1 && size < UINT64_MAX
+         && vlc_http_file_can_seek(sys->resource))
+            sys->ranges = vlc_http_ranges_create(obj, jar, sys->resource,
+                                                 size, parallel);
+        if (sys->ranges != NULL)
+        {
+            sys->size = size;
+            sys->type = vlc_http_file_get_type(sys->resource);
+            /* The initial response is not used to read data. */
+            vlc_http_res_destroy(sys->resource);
+            sys->resource = NULL;
+            vlc_http_mgr_destroy(sys->manager);
+            sys->manager = NULL;
+        }
+    }
+
     access->pf_read = NULL;
     if (live)
     {
@@ -249,6 +369,12 @@ static int Open(vlc_object_t *obj)
         access->pf_seek = NULL;
         access->pf_control = LiveControl;
     }
+    else if (sys->ranges != NULL)
+    {
+        access->pf_block = RangesRead;
+        access->pf_seek = RangesSeek;
+        access->pf_control = RangesControl;
+    }
     else
     {
         access->pf_block = FileRead;
@@ -261,6 +387,8 @@ static int Open(vlc_object_t *obj)
 error:
     if (sys->resource != NULL)
         vlc_http_res_destroy(sys->resource);
+    if (sys->cache != NULL)
+        vlc_http_cache_close(sys->cache);
     if (sys->manager != NULL)
         vlc_http_mgr_destroy(sys->manager);
     free(psz_realm);
@@ -275,8 +403,15 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
-    vlc_http_res_destroy(sys->resource);
-    vlc_http_mgr_destroy(sys->manager);
+    if (sys->ranges != NULL)
+        vlc_http_ranges_destroy(sys->ranges);
+    if (sys->resource != NULL)
+        vlc_http_res_destroy(sys->resource);
+    if (sys->cache != NULL)
+        vlc_http_cache_close(sys->cache);
+    if (sys->manager != NULL)
+        vlc_http_mgr_destroy(sys->manager);
+    free(sys->type);
     free(sys);
 }
 
@@ -292,6 +427,23 @@ vlc_module_begin()
     add_bool("http-continuous", false, N_("Continuous stream"),
              N_("Keep reading a resource that keeps being updated."), true)
         change_volatile()
+    add_integer("http-parallel-ranges", 1, N_("Parallel range requests"),
+                 N_("Maximum number of concurrent byte range requests, each "
+                    "over its own connection, used to download seekable "
+                    "files. The actual number adapts to the measured "
+                    "throughput. This can improve throughput over links "
+                    "with high latency. 1 disables parallel requests."), true)
+        change_integer_range(1, 16)
+        change_safe()
+    add_bool("http-cache", false, N_("Disk cache"),
+             N_("Store downloaded files in the user cache directory, so that "
+                "already fetched parts are read locally when played or "
+                "seeked again. Cached files are revalidated with the server "
+                "as per their HTTP caching headers."), true)
+    add_integer("http-cache-size", 1024, N_("Disk cache size (MiB)"),
+                N_("Maximum total size of the HTTP disk cache. Least recently "
+                   "used files are evicted beyond this size."), true)
+        change_integer_range(1, 1 << 20)
     add_bool("http-forward-cookies", true, N_("Cookies forwarding"),
              N_("Forward cookies across HTTP redirections."), true)
     add_string("http-referrer", NULL, N_("Referrer"),
@@ -0,0 +1,762 @@
+/*****************************************************************************
+ * cache.c: HTTP persistent disk cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifdef HAVE_FLOCK
+# include <sys/file.h>
+#endif
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_rand.h>
+#include "message.h"
+#include "cache.h"
+
+#pragma GCC visibility push(default)
+
+#define VLC_HTTP_CACHE_MAGIC "VLC HTTP cache 2"
+#define VLC_HTTP_CACHE_BLOCK 65536
+#define VLC_HTTP_CACHE_HEURISTIC_MAX 86400 /* seconds */
+
+struct vlc_http_cache_range
+{
+    uintmax_t start;
+    uintmax_t end; /**< exclusive */
+};
+
+struct vlc_http_cache
+{
+    char *path; /**< data file path (metadata file path without suffix) */
+    char *key; /**< URL without user information */
+    int fd;
+
+    bool valid; /**< whether the entity is known and cacheable */
+    bool seekable;
+    char *etag;
+    char *type;
+    time_t mtime;
+    time_t expires;
+    uintmax_t size;
+
+    size_t count;
+    struct vlc_http_cache_range *ranges; /**< sorted disjoint stored ranges */
+};
+
+/**
+ * Strips the user information from a URL, so that credentials are neither
+ * part of the cache key nor written to the disk.
+ */
+static char *vlc_http_cache_key(const char *url)
+{
+    const char *auth = strstr(url, "://");
+    if (auth == NULL)
+        return strdup(url);
+    auth += 3;
+
+    const char *host = auth;
+    for (size_t len = strcspn(auth, "/?#"); len > 0; len--)
+        if (auth[len - 1] == '@')
+        {
+            host = auth + len;
+            break;
+        }
+
+    char *key;
+    if (unlikely(asprintf(&key, "%.*s%s", (int)(auth - url), url,
+                          host) == -1))
+        key = NULL;
+    return key;
+}
+
+static char *vlc_http_cache_digest(const char *salt, const char *key)
+{
+    struct md5_s md5;
+
+    InitMD5(&md5);
+    AddMD5(&md5, salt, strlen(salt));
+    AddMD5(&md5, key, strlen(key));
+    EndMD5(&md5);
+    return psz_md5_hash(&md5);
+}
+
+/**
+ * Locks an entry data file, so that an entry is used, written back or
+ * evicted by only one process at a time. The lock is released on close.
+ */
+static int vlc_http_cache_lock(int fd)
+{
+#ifdef HAVE_FLOCK
+    return flock(fd, LOCK_EX | LOCK_NB);
+#else
+    (void) fd;
+    return 0;
+#endif
+}
+
+static char *vlc_http_cache_meta_path(const char *path)
+{
+    char *meta;
+
+    if (unlikely(asprintf(&meta, "%s.meta", path) == -1))
+        meta = NULL;
+    return meta;
+}
+
+static void vlc_http_cache_clear(struct vlc_http_cache *c)
+{
+    free(c->etag);
+    free(c->type);
+    free(c->ranges);
+    c->valid = false;
+    c->seekable = false;
+    c->etag = NULL;
+    c->type = NULL;
+    c->mtime = -1;
+    c->expires = 0;
+    c->size = -1;
+    c->count = 0;
+    c->ranges = NULL;
+
+    if (c->fd != -1 && ftruncate(c->fd, 0))
+    {   /* Cannot drop stale data: do not use the data file anymore. */
+        vlc_close(c->fd);
+        c->fd = -1;
+    }
+}
+
+static int vlc_http_cache_insert(struct vlc_http_cache *c,
+                                 uintmax_t start, uintmax_t end)
+{
+    size_t i = 0, j;
+
+    /* Find the first range that overlaps or touches the new one... */
+    while (i < c->count && c->ranges[i].end < start)
+        i++;
+    /* ...and merge all such ranges. */
+    for (j = i; j < c->count && c->ranges[j].start <= end; j++)
+    {
+        if (start > c->ranges[j].start)
+            start = c->ranges[j].start;
+        if (end < c->ranges[j].end)
+            end = c->ranges[j].end;
+    }
+
+    if (i == j)
+    {
+        struct vlc_http_cache_range *tab = realloc(c->ranges,
+                                           (c->count + 1) * sizeof (*tab));
+        if (unlikely(tab == NULL))
+            return -1;
+
+        memmove(tab + i + 1, tab + i, (c->count - i) * sizeof (*tab));
+        c->ranges = tab;
+        c->count++;
+    }
+    else
+    {
+        memmove(c->ranges + i + 1, c->ranges + j,
+                (c->count - j) * sizeof (*c->ranges));
+        c->count -= j - i - 1;
+    }
+
+    c->ranges[i].start = start;
+    c->ranges[i].end = end;
+    return 0;
+}
+
+static int vlc_http_cache_load(struct vlc_http_cache *c, const char *meta)
+{
+    FILE *stream = vlc_fopen(meta, "rt");
+    if (stream == NULL)
+        return -1;
+
+    char *line = NULL, *salt = NULL, *digest = NULL;
+    size_t len = 0;
+    ssize_t val;
+    bool magic = false;
+    int ret = -1;
+
+    while ((val = getline(&line, &len, stream)) != -1)
+    {
+        if (val > 0 && line[val - 1] == '\n')
+            line[val - 1] = '\0';
+
+        if (!magic)
+        {
+            if (strcmp(line, VLC_HTTP_CACHE_MAGIC))
+                goto out;
+            magic = true;
+            continue;
+        }
+
+        char *value = strchr(line, ' ');
+        if (value == NULL)
+            goto out;
+        *(value++) = '\0';
+
+        if (!strcmp(line, "salt"))
+        {
+            free(salt);
+            salt = strdup(value);
+        }
+        else if (!strcmp(line, "key"))
+        {
+            free(digest);
+            digest = strdup(value);
+        }
+        else if (!strcmp(line, "etag"))
+        {
+            free(c->etag);
+            c->etag = strdup(value);
+        }
+        else if (!strcmp(line, "type"))
+        {
+            free(c->type);
+            c->type = strdup(value);
+        }
+        else if (!strcmp(line, "mtime"))
+            c->mtime = strtoll(value, NULL, 10);
+        else if (!strcmp(line, "expires"))
+            c->expires = strtoll(value, NULL, 10);
+        else if (!strcmp(line, "size"))
+            c->size = strtoumax(value, NULL, 10);
+        else if (!strcmp(line, "seekable"))
+            c->seekable = atoi(value) != 0;
+        else if (!strcmp(line, "range"))
+        {
+            uintmax_t start, end;
+
+            if (sscanf(value, "%" SCNuMAX " %" SCNuMAX, &start, &end) != 2
+             || start >= end || end > c->size
+             || vlc_http_cache_insert(c, start, end))
+                goto out;
+        }
+    }
+
+    /* The salted digest of the key guards against collisions of the file
+     * name digest, without storing the URL. */
+    bool match = false;
+    if (salt != NULL && digest != NULL)
+    {
+        char *check = vlc_http_cache_digest(salt, c->key);
+
+        match = check != NULL && !strcmp(check, digest);
+        free(check);
+    }
+
+    if (match && c->size != (uintmax_t)-1
+     && (c->etag != NULL || c->mtime != -1))
+    {
+        c->valid = true;
+        ret = 0;
+    }
+out:
+    free(digest);
+    free(salt);
+    free(line);
+    fclose(stream);
+    return ret;
+}
+
+static int vlc_http_cache_save(const struct vlc_http_cache *c,
+                               const char *meta)
+{
+    uint8_t rnd[16];
+    char salt[2 * sizeof (rnd) + 1];
+
+    vlc_rand_bytes(rnd, sizeof (rnd));
+    for (size_t i = 0; i < sizeof (rnd); i++)
+        sprintf(salt + 2 * i, "%02"PRIx8, rnd[i]);
+
+    char *digest = vlc_http_cache_digest(salt, c->key);
+    if (unlikely(digest == NULL))
+        return -1;
+
+    /* The metadata is written to a private file with a unique name, then
+     * renamed over the old one, so that concurrent readers never see a
+     * partial file. */
+    char *tmp;
+
+    if (unlikely(asprintf(&tmp, "%s.XXXXXX", meta) == -1))
+    {
+        free(digest);
+        return -1;
+    }
+
+    int fd = vlc_mkstemp(tmp);
+    FILE *stream = (fd != -1) ? fdopen(fd, "wt") : NULL;
+    if (stream == NULL)
+    {
+        if (fd != -1)
+        {
+            vlc_close(fd);
+            vlc_unlink(tmp);
+        }
+        free(tmp);
+        free(digest);
+        return -1;
+    }
+
+    fprintf(stream, VLC_HTTP_CACHE_MAGIC "\n");
+    fprintf(stream, "salt %s\n", salt);
+    fprintf(stream, "key %s\n", digest);
+    free(digest);
+    if (c->etag != NULL)
+        fprintf(stream, "etag %s\n", c->etag);
+    if (c->type != NULL)
+        fprintf(stream, "type %s\n", c->type);
+    fprintf(stream, "mtime %lld\n", (long long)c->mtime);
+    fprintf(stream, "expires %lld\n", (long long)c->expires);
+    fprintf(stream, "size %" PRIuMAX "\n", c->size);
+    fprintf(stream, "seekable %d\n", c->seekable);
+    for (size_t i = 0; i < c->count; i++)
+        fprintf(stream, "range %" PRIuMAX " %" PRIuMAX "\n",
+                c->ranges[i].start, c->ranges[i].end);
+
+    int ret = ferror(stream);
+    if (fclose(stream))
+        ret = -1;
+    if (ret == 0)
+        ret = vlc_rename(tmp, meta);
+    if (ret)
+        vlc_unlink(tmp);
+    free(tmp);
+    return ret;
+}
+
+struct vlc_http_cache_file
+{
+    char *name;
+    time_t atime;
+    uintmax_t size;
+};
+
+static int vlc_http_cache_file_cmp(const void *a, const void *b)
+{
+    const struct vlc_http_cache_file *fa = a, *fb = b;
+
+    return (fa->atime > fb->atime) - (fa->atime < fb->atime);
+}
+
+/**
+ * Removes least recently used entries until the cache fits its size limit.
+ * The metadata file is rewritten whenever an entry is used, so its
+ * modification time is the entry last access time.
+ */
+static void vlc_http_cache_evict(const char *dir, const char *keep,
+                                 uintmax_t max)
+{
+    DIR *d = vlc_opendir(dir);
+    if (d == NULL)
+        return;
+
+    struct vlc_http_cache_file *files = NULL;
+    size_t count = 0;
+    uintmax_t total = 0;
+    const char *name;
+
+    while ((name = vlc_readdir(d)) != NULL)
+    {
+        size_t len = strlen(name);
+
+        if (len <= 5 || strcmp(name + len - 5, ".meta"))
+            continue;
+
+        struct vlc_http_cache_file f;
+        struct stat st;
+
+        if (asprintf(&f.name, "%s" DIR_SEP "%.*s", dir, (int)(len - 5),
+                     name) == -1)
+            continue;
+
+        char *meta = vlc_http_cache_meta_path(f.name);
+        if (meta == NULL || vlc_stat(meta, &st))
+        {
+            free(meta);
+            free(f.name);
+            continue;
+        }
+        free(meta);
+
+        f.atime = st.st_mtime;
+        f.size = st.st_size;
+        if (vlc_stat(f.name, &st) == 0)
+            f.size += st.st_size;
+
+        struct vlc_http_cache_file *tab = realloc(files,
+                                                  (count + 1) * sizeof (*tab));
+        if (unlikely(tab == NULL))
+        {
+            free(f.name);
+            break;
+        }
+        files = tab;
+        files[count++] = f;
+        total += f.size;
+    }
+    closedir(d);
+
+    if (total > max)
+        qsort(files, count, sizeof (*files), vlc_http_cache_file_cmp);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (total > max && strcmp(files[i].name, keep))
+        {   /* Entries in use by another process are kept. */
+            int fd = vlc_open(files[i].name, O_RDWR);
+
+            if (fd == -1 || vlc_http_cache_lock(fd) == 0)
+            {
+                char *meta = vlc_http_cache_meta_path(files[i].name);
+                if (meta != NULL)
+                {
+                    vlc_unlink(meta);
+                    free(meta);
+                }
+                vlc_unlink(files[i].name);
+                total -= files[i].size;
+            }
+            if (fd != -1)
+                vlc_close(fd);
+        }
+        free(files[i].name);
+    }
+    free(files);
+}
+
+struct vlc_http_cache *vlc_http_cache_open(const char *dir, const char *url,
+                                           uintmax_t max)
+{
+    struct vlc_http_cache *c = malloc(sizeof (*c));
+    if (unlikely(c == NULL))
+        return NULL;
+
+    char *hash, *meta;
+
+    c->key = vlc_http_cache_key(url);
+    if (unlikely(c->key == NULL))
+    {
+        free(c);
+        return NULL;
+    }
+
+    hash = vlc_http_cache_digest("", c->key);
+    if (unlikely(hash == NULL)
+     || unlikely(asprintf(&c->path, "%s" DIR_SEP "%s", dir, hash) == -1))
+    {
+        free(hash);
+        free(c->key);
+        free(c);
+        return NULL;
+    }
+    free(hash);
+
+    if (vlc_mkdir(dir, 0700) && errno != EEXIST)
+        goto error;
+
+    vlc_http_cache_evict(dir, c->path, max);
+
+    c->fd = -1;
+    c->etag = NULL;
+    c->type = NULL;
+    c->ranges = NULL;
+    vlc_http_cache_clear(c);
+
+    int fd = vlc_open(c->path, O_RDWR | O_CREAT, 0600);
+    if (fd == -1)
+        goto error;
+    if (vlc_http_cache_lock(fd))
+    {   /* The entry is in use by another process. */
+        vlc_close(fd);
+        goto error;
+    }
+
+    meta = vlc_http_cache_meta_path(c->path);
+    if (meta != NULL)
+    {
+        vlc_http_cache_load(c, meta);
+        free(meta);
+    }
+
+    c->fd = fd;
+    if (!c->valid)
+        vlc_http_cache_clear(c); /* discard any partially loaded metadata */
+    return c;
+
+error:
+    free(c->key);
+    free(c->path);
+    free(c);
+    return NULL;
+}
+
+void vlc_http_cache_close(struct vlc_http_cache *c)
+{
+    char *meta = vlc_http_cache_meta_path(c->path);
+
+    if (meta != NULL)
+    {
+        if (!c->valid || c->fd == -1 || vlc_http_cache_save(c, meta))
+        {
+            vlc_unlink(meta);
+            vlc_unlink(c->path);
+        }
+        free(meta);
+    }
+
+    if (c->fd != -1)
+        vlc_close(c->fd);
+    free(c->ranges);
+    free(c->type);
+    free(c->etag);
+    free(c->key);
+    free(c->path);
+    free(c);
+}
+
+bool vlc_http_cache_is_valid(const struct vlc_http_cache *c)
+{
+    return c->valid;
+}
+
+bool vlc_http_cache_is_fresh(const struct vlc_http_cache *c)
+{
+    return c->valid && time(NULL) < c->expires;
+}
+
+int vlc_http_cache_add_conditions(const struct vlc_http_cache *c,
+                                  struct vlc_http_msg *req)
+{
+    if (!c->valid)
+        return -1;
+    /* IETF RFC7232 §3.3: If-Modified-Since is ignored with If-None-Match */
+    if (c->etag != NULL)
+        return vlc_http_msg_add_header(req, "If-None-Match", "%s", c->etag);
+    return vlc_http_msg_add_time(req, "If-Modified-Since", &c->mtime);
+}
+
+/**
+ * Computes the expiry time of a response (IETF RFC7234 §4.2).
+ */
+static time_t vlc_http_cache_expiry(const struct vlc_http_msg *resp)
+{
+    time_t now = time(NULL);
+    const char *str;
+
+    if (vlc_http_msg_get_token(resp, "Cache-Control", "no-cache") != NULL)
+        return now; /* must always be revalidated */
+
+    str = vlc_http_msg_get_token(resp, "Cache-Control", "max-age");
+    if (str != NULL)
+    {
+        unsigned long max_age, age = 0;
+
+        if (sscanf(str + strlen("max-age"), " = %lu", &max_age) != 1)
+            return now;
+
+        str = vlc_http_msg_get_header(resp, "Age");
+        if (str != NULL)
+            age = strtoul(str, NULL, 10);
+        if (age >= max_age)
+            return now;
+        if (max_age - age > INT32_MAX)
+            return now + INT32_MAX;
+        return now + (max_age - age);
+    }
+
+    time_t date = vlc_http_msg_get_atime(resp);
+    if (date == -1)
+        date = now;
+
+    if (vlc_http_msg_get_header(resp, "Expires") != NULL)
+    {   /* Invalid dates mean already expired. Use the server clock. */
+        time_t expires = vlc_http_msg_get_time(resp, "Expires");
+        if (expires <= date)
+            return now;
+        return now + (expires - date);
+    }
+
+    time_t mtime = vlc_http_msg_get_mtime(resp);
+    if (mtime != -1 && mtime < date)
+    {   /* Heuristic freshness: a tenth of the entity age (RFC7234 §4.2.2) */
+        time_t lifetime = (date - mtime) / 10;
+
+        if (lifetime > VLC_HTTP_CACHE_HEURISTIC_MAX)
+            lifetime = VLC_HTTP_CACHE_HEURISTIC_MAX;
+        return now + lifetime;
+    }
+    return now;
+}
+
+int vlc_http_cache_update(struct vlc_http_cache *c,
+                          const struct vlc_http_msg *resp, uintmax_t size)
+{
+    int status = vlc_http_msg_get_status(resp);
+
+    if (status == 304 /* Not Modified */)
+    {
+        if (!c->valid)
+            return -1;
+        c->expires = vlc_http_cache_expiry(resp);
+        return 0;
+    }
+
+    if (status != 200 && status != 206)
+        return c->valid ? 0 : -1;
+
+    if (vlc_http_msg_get_token(resp, "Cache-Control", "no-store") != NULL)
+        goto discard;
+
+    const char *etag = vlc_http_msg_get_header(resp, "ETag");
+    time_t mtime = vlc_http_msg_get_mtime(resp);
+
+    if ((etag == NULL && mtime == -1) /* cannot be revalidated */
+     || size == (uintmax_t)-1 /* cannot be stored by ranges */)
+        goto discard;
+
+    if (!c->valid || c->size != size || c->mtime != mtime
+     || (etag != NULL) != (c->etag != NULL)
+     || (etag != NULL && strcmp(etag, c->etag)))
+    {   /* New or modified entity: drop any stored data. */
+        const char *type = vlc_http_msg_get_header(resp, "Content-Type");
+
+        vlc_http_cache_clear(c);
+        if (etag != NULL)
+        {
+            c->etag = strdup(etag);
+            if (unlikely(c->etag == NULL))
+                goto discard;
+        }
+        if (type != NULL)
+        {
+            c->type = strdup(type);
+            if (unlikely(c->type == NULL))
+                goto discard;
+        }
+        c->mtime = mtime;
+        c->size = size;
+        c->valid = true;
+    }
+
+    c->seekable = status == 206
+        || vlc_http_msg_get_token(resp, "Accept-Ranges", "bytes") != NULL;
+    c->expires = vlc_http_cache_expiry(resp);
+    return 0;
+
+discard:
+    vlc_http_cache_clear(c);
+    return -1;
+}
+
+struct vlc_http_msg *vlc_http_cache_get_response(const struct vlc_http_cache *c)
+{
+    if (!c->valid)
+        return NULL;
+
+    struct vlc_http_msg *resp = vlc_http_resp_create(200);
+    if (unlikely(resp == NULL))
+        return NULL;
+
+    if (vlc_http_msg_add_header(resp, "Content-Length", "%" PRIuMAX, c->size)
+     || (c->etag != NULL
+      && vlc_http_msg_add_header(resp, "ETag", "%s", c->etag))
+     || (c->mtime != -1
+      && vlc_http_msg_add_time(resp, "Last-Modified", &c->mtime))
+     || (c->type != NULL
+      && vlc_http_msg_add_header(resp, "Content-Type", "%s", c->type))
+     || (c->seekable
+      && vlc_http_msg_add_header(resp, "Accept-Ranges", "bytes")))
+    {
+        vlc_http_msg_destroy(resp);
+        return NULL;
+    }
+    return resp;
+}
+
+block_t *vlc_http_cache_read(struct vlc_http_cache *c, uintmax_t offset)
+{
+    if (!c->valid || c->fd == -1)
+        return NULL;
+
+    for (size_t i = 0; i < c->count; i++)
+    {
+        const struct vlc_http_cache_range *r = c->ranges + i;
+
+        if (offset < r->start)
+            break;
+        if (offset >= r->end)
+            continue;
+
+        size_t len = VLC_HTTP_CACHE_BLOCK;
+        if (len > r->end - offset)
+            len = r->end - offset;
+
+        block_t *block = block_Alloc(len);
+        if (unlikely(block == NULL))
+            return NULL;
+
+        ssize_t val = -1;
+        if (lseek(c->fd, offset, SEEK_SET) != (off_t)-1)
+            val = read(c->fd, block->p_buffer, len);
+        if (val <= 0)
+        {   /* The data file was truncated or damaged behind our back. */
+            block_Release(block);
+            vlc_http_cache_clear(c);
+            return NULL;
+        }
+
+        block->i_buffer = val;
+        return block;
+    }
+    return NULL;
+}
+
+void vlc_http_cache_write(struct vlc_http_cache *c, uintmax_t offset,
+                          const block_t *block)
+{
+    if (!c->valid || c->fd == -1 || block->i_buffer == 0
+     || offset >= c->size || block->i_buffer > c->size - offset)
+        return;
+
+    /* Data is only recorded as stored once fully written, so a failure
+     * (e.g. a full disk) leaves the entry consistent. */
+    if (lseek(c->fd, offset, SEEK_SET) == (off_t)-1
+     || write(c->fd, block->p_buffer, block->i_buffer)
+                                               != (ssize_t)block->i_buffer)
+        return;
+
+    vlc_http_cache_insert(c, offset, offset + block->i_buffer);
+}
@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * cache.h: HTTP persistent disk cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \defgroup http_cache Disk cache
+ * Persistent storage of HTTP files
+ * \ingroup http_file
+ * @{
+ */
+
+struct vlc_http_cache;
+struct vlc_http_msg;
+struct block_t;
+
+/**
+ * Opens a cache entry.
+ *
+ * Looks up the cache entry for a URL in a cache directory, or creates an empty
+ * one. Each entry consists of a sparse data file and of a metadata file
+ * recording the entity validators, the freshness lifetime and the byte ranges
+ * stored in the data file. The entry is keyed by the URL without its user
+ * information, and the URL itself is not stored.
+ *
+ * An entry is used by only one process at a time.
+ *
+ * Least recently used entries are evicted if the total size of the cache
+ * directory exceeds the given limit.
+ *
+ * @param dir cache directory path (created if missing)
+ * @param url URL of the cached file
+ * @param max maximum total size of the cache directory in bytes
+ *
+ * @return a cache entry pointer, or NULL on error or if the entry is in use
+ */
+struct vlc_http_cache *vlc_http_cache_open(const char *dir, const char *url,
+                                           uintmax_t max);
+
+/**
+ * Closes a cache entry.
+ *
+ * Writes the entry metadata back, or removes the entry if its content cannot
+ * be stored.
+ */
+void vlc_http_cache_close(struct vlc_http_cache *);
+
+/**
+ * Checks whether a cache entry describes an entity.
+ *
+ * @retval true if the entry holds the validators of an entity
+ * @retval false if the entry is empty
+ */
+bool vlc_http_cache_is_valid(const struct vlc_http_cache *);
+
+/**
+ * Checks cache entry freshness.
+ *
+ * @retval true if the cached entity can be used without revalidation
+ * @retval false if the entry must be revalidated or is empty
+ */
+bool vlc_http_cache_is_fresh(const struct vlc_http_cache *);
+
+/**
+ * Adds revalidation conditions.
+ *
+ * Adds the If-None-Match or If-Modified-Since header to a request, so that
+ * the server replies 304 Not Modified if the cached entity is still valid.
+ *
+ * @retval 0 on success
+ * @retval -1 if the entry has no validators
+ */
+int vlc_http_cache_add_conditions(const struct vlc_http_cache *,
+                                  struct vlc_http_msg *req);
+
+/**
+ * Updates a cache entry from a response.
+ *
+ * Refreshes the entry freshness from a 304 Not Modified response. Records the
+ * validators, type and size of the entity from a 200 OK or 206 Partial
+ * Content response, discarding stored data if the entity has changed. Other
+ * responses are ignored.
+ *
+ * @param resp response headers
+ * @param size entity size in bytes, or (uintmax_t)-1 if unknown
+ *
+ * @retval 0 if the cached data is valid
+ * @retval -1 if the response is not cacheable or nothing is cached
+ */
+int vlc_http_cache_update(struct vlc_http_cache *,
+                          const struct vlc_http_msg *resp, uintmax_t size);
+
+/**
+ * Creates a response from a cache entry.
+ *
+ * Creates 200 OK response headers describing the cached entity, without
+ * payload, as a substitute for a network response.
+ *
+ * @return response headers, or NULL on error
+ */
+struct vlc_http_msg *vlc_http_cache_get_response(const struct vlc_http_cache *);
+
+/**
+ * Reads cached data.
+ *
+ * @param offset byte offset of the data to read
+ * @return a data block, or NULL if the offset is not cached
+ */
+struct block_t *vlc_http_cache_read(struct vlc_http_cache *, uintmax_t offset);
+
+/**
+ * Stores data.
+ *
+ * @param offset byte offset of the data within the entity
+ * @param block data block to store
+ */
+void vlc_http_cache_write(struct vlc_http_cache *, uintmax_t offset,
+                          const struct block_t *block);
+
+/** @} */
@@ -36,6 +36,7 @@
 #include "message.h"
 #include "resource.h"
 #include "file.h"
+#include "cache.h"
 
 #pragma GCC visibility push(default)
 
@@ -43,8 +44,13 @@ struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    uintmax_t resp_offset; /**< offset of the next byte of the response */
+    struct vlc_http_cache *cache;
+    bool revalidate;
 };
 
+static uintmax_t vlc_http_msg_get_file_size(const struct vlc_http_msg *);
+
 static int vlc_http_file_req(const struct vlc_http_resource *res,
                              struct vlc_http_msg *req, void *opaque)
 {
@@ -68,6 +74,8 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
                 vlc_http_msg_add_time(req, "If-Unmodified-Since", &mtime);
         }
     }
+    else if (file->revalidate)
+        vlc_http_cache_add_conditions(file->cache, req);
 
     if (vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-", *offset)
      && *offset != 0)
@@ -96,7 +104,16 @@ static int vlc_http_file_resp(const struct vlc_http_resource *res,
             goto fail;
     }
 
-    (void) res;
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    if (file->cache != NULL)
+    {
+        uintmax_t size = vlc_http_msg_get_file_size(resp);
+        if (size == (uintmax_t)-1 && vlc_http_msg_get_status(resp) == 200)
+            size = vlc_http_msg_get_size(resp);
+
+        vlc_http_cache_update(file->cache, resp, size);
+    }
     return 0;
 
 fail:
@@ -126,9 +143,47 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     }
 
     file->offset = 0;
+    file->resp_offset = 0;
+    file->cache = NULL;
+    file->revalidate = false;
     return &file->resource;
 }
 
+void vlc_http_file_set_cache(struct vlc_http_resource *res,
+                             struct vlc_http_cache *cache)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    assert(res->response == NULL);
+    assert(file->offset == 0);
+    file->cache = cache;
+
+    if (!vlc_http_cache_is_fresh(cache))
+    {
+        if (!vlc_http_cache_is_valid(cache))
+            return; /* nothing to revalidate */
+
+        file->revalidate = true;
+        struct vlc_http_msg *resp = vlc_http_res_open(res, &file->offset);
+        file->revalidate = false;
+
+        if (resp == NULL)
+            return;
+        if (vlc_http_msg_get_status(resp) != 304 /* Not Modified */)
+        {   /* Modified entity, or error */
+            res->response = resp;
+            return;
+        }
+        vlc_http_msg_destroy(resp);
+    }
+
+    /* Use the cached entity, without payload: read from the cache, and
+     * resume the download on cache miss. */
+    res->response = vlc_http_cache_get_response(cache);
+    if (res->response != NULL)
+        file->resp_offset = -1;
+}
+
 static uintmax_t vlc_http_msg_get_file_size(const struct vlc_http_msg *resp)
 {
     int status = vlc_http_msg_get_status(resp);
@@ -201,7 +256,7 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *res)
     return vlc_http_msg_can_seek(res->response);
 }
 
-int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
+static int vlc_http_file_open(struct vlc_http_resource *res, uintmax_t offset)
 {
     struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
     if (resp == NULL)
@@ -226,20 +281,53 @@ int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
 
     res->response = resp;
     file->offset = offset;
+    file->resp_offset = offset;
     return 0;
 }
 
+int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    if (file->cache != NULL && vlc_http_file_can_seek(res))
+    {   /* Defer any request until a cache miss */
+        file->offset = offset;
+        return 0;
+    }
+    return vlc_http_file_open(res, offset);
+}
+
 block_t *vlc_http_file_read(struct vlc_http_resource *res)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
-    block_t *block = vlc_http_res_read(res);
+    block_t *block;
+
+    if (file->cache != NULL)
+    {
+        block = vlc_http_cache_read(file->cache, file->offset);
+        if (block != NULL)
+        {
+            file->offset += block->i_buffer;
+            return block;
+        }
+
+        if (file->offset >= vlc_http_file_get_size(res))
+            return NULL; /* End of file */
+
+        /* Cache miss: resume the download from the read offset */
+        if (file->resp_offset != file->offset
+         && vlc_http_file_open(res, file->offset))
+            return NULL;
+    }
+
+    block = vlc_http_res_read(res);
 
     if (block == vlc_http_error)
     {   /* Automatically reconnect on error if server supports seek */
         if (res->response != NULL
          && vlc_http_msg_can_seek(res->response)
          && file->offset < vlc_http_msg_get_file_size(res->response)
-         && vlc_http_file_seek(res, file->offset) == 0)
+         && vlc_http_file_open(res, file->offset) == 0)
             block = vlc_http_res_read(res);
 
         if (block == vlc_http_error)
@@ -249,6 +337,9 @@ block_t *vlc_http_file_read(struct vlc_http_resource *res)
     if (block == NULL)
         return NULL; /* End of stream */
 
+    if (file->cache != NULL)
+        vlc_http_cache_write(file->cache, file->offset, block);
     file->offset += block->i_buffer;
+    file->resp_offset = file->offset;
     return block;
 }
@@ -29,6 +29,7 @@
 
 struct vlc_http_mgr;
 struct vlc_http_resource;
+struct vlc_http_cache;
 struct block_t;
 
 /**
@@ -46,6 +47,21 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
                                                const char *url, const char *ua,
                                                const char *ref);
 
+/**
+ * Attaches a disk cache entry to an HTTP file.
+ *
+ * If the cached entity is fresh, no request is sent. If it is stale, it is
+ * revalidated with a conditional request. Then data is read from the cache
+ * whenever possible, and data downloaded from the server is stored in the
+ * cache.
+ *
+ * This must be called before any request for the file is made.
+ *
+ * @param cache cache entry (must remain valid until the file is destroyed)
+ */
+void vlc_http_file_set_cache(struct vlc_http_resource *,
+                             struct vlc_http_cache *cache);
+
 /**
  * Gets file size.
  *
@@ -45,6 +45,15 @@
 #define CO(c) ((c)->opaque)
 #define SO(s) CO((s)->conn)
 
+/** Upper bound for the receive window of a stream */
+#define VLC_H2_MAX_WINDOW   (16 << 20)
+/** Upper bound for the sum of receive windows of a connection */
+#define VLC_H2_RECV_BUDGET  (32 << 20)
+/** Lower bound for the receive window of a stream */
+#define VLC_H2_MIN_WINDOW   VLC_H2_DEFAULT_INIT_WINDOW
+/** Round trip time probes without window growth before probing stops */
+#define VLC_H2_MAX_IDLE_PROBES 3
+
 /** HTTP/2 connection */
 struct vlc_h2_conn
 {
@@ -59,6 +68,17 @@ struct vlc_h2_conn
     uint32_t init_send_cwnd; /**< Initial send congestion window */
     uint64_t send_cwnd; /**< Send congestion window */
 
+    unsigned stream_count; /**< Number of open streams */
+    size_t recv_window; /**< Target receive window size per stream */
+
+    /* Bandwidth-delay product estimation */
+    bool ping_pending; /**< Whether a round trip time probe is in flight */
+    uint64_t ping_opaque; /**< Opaque value of the probe */
+    vlc_tick_t ping_time; /**< Time the probe was sent */
+    size_t ping_bytes; /**< Data bytes received since the probe was sent */
+    unsigned ping_idle; /**< Probes since the window last grew */
+    uint64_t bw_max; /**< Highest measured bandwidth (bytes per second) */
+
     vlc_mutex_t lock; /**< State machine lock */
     vlc_thread_t thread; /**< Receive thread */
 };
@@ -101,6 +121,89 @@ static int vlc_h2_conn_queue_prio(struct vlc_h2_conn *conn,
 }
 
 
+/* Receive window auto-tuning */
+
+/**
+ * Computes the receive window size of a stream.
+ *
+ * This is the bandwidth-delay product estimate, bounded so that the windows
+ * of all open streams fit within the connection memory budget.
+ */
+static size_t vlc_h2_stream_window(const struct vlc_h2_stream *s)
+{
+    const struct vlc_h2_conn *conn = s->conn;
+    size_t window = conn->recv_window;
+    size_t share = VLC_H2_RECV_BUDGET / conn->stream_count;
+
+    if (window > share)
+        window = share;
+    if (window < VLC_H2_MIN_WINDOW)
+        window = VLC_H2_MIN_WINDOW;
+    return window;
+}
+
+/**
+ * Accounts for received data.
+ *
+ * Starts a round trip time probe if none is pending. The data received until
+ * the probe is acknowledged approximates the bandwidth-delay product.
+ * Probing stops once the window has not grown for a few probes, until a new
+ * stream is opened, so as not to send a PING every round trip.
+ */
+static void vlc_h2_bdp_received(struct vlc_h2_conn *conn, size_t len)
+{
+    conn->ping_bytes += len;
+
+    if (conn->ping_pending || conn->recv_window >= VLC_H2_MAX_WINDOW
+     || conn->ping_idle >= VLC_H2_MAX_IDLE_PROBES)
+        return;
+
+    conn->ping_opaque++;
+    if (vlc_h2_conn_queue_prio(conn,
+                               vlc_h2_frame_ping(conn->ping_opaque)) == 0)
+    {
+        conn->ping_pending = true;
+        conn->ping_time = vlc_tick_now();
+        conn->ping_bytes = 0;
+    }
+}
+
+/**
+ * Updates the bandwidth-delay product estimate from a probe acknowledgement.
+ *
+ * If the window was nearly filled within one round trip at the best measured
+ * bandwidth so far, the window is likely what limits the throughput, so it is
+ * grown to twice the estimate.
+ */
+static void vlc_h2_bdp_acked(struct vlc_h2_conn *conn)
+{
+    vlc_tick_t rtt = vlc_tick_now() - conn->ping_time;
+    if (rtt <= 0)
+        rtt = 1;
+
+    uint64_t bw = (uint64_t)conn->ping_bytes * CLOCK_FREQ / rtt;
+    if (bw > conn->bw_max)
+        conn->bw_max = bw;
+
+    conn->ping_pending = false;
+    conn->ping_idle++;
+
+    if (conn->ping_bytes < conn->recv_window * 2 / 3 || bw < conn->bw_max)
+        return;
+
+    size_t window = conn->ping_bytes * 2;
+    if (window > VLC_H2_MAX_WINDOW)
+        window = VLC_H2_MAX_WINDOW;
+    if (window <= conn->recv_window)
+        return;
+
+    vlc_http_dbg(CO(conn), "receive window: %zu bytes (RTT: %"PRId64" us, "
+                 "bandwidth: %"PRIu64" bytes/s)", window,
+                 US_FROM_VLC_TICK(rtt), bw);
+    conn->recv_window = window;
+    conn->ping_idle = 0;
+}
+
 /* Stream callbacks */
 
 /** Looks a stream up by ID. */
@@ -182,6 +285,7 @@ static int vlc_h2_stream_data(void *ctx, struct vlc_h2_frame *f)
         return vlc_h2_stream_fatal(s, VLC_H2_FLOW_CONTROL_ERROR);
     }
     s->recv_cwnd -= len;
+    vlc_h2_bdp_received(s->conn, len);
 
     *(s->recv_tailp) = f;
     s->recv_tailp = &f->next;
@@ -322,11 +426,18 @@ static block_t *vlc_h2_stream_read(struct vlc_http_stream *stream)
         s->recv_tailp = &s->recv_head;
     }
 
-    /* Credit the receive window if missing credit exceeds 50%. */
-    uint_fast32_t credit = VLC_H2_INIT_WINDOW - s->recv_cwnd;
-    if (credit >= (VLC_H2_INIT_WINDOW / 2)
-     && !vlc_h2_conn_queue(conn, vlc_h2_frame_window_update(s->id, credit)))
-        s->recv_cwnd += credit;
+    /* Credit the receive window if missing credit exceeds 50%. If the window
+     * shrank, credit is withheld until enough data is consumed. */
+    size_t window = vlc_h2_stream_window(s);
+    if (s->recv_cwnd < window)
+    {
+        uint_fast32_t credit = window - s->recv_cwnd;
+
+        if (credit >= (window / 2)
+         && !vlc_h2_conn_queue(conn,
+                               vlc_h2_frame_window_update(s->id, credit)))
+            s->recv_cwnd += credit;
+    }
 
     vlc_h2_stream_unlock(s);
 
@@ -374,6 +485,7 @@ static void vlc_h2_stream_close(struct vlc_http_stream *stream, bool aborted)
         conn->streams = s->older;
         destroy = (conn->streams == NULL) && conn->released;
     }
+    conn->stream_count--;
     vlc_mutex_unlock(&conn->lock);
 
     if (s->recv_hdr != NULL || s->recv_head != NULL || !s->recv_end)
@@ -459,6 +571,8 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
     if (s->older != NULL)
         s->older->newer = s;
     conn->streams = s;
+    conn->stream_count++;
+    conn->ping_idle = 0; /* the new transfer may need a larger window */
     vlc_mutex_unlock(&conn->lock);
     return &s->stream;
 
@@ -515,6 +629,15 @@ static int vlc_h2_ping(void *ctx, uint_fast64_t opaque)
     return vlc_h2_conn_queue_prio(conn, vlc_h2_frame_pong(opaque));
 }
 
+/** Reports a ping acknowledgement from HTTP/2 peer */
+static void vlc_h2_pong(void *ctx, uint_fast64_t opaque)
+{
+    struct vlc_h2_conn *conn = ctx;
+
+    if (conn->ping_pending && opaque == conn->ping_opaque)
+        vlc_h2_bdp_acked(conn);
+}
+
 /** Reports a local HTTP/2 connection failure */
 static void vlc_h2_error(void *ctx, uint_fast32_t code)
 {
@@ -557,12 +680,22 @@ static void vlc_h2_window_status(void *ctx, uint32_t *restrict rcwd)
 {
     struct vlc_h2_conn *conn = ctx;
 
-    /* Maintain connection receive window to insanely large values.
-     * Congestion control is done per stream instead. */
-    if (*rcwd < (1 << 30)
-     && vlc_h2_conn_queue_prio(conn,
-                               vlc_h2_frame_window_update(0, 1 << 30)) == 0)
-        *rcwd += 1 << 30;
+    /* Flow control is done per stream. The connection window is credited as
+     * data is received, and sized to cover the windows of all streams. */
+    size_t window = 2 * conn->recv_window;
+    if (conn->stream_count > 1)
+        window *= conn->stream_count;
+    if (window > VLC_H2_RECV_BUDGET)
+        window = VLC_H2_RECV_BUDGET;
+
+    if (*rcwd < window / 2)
+    {
+        uint_fast32_t credit = window - *rcwd;
+
+        if (vlc_h2_conn_queue_prio(conn,
+                                   vlc_h2_frame_window_update(0, credit)) == 0)
+            *rcwd += credit;
+    }
 }
 
 static void vlc_h2_window_update(void *ctx, uint_fast32_t credit)
@@ -581,6 +714,7 @@ static const struct vlc_h2_parser_cbs vlc_h2_parser_callbacks =
     vlc_h2_setting,
     vlc_h2_settings_done,
     vlc_h2_ping,
+    vlc_h2_pong,
     vlc_h2_error,
     vlc_h2_reset,
     vlc_h2_window_status,
@@ -786,6 +920,13 @@ struct vlc_http_conn *vlc_h2_conn_create(void *ctx, struct vlc_tls *tls)
     conn->released = false;
     conn->init_send_cwnd = VLC_H2_DEFAULT_INIT_WINDOW;
     conn->send_cwnd = VLC_H2_DEFAULT_INIT_WINDOW;
+    conn->stream_count = 0;
+    conn->recv_window = VLC_H2_INIT_WINDOW;
+    conn->ping_pending = false;
+    conn->ping_opaque = 0;
+    conn->ping_bytes = 0;
+    conn->ping_idle = 0;
+    conn->bw_max = 0;
 
     if (unlikely(conn->out == NULL))
         goto error;
@@ -64,32 +64,52 @@ enum {
     WINDOW_UPDATE, CONTINUATION,
 };
 
+static bool probe_pending; /* PING from the connection under test */
+static uint64_t probe_opaque;
+static uint_fast32_t stream_credit_max; /* Largest stream WINDOW_UPDATE */
+
 static void conn_expect(uint_fast8_t wanted)
 {
     size_t len;
     ssize_t val;
     uint8_t hdr[9];
     uint8_t got;
+    bool ack;
 
     do {
         val = vlc_tls_Read(external_tls, hdr, 9, true);
         assert(val == 9);
         assert(hdr[0] == 0);
 
-        /* Check type. We do not currently validate WINDOW_UPDATE. */
+        /* Check type. WINDOW_UPDATE and PING probes can come anytime. */
         got = hdr[3];
-        assert(wanted == got || WINDOW_UPDATE == got);
+        ack = (got == PING) && (hdr[4] & 0x01);
+        assert(wanted == got || WINDOW_UPDATE == got || PING == got);
 
         len = (hdr[1] << 8) | hdr[2];
         if (len > 0)
         {
-            char buf[len];
+            uint8_t buf[len];
 
             val = vlc_tls_Read(external_tls, buf, len, true);
             assert(val == (ssize_t)len);
+
+            if (got == WINDOW_UPDATE && (GetDWBE(hdr + 5) & 0x7fffffff))
+            {
+                uint_fast32_t credit = GetDWBE(buf) & 0x7fffffff;
+                if (credit > stream_credit_max)
+                    stream_credit_max = credit;
+            }
+
+            if (got == PING && !ack)
+            {
+                assert(len == 8);
+                memcpy(&probe_opaque, buf, 8);
+                probe_pending = true;
+            }
         }
     }
-    while (got != wanted);
+    while (got != wanted || (got == PING && !ack));
 }
 
 static void conn_create(void)
@@ -156,6 +176,32 @@ static void stream_data(uint_fast32_t id, const char *str, bool eos)
     conn_send(vlc_h2_frame_data(id, str, strlen(str), eos));
 }
 
+static void stream_fill(uint_fast32_t id, size_t len)
+{
+    static const char buf[VLC_H2_DEFAULT_MAX_FRAME];
+
+    while (len > 0)
+    {
+        size_t n = (len < sizeof (buf)) ? len : sizeof (buf);
+
+        conn_send(vlc_h2_frame_data(id, buf, n, false));
+        len -= n;
+    }
+}
+
+static void stream_drain(struct vlc_http_msg *m, size_t len)
+{
+    while (len > 0)
+    {
+        struct block_t *b = vlc_http_msg_read(m);
+
+        assert(b != NULL && b != vlc_http_error);
+        assert(b->i_buffer <= len);
+        len -= b->i_buffer;
+        block_Release(b);
+    }
+}
+
 /* TODO: check messages coming from the connection under test */
 
 int main(void)
@@ -255,6 +301,87 @@ int main(void)
     conn_expect(RST_STREAM);
     conn_expect(RST_STREAM);
 
+    /* Test receive window growth: the whole window is received within one
+     * round trip time. */
+    sid += 2;
+    s = stream_open();
+    assert(s != NULL);
+    stream_reply(sid, false);
+    m = vlc_http_msg_get_initial(s);
+    assert(m != NULL);
+    conn_expect(HEADERS);
+
+    stream_fill(sid, VLC_H2_INIT_WINDOW);
+    while (!probe_pending) /* might have been sent with earlier data */
+        conn_expect(PING);
+    probe_pending = false;
+    conn_send(vlc_h2_frame_pong(probe_opaque));
+    conn_send(vlc_h2_frame_ping(42)); /* wait for the pong to be processed */
+    conn_expect(PING);
+
+    stream_credit_max = 0;
+    stream_drain(m, VLC_H2_INIT_WINDOW);
+    vlc_http_msg_destroy(m);
+    conn_expect(RST_STREAM);
+    assert(stream_credit_max > VLC_H2_INIT_WINDOW);
+
+    /* Test that probing stops once the window no longer grows */
+    sid += 2;
+    s = stream_open();
+    assert(s != NULL);
+    stream_reply(sid, false);
+    m = vlc_http_msg_get_initial(s);
+    assert(m != NULL);
+    conn_expect(HEADERS);
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        stream_fill(sid, 1000);
+        conn_send(vlc_h2_frame_ping(42)); /* probe is sent before the pong */
+        conn_expect(PING);
+        assert(probe_pending);
+        probe_pending = false;
+        conn_send(vlc_h2_frame_pong(probe_opaque));
+    }
+
+    stream_fill(sid, 1000);
+    conn_send(vlc_h2_frame_ping(42));
+    conn_expect(PING);
+    assert(!probe_pending);
+
+    stream_drain(m, 4000);
+    vlc_http_msg_destroy(m);
+    conn_expect(RST_STREAM);
+
+    /* Test receive window shrinking with many concurrent streams */
+    struct vlc_http_stream *sv[40];
+
+    for (size_t i = 0; i < ARRAY_SIZE(sv); i++)
+    {
+        sid += 2;
+        sv[i] = stream_open();
+        assert(sv[i] != NULL);
+        conn_expect(HEADERS);
+    }
+
+    stream_reply(sid, false);
+    m = vlc_http_msg_get_initial(sv[ARRAY_SIZE(sv) - 1]);
+    assert(m != NULL);
+    stream_fill(sid, VLC_H2_INIT_WINDOW);
+
+    stream_credit_max = 0;
+    stream_drain(m, VLC_H2_INIT_WINDOW);
+    vlc_http_msg_destroy(m);
+    conn_expect(RST_STREAM);
+    assert(stream_credit_max > 0);
+    assert(stream_credit_max < VLC_H2_INIT_WINDOW);
+
+    for (size_t i = 0; i < ARRAY_SIZE(sv) - 1; i++)
+    {
+        vlc_http_stream_close(sv[i], false);
+        conn_expect(RST_STREAM);
+    }
+
     /* Test nonexistent stream reset */
     conn_send(vlc_h2_frame_rst_stream(sid + 100, VLC_H2_REFUSED_STREAM));
 
@@ -0,0 +1,621 @@
+/*****************************************************************************
+ * ranges.c: HTTP parallel byte ranges
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+#include "conn.h"
+#include "connmgr.h"
+#include "message.h"
+#include "resource.h"
+#include "ranges.h"
+
+#pragma GCC visibility push(default)
+
+/** Size of each range request (bytes) */
+#define VLC_HTTP_RANGE_SIZE (1 << 20)
+/** Number of attempts to fetch the remainder of a failed range */
+#define VLC_HTTP_RANGE_RETRIES 2
+
+struct vlc_http_range
+{
+    uintmax_t start; /**< Offset of the next byte to fetch */
+    uintmax_t end; /**< Offset past the last byte of the range */
+    block_t *head; /**< Fetched but not read data */
+    block_t **tailp;
+    struct vlc_http_range_worker *worker; /**< Fetching worker, or NULL */
+    unsigned failures;
+    bool done;
+};
+
+struct vlc_http_range_worker
+{
+    struct vlc_http_resource resource;
+    struct vlc_http_ranges *owner;
+    vlc_interrupt_t *interrupt; /**< Set while fetching */
+    vlc_thread_t thread;
+};
+
+struct vlc_http_ranges
+{
+    vlc_object_t *obj;
+    struct vlc_logger *logger;
+    struct vlc_http_cookie_jar_t *jar;
+    char *etag;
+    time_t mtime;
+    uintmax_t size;
+    uintmax_t offset; /**< Read offset */
+    uintmax_t next; /**< Start of the next range to queue */
+
+    unsigned slots; /**< Size of the ranges ring */
+    unsigned max; /**< Number of workers */
+    unsigned target; /**< Current number of concurrent requests */
+    unsigned active; /**< Number of busy workers */
+    unsigned first; /**< Ring index of the range being read */
+    unsigned count; /**< Number of queued ranges */
+    bool closing;
+    bool interrupted;
+
+    /* Throughput estimation */
+    uint64_t rate_sum;
+    unsigned rate_count;
+    uint64_t rate;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait_data;
+    vlc_cond_t wait_work;
+    struct vlc_http_range_worker **workers;
+    struct vlc_http_range ranges[];
+};
+
+struct vlc_http_range_req
+{
+    uintmax_t first;
+    uintmax_t last;
+};
+
+static int vlc_http_range_req(const struct vlc_http_resource *res,
+                              struct vlc_http_msg *req, void *opaque)
+{
+    const struct vlc_http_range_worker *w =
+        container_of(res, struct vlc_http_range_worker, resource);
+    const struct vlc_http_ranges *r = w->owner;
+    const struct vlc_http_range_req *range = opaque;
+
+    /* All ranges must come from the same entity as the initial response. */
+    if (r->etag != NULL)
+        vlc_http_msg_add_header(req, "If-Match", "%s", r->etag);
+    else if (r->mtime != -1)
+        vlc_http_msg_add_time(req, "If-Unmodified-Since", &r->mtime);
+
+    return vlc_http_msg_add_header(req, "Range",
+                                   "bytes=%" PRIuMAX "-%" PRIuMAX,
+                                   range->first, range->last);
+}
+
+static int vlc_http_range_resp(const struct vlc_http_resource *res,
+                               const struct vlc_http_msg *resp, void *opaque)
+{
+    const struct vlc_http_range_req *range = opaque;
+
+    if (vlc_http_msg_get_status(resp) != 206)
+        goto fail; /* range not honored, or entity changed (412) */
+
+    const char *str = vlc_http_msg_get_header(resp, "Content-Range");
+    uintmax_t start, end;
+
+    if (str == NULL
+     || sscanf(str, "bytes %" SCNuMAX "-%" SCNuMAX, &start, &end) != 2
+     || start != range->first || start > end)
+        goto fail;
+
+    (void) res;
+    return 0;
+
+fail:
+    errno = EIO;
+    return -1;
+}
+
+static const struct vlc_http_resource_cbs vlc_http_range_callbacks =
+{
+    vlc_http_range_req,
+    vlc_http_range_resp,
+};
+
+/**
+ * Finds a range to fetch.
+ *
+ * Picks the first range of the reading window that is not being fetched, or
+ * appends a new one to the window.
+ */
+static struct vlc_http_range *vlc_http_ranges_get(struct vlc_http_ranges *r)
+{
+    const unsigned slots = r->slots;
+
+    if (r->active >= r->target)
+        return NULL;
+
+    for (unsigned i = 0; i < r->count; i++)
+    {
+        struct vlc_http_range *range = &r->ranges[(r->first + i) % slots];
+
+        if (!range->done && range->worker == NULL
+         && range->failures <= VLC_HTTP_RANGE_RETRIES)
+            return range;
+    }
+
+    /* Bound buffering to one range ahead of the fetched ones */
+    if (r->count > r->target || r->next >= r->size)
+        return NULL;
+
+    struct vlc_http_range *range = &r->ranges[(r->first + r->count) % slots];
+
+    range->start = r->next;
+    range->end = r->next + VLC_HTTP_RANGE_SIZE;
+    if (range->end > r->size)
+        range->end = r->size;
+    range->head = NULL;
+    range->tailp = &range->head;
+    range->worker = NULL;
+    range->failures = 0;
+    range->done = false;
+    r->next = range->end;
+    r->count++;
+    return range;
+}
+
+/**
+ * Adapts the number of concurrent requests.
+ *
+ * The aggregate throughput is estimated as the average throughput of a range
+ * times the number of concurrent ranges. More ranges are requested as long as
+ * this increases the aggregate, i.e. as long as connections are not competing
+ * for the same bottleneck.
+ */
+static void vlc_http_ranges_tune(struct vlc_http_ranges *r, uintmax_t bytes,
+                                 vlc_tick_t duration)
+{
+    if (duration <= 0)
+        return;
+
+    r->rate_sum += bytes * CLOCK_FREQ / duration;
+    if (++r->rate_count < r->target)
+        return;
+
+    uint64_t rate = r->rate_sum / r->rate_count * r->target;
+    unsigned target = r->target;
+
+    if (rate > r->rate + r->rate / 8)
+    {
+        if (target < r->max)
+            target++;
+    }
+    else if (rate + rate / 8 < r->rate && target > 1)
+        target--;
+
+    if (target != r->target)
+    {
+        vlc_http_dbg(r->logger, "%u parallel ranges (%" PRIu64 " kB/s)",
+                     target, rate / 1000);
+        vlc_cond_broadcast(&r->wait_work);
+    }
+
+    r->target = target;
+    r->rate = rate;
+    r->rate_sum = 0;
+    r->rate_count = 0;
+}
+
+static void vlc_http_range_fetch(struct vlc_http_range_worker *w,
+                                 struct vlc_http_range *range,
+                                 struct vlc_http_range_req *req)
+{
+    struct vlc_http_ranges *r = w->owner;
+    struct vlc_http_msg *resp = vlc_http_res_open(&w->resource, req);
+    bool eos = false;
+
+    while (resp != NULL)
+    {
+        block_t *block = vlc_http_msg_read(resp);
+        if (block == NULL)
+        {
+            eos = true;
+            break;
+        }
+        if (block == vlc_http_error)
+            break;
+
+        vlc_mutex_lock(&r->lock);
+        if (range->worker != w)
+        {   /* Range was discarded (seek or close) */
+            vlc_mutex_unlock(&r->lock);
+            block_Release(block);
+            break;
+        }
+
+        if (block->i_buffer > range->end - range->start)
+            block->i_buffer = range->end - range->start;
+
+        range->start += block->i_buffer;
+        block_ChainLastAppend(&range->tailp, block);
+        vlc_cond_signal(&r->wait_data);
+        vlc_mutex_unlock(&r->lock);
+    }
+
+    if (resp != NULL)
+        vlc_http_msg_destroy(resp);
+
+    if (!eos)
+    {   /* The response was not read to its end, or not even validated.
+         * Do not reuse the connection. */
+        struct vlc_http_mgr *mgr = vlc_http_mgr_create(r->obj, r->jar);
+        if (likely(mgr != NULL))
+        {
+            vlc_http_mgr_destroy(w->resource.manager);
+            w->resource.manager = mgr;
+        }
+    }
+}
+
+static void *vlc_http_ranges_thread(void *data)
+{
+    struct vlc_http_range_worker *w = data;
+    struct vlc_http_ranges *r = w->owner;
+
+    vlc_mutex_lock(&r->lock);
+    while (!r->closing)
+    {
+        struct vlc_http_range *range = vlc_http_ranges_get(r);
+        if (range == NULL)
+        {
+            vlc_cond_wait(&r->wait_work, &r->lock);
+            continue;
+        }
+
+        vlc_interrupt_t *intr = vlc_interrupt_create();
+        struct vlc_http_range_req req = { range->start, range->end - 1 };
+        vlc_tick_t begin = vlc_tick_now();
+
+        range->worker = w;
+        w->interrupt = intr;
+        r->active++;
+        vlc_mutex_unlock(&r->lock);
+
+        if (likely(intr != NULL))
+        {
+            vlc_interrupt_set(intr);
+            vlc_http_range_fetch(w, range, &req);
+            vlc_interrupt_set(NULL);
+        }
+
+        vlc_mutex_lock(&r->lock);
+        w->interrupt = NULL;
+        r->active--;
+
+        if (range->worker == w)
+        {
+            range->worker = NULL;
+
+            if (range->start >= range->end)
+            {
+                range->done = true;
+                vlc_http_ranges_tune(r, range->end - req.first,
+                                     vlc_tick_now() - begin);
+            }
+            else
+            {   /* Retry the remainder, possibly through a new connection */
+                range->failures++;
+                vlc_http_dbg(r->logger, "range %" PRIuMAX "-%" PRIuMAX
+                             " failed (%u)", range->start, range->end - 1,
+                             range->failures);
+            }
+            vlc_cond_signal(&r->wait_data);
+        }
+
+        if (intr != NULL)
+            vlc_interrupt_destroy(intr);
+    }
+    vlc_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+/** Aborts all ranges. Must be called with the lock held. */
+static void vlc_http_ranges_flush(struct vlc_http_ranges *r)
+{
+    const unsigned slots = r->slots;
+
+    for (unsigned i = 0; i < r->count; i++)
+    {
+        struct vlc_http_range *range = &r->ranges[(r->first + i) % slots];
+
+        if (range->worker != NULL)
+        {
+            if (range->worker->interrupt != NULL)
+                vlc_interrupt_kill(range->worker->interrupt);
+            range->worker = NULL;
+        }
+        block_ChainRelease(range->head);
+        range->head = NULL;
+        range->tailp = &range->head;
+    }
+
+    r->first = 0;
+    r->count = 0;
+}
+
+static void vlc_http_ranges_wake_up(void *data)
+{
+    struct vlc_http_ranges *r = data;
+
+    vlc_mutex_lock(&r->lock);
+    r->interrupted = true;
+    vlc_cond_broadcast(&r->wait_data);
+    vlc_mutex_unlock(&r->lock);
+}
+
+block_t *vlc_http_ranges_read(struct vlc_http_ranges *r)
+{
+    const unsigned slots = r->slots;
+    struct vlc_http_range *range = NULL;
+
+    r->interrupted = false;
+    vlc_interrupt_register(vlc_http_ranges_wake_up, r);
+    vlc_mutex_lock(&r->lock);
+
+    while (r->offset < r->size && !r->interrupted)
+    {
+        if (r->count > 0)
+        {
+            range = &r->ranges[r->first];
+            if (range->head != NULL)
+                break;
+
+            if (range->done)
+            {   /* Range fully read: make room for the next one */
+                r->first = (r->first + 1) % slots;
+                r->count--;
+                vlc_cond_signal(&r->wait_work);
+                range = NULL;
+                continue;
+            }
+
+            if (range->failures > VLC_HTTP_RANGE_RETRIES)
+            {
+                vlc_http_err(r->logger, "cannot fetch range %" PRIuMAX
+                             "-%" PRIuMAX, range->start, range->end - 1);
+                range = NULL;
+                break;
+            }
+            range = NULL;
+        }
+
+        mutex_cleanup_push(&r->lock);
+        vlc_cond_wait(&r->wait_data, &r->lock);
+        vlc_cleanup_pop();
+    }
+
+    block_t *block = NULL;
+
+    if (range != NULL)
+    {
+        block = range->head;
+        range->head = block->p_next;
+        if (range->head == NULL)
+            range->tailp = &range->head;
+        block->p_next = NULL;
+        r->offset += block->i_buffer;
+    }
+
+    vlc_mutex_unlock(&r->lock);
+    vlc_interrupt_unregister();
+    return block;
+}
+
+int vlc_http_ranges_seek(struct vlc_http_ranges *r, uintmax_t offset)
+{
+    vlc_mutex_lock(&r->lock);
+    if (offset != r->offset)
+    {
+        vlc_http_ranges_flush(r);
+        r->offset = offset;
+        r->next = offset;
+        vlc_cond_broadcast(&r->wait_work);
+    }
+    vlc_mutex_unlock(&r->lock);
+    return 0;
+}
+
+static char *vlc_http_res_get_url(const struct vlc_http_resource *res)
+{
+    char *url;
+
+    if (unlikely(asprintf(&url, "http%s://%s%s", res->secure ? "s" : "",
+                          res->authority, res->path) == -1))
+        return NULL;
+    return url;
+}
+
+static struct vlc_http_range_worker *
+vlc_http_range_worker_create(struct vlc_http_ranges *r,
+                             const struct vlc_http_resource *res,
+                             const char *url)
+{
+    struct vlc_http_range_worker *w = malloc(sizeof (*w));
+    if (unlikely(w == NULL))
+        return NULL;
+
+    struct vlc_http_mgr *mgr = vlc_http_mgr_create(r->obj, r->jar);
+    if (mgr == NULL)
+    {
+        free(w);
+        return NULL;
+    }
+
+    if (vlc_http_res_init(&w->resource, &vlc_http_range_callbacks, mgr, url,
+                          res->agent, res->referrer))
+    {
+        vlc_http_mgr_destroy(mgr);
+        free(w);
+        return NULL;
+    }
+
+    w->resource.negotiate = res->negotiate;
+    w->owner = r;
+    w->interrupt = NULL;
+
+    if ((res->username == NULL
+      || vlc_http_res_set_login(&w->resource, res->username,
+                                res->password) == 0)
+     && vlc_clone(&w->thread, vlc_http_ranges_thread, w,
+                  VLC_THREAD_PRIORITY_INPUT) == 0)
+        return w;
+
+    vlc_http_res_destroy(&w->resource);
+    vlc_http_mgr_destroy(mgr);
+    return NULL;
+}
+
+static void vlc_http_range_worker_destroy(struct vlc_http_range_worker *w)
+{
+    vlc_join(w->thread, NULL);
+
+    struct vlc_http_mgr *mgr = w->resource.manager;
+
+    vlc_http_res_destroy(&w->resource);
+    vlc_http_mgr_destroy(mgr);
+}
+
+struct vlc_http_ranges *vlc_http_ranges_create(vlc_object_t *obj,
+                                               struct vlc_http_cookie_jar_t *jar,
+                                               struct vlc_http_resource *res,
+                                               uintmax_t size, unsigned max)
+{
+    assert(res->response != NULL);
+
+    /* No point in more requests than ranges */
+    if (size / VLC_HTTP_RANGE_SIZE < max)
+        max = (size + VLC_HTTP_RANGE_SIZE - 1) / VLC_HTTP_RANGE_SIZE;
+    if (max < 2)
+        return NULL;
+
+    char *url = vlc_http_res_get_url(res);
+    if (unlikely(url == NULL))
+        return NULL;
+
+    /* One more range than requests, so that the next range can be fetched
+     * while the first one is being read. */
+    struct vlc_http_ranges *r = malloc(sizeof (*r)
+                                       + (max + 1) * sizeof (r->ranges[0]));
+    if (unlikely(r == NULL))
+        goto error;
+
+    r->workers = vlc_alloc(max, sizeof (*r->workers));
+    if (unlikely(r->workers == NULL))
+    {
+        free(r);
+        goto error;
+    }
+
+    const char *etag = vlc_http_msg_get_header(res->response, "ETag");
+    if (etag != NULL && !memcmp(etag, "W/", 2))
+        etag += 2; /* skip weak mark */
+
+    r->obj = obj;
+    r->logger = obj->logger;
+    r->jar = jar;
+    r->etag = (etag != NULL) ? strdup(etag) : NULL;
+    r->mtime = vlc_http_msg_get_mtime(res->response);
+    r->size = size;
+    r->offset = 0;
+    r->next = 0;
+    r->slots = max + 1;
+    r->max = max;
+    r->target = 2;
+    r->active = 0;
+    r->first = 0;
+    r->count = 0;
+    r->closing = false;
+    r->interrupted = false;
+    r->rate_sum = 0;
+    r->rate_count = 0;
+    r->rate = 0;
+    vlc_mutex_init(&r->lock);
+    vlc_cond_init(&r->wait_data);
+    vlc_cond_init(&r->wait_work);
+
+    unsigned count = 0;
+    while (count < max
+        && (r->workers[count] = vlc_http_range_worker_create(r, res,
+                                                             url)) != NULL)
+        count++;
+
+    /* Fall back to fewer workers if some could not be started */
+    vlc_mutex_lock(&r->lock);
+    r->max = count;
+    if (r->target > count)
+        r->target = count;
+    vlc_mutex_unlock(&r->lock);
+
+    if (count < 2)
+    {
+        vlc_http_ranges_destroy(r);
+        r = NULL;
+    }
+    else
+        vlc_http_dbg(r->logger, "up to %u parallel ranges", count);
+
+    free(url);
+    return r;
+error:
+    free(url);
+    return NULL;
+}
+
+void vlc_http_ranges_destroy(struct vlc_http_ranges *r)
+{
+    vlc_mutex_lock(&r->lock);
+    r->closing = true;
+    vlc_http_ranges_flush(r);
+    vlc_cond_broadcast(&r->wait_work);
+    vlc_mutex_unlock(&r->lock);
+
+    for (unsigned i = 0; i < r->max; i++)
+        vlc_http_range_worker_destroy(r->workers[i]);
+
+    vlc_cond_destroy(&r->wait_work);
+    vlc_cond_destroy(&r->wait_data);
+    vlc_mutex_destroy(&r->lock);
+    free(r->workers);
+    free(r->etag);
+    free(r);
+}
@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * ranges.h: HTTP parallel byte ranges
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdint.h>
+
+/**
+ * \defgroup http_ranges Parallel ranges
+ * Concurrent byte range downloads of an HTTP file
+ * \ingroup http_file
+ * @{
+ */
+
+struct vlc_http_ranges;
+struct vlc_http_resource;
+struct vlc_http_cookie_jar_t;
+struct block_t;
+
+/**
+ * Creates a parallel ranges downloader.
+ *
+ * Splits the download of a seekable HTTP file of known size into byte range
+ * requests, each sent over its own connection, and reassembles the data in
+ * order. Connections are kept alive from one range to the next. The number of
+ * concurrent requests adapts to the measured throughput, up to the given
+ * maximum.
+ *
+ * @param obj parent VLC object
+ * @param jar HTTP cookies jar (NULL to disable cookies)
+ * @param res HTTP file resource with a successful response; its URL,
+ *            credentials and entity validators are copied
+ * @param size file size in bytes
+ * @param max maximum number of concurrent range requests
+ *
+ * @return a downloader object pointer, or NULL on error or if the file is
+ *         too small to be split
+ */
+struct vlc_http_ranges *vlc_http_ranges_create(vlc_object_t *obj,
+                                               struct vlc_http_cookie_jar_t *,
+                                               struct vlc_http_resource *res,
+                                               uintmax_t size, unsigned max);
+
+/**
+ * Destroys a parallel ranges downloader.
+ *
+ * Aborts pending requests and closes all connections.
+ */
+void vlc_http_ranges_destroy(struct vlc_http_ranges *);
+
+/**
+ * Sets the read offset.
+ *
+ * Pending range requests are aborted and new ones start from the offset.
+ *
+ * @param offset byte offset of next read
+ * @retval 0 if seek succeeded
+ * @retval -1 if seek failed
+ */
+int vlc_http_ranges_seek(struct vlc_http_ranges *, uintmax_t offset);
+
+/**
+ * Reads data.
+ *
+ * Reads data in order and updates the read offset. This waits for the range
+ * containing the offset if necessary.
+ *
+ * @return a data block, or NULL on end of file, error or interruption
+ */
+struct block_t *vlc_http_ranges_read(struct vlc_http_ranges *);
+
+/** @} */
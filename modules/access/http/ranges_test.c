@@ -0,0 +1,303 @@
+/*****************************************************************************
+ * ranges_test.c: HTTP parallel byte ranges test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include "resource.h"
+#include "file.h"
+#include "ranges.h"
+#include "message.h"
+
+const char vlc_module_name[] = "test_http_ranges";
+
+static const char url[] = "https://www.example.com:8443/dir/file.ext?a=b";
+static const char ua[] = PACKAGE_NAME "/" PACKAGE_VERSION " (test suite)";
+
+#define FILE_SIZE ((5 << 20) + 1234)
+
+static atomic_bool ignore_ranges;
+static atomic_uint requests;
+static atomic_uint streams;
+static atomic_uint max_streams;
+static atomic_int managers;
+
+static unsigned char pattern(uintmax_t offset)
+{
+    return (offset * 7) ^ (offset >> 12);
+}
+
+static uintmax_t check_read(struct vlc_http_ranges *r, uintmax_t offset,
+                            uintmax_t max)
+{
+    uintmax_t end = (max < UINTMAX_MAX - offset) ? offset + max : UINTMAX_MAX;
+    block_t *block;
+
+    while (offset < end && (block = vlc_http_ranges_read(r)) != NULL)
+    {
+        for (size_t i = 0; i < block->i_buffer; i++)
+            assert(block->p_buffer[i] == pattern(offset + i));
+        offset += block->i_buffer;
+        block_Release(block);
+    }
+    return offset;
+}
+
+int main(void)
+{
+    static vlc_object_t obj;
+    struct vlc_http_resource *f;
+    struct vlc_http_ranges *r;
+
+    atomic_init(&requests, 0);
+    atomic_init(&streams, 0);
+    atomic_init(&max_streams, 0);
+    atomic_init(&managers, 0);
+    atomic_init(&ignore_ranges, false);
+
+    f = vlc_http_file_create(NULL, url, ua, NULL);
+    assert(f != NULL);
+    assert(vlc_http_file_can_seek(f));
+    assert(vlc_http_file_get_size(f) == FILE_SIZE);
+
+    /* Too small to be split */
+    r = vlc_http_ranges_create(&obj, NULL, f, 1 << 20, 4);
+    assert(r == NULL);
+    r = vlc_http_ranges_create(&obj, NULL, f, FILE_SIZE, 1);
+    assert(r == NULL);
+
+    /* Sequential read */
+    r = vlc_http_ranges_create(&obj, NULL, f, FILE_SIZE, 4);
+    assert(r != NULL);
+    assert(check_read(r, 0, UINTMAX_MAX) == FILE_SIZE);
+    assert(vlc_http_ranges_read(r) == NULL);
+    assert(atomic_load(&max_streams) <= 4);
+
+    /* Seeks */
+    assert(vlc_http_ranges_seek(r, 3 << 20) == 0);
+    assert(check_read(r, 3 << 20, 100000) >= (3 << 20) + 100000);
+    assert(vlc_http_ranges_seek(r, 12345) == 0);
+    assert(check_read(r, 12345, 3 << 20) >= (3 << 20) + 12345);
+    assert(vlc_http_ranges_seek(r, FILE_SIZE - 10) == 0);
+    assert(check_read(r, FILE_SIZE - 10, UINTMAX_MAX) == FILE_SIZE);
+    assert(vlc_http_ranges_seek(r, FILE_SIZE + 10) == 0);
+    assert(vlc_http_ranges_read(r) == NULL);
+    assert(vlc_http_ranges_seek(r, 1 << 20) == 0);
+    vlc_http_ranges_destroy(r);
+    assert(atomic_load(&streams) == 0);
+
+    /* Server not honoring ranges */
+    r = vlc_http_ranges_create(&obj, NULL, f, FILE_SIZE, 3);
+    assert(r != NULL);
+    atomic_store(&ignore_ranges, true);
+    vlc_http_ranges_seek(r, 1 << 20);
+    assert(check_read(r, 1 << 20, UINTMAX_MAX) < FILE_SIZE);
+    vlc_http_ranges_destroy(r);
+    atomic_store(&ignore_ranges, false);
+
+    vlc_http_file_destroy(f);
+    assert(atomic_load(&streams) == 0);
+    assert(atomic_load(&managers) == 0);
+    return 0;
+}
+
+/* Callback for vlc_http_msg_h2_frame */
+#include "h2frame.h"
+
+struct vlc_h2_frame *
+vlc_h2_frame_headers(uint_fast32_t id, uint_fast32_t mtu, bool eos,
+                     unsigned count, const char *const tab[][2])
+{
+    (void) id; (void) mtu; (void) count, (void) tab;
+    assert(!eos);
+    return NULL;
+}
+
+/* Callbacks for the HTTP connection */
+#include "conn.h"
+
+void vlc_http_err(void *ctx, const char *fmt, ...)
+{
+    (void) ctx; (void) fmt;
+}
+
+void vlc_http_dbg(void *ctx, const char *fmt, ...)
+{
+    (void) ctx; (void) fmt;
+}
+
+struct test_stream
+{
+    struct vlc_http_stream stream;
+    uintmax_t offset;
+    uintmax_t end;
+    uintmax_t fail;
+    bool range;
+};
+
+static struct vlc_http_msg *stream_read_headers(struct vlc_http_stream *s)
+{
+    (void) s;
+    vlc_assert_unreachable();
+}
+
+static struct block_t *stream_read(struct vlc_http_stream *s)
+{
+    struct test_stream *ts = container_of(s, struct test_stream, stream);
+
+    if (ts->offset >= ts->fail)
+        return vlc_http_error;
+    if (ts->offset >= ts->end)
+        return NULL;
+
+    size_t len = 4096;
+    if (len > ts->end - ts->offset)
+        len = ts->end - ts->offset;
+
+    block_t *block = block_Alloc(len);
+    assert(block != NULL);
+    for (size_t i = 0; i < len; i++)
+        block->p_buffer[i] = pattern(ts->offset + i);
+    ts->offset += len;
+    return block;
+}
+
+static void stream_close(struct vlc_http_stream *s, bool abort)
+{
+    struct test_stream *ts = container_of(s, struct test_stream, stream);
+
+    (void) abort;
+    if (ts->range)
+        atomic_fetch_sub(&streams, 1);
+    free(ts);
+}
+
+static const struct vlc_http_stream_cbs stream_callbacks =
+{
+    stream_read_headers,
+    stream_read,
+    stream_close,
+};
+
+#include "connmgr.h"
+
+struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
+                                         struct vlc_http_cookie_jar_t *jar)
+{
+    (void) obj; (void) jar;
+    atomic_fetch_add(&managers, 1);
+    return malloc(1);
+}
+
+void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
+{
+    atomic_fetch_sub(&managers, 1);
+    free(mgr);
+}
+
+struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
+                                          const char *host, unsigned port,
+                                          const struct vlc_http_msg *req)
+{
+    uintmax_t first, last = FILE_SIZE - 1;
+    const char *str;
+
+    assert(https);
+    assert(!strcmp(host, "www.example.com"));
+    assert(port == 8443);
+    str = vlc_http_msg_get_path(req);
+    assert(!strcmp(str, "/dir/file.ext?a=b"));
+    str = vlc_http_msg_get_agent(req);
+    assert(!strcmp(str, ua));
+
+    str = vlc_http_msg_get_header(req, "Range");
+    assert(str != NULL);
+    int n = sscanf(str, "bytes=%" SCNuMAX "-%" SCNuMAX, &first, &last);
+
+    if (mgr != NULL)
+    {   /* Range request */
+        assert(n == 2);
+        assert(first <= last && last < FILE_SIZE);
+        str = vlc_http_msg_get_header(req, "If-Match");
+        assert(str != NULL && !strcmp(str, "\"foobar42\""));
+    }
+    else
+    {   /* Initial request */
+        assert(n == 1);
+        assert(first == 0);
+    }
+
+    struct test_stream *ts = malloc(sizeof (*ts));
+    assert(ts != NULL);
+    ts->stream.cbs = &stream_callbacks;
+    ts->offset = first;
+    ts->end = last + 1;
+    ts->fail = UINTMAX_MAX;
+    ts->range = mgr != NULL;
+
+    /* Break one range half-way to exercise retries */
+    if (atomic_fetch_add(&requests, 1) == 3)
+        ts->fail = first + (last - first) / 2;
+
+    struct vlc_http_msg *m;
+
+    if (atomic_load(&ignore_ranges) && mgr != NULL)
+    {
+        m = vlc_http_resp_create(200);
+        assert(m != NULL);
+    }
+    else
+    {
+        m = vlc_http_resp_create(206);
+        assert(m != NULL);
+        vlc_http_msg_add_header(m, "Content-Range", "bytes %" PRIuMAX "-%"
+                                PRIuMAX "/%u", first, last, (unsigned)FILE_SIZE);
+    }
+    vlc_http_msg_add_header(m, "ETag", "W/\"foobar42\"");
+
+    if (ts->range)
+    {
+        unsigned count = atomic_fetch_add(&streams, 1) + 1;
+        unsigned max = atomic_load(&max_streams);
+        while (count > max
+            && !atomic_compare_exchange_weak(&max_streams, &max, count));
+    }
+
+    vlc_http_msg_attach(m, &ts->stream);
+    return m;
+}
+
+struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
+{
+    (void) mgr;
+    return NULL;
+}
@@ -28,8 +28,10 @@
 #include <vlc_demux.h>
 #include <vlc_block.h>
 #include <vlc_network.h>
+#include <vlc_input_item.h>
 
 #include <limits.h>
+#include <string.h>
 #include <errno.h>
 #include <unistd.h>
 #ifdef HAVE_POLL
@@ -46,6 +48,15 @@
 
 #define DEFAULT_MRU (1500u - (20 + 8))
 
+/* Number of datagrams received per system call */
+#ifdef HAVE_RECVMMSG
+# define RTP_BATCH_MAX 32
+#else
+# define RTP_BATCH_MAX 1
+#endif
+
+#define RTP_STATS_PERIOD VLC_TICK_FROM_SEC(1)
+
 /**
  * Processes a packet received from the RTP socket.
  */
@@ -100,6 +111,45 @@ static int rtp_timeout (vlc_tick_t deadline)
     return t;
 }
 
+/**
+ * Publishes the reception statistics in the input item information.
+ */
+static void rtp_report (demux_t *demux)
+{
+    demux_sys_t *sys = demux->p_sys;
+    input_item_t *item = demux->p_input_item;
+    const char *cat = _("RTP reception");
+    rtp_stats_t stats;
+
+    if (item == NULL)
+        return;
+
+    rtp_session_stats (sys->session, &stats);
+    input_item_AddInfo (item, cat, _("Received packets"), "%"PRIu64,
+                        stats.received);
+    input_item_AddInfo (item, cat, _("Lost packets"), "%"PRIu64,
+                        stats.lost);
+    input_item_AddInfo (item, cat, _("Reordered packets"), "%"PRIu64,
+                        stats.reordered);
+    input_item_AddInfo (item, cat, _("Duplicate packets"), "%"PRIu64,
+                        stats.duplicate);
+    input_item_AddInfo (item, cat, _("Late packets"), "%"PRIu64,
+                        stats.late);
+    input_item_AddInfo (item, cat, _("Jitter"), _("%.2f ms"),
+                        secf_from_vlc_tick (stats.jitter) * 1000.);
+    input_item_AddInfo (item, cat, _("Buffered packets"), "%u",
+                        stats.buffered);
+}
+
+static void rtp_batch_cleanup (void *data)
+{
+    block_t **blocks = data;
+
+    for (unsigned i = 0; i < RTP_BATCH_MAX; i++)
+        if (blocks[i] != NULL)
+            block_Release (blocks[i]);
+}
+
 /**
  * RTP/RTCP session thread for datagram sockets
  */
@@ -108,27 +158,41 @@ void *rtp_dgram_thread (void *opaque)
     demux_t *demux = opaque;
     demux_sys_t *sys = demux->p_sys;
     vlc_tick_t deadline = VLC_TICK_INVALID;
+    vlc_tick_t report = vlc_tick_now () + RTP_STATS_PERIOD;
     int rtp_fd = sys->fd;
 #ifdef __linux__
     const int trunc_flag = MSG_TRUNC;
 #else
     const int trunc_flag = 0;
 #endif
+    size_t mru = DEFAULT_MRU;
+
+    /* Buffers are allocated for a whole batch, those left unused by a
+     * system call are kept for the next one. */
+    block_t *blocks[RTP_BATCH_MAX] = { NULL };
+    struct iovec iov[RTP_BATCH_MAX];
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgv[RTP_BATCH_MAX];
 
-    struct iovec iov =
+    memset (msgv, 0, sizeof (msgv));
+    for (unsigned i = 0; i < RTP_BATCH_MAX; i++)
     {
-        .iov_len = DEFAULT_MRU,
-    };
+        msgv[i].msg_hdr.msg_iov = &iov[i];
+        msgv[i].msg_hdr.msg_iovlen = 1;
+    }
+#else
     struct msghdr msg =
     {
-        .msg_iov = &iov,
+        .msg_iov = iov,
         .msg_iovlen = 1,
     };
+#endif
 
     struct pollfd ufd[1];
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
 
+    vlc_cleanup_push (rtp_batch_cleanup, blocks);
     for (;;)
     {
         int n = poll (ufd, 1, rtp_timeout (deadline));
@@ -145,46 +209,93 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
-            block_t *block = block_Alloc (iov.iov_len);
-            if (unlikely(block == NULL))
+            unsigned count = 0;
+            while (count < RTP_BATCH_MAX)
+            {
+                block_t *block = blocks[count];
+
+                if (block != NULL && block->i_buffer < mru)
+                {   /* MRU has grown since allocation */
+                    block_Release (block);
+                    block = NULL;
+                }
+                if (block == NULL)
+                {
+                    block = blocks[count] = block_Alloc (mru);
+                    if (unlikely(block == NULL))
+                        break;
+                }
+                iov[count].iov_base = block->p_buffer;
+                iov[count].iov_len = block->i_buffer;
+                count++;
+            }
+
+            if (unlikely(count == 0))
             {
-                if (iov.iov_len == DEFAULT_MRU)
+                if (mru == DEFAULT_MRU)
                     break; /* we are totallly screwed */
-                iov.iov_len = DEFAULT_MRU;
-                continue; /* retry with shrunk MRU */
+                mru = DEFAULT_MRU;
+                goto dequeue; /* retry with shrunk MRU */
             }
 
-            iov.iov_base = block->p_buffer;
+#ifdef HAVE_RECVMMSG
+            int val = recvmmsg (rtp_fd, msgv, count,
+                                MSG_DONTWAIT | trunc_flag, NULL);
+#else
             msg.msg_flags = trunc_flag;
 
             ssize_t len = recvmsg (rtp_fd, &msg, trunc_flag);
-            if (len != -1)
+            int val = (len != -1) ? 1 : -1;
+#endif
+            if (val == -1)
             {
-                if (msg.msg_flags & trunc_flag)
+                msg_Warn (demux, "RTP network error: %s",
+                          vlc_strerror_c(errno));
+                goto dequeue;
+            }
+
+            /* All packets of the batch share the same reception time */
+            vlc_tick_t now = vlc_tick_now ();
+
+            for (int i = 0; i < val; i++)
+            {
+                block_t *block = blocks[i];
+#ifdef HAVE_RECVMMSG
+                size_t len = msgv[i].msg_len;
+                int flags = msgv[i].msg_hdr.msg_flags;
+#else
+                int flags = msg.msg_flags;
+#endif
+                blocks[i] = NULL;
+
+                if (flags & trunc_flag)
                 {
-                    msg_Err(demux, "%zd bytes packet truncated (MRU was %zu)",
-                            len, iov.iov_len);
+                    msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                            (size_t)len, block->i_buffer);
                     block->i_flags |= BLOCK_FLAG_CORRUPTED;
-                    iov.iov_len = len;
+                    mru = len;
                 }
                 else
                     block->i_buffer = len;
 
+                block->i_pts = now;
                 rtp_process (demux, block);
             }
-            else
-            {
-                msg_Warn (demux, "RTP network error: %s",
-                          vlc_strerror_c(errno));
-                block_Release (block);
-            }
         }
 
     dequeue:
         if (!rtp_dequeue (demux, sys->session, &deadline))
             deadline = VLC_TICK_INVALID;
+
+        if (vlc_tick_now () >= report)
+        {
+            rtp_report (demux);
+            report = vlc_tick_now () + RTP_STATS_PERIOD;
+        }
         vlc_restorecancel (canc);
     }
+    vlc_cleanup_pop ();
+    rtp_batch_cleanup (blocks);
     return NULL;
 }
 
@@ -222,6 +333,7 @@ void *rtp_stream_thread (void *opaque)
         }
 
         int canc = vlc_savecancel ();
+        block->i_pts = vlc_tick_now ();
         rtp_process (demux, block);
         rtp_dequeue_force (demux, sys->session);
         vlc_restorecancel (canc);
@@ -51,11 +51,24 @@ void xiph_destroy (demux_t *demux, void *data);
 void xiph_decode (demux_t *demux, void *data, block_t *block);
 
 /** @section RTP session */
+/** RTP session reception statistics */
+typedef struct rtp_stats_t
+{
+    uint64_t   received; /**< Packets queued for decoding */
+    uint64_t   lost; /**< Packets missing when their successor was decoded */
+    uint64_t   reordered; /**< Packets received out of sequence order */
+    uint64_t   duplicate; /**< Packets received more than once */
+    uint64_t   late; /**< Packets received after their successor was decoded */
+    vlc_tick_t jitter; /**< Highest interarrival jitter of all sources */
+    unsigned   buffered; /**< Packets in the jitter buffers */
+} rtp_stats_t;
+
 rtp_session_t *rtp_session_create (demux_t *);
 void rtp_session_destroy (demux_t *, rtp_session_t *);
+void rtp_session_stats (const rtp_session_t *, rtp_stats_t *);
 void rtp_queue (demux_t *, rtp_session_t *, block_t *);
-bool rtp_dequeue (demux_t *, const rtp_session_t *, vlc_tick_t *);
-void rtp_dequeue_force (demux_t *, const rtp_session_t *);
+bool rtp_dequeue (demux_t *, rtp_session_t *, vlc_tick_t *);
+void rtp_dequeue_force (demux_t *, rtp_session_t *);
 int rtp_add_type (demux_t *demux, rtp_session_t *ses, const rtp_pt_t *pt);
 
 void *rtp_dgram_thread (void *data);
@@ -74,6 +87,7 @@ typedef struct
     vlc_thread_t  thread;
 
     vlc_tick_t    timeout;
+    vlc_tick_t    jitter_max; /**< Max wait for missing packets */
     uint16_t      max_dropout; /**< Max packet forward misordering */
     uint16_t      max_misorder; /**< Max packet backward misordering */
     uint8_t       max_src; /**< Max simultaneous RTP sources */
@@ -25,6 +25,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -42,6 +43,7 @@ struct rtp_session_t
     unsigned       srcc;
     uint8_t        ptc;
     rtp_pt_t      *ptv;
+    rtp_stats_t    stats;
 };
 
 static rtp_source_t *
@@ -49,7 +51,8 @@ rtp_source_create (demux_t *, const rtp_session_t *, uint32_t, uint16_t);
 static void
 rtp_source_destroy (demux_t *, const rtp_session_t *, rtp_source_t *);
 
-static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
+static void rtp_decode (demux_t *, rtp_session_t *, rtp_source_t *,
+                        block_t *);
 
 /**
  * Creates a new RTP session.
@@ -65,6 +68,7 @@ rtp_session_create (demux_t *demux)
     session->srcc = 0;
     session->ptc = 0;
     session->ptv = NULL;
+    memset (&session->stats, 0, sizeof (session->stats));
 
     (void)demux;
     return session;
@@ -139,6 +143,7 @@ struct rtp_source_t
 {
     uint32_t ssrc;
     uint32_t jitter;  /* interarrival delay jitter estimate */
+    uint32_t frequency; /* RTP clock rate of the jitter estimate */
     vlc_tick_t  last_rx; /* last received packet local timestamp */
     uint32_t last_ts; /* last received packet RTP timestamp */
 
@@ -148,11 +153,19 @@ struct rtp_source_t
     uint16_t bad_seq; /* tentatively next expected sequence for resync */
     uint16_t max_seq; /* next expected sequence */
 
-    uint16_t last_seq; /* sequence of the next dequeued packet */
-    block_t *blocks; /* re-ordered blocks queue */
+    uint16_t last_seq; /* sequence of the last dequeued packet */
+    bool     resync; /* next dequeued packet follows a resynchronization */
+    unsigned count; /* number of packets in the jitter buffer */
+    unsigned mask; /* size of the jitter buffer minus one */
+    block_t **blocks; /* jitter buffer, indexed by sequence number */
     void    *opaque[]; /* Per-source private payload data */
 };
 
+/** Initial jitter buffer size (must be a power of two) */
+#define RTP_JB_MIN 64
+
+static void rtp_source_flush (rtp_source_t *);
+
 /**
  * Initializes a new RTP source within an RTP session.
  */
@@ -166,13 +179,23 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
     if (source == NULL)
         return NULL;
 
+    source->blocks = calloc (RTP_JB_MIN, sizeof (*source->blocks));
+    if (source->blocks == NULL)
+    {
+        free (source);
+        return NULL;
+    }
+
     source->ssrc = ssrc;
     source->jitter = 0;
+    source->frequency = 0;
     source->ref_rtp = 0;
     source->ref_ntp = UINT64_C (1) << 62;
     source->max_seq = source->bad_seq = init_seq;
     source->last_seq = init_seq - 1;
-    source->blocks = NULL;
+    source->resync = false;
+    source->count = 0;
+    source->mask = RTP_JB_MIN - 1;
 
     /* Initializes all payload */
     for (unsigned i = 0; i < session->ptc; i++)
@@ -194,7 +217,8 @@ rtp_source_destroy (demux_t *demux, const rtp_session_t *session,
 
     for (unsigned i = 0; i < session->ptc; i++)
         session->ptv[i].destroy (demux, source->opaque[i]);
-    block_ChainRelease (source->blocks);
+    rtp_source_flush (source);
+    free (source->blocks);
     free (source);
 }
 
@@ -210,6 +234,92 @@ static inline uint32_t rtp_timestamp (const block_t *block)
     return GetDWBE (block->p_buffer + 4);
 }
 
+/**
+ * Releases all packets in the jitter buffer of a source.
+ */
+static void rtp_source_flush (rtp_source_t *src)
+{
+    for (unsigned i = 0; src->count > 0; i++)
+    {
+        assert (i <= src->mask);
+        if (src->blocks[i] != NULL)
+        {
+            block_Release (src->blocks[i]);
+            src->blocks[i] = NULL;
+            src->count--;
+        }
+    }
+}
+
+/**
+ * Enlarges the jitter buffer of a source so that it holds packets up to
+ * the given distance from the next expected packet.
+ */
+static int rtp_source_grow (rtp_source_t *src, uint16_t offset)
+{
+    unsigned size = src->mask + 1;
+
+    assert (offset < 0x8000);
+    while (size <= offset)
+        size *= 2;
+
+    block_t **tab = calloc (size, sizeof (*tab));
+    if (unlikely(tab == NULL))
+        return ENOMEM;
+
+    for (unsigned i = 0; i <= src->mask; i++)
+    {
+        block_t *block = src->blocks[i];
+        if (block != NULL)
+            tab[rtp_seq (block) & (size - 1)] = block;
+    }
+
+    free (src->blocks);
+    src->blocks = tab;
+    src->mask = size - 1;
+    return 0;
+}
+
+/**
+ * Returns the packet with the lowest sequence number in the jitter buffer.
+ * All queued packets follow the last dequeued one by less than the buffer
+ * size, so this only scans the slots of the missing packets, if any.
+ */
+static block_t *rtp_source_first (const rtp_source_t *src)
+{
+    assert (src->count > 0);
+
+    for (uint16_t seq = src->last_seq + 1;; seq++)
+    {
+        block_t *block = src->blocks[seq & src->mask];
+        if (block != NULL)
+            return block;
+    }
+}
+
+/**
+ * Computes how long to wait for a missing packet of a source.
+ */
+static vlc_tick_t rtp_source_delay (const demux_sys_t *sys,
+                                    const rtp_source_t *src)
+{
+    vlc_tick_t delay = 0; /* no jitter estimate with no frequency :( */
+
+    /* Wait for 3 times the inter-arrival delay variance (about 99.7%
+     * match for random gaussian jitter), but not longer than the input
+     * buffering: later packets would not make it in time anyway.
+     */
+    if (src->frequency != 0)
+        delay = vlc_tick_from_samples (3 * src->jitter, src->frequency);
+    if (delay > sys->jitter_max)
+        delay = sys->jitter_max;
+
+    /* Make sure we wait at least for 25 msec */
+    if (delay < VLC_TICK_FROM_MS(25))
+        delay = VLC_TICK_FROM_MS(25);
+    return delay;
+}
+
 static const struct rtp_pt_t *
 rtp_find_ptype (const rtp_session_t *session, rtp_source_t *source,
                 const block_t *block, void **pt_data)
@@ -233,7 +343,8 @@ rtp_find_ptype (const rtp_session_t *session, rtp_source_t *source,
  *
  * @param demux VLC demux object
  * @param session RTP session receiving the packet
- * @param block RTP packet including the RTP header
+ * @param block RTP packet including the RTP header,
+ * with the reception time as PTS
  */
 void
 rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
@@ -256,7 +367,7 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
         block->i_buffer -= padding;
     }
 
-    vlc_tick_t     now = vlc_tick_now ();
+    vlc_tick_t     now = block->i_pts;
     rtp_source_t  *src  = NULL;
     const uint16_t seq  = rtp_seq (block);
     const uint32_t ssrc = GetDWBE (block->p_buffer + 8);
@@ -312,21 +423,22 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
              * That is computed from the RTP timestamps and the system clock.
              * It is independent of RTP sequence. */
             uint32_t freq = pt->frequency;
-            int64_t ts = rtp_timestamp (block);
+            int32_t ts = rtp_timestamp (block) - src->last_ts;
             int64_t d = samples_from_vlc_tick(now - src->last_rx, freq);
-            d        -=    ts - src->last_ts;
+            d        -=    ts;
             if (d < 0) d = -d;
             src->jitter += ((d - src->jitter) + 8) >> 4;
+            src->frequency = freq;
         }
     }
     src->last_rx = now;
-    block->i_pts = now; /* store reception time until dequeued */
     src->last_ts = rtp_timestamp (block);
 
     /* Check sequence number */
     /* NOTE: the sequence number is per-source,
      * but is independent from the payload type. */
     int16_t delta_seq = seq - src->max_seq;
+    bool reordered = false;
     if ((delta_seq > 0) ? (delta_seq > p_sys->max_dropout)
                         : (-delta_seq > p_sys->max_misorder))
     {
@@ -335,10 +447,10 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
         if (seq == src->bad_seq)
         {
             src->max_seq = src->bad_seq = seq + 1;
-            src->last_seq = seq - 0x7fffe; /* hack for rtp_decode() */
+            src->last_seq = seq - 1;
+            src->resync = true;
             msg_Warn (demux, "sequence resynchronized");
-            block_ChainRelease (src->blocks);
-            src->blocks = NULL;
+            rtp_source_flush (src);
         }
         else
         {
@@ -349,26 +461,35 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
     else
     if (delta_seq >= 0)
         src->max_seq = seq + 1;
+    else
+        reordered = true;
+
+    /* Queues the block in the jitter buffer, indexed by sequence number,
+     * hence there is a single buffer for all payload types. */
+    uint16_t offset = seq - (uint16_t)(src->last_seq + 1);
+    if (offset >= 0x8000)
+    {   /* Trash too late packets (and PIM Assert duplicates) */
+        msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")", seq);
+        session->stats.late++;
+        goto drop;
+    }
+    if (offset > src->mask && rtp_source_grow (src, offset))
+        goto drop;
 
-    /* Queues the block in sequence order,
-     * hence there is a single queue for all payload types. */
-    block_t **pp = &src->blocks;
-    for (block_t *prev = *pp; prev != NULL; prev = *pp)
+    block_t **slot = &src->blocks[seq & src->mask];
+    if (*slot != NULL)
     {
-        delta_seq = seq - rtp_seq (prev);
-        if (delta_seq < 0)
-            break;
-        if (delta_seq == 0)
-        {
-            msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
-            goto drop; /* duplicate */
-        }
-        pp = &prev->p_next;
+        msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
+        session->stats.duplicate++;
+        goto drop; /* duplicate */
     }
-    block->p_next = *pp;
-    *pp = block;
+    block->i_pts = now; /* store reception time until dequeued */
+    *slot = block;
+    src->count++;
 
-    /*rtp_decode (demux, session, src);*/
+    session->stats.received++;
+    if (reordered)
+        session->stats.reordered++;
     return;
 
 drop:
@@ -376,8 +497,6 @@ drop:
 }
 
 
-static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
-
 /**
  * Dequeues RTP packets and pass them to decoder. Not cancellation-safe(?).
  * A packet is decoded if it is the next in sequence order, or if we have
@@ -390,9 +509,10 @@ static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
  * @return true if the buffer is not empty, false otherwise.
  * In the later case, *deadlinep is undefined.
  */
-bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
+bool rtp_dequeue (demux_t *demux, rtp_session_t *session,
                   vlc_tick_t *restrict deadlinep)
 {
+    demux_sys_t *p_sys = demux->p_sys;
     vlc_tick_t now = vlc_tick_now ();
     bool pending = false;
 
@@ -401,7 +521,6 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
 
         /* Because of IP packet delay variation (IPDV), we need to guesstimate
          * how long to wait for a missing packet in the RTP sequence
@@ -419,27 +538,17 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
          * LibVLC E/S-out clock synchronization. Here, we need to bother about
          * re-ordering packets, as decoders can't cope with mis-ordered data.
          */
-        while (((block = src->blocks)) != NULL)
+        while (src->count > 0)
         {
-            if ((int16_t)(rtp_seq (block) - (src->last_seq + 1)) <= 0)
-            {   /* Next (or earlier) block ready, no need to wait */
-                rtp_decode (demux, session, src);
+            block_t *block = rtp_source_first (src);
+
+            if (rtp_seq (block) == (uint16_t)(src->last_seq + 1))
+            {   /* Next block ready, no need to wait */
+                rtp_decode (demux, session, src, block);
                 continue;
             }
 
-            /* Wait for 3 times the inter-arrival delay variance (about 99.7%
-             * match for random gaussian jitter).
-             */
-            vlc_tick_t deadline;
-            const rtp_pt_t *pt = rtp_find_ptype (session, src, block, NULL);
-            if (pt)
-                deadline = vlc_tick_from_samples(3 * src->jitter, pt->frequency);
-            else
-                deadline = 0; /* no jitter estimate with no frequency :( */
-
-            /* Make sure we wait at least for 25 msec */
-            if (deadline < VLC_TICK_FROM_MS(25))
-                deadline = VLC_TICK_FROM_MS(25);
+            vlc_tick_t deadline = rtp_source_delay (p_sys, src);
 
             /* Additionnaly, we implicitly wait for the packetization time
              * multiplied by the number of missing packets. block is the first
@@ -449,7 +558,7 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
             deadline += block->i_pts;
             if (now >= deadline)
             {
-                rtp_decode (demux, session, src);
+                rtp_decode (demux, session, src, block);
                 continue;
             }
             if (*deadlinep > deadline)
@@ -465,42 +574,63 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
  * Dequeues all RTP packets and pass them to decoder. Not cancellation-safe(?).
  * This function can be used when the packet source is known not to reorder.
  */
-void rtp_dequeue_force (demux_t *demux, const rtp_session_t *session)
+void rtp_dequeue_force (demux_t *demux, rtp_session_t *session)
 {
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
 
-        while (((block = src->blocks)) != NULL)
-            rtp_decode (demux, session, src);
+        while (src->count > 0)
+            rtp_decode (demux, session, src, rtp_source_first (src));
     }
 }
 
 /**
- * Decodes one RTP packet.
+ * Reports the reception statistics of an RTP session.
  */
-static void
-rtp_decode (demux_t *demux, const rtp_session_t *session, rtp_source_t *src)
+void rtp_session_stats (const rtp_session_t *session, rtp_stats_t *stats)
 {
-    block_t *block = src->blocks;
+    *stats = session->stats;
+
+    for (unsigned i = 0; i < session->srcc; i++)
+    {
+        const rtp_source_t *src = session->srcv[i];
+
+        if (src->frequency != 0)
+        {
+            vlc_tick_t jitter = vlc_tick_from_samples (src->jitter,
+                                                       src->frequency);
+            if (stats->jitter < jitter)
+                stats->jitter = jitter;
+        }
+        stats->buffered += src->count;
+    }
+}
 
-    assert (block);
-    src->blocks = block->p_next;
-    block->p_next = NULL;
+/**
+ * Decodes one RTP packet, removing it from the jitter buffer.
+ */
+static void
+rtp_decode (demux_t *demux, rtp_session_t *session, rtp_source_t *src,
+            block_t *block)
+{
+    assert (src->blocks[rtp_seq (block) & src->mask] == block);
+    src->blocks[rtp_seq (block) & src->mask] = NULL;
+    src->count--;
 
     /* Discontinuity detection */
     uint16_t delta_seq = rtp_seq (block) - (src->last_seq + 1);
+    assert (delta_seq < 0x8000); /* late packets are not queued */
     if (delta_seq != 0)
     {
-        if (delta_seq >= 0x8000)
-        {   /* Trash too late packets (and PIM Assert duplicates) */
-            msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")",
-                      rtp_seq (block));
-            goto drop;
-        }
         msg_Warn (demux, "%"PRIu16" packet(s) lost", delta_seq);
+        session->stats.lost += delta_seq;
+        block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+    }
+    if (src->resync)
+    {
         block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        src->resync = false;
     }
     src->last_seq = rtp_seq (block);
 
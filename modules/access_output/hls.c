@@ -0,0 +1,492 @@
+/*****************************************************************************
+ * hls.c: HTTP Live Streaming origin server
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include <vlc_httpd.h>
+#include <vlc_interrupt.h>
+#include <vlc_memstream.h>
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define SOUT_CFG_PREFIX "sout-hls-"
+
+#define SEGLEN_TEXT N_("Segment length")
+#define SEGLEN_LONGTEXT N_("Length of the TS stream segments, in seconds.")
+#define NUMSEGS_TEXT N_("Number of segments")
+#define NUMSEGS_LONGTEXT N_("Number of segments listed in the playlist.")
+#define SPLITANYWHERE_TEXT N_("Split segments anywhere")
+#define SPLITANYWHERE_LONGTEXT N_("Don't require a keyframe before splitting "\
+                                  "a segment. Needed for audio only.")
+
+vlc_module_begin ()
+    set_description( N_("HTTP Live Streaming origin server") )
+    set_shortname( N_("HLS origin") )
+    set_capability( "sout access", 0 )
+    add_shortcut( "hls" )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_ACO )
+    add_integer( SOUT_CFG_PREFIX "seglen", 4, SEGLEN_TEXT, SEGLEN_LONGTEXT,
+                 false )
+        change_integer_range( 1, 60 )
+    add_integer( SOUT_CFG_PREFIX "numsegs", 5, NUMSEGS_TEXT, NUMSEGS_LONGTEXT,
+                 false )
+        change_integer_range( 2, 100 )
+    add_bool( SOUT_CFG_PREFIX "splitanywhere", false,
+              SPLITANYWHERE_TEXT, SPLITANYWHERE_LONGTEXT, true )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Exported prototypes
+ *****************************************************************************/
+static const char *const ppsz_sout_options[] = {
+    "seglen",
+    "numsegs",
+    "splitanywhere",
+    NULL
+};
+
+/* Segments removed from the playlist remain available for a while, for the
+ * clients that have just fetched the previous version of the playlist. */
+#define EXTRA_SEGMENTS 2
+
+typedef struct
+{
+    httpd_block_t   *p_block;       /* served segment data, immutable */
+    vlc_tick_t       i_length;
+    uint32_t         i_number;
+} hls_segment_t;
+
+typedef struct
+{
+    httpd_host_t    *p_host;
+    httpd_handler_t *p_playlist_handler;
+    char            *psz_base;      /* segment URL path, without the number */
+    const char      *psz_name;      /* segment file name, within psz_base */
+
+    vlc_mutex_t      lock;
+    char            *psz_playlist;  /* current playlist, protected by lock */
+    size_t           i_playlist;
+    unsigned         i_playlist_max_age;
+
+    vlc_array_t      segments;      /* published segments, oldest first */
+    block_t         *p_current;     /* segment being gathered */
+    block_t        **pp_current_last;
+    vlc_tick_t       i_current_length;
+    uint32_t         i_sequence;    /* number of the next segment */
+
+    vlc_tick_t       i_seglen;
+    unsigned         i_numsegs;
+    bool             b_splitanywhere;
+} sout_access_out_sys_t;
+
+static ssize_t Write( sout_access_out_t *, block_t * );
+static int Control( sout_access_out_t *, int, va_list );
+
+/*****************************************************************************
+ * HTTP handlers
+ *****************************************************************************/
+static void Respond( uint8_t **pp_data, int *pi_data, const char *psz_type,
+                     unsigned i_max_age, const void *p_body, size_t i_body )
+{
+    char *psz_header;
+    int i_header;
+
+    if( p_body != NULL )
+        i_header = asprintf( &psz_header, "HTTP/1.1 200 OK\r\n"
+                             "Content-Type: %s\r\n"
+                             "Content-Length: %zu\r\n"
+                             "Cache-Control: max-age=%u\r\n"
+                             "Access-Control-Allow-Origin: *\r\n"
+                             "\r\n", psz_type, i_body, i_max_age );
+    else
+        i_header = asprintf( &psz_header, "HTTP/1.1 404 Not Found\r\n"
+                             "Content-Length: 0\r\n"
+                             "Cache-Control: no-cache\r\n"
+                             "\r\n" );
+    if( i_header < 0 )
+    {
+        *pp_data = NULL;
+        *pi_data = 0;
+        return;
+    }
+
+    uint8_t *p_data = malloc( i_header + i_body );
+    if( unlikely(p_data == NULL) )
+    {
+        free( psz_header );
+        *pp_data = NULL;
+        *pi_data = 0;
+        return;
+    }
+
+    memcpy( p_data, psz_header, i_header );
+    if( i_body > 0 )
+        memcpy( p_data + i_header, p_body, i_body );
+    free( psz_header );
+
+    *pp_data = p_data;
+    *pi_data = i_header + i_body;
+}
+
+static int PlaylistHandler( void *opaque, httpd_handler_t *handler,
+                            char *psz_url, uint8_t *psz_request, int i_type,
+                            uint8_t *p_in, int i_in, char *psz_remote_addr,
+                            char *psz_remote_host, uint8_t **pp_data,
+                            int *pi_data )
+{
+    sout_access_out_sys_t *p_sys = opaque;
+
+    (void) handler; (void) psz_url; (void) psz_request; (void) i_type;
+    (void) p_in; (void) i_in; (void) psz_remote_addr; (void) psz_remote_host;
+
+    vlc_mutex_lock( &p_sys->lock );
+    Respond( pp_data, pi_data, "application/vnd.apple.mpegurl",
+             p_sys->i_playlist_max_age, p_sys->psz_playlist,
+             p_sys->i_playlist );
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Segments and playlist
+ *****************************************************************************/
+static void DestroySegment( hls_segment_t *segment )
+{
+    httpd_BlockDelete( segment->p_block );
+    free( segment );
+}
+
+static void UpdatePlaylist( sout_access_out_t *p_access, bool b_end )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_count = vlc_array_count( &p_sys->segments );
+    size_t i_first = 0;
+    vlc_tick_t i_target = p_sys->i_seglen;
+    struct vlc_memstream ms;
+
+    if( i_count > p_sys->i_numsegs )
+        i_first = i_count - p_sys->i_numsegs;
+
+    for( size_t i = i_first; i < i_count; i++ )
+    {
+        const hls_segment_t *segment =
+            vlc_array_item_at_index( &p_sys->segments, i );
+        i_target = __MAX( i_target, segment->i_length );
+    }
+
+    if( vlc_memstream_open( &ms ) )
+        return;
+
+    vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-VERSION:3\n"
+                          "#EXT-X-TARGETDURATION:%"PRId64"\n",
+                          SEC_FROM_VLC_TICK( i_target + VLC_TICK_FROM_SEC(1)
+                                             - 1 ) );
+
+    for( size_t i = i_first; i < i_count; i++ )
+    {
+        const hls_segment_t *segment =
+            vlc_array_item_at_index( &p_sys->segments, i );
+        int64_t i_ms = MS_FROM_VLC_TICK( segment->i_length );
+
+        if( i == i_first )
+            vlc_memstream_printf( &ms, "#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n",
+                                  segment->i_number );
+        vlc_memstream_printf( &ms, "#EXTINF:%"PRId64".%03u,\n%s%"PRIu32".ts\n",
+                              i_ms / 1000, (unsigned)(i_ms % 1000),
+                              p_sys->psz_name, segment->i_number );
+    }
+
+    if( b_end )
+        vlc_memstream_puts( &ms, "#EXT-X-ENDLIST\n" );
+
+    if( vlc_memstream_close( &ms ) )
+        return;
+
+    vlc_mutex_lock( &p_sys->lock );
+    char *psz_old = p_sys->psz_playlist;
+    p_sys->psz_playlist = ms.ptr;
+    p_sys->i_playlist = ms.length;
+    vlc_mutex_unlock( &p_sys->lock );
+    free( psz_old );
+}
+
+/*****************************************************************************
+ * PublishSegment: make the gathered data available as a new segment
+ *****************************************************************************/
+static void PublishSegment( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    block_t *p_data = block_ChainGather( p_sys->p_current );
+
+    p_sys->p_current = NULL;
+    p_sys->pp_current_last = &p_sys->p_current;
+
+    if( unlikely(p_data == NULL) )
+        return;
+
+    hls_segment_t *segment = malloc( sizeof( *segment ) );
+    char *psz_url;
+    if( unlikely(segment == NULL)
+     || asprintf( &psz_url, "%s%"PRIu32".ts", p_sys->psz_base,
+                  p_sys->i_sequence ) < 0 )
+    {
+        free( segment );
+        block_Release( p_data );
+        return;
+    }
+
+    segment->i_length = p_sys->i_current_length;
+    segment->i_number = p_sys->i_sequence++;
+    p_sys->i_current_length = 0;
+
+    /* the segment is immutable, and gone after the playlist window */
+    char psz_cache[32];
+    snprintf( psz_cache, sizeof( psz_cache ), "max-age=%"PRId64,
+              SEC_FROM_VLC_TICK( p_sys->i_seglen )
+              * ( p_sys->i_numsegs + EXTRA_SEGMENTS ) );
+
+    const httpd_header headers[] = {
+        { (char *)"Cache-Control", psz_cache },
+        { (char *)"Access-Control-Allow-Origin", (char *)"*" },
+    };
+
+    /* The clients are served from the segment block, without copying */
+    segment->p_block = httpd_BlockNew( p_sys->p_host, psz_url, "video/MP2T",
+                                       headers, ARRAY_SIZE(headers), p_data );
+    if( segment->p_block == NULL )
+    {
+        msg_Err( p_access, "cannot add segment %s", psz_url );
+        free( psz_url );
+        free( segment );
+        return;
+    }
+    msg_Dbg( p_access, "segment %s published (%"PRId64" ms)", psz_url,
+             MS_FROM_VLC_TICK( segment->i_length ) );
+    free( psz_url );
+
+    if( vlc_array_append( &p_sys->segments, segment ) )
+    {
+        DestroySegment( segment );
+        return;
+    }
+
+    UpdatePlaylist( p_access, false );
+
+    /* Segments are deleted last: they may be running with the httpd lock */
+    while( vlc_array_count( &p_sys->segments )
+                                        > p_sys->i_numsegs + EXTRA_SEGMENTS )
+    {
+        hls_segment_t *old = vlc_array_item_at_index( &p_sys->segments, 0 );
+
+        vlc_array_remove( &p_sys->segments, 0 );
+        DestroySegment( old );
+    }
+}
+
+/*****************************************************************************
+ * Open: open the origin server
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    sout_access_out_t       *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t   *p_sys;
+
+    config_ChainParse( p_access, SOUT_CFG_PREFIX, ppsz_sout_options, p_access->p_cfg );
+
+    /* [host][:port]/path/name.m3u8, like the HTTP output */
+    const char *path = p_access->psz_path;
+    path += strcspn( path, "/" );
+    if( path > p_access->psz_path )
+    {
+        const char *port = strrchr( p_access->psz_path, ':' );
+        if( port != NULL && strchr( port, ']' ) != NULL )
+            port = NULL; /* IPv6 numeral */
+        if( port != p_access->psz_path )
+        {
+            int len = (port ? port : path) - p_access->psz_path;
+            char host[len + 1];
+
+            strncpy( host, p_access->psz_path, len );
+            host[len] = '\0';
+            var_Create( p_access, "http-host", VLC_VAR_STRING );
+            var_SetString( p_access, "http-host", host );
+        }
+        if( port != NULL && atoi( port + 1 ) > 0 )
+        {
+            var_Create( p_access, "http-port", VLC_VAR_INTEGER );
+            var_SetInteger( p_access, "http-port", atoi( port + 1 ) );
+        }
+    }
+    if( *path == '\0' )
+        path = "/live.m3u8";
+
+    if( unlikely( !( p_sys = calloc( 1, sizeof( *p_sys ) ) ) ) )
+        return VLC_ENOMEM;
+
+    /* Segments are served next to the playlist: name.m3u8 -> name-N.ts */
+    const char *ext = strrchr( path, '.' );
+    if( ext == NULL || strchr( ext, '/' ) != NULL )
+        ext = path + strlen( path );
+    if( asprintf( &p_sys->psz_base, "%.*s-", (int)(ext - path), path ) < 0 )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->psz_name = strrchr( p_sys->psz_base, '/' ) + 1;
+
+    p_sys->i_seglen = vlc_tick_from_sec(
+                    var_GetInteger( p_access, SOUT_CFG_PREFIX "seglen" ) );
+    p_sys->i_numsegs = var_GetInteger( p_access, SOUT_CFG_PREFIX "numsegs" );
+    p_sys->b_splitanywhere = var_GetBool( p_access,
+                                          SOUT_CFG_PREFIX "splitanywhere" );
+    /* clients refresh the playlist about once per segment */
+    p_sys->i_playlist_max_age = SEC_FROM_VLC_TICK( p_sys->i_seglen ) / 2;
+
+    vlc_mutex_init( &p_sys->lock );
+    vlc_array_init( &p_sys->segments );
+    p_sys->pp_current_last = &p_sys->p_current;
+    p_sys->i_sequence = 1;
+    p_access->p_sys = p_sys;
+
+    p_sys->p_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+    if( p_sys->p_host == NULL )
+    {
+        msg_Err( p_access, "cannot start HTTP server" );
+        goto error;
+    }
+
+    p_sys->p_playlist_handler = httpd_HandlerNew( p_sys->p_host, path,
+                                                  NULL, NULL,
+                                                  PlaylistHandler, p_sys );
+    if( p_sys->p_playlist_handler == NULL )
+    {
+        msg_Err( p_access, "cannot add playlist %s", path );
+        httpd_HostDelete( p_sys->p_host );
+        goto error;
+    }
+
+    p_access->pf_write       = Write;
+    p_access->pf_control     = Control;
+    return VLC_SUCCESS;
+
+error:
+    vlc_mutex_destroy( &p_sys->lock );
+    free( p_sys->psz_base );
+    free( p_sys );
+    return VLC_EGENERIC;
+}
+
+/*****************************************************************************
+ * Close: close the origin server
+ *****************************************************************************/
+static void Close( vlc_object_t * p_this )
+{
+    sout_access_out_t       *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t   *p_sys = p_access->p_sys;
+
+    /* Publish the last segment, and tell the clients the stream ended */
+    if( p_sys->p_current != NULL )
+        PublishSegment( p_access );
+    UpdatePlaylist( p_access, true );
+
+    /* Keep serving for one target duration, so that the clients polling the
+     * playlist get to see its end */
+    vlc_msleep_i11e( p_sys->i_seglen );
+
+    httpd_HandlerDelete( p_sys->p_playlist_handler );
+
+    for( size_t i = 0; i < vlc_array_count( &p_sys->segments ); i++ )
+        DestroySegment( vlc_array_item_at_index( &p_sys->segments, i ) );
+    vlc_array_clear( &p_sys->segments );
+    block_ChainRelease( p_sys->p_current );
+
+    httpd_HostDelete( p_sys->p_host );
+
+    vlc_mutex_destroy( &p_sys->lock );
+    free( p_sys->psz_playlist );
+    free( p_sys->psz_base );
+    free( p_sys );
+}
+
+static int Control( sout_access_out_t *p_access, int i_query, va_list args )
+{
+    (void)p_access;
+
+    switch( i_query )
+    {
+        case ACCESS_OUT_CONTROLS_PACE:
+            *va_arg( args, bool * ) = false;
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Write: gather the data into segments
+ *****************************************************************************/
+static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_write = 0;
+
+    while( p_buffer )
+    {
+        block_t *p_next = p_buffer->p_next;
+        p_buffer->p_next = NULL;
+
+        /* Start a new segment on the PAT/PMT the TS muxer repeats before
+         * each keyframe, once the current one is long enough, so that every
+         * segment can be decoded on its own */
+        if( p_sys->p_current != NULL
+         && p_sys->i_current_length >= p_sys->i_seglen
+         && ( p_sys->b_splitanywhere
+           || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
+            PublishSegment( p_access );
+
+        i_write += p_buffer->i_buffer;
+        p_sys->i_current_length += p_buffer->i_length;
+        block_ChainLastAppend( &p_sys->pp_current_last, p_buffer );
+        p_buffer = p_next;
+    }
+
+    return i_write;
+}
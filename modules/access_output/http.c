@@ -390,9 +390,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                 /* send the combined header here instead of sending them as regular
                  * data, so that we get them as a single Metacube header block */
                 httpd_StreamHeader( p_sys->p_httpd_stream, p_hdr_block->p_buffer, p_hdr_block->i_buffer );
-                httpd_StreamSend( p_sys->p_httpd_stream, p_hdr_block );
-
-                block_Release( p_hdr_block );
+                httpd_StreamSendBlock( p_sys->p_httpd_stream, p_hdr_block );
             }
             else
             {
@@ -438,10 +436,10 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
             memcpy( p_buffer->p_buffer, &hdr, sizeof( hdr ) );
         }
 
-        /* send data */
-        i_err = httpd_StreamSend( p_sys->p_httpd_stream, p_buffer );
+        /* send data, the block is shared by the clients */
+        p_buffer->p_next = NULL;
+        i_err = httpd_StreamSendBlock( p_sys->p_httpd_stream, p_buffer );
 
-        block_Release( p_buffer );
         p_buffer = p_next;
 
         if( i_err < 0 )
@@ -28,7 +28,7 @@
 #include <vlc_block.h>
 #include <vlc_meta.h>
 #include <algorithm>
-#include <set>
+#include <new>
 
 using namespace adaptive;
 
@@ -41,9 +41,13 @@ enum
     ES_OUT_PRIVATE_COMMAND_DISCONTINUITY
 };
 
+/* Max number of recycled commands kept per pool */
+#define COMMANDS_POOL_MAX 8192
+
 AbstractCommand::AbstractCommand( int type_ )
 {
     type = type_;
+    prev = next = NULL;
 }
 
 AbstractCommand::~AbstractCommand()
@@ -61,6 +65,90 @@ int AbstractCommand::getType() const
     return type;
 }
 
+AbstractCommand * AbstractCommand::nextCommand() const
+{
+    return next;
+}
+
+CommandsList::CommandsList()
+{
+    head = tail = NULL;
+}
+
+bool CommandsList::empty() const
+{
+    return head == NULL;
+}
+
+AbstractCommand * CommandsList::front() const
+{
+    return head;
+}
+
+void CommandsList::insert_after( AbstractCommand *pos, AbstractCommand *command )
+{
+    command->prev = pos;
+    command->next = pos ? pos->next : head;
+    if( command->next )
+        command->next->prev = command;
+    else
+        tail = command;
+    if( pos )
+        pos->next = command;
+    else
+        head = command;
+}
+
+void CommandsList::push_back( AbstractCommand *command )
+{
+    insert_after( tail, command );
+}
+
+void CommandsList::push_sorted( AbstractCommand *command )
+{
+    /* Blocks mostly arrive in order, or interleaved by a few ES,
+       so walking back from the tail is cheaper than sorting on commit.
+       Non dated commands are kept in order and act as barriers. */
+    const vlc_tick_t time = command->getTime();
+    AbstractCommand *pos = tail;
+    if( time != VLC_TICK_INVALID )
+    {
+        while( pos && pos->getTime() != VLC_TICK_INVALID &&
+               pos->getTime() > time )
+            pos = pos->prev;
+    }
+    insert_after( pos, command );
+}
+
+AbstractCommand * CommandsList::pop_front()
+{
+    AbstractCommand *command = head;
+    if( command )
+    {
+        head = command->next;
+        if( head )
+            head->prev = NULL;
+        else
+            tail = NULL;
+        command->prev = command->next = NULL;
+    }
+    return command;
+}
+
+void CommandsList::splice( CommandsList &other )
+{
+    if( other.empty() )
+        return;
+    if( tail )
+    {
+        tail->next = other.head;
+        other.head->prev = tail;
+    }
+    else head = other.head;
+    tail = other.tail;
+    other.head = other.tail = NULL;
+}
+
 AbstractFakeEsCommand::AbstractFakeEsCommand( int type, FakeESOutID *p_es ) :
     AbstractCommand( type )
 {
@@ -185,8 +273,36 @@ void EsOutMetaCommand::Execute( es_out_t *out )
  * Commands Default Factory
  */
 
+CommandsFactory::CommandsFactory()
+{
+    vlc_mutex_init(&lock);
+    i_sendpool = 0;
+    i_pcrpool = 0;
+}
+
+CommandsFactory::~CommandsFactory()
+{
+    while( !sendpool.empty() )
+        delete sendpool.pop_front();
+    while( !pcrpool.empty() )
+        delete pcrpool.pop_front();
+    vlc_mutex_destroy(&lock);
+}
+
 EsOutSendCommand * CommandsFactory::createEsOutSendCommand( FakeESOutID *id, block_t *p_block ) const
 {
+    vlc_mutex_lock(&lock);
+    EsOutSendCommand *command = static_cast<EsOutSendCommand *>(sendpool.pop_front());
+    if( command )
+        i_sendpool--;
+    vlc_mutex_unlock(&lock);
+
+    if( command )
+    {
+        command->p_fakeid = id;
+        command->p_block = p_block;
+        return command;
+    }
     return new (std::nothrow) EsOutSendCommand( id, p_block );
 }
 
@@ -202,6 +318,18 @@ EsOutAddCommand * CommandsFactory::createEsOutAddCommand( FakeESOutID *id ) cons
 
 EsOutControlPCRCommand * CommandsFactory::createEsOutControlPCRCommand( int group, vlc_tick_t pcr ) const
 {
+    vlc_mutex_lock(&lock);
+    EsOutControlPCRCommand *command = static_cast<EsOutControlPCRCommand *>(pcrpool.pop_front());
+    if( command )
+        i_pcrpool--;
+    vlc_mutex_unlock(&lock);
+
+    if( command )
+    {
+        command->group = group;
+        command->pcr = pcr;
+        return command;
+    }
     return new (std::nothrow) EsOutControlPCRCommand( group, pcr );
 }
 
@@ -226,14 +354,52 @@ EsOutMetaCommand * CommandsFactory::createEsOutMetaCommand( int group, const vlc
     return NULL;
 }
 
+void CommandsFactory::releaseCommand( AbstractCommand *command ) const
+{
+    switch( command->getType() )
+    {
+        case ES_OUT_PRIVATE_COMMAND_SEND:
+        {
+            EsOutSendCommand *sendcommand = static_cast<EsOutSendCommand *>(command);
+            if( sendcommand->p_block )
+            {
+                block_Release( sendcommand->p_block );
+                sendcommand->p_block = NULL;
+            }
+            vlc_mutex_lock(&lock);
+            if( i_sendpool < COMMANDS_POOL_MAX )
+            {
+                sendpool.push_back( command );
+                i_sendpool++;
+                command = NULL;
+            }
+            vlc_mutex_unlock(&lock);
+            break;
+        }
+        case ES_OUT_SET_GROUP_PCR:
+            vlc_mutex_lock(&lock);
+            if( i_pcrpool < COMMANDS_POOL_MAX )
+            {
+                pcrpool.push_back( command );
+                i_pcrpool++;
+                command = NULL;
+            }
+            vlc_mutex_unlock(&lock);
+            break;
+        default:
+            break;
+    }
+    delete command;
+}
+
 /*
  * Commands Queue management
  */
 #if 0
 /* For queue printing/debugging */
-std::ostream& operator<<(std::ostream& ostr, const std::list<AbstractCommand *>& list)
+std::ostream& operator<<(std::ostream& ostr, const CommandsList& list)
 {
-    for (auto &i : list) {
+    for (const AbstractCommand *i = list.front(); i; i = i->nextCommand()) {
         ostr << "[" << i->getType() << "]" << SEC_FROM_VLC_TICK(i->getTime()) << " ";
     }
     return ostr;
@@ -256,25 +422,11 @@ CommandsQueue::~CommandsQueue()
     delete commandsFactory;
 }
 
-static bool compareCommands( AbstractCommand *a, AbstractCommand *b )
-{
-    if(a->getTime() == b->getTime())
-    {
-        /* Reorder the initial clock PCR setting PCR0 DTS0 PCR0 DTS1 PCR1
-           so it appears after the block, avoiding it not being output */
-        if(a->getType() == ES_OUT_SET_GROUP_PCR &&
-           b->getType() == ES_OUT_PRIVATE_COMMAND_SEND)
-            return false;
-        return true;
-    }
-    else return (a->getTime() < b->getTime() && a->getTime() != VLC_TICK_INVALID);
-}
-
 void CommandsQueue::Schedule( AbstractCommand *command )
 {
     if( b_drop )
     {
-        delete command;
+        commandsFactory->releaseCommand( command );
     }
     else if( command->getType() == ES_OUT_SET_GROUP_PCR )
     {
@@ -284,7 +436,8 @@ void CommandsQueue::Schedule( AbstractCommand *command )
     }
     else
     {
-        incoming.push_back( command );
+        /* reorder all blocks by time between 2 PCR */
+        incoming.push_sorted( command );
     }
 }
 
@@ -296,7 +449,6 @@ const CommandsFactory * CommandsQueue::factory() const
 vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
 {
     vlc_tick_t lastdts = barrier;
-    std::set<const void *> disabled_esids;
     bool b_datasent = false;
 
     /* We need to filter the current commands list
@@ -306,11 +458,11 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
        ex: for a target time of 2, you must dequeue <= 2 until >= PCR2
        A0,A1,A2,B0,PCR0,B1,B2,PCR2,B3,A3,PCR3
     */
-    std::list<AbstractCommand *> output;
-    std::list<AbstractCommand *> in;
-
+    CommandsList output;
+    CommandsList in;
 
-    in.splice( in.end(), commands );
+    disabled_esids.clear();
+    in.splice( commands );
 
     while( !in.empty() )
     {
@@ -330,21 +482,22 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
         {
-            EsOutSendCommand *sendcommand = dynamic_cast<EsOutSendCommand *>(command);
+            EsOutSendCommand *sendcommand = static_cast<EsOutSendCommand *>(command);
             /* We need a stream identifier to send NON DATED data following DATA for the same ES */
-            const void *id = (sendcommand) ? sendcommand->esIdentifier() : 0;
+            const void *id = sendcommand->esIdentifier();
 
             /* Not for now */
             if( command->getTime() > barrier ) /* Not for now */
             {
                 /* ensure no more non dated for that ES is sent
                  * since we're sure that data is above barrier */
-                disabled_esids.insert( id );
+                if( std::find( disabled_esids.begin(), disabled_esids.end(), id ) == disabled_esids.end() )
+                    disabled_esids.push_back( id );
                 commands.push_back( command );
             }
             else if( command->getTime() == VLC_TICK_INVALID )
             {
-                if( disabled_esids.find( id ) == disabled_esids.end() )
+                if( std::find( disabled_esids.begin(), disabled_esids.end(), id ) == disabled_esids.end() )
                     output.push_back( command );
                 else
                     commands.push_back( command );
@@ -358,7 +511,7 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
     }
 
     /* push remaining ones if broke above */
-    commands.splice( commands.end(), in );
+    commands.splice( in );
 
     if(commands.empty() && b_draining)
         b_draining = false;
@@ -366,8 +519,7 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
     /* Now execute our selected commands */
     while( !output.empty() )
     {
-        AbstractCommand *command = output.front();
-        output.pop_front();
+        AbstractCommand *command = output.pop_front();
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
         {
@@ -377,7 +529,7 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
         }
 
         command->Execute( out );
-        delete command;
+        commandsFactory->releaseCommand( command );
     }
     pcr = lastdts; /* Warn! no PCR update/lock release until execution */
 
@@ -387,9 +539,8 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
 
 void CommandsQueue::LockedCommit()
 {
-    /* reorder all blocks by time between 2 PCR and merge with main list */
-    incoming.sort( compareCommands );
-    commands.splice( commands.end(), incoming );
+    /* incoming is kept sorted on scheduling, merge with main list */
+    commands.splice( incoming );
 }
 
 void CommandsQueue::Commit()
@@ -399,12 +550,9 @@ void CommandsQueue::Commit()
 
 void CommandsQueue::Abort( bool b_reset )
 {
-    commands.splice( commands.end(), incoming );
+    commands.splice( incoming );
     while( !commands.empty() )
-    {
-        delete commands.front();
-        commands.pop_front();
-    }
+        commandsFactory->releaseCommand( commands.pop_front() );
 
     if( b_reset )
     {
@@ -466,11 +614,11 @@ vlc_tick_t CommandsQueue::getBufferingLevel() const
 
 vlc_tick_t CommandsQueue::getFirstDTS() const
 {
-    std::list<AbstractCommand *>::const_iterator it;
     vlc_tick_t i_firstdts = pcr;
-    for( it = commands.begin(); it != commands.end(); ++it )
+    for( const AbstractCommand *command = commands.front(); command;
+         command = command->nextCommand() )
     {
-        const vlc_tick_t i_dts = (*it)->getTime();
+        const vlc_tick_t i_dts = command->getTime();
         if( i_dts != VLC_TICK_INVALID )
         {
             if( i_dts < i_firstdts || i_firstdts == VLC_TICK_INVALID )
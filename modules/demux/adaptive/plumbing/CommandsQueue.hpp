@@ -24,7 +24,7 @@
 #include <vlc_es.h>
 
 #include <atomic>
-#include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -34,15 +34,40 @@ namespace adaptive
     class AbstractCommand
     {
         friend class CommandsFactory;
+        friend class CommandsList;
         public:
             virtual ~AbstractCommand();
             virtual void Execute( es_out_t * ) = 0;
             virtual vlc_tick_t getTime() const;
             int getType() const;
+            AbstractCommand * nextCommand() const;
 
         protected:
             AbstractCommand( int );
             int type;
+
+        private:
+            /* intrusive linkage, a command is only ever in one list */
+            AbstractCommand *prev;
+            AbstractCommand *next;
+    };
+
+    /* Intrusive list, so queuing a command never allocates */
+    class CommandsList
+    {
+        public:
+            CommandsList();
+            bool empty() const;
+            AbstractCommand * front() const;
+            void push_back( AbstractCommand * );
+            void push_sorted( AbstractCommand * );
+            AbstractCommand * pop_front();
+            void splice( CommandsList & );
+
+        private:
+            void insert_after( AbstractCommand *, AbstractCommand * );
+            AbstractCommand *head;
+            AbstractCommand *tail;
     };
 
     class AbstractFakeEsCommand : public AbstractCommand
@@ -133,11 +158,14 @@ namespace adaptive
             vlc_meta_t *p_meta;
     };
 
-    /* Factory so we can alter behaviour and filter on execution */
+    /* Factory so we can alter behaviour and filter on execution.
+       Per packet commands are recycled, so overriding their creation
+       also requires overriding releaseCommand() */
     class CommandsFactory
     {
         public:
-            virtual ~CommandsFactory() {}
+            CommandsFactory();
+            virtual ~CommandsFactory();
             virtual EsOutSendCommand * createEsOutSendCommand( FakeESOutID *, block_t * ) const;
             virtual EsOutDelCommand * createEsOutDelCommand( FakeESOutID * ) const;
             virtual EsOutAddCommand * createEsOutAddCommand( FakeESOutID * ) const;
@@ -145,6 +173,15 @@ namespace adaptive
             virtual EsOutControlResetPCRCommand * creatEsOutControlResetPCRCommand() const;
             virtual EsOutDestroyCommand * createEsOutDestroyCommand() const;
             virtual EsOutMetaCommand * createEsOutMetaCommand( int, const vlc_meta_t * ) const;
+            virtual void releaseCommand( AbstractCommand * ) const;
+
+        private:
+            /* Created by the demux side, released by the dequeuing side */
+            mutable vlc_mutex_t lock;
+            mutable CommandsList sendpool;
+            mutable CommandsList pcrpool;
+            mutable size_t i_sendpool;
+            mutable size_t i_pcrpool;
     };
 
     /* Queuing for doing all the stuff in order */
@@ -173,8 +210,9 @@ namespace adaptive
             CommandsFactory *commandsFactory;
             void LockedCommit();
             void LockedSetDraining();
-            std::list<AbstractCommand *> incoming;
-            std::list<AbstractCommand *> commands;
+            CommandsList incoming;
+            CommandsList commands;
+            std::vector<const void *> disabled_esids;
             vlc_tick_t bufferinglevel;
             vlc_tick_t pcr;
             bool b_draining;
@@ -396,7 +396,9 @@ CreateVideoBlock(demux_t *demux, struct mock_track *track)
         block_len += pic->p[i].i_lines * pic->p[i].i_pitch;
     memset(pic->p[0].p_pixels, (sys->video_pts / VLC_TICK_FROM_MS(10)) % 255,
            block_len);
-    return block_Init(&video->b, &cbs, pic->p[0].p_pixels, block_len);
+    block_t *b = block_Init(&video->b, &cbs, pic->p[0].p_pixels, block_len);
+    b->i_flags |= BLOCK_FLAG_TYPE_I; /* raw pictures are all intra */
+    return b;
     (void) demux;
 }
 
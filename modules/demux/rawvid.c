@@ -418,6 +418,7 @@ static int Demux( demux_t *p_demux )
         return VLC_DEMUXER_EOF;
 
     p_block->i_dts = p_block->i_pts = i_pcr;
+    p_block->i_flags |= BLOCK_FLAG_TYPE_I;
     es_out_Send( p_demux->out, p_sys->p_es_video, p_block );
 
     date_Increment( &p_sys->pcr, 1 );
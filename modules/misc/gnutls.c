@@ -38,6 +38,7 @@
 #include <vlc_tls.h>
 #include <vlc_block.h>
 #include <vlc_dialog.h>
+#include <vlc_memstream.h>
 
 #include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
@@ -47,6 +48,9 @@ typedef struct vlc_tls_gnutls
     vlc_tls_t tls;
     gnutls_session_t session;
     vlc_object_t *obj;
+    char *resumption_key; /**< Session cache key (client side only) */
+    bool resumption_started; /**< Cache looked up (client side only) */
+    bool verified; /**< Peer authenticated (client side only) */
 } vlc_tls_gnutls_t;
 
 static void gnutls_Banner(vlc_object_t *obj)
@@ -208,9 +212,17 @@ static void gnutls_Close (vlc_tls_t *tls)
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
 
     gnutls_deinit(priv->session);
+    free(priv->resumption_key);
     free(priv);
 }
 
+static bool gnutls_IsResumed(vlc_tls_t *tls)
+{
+    vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
+
+    return gnutls_session_is_resumed(priv->session) != 0;
+}
+
 static const struct vlc_tls_operations gnutls_ops =
 {
     gnutls_GetFD,
@@ -218,6 +230,7 @@ static const struct vlc_tls_operations gnutls_ops =
     gnutls_Send,
     gnutls_Shutdown,
     gnutls_Close,
+    gnutls_IsResumed,
 };
 
 static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
@@ -293,8 +306,12 @@ static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
     gnutls_transport_set_vec_push_function(session, vlc_gnutls_writev);
     gnutls_transport_set_pull_function(session, vlc_gnutls_read);
 
+    gnutls_session_set_ptr(session, priv);
     priv->session = session;
     priv->obj = obj;
+    priv->resumption_key = NULL;
+    priv->resumption_started = false;
+    priv->verified = false;
 
     vlc_tls_t *tls = &priv->tls;
 
@@ -352,6 +369,8 @@ static int gnutls_Handshake(vlc_tls_t *tls, char **restrict alp)
         msg_Dbg(obj, " - encrypt then MAC (RFC7366) enabled");
     if (flags & GNUTLS_SFLAGS_FALSE_START)
         msg_Dbg(obj, " - false start (RFC7918) enabled");
+    if (gnutls_session_is_resumed(session))
+        msg_Dbg(obj, " - session resumed");
 
     if (alp != NULL)
     {
@@ -373,6 +392,161 @@ static int gnutls_Handshake(vlc_tls_t *tls, char **restrict alp)
     return 0;
 }
 
+/*
+ * Client session resumption cache
+ *
+ * Session data (session ticket or session ID and master secret) is kept
+ * process-wide so that new connections to a same server can skip the full
+ * handshake. Entries are keyed by credentials, server name, port and
+ * Application Layer Protocols list, and each entry is used only once (as
+ * recommended for TLS 1.3 tickets): the resumed session provides fresh
+ * session data in turn. Only the data of sessions whose peer was
+ * authenticated is stored.
+ */
+#define RESUMPTION_CACHE_SIZE 32
+
+static struct
+{
+    const vlc_tls_client_t *creds;
+    char *key;
+    gnutls_datum_t data;
+} resumption_cache[RESUMPTION_CACHE_SIZE]; /* oldest entries first */
+static unsigned resumption_count = 0;
+static vlc_mutex_t resumption_lock = VLC_STATIC_MUTEX;
+
+static char *gnutls_ResumptionKey(const char *hostname,
+                                  const char *const *alpn)
+{
+    struct vlc_memstream stream;
+
+    vlc_memstream_open(&stream);
+    vlc_memstream_puts(&stream, hostname);
+    if (alpn != NULL)
+        while (*alpn != NULL)
+            vlc_memstream_printf(&stream, "\n%s", *(alpn++));
+
+    if (vlc_memstream_close(&stream))
+        return NULL;
+    return stream.ptr;
+}
+
+/** Removes the cache entry at the given index (lock must be held). */
+static gnutls_datum_t gnutls_ResumptionRemove(unsigned i)
+{
+    gnutls_datum_t data = resumption_cache[i].data;
+
+    assert(i < resumption_count);
+    free(resumption_cache[i].key);
+    resumption_count--;
+    memmove(resumption_cache + i, resumption_cache + i + 1,
+            (resumption_count - i) * sizeof (resumption_cache[0]));
+    return data;
+}
+
+static bool gnutls_ResumptionMatch(unsigned i,
+                                   const vlc_tls_client_t *creds,
+                                   const char *key)
+{
+    return resumption_cache[i].creds == creds
+        && (key == NULL || strcmp(resumption_cache[i].key, key) == 0);
+}
+
+/** Takes session data out of the cache, if any. */
+static int gnutls_ResumptionGet(const vlc_tls_client_t *creds,
+                                const char *key, gnutls_datum_t *data)
+{
+    int ret = -1;
+
+    vlc_mutex_lock(&resumption_lock);
+    for (unsigned i = resumption_count; i > 0; i--)
+        if (gnutls_ResumptionMatch(i - 1, creds, key))
+        {
+            *data = gnutls_ResumptionRemove(i - 1);
+            ret = 0;
+            break;
+        }
+    vlc_mutex_unlock(&resumption_lock);
+    return ret;
+}
+
+/**
+ * Removes the cache entries of the given credentials.
+ *
+ * @param key only remove the entries with this key (or NULL for all)
+ */
+static void gnutls_ResumptionDrop(const vlc_tls_client_t *creds,
+                                  const char *key)
+{
+    vlc_mutex_lock(&resumption_lock);
+    for (unsigned i = resumption_count; i > 0; i--)
+        if (gnutls_ResumptionMatch(i - 1, creds, key))
+            gnutls_free(gnutls_ResumptionRemove(i - 1).data);
+    vlc_mutex_unlock(&resumption_lock);
+}
+
+/** Puts the session data of an established session in the cache. */
+static void gnutls_ResumptionPut(vlc_tls_gnutls_t *priv)
+{
+    gnutls_datum_t data;
+    const vlc_tls_client_t *creds = (const vlc_tls_client_t *)priv->obj;
+
+    if (!priv->verified)
+        return; /* never cache data from an unauthenticated peer */
+
+    char *key = strdup(priv->resumption_key);
+    if (unlikely(key == NULL))
+        return;
+
+    if (gnutls_session_get_data2(priv->session, &data))
+    {
+        free(key);
+        return;
+    }
+
+    vlc_mutex_lock(&resumption_lock);
+    /* Replace the entry for the same server, if any, or else the oldest. */
+    for (unsigned i = 0; i < resumption_count; i++)
+        if (gnutls_ResumptionMatch(i, creds, key))
+        {
+            gnutls_free(gnutls_ResumptionRemove(i).data);
+            break;
+        }
+
+    if (resumption_count == RESUMPTION_CACHE_SIZE)
+        gnutls_free(gnutls_ResumptionRemove(0).data);
+
+    resumption_cache[resumption_count].creds = creds;
+    resumption_cache[resumption_count].key = key;
+    resumption_cache[resumption_count].data = data;
+    resumption_count++;
+    vlc_mutex_unlock(&resumption_lock);
+
+    msg_Dbg(priv->obj, "stored TLS session data (%u bytes)", data.size);
+}
+
+/**
+ * Handshake message hook for session tickets.
+ *
+ * With TLS 1.3, the server sends session tickets after the handshake, so the
+ * session data is only usable once a ticket was received. Before TLS 1.3, the
+ * ticket arrives during the handshake, before the peer is authenticated, and
+ * is ignored here: the session data is stored once verification succeeds.
+ */
+static int gnutls_TicketHook(gnutls_session_t session, unsigned type,
+                             unsigned when, unsigned incoming,
+                             const gnutls_datum_t *msg)
+{
+    vlc_tls_gnutls_t *priv = gnutls_session_get_ptr(session);
+
+    assert(type == GNUTLS_HANDSHAKE_NEW_SESSION_TICKET);
+    assert(when == GNUTLS_HOOK_POST);
+    (void) type; (void) when; (void) msg;
+
+    if (incoming)
+        gnutls_ResumptionPut(priv);
+    return 0;
+}
+
 static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
                                            vlc_tls_t *sk, const char *hostname,
                                            const char *const *alpn)
@@ -388,13 +562,57 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
     gnutls_dh_set_prime_bits (session, 1024);
 
     if (likely(hostname != NULL))
+    {
         /* fill Server Name Indication */
         gnutls_server_name_set (session, GNUTLS_NAME_DNS,
                                 hostname, strlen (hostname));
 
+        /* The key is completed with the service on the first handshake */
+        if (var_InheritBool(crd, "gnutls-resumption"))
+            priv->resumption_key = gnutls_ResumptionKey(hostname, alpn);
+    }
+
     return &priv->tls;
 }
 
+/**
+ * Looks up session data to resume, before the handshake starts.
+ */
+static void gnutls_ResumptionStart(vlc_tls_gnutls_t *priv,
+                                   const char *service)
+{
+    vlc_tls_client_t *crd = (vlc_tls_client_t *)priv->obj;
+    char *key = priv->resumption_key;
+
+    /* Prepend the service (port) */
+    if (asprintf(&priv->resumption_key, "%s\n%s",
+                 (service != NULL) ? service : "", key) == -1)
+        priv->resumption_key = NULL;
+    free(key);
+
+    if (priv->resumption_key == NULL)
+        return;
+
+    gnutls_session_t session = priv->session;
+    gnutls_datum_t data;
+
+    if (gnutls_ResumptionGet(crd, priv->resumption_key, &data) == 0)
+    {
+        int val = gnutls_session_set_data(session, data.data, data.size);
+        if (val)
+            msg_Warn(crd, "cannot resume TLS session: %s",
+                     gnutls_strerror(val));
+        else
+            msg_Dbg(crd, "resuming TLS session");
+        gnutls_free(data.data);
+    }
+
+    gnutls_handshake_set_hook_function(session,
+                                       GNUTLS_HANDSHAKE_NEW_SESSION_TICKET,
+                                       GNUTLS_HOOK_POST,
+                                       gnutls_TicketHook);
+}
+
 static int gnutls_ClientHandshake(vlc_tls_t *tls,
                                   const char *host, const char *service,
                                   char **restrict alp)
@@ -402,6 +620,12 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
     vlc_object_t *obj = priv->obj;
 
+    if (priv->resumption_key != NULL && !priv->resumption_started)
+    {
+        priv->resumption_started = true;
+        gnutls_ResumptionStart(priv, service);
+    }
+
     int val = gnutls_Handshake(tls, alp);
     if (val)
         return val;
@@ -419,7 +643,7 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
     }
 
     if (status == 0) /* Good certificate */
-        return 0;
+        goto success;
 
     /* Bad certificate */
     gnutls_datum_t desc;
@@ -457,7 +681,7 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
     {
         case 0:
             msg_Dbg(obj, "certificate key match for %s", host);
-            return 0;
+            goto success;
         case GNUTLS_E_NO_CERTIFICATE_FOUND:
             msg_Dbg(obj, "no known certificates for %s", host);
             msg = N_("However, the security certificate presented by the "
@@ -521,9 +745,22 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
         default:
             goto error;
     }
+
+success:
+    priv->verified = true;
+
+    /* Before TLS 1.3, session data is available from the handshake. */
+    if (priv->resumption_key != NULL
+#if (GNUTLS_VERSION_NUMBER >= 0x030600)
+     && gnutls_protocol_get_version(session) < GNUTLS_TLS1_3
+#endif
+       )
+        gnutls_ResumptionPut(priv);
     return 0;
 
 error:
+    if (priv->resumption_key != NULL)
+        gnutls_ResumptionDrop((vlc_tls_client_t *)obj, priv->resumption_key);
     if (alp != NULL)
         free(*alp);
     return -1;
@@ -533,6 +770,8 @@ static void gnutls_ClientDestroy(vlc_tls_client_t *crd)
 {
     gnutls_certificate_credentials_t x509 = crd->sys;
 
+    gnutls_ResumptionDrop(crd, NULL);
+
     gnutls_certificate_free_credentials(x509);
 }
 
@@ -599,6 +838,7 @@ typedef struct vlc_tls_creds_sys
 {
     gnutls_certificate_credentials_t x509_cred;
     gnutls_dh_params_t dh_params;
+    gnutls_datum_t ticket_key;
 } vlc_tls_creds_sys_t;
 
 /**
@@ -611,7 +851,12 @@ static vlc_tls_t *gnutls_ServerSessionOpen(vlc_tls_server_t *crd,
     vlc_tls_creds_sys_t *sys = crd->sys;
     vlc_tls_gnutls_t *priv = gnutls_SessionOpen(VLC_OBJECT(crd), GNUTLS_SERVER,
                                                 sys->x509_cred, sk, alpn);
-    return (priv != NULL) ? &priv->tls : NULL;
+    if (priv == NULL)
+        return NULL;
+
+    if (sys->ticket_key.data != NULL)
+        gnutls_session_ticket_enable_server(priv->session, &sys->ticket_key);
+    return &priv->tls;
 }
 
 static void gnutls_ServerDestroy(vlc_tls_server_t *crd)
@@ -621,6 +866,11 @@ static void gnutls_ServerDestroy(vlc_tls_server_t *crd)
     /* all sessions depending on the server are now deinitialized */
     gnutls_certificate_free_credentials(sys->x509_cred);
     gnutls_dh_params_deinit(sys->dh_params);
+    if (sys->ticket_key.data != NULL)
+    {
+        gnutls_memset(sys->ticket_key.data, 0, sys->ticket_key.size);
+        gnutls_free(sys->ticket_key.data);
+    }
     free(sys);
 }
 
@@ -709,6 +959,15 @@ static int OpenServer(vlc_tls_server_t *crd, const char *cert, const char *key)
                  gnutls_strerror (val));
     }
 
+    /* Session tickets encryption key, for session resumption (RFC5077) */
+    val = gnutls_session_ticket_key_generate(&sys->ticket_key);
+    if (val < 0)
+    {
+        msg_Err (crd, "cannot generate session ticket key: %s",
+                 gnutls_strerror (val));
+        sys->ticket_key.data = NULL;
+    }
+
     msg_Dbg (crd, "ciphers parameters loaded");
 
     crd->ops = &gnutls_ServerOps;
@@ -732,6 +991,11 @@ error:
     "Trust the root certificates of Certificate Authorities stored in " \
     "the specified directory to authenticate TLS sessions.")
 
+#define RESUMPTION_TEXT N_("Resume TLS sessions")
+#define RESUMPTION_LONGTEXT N_( \
+    "Reuse the parameters of earlier sessions with the same server to skip " \
+    "the full TLS handshake when connecting again.")
+
 #define PRIORITIES_TEXT N_("TLS cipher priorities")
 #define PRIORITIES_LONGTEXT N_("Ciphers, key exchange methods, " \
     "hash functions and compression methods can be selected. " \
@@ -762,6 +1026,8 @@ vlc_module_begin ()
              SYSTEM_TRUST_LONGTEXT, true)
     add_string("gnutls-dir-trust", NULL, DIR_TRUST_TEXT,
                DIR_TRUST_TEXT, true)
+    add_bool("gnutls-resumption", true, RESUMPTION_TEXT,
+             RESUMPTION_LONGTEXT, true)
     add_string ("gnutls-priorities", "NORMAL", PRIORITIES_TEXT,
                 PRIORITIES_LONGTEXT, false)
         change_string_list (priorities_values, priorities_text)
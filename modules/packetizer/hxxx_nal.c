@@ -101,8 +101,9 @@ block_t *hxxx_AnnexB_to_xVC( block_t *p_block, uint8_t i_nal_length_size )
     if( !i_nalcount )
         goto error;
 
-    /* Optimization for 1 NAL block only case */
-    if( i_nalcount == 1 && block_WillRealloc( p_block, p_list[0].move, p_block->i_buffer ) )
+    /* Optimization for 1 NAL block only case (the prefix is written in place) */
+    if( i_nalcount == 1 && block_IsWritable( p_block ) &&
+        block_WillRealloc( p_block, p_list[0].move, p_block->i_buffer ) )
     {
         uint32_t i_payload = p_block->i_buffer - p_list[0].prefix;
         block_t *p_newblock = block_Realloc( p_block, p_list[0].move, p_block->i_buffer );
@@ -120,7 +121,8 @@ block_t *hxxx_AnnexB_to_xVC( block_t *p_block, uint8_t i_nal_length_size )
     uint8_t *p_dest = NULL;
     const size_t i_dest = p_block->i_buffer + p_list[i_nalcount - 1].move;
 
-    if( p_list[i_nalcount - 1].move != 0 || i_nal_length_size != 4 )  /* We'll need to grow or shrink */
+    if( p_list[i_nalcount - 1].move != 0 || i_nal_length_size != 4 ||  /* We'll need to grow or shrink */
+        !block_IsWritable( p_block ) ) /* or to copy a shared payload */
     {
         /* If we grow in size, try using realloc to avoid memcpy */
         if( p_list[i_nalcount - 1].move > 0 && block_WillRealloc( p_block, 0, i_dest ) )
@@ -289,8 +289,12 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
     sout_stream_id_sys_t *id = (sout_stream_id_sys_t *)_id;
-    sout_stream_t     *p_dup_stream;
-    int               i_stream;
+    block_t           *pp_refs[p_sys->i_nb_streams];
+    unsigned          i_refs = 0;
+
+    for( int i_stream = 0; i_stream < p_sys->i_nb_streams; i_stream++ )
+        if( id->pp_ids[i_stream] )
+            i_refs++;
 
     /* Loop through the linked list of buffers */
     while( p_buffer )
@@ -299,27 +303,31 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
 
         p_buffer->p_next = NULL;
 
-        for( i_stream = 0; i_stream < p_sys->i_nb_streams - 1; i_stream++ )
+        if( i_refs == 0 )
         {
-            p_dup_stream = p_sys->pp_streams[i_stream];
-
-            if( id->pp_ids[i_stream] )
-            {
-                block_t *p_dup = block_Duplicate( p_buffer );
-
-                if( p_dup )
-                    sout_StreamIdSend( p_dup_stream, id->pp_ids[i_stream], p_dup );
-            }
+            block_Release( p_buffer );
+            p_buffer = p_next;
+            continue;
         }
 
-        if( i_stream < p_sys->i_nb_streams && id->pp_ids[i_stream] )
-        {
-            p_dup_stream = p_sys->pp_streams[i_stream];
-            sout_StreamIdSend( p_dup_stream, id->pp_ids[i_stream], p_buffer );
+        /* Fan the payload out by reference; branches that modify it in
+         * place (e.g. to prepend mux headers) get a copy on write. */
+        if( i_refs == 1 || block_Share( p_buffer, pp_refs, i_refs ) )
+        {   /* Single branch or out of memory: fall back to copies */
+            for( unsigned i = 0; i + 1 < i_refs; i++ )
+                pp_refs[i] = block_Duplicate( p_buffer );
+            pp_refs[i_refs - 1] = p_buffer;
         }
-        else
+
+        for( int i_stream = 0, i = 0; i_stream < p_sys->i_nb_streams; i_stream++ )
         {
-            block_Release( p_buffer );
+            if( id->pp_ids[i_stream] == NULL )
+                continue;
+
+            block_t *p_ref = pp_refs[i++];
+            if( p_ref )
+                sout_StreamIdSend( p_sys->pp_streams[i_stream],
+                                   id->pp_ids[i_stream], p_ref );
         }
 
         p_buffer = p_next;
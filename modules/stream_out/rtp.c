@@ -1389,54 +1389,154 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Maximum number of packets sent at once, typically an access unit */
+#define RTP_BATCH_MAX 64
+
+struct rtp_batch
+{
+    block_t *pktv[RTP_BATCH_MAX];
+    unsigned pktc;
+    block_t *next; /* first packet not due yet */
+};
+
+static void rtp_batch_cleanup( void *data )
+{
+    struct rtp_batch *batch = data;
+
+    for( unsigned i = 0; i < batch->pktc; i++ )
+        block_Release( batch->pktv[i] );
+    batch->pktc = 0;
+    if( batch->next != NULL )
+        block_Release( batch->next );
+    batch->next = NULL;
+}
+
+/**
+ * Sends a batch of packets to one sink.
+ * @return false if the connection is broken
+ */
+static bool rtp_sink_send( int fd, block_t *const *pktv, unsigned pktc )
+{
+    for( unsigned i = 0; i < pktc; )
+    {
+#ifdef HAVE_SENDMMSG
+        struct mmsghdr msgv[pktc - i];
+        struct iovec iov[pktc - i];
+
+        for( unsigned j = 0; j < pktc - i; j++ )
+        {
+            iov[j].iov_base = pktv[i + j]->p_buffer;
+            iov[j].iov_len = pktv[i + j]->i_buffer;
+            msgv[j].msg_hdr = (struct msghdr) {
+                .msg_iov = &iov[j],
+                .msg_iovlen = 1,
+            };
+        }
+
+        int val = sendmmsg( fd, msgv, pktc - i, 0 );
+        if( val > 0 )
+        {
+            i += val;
+            continue;
+        }
+#else
+        if( send( fd, pktv[i]->p_buffer, pktv[i]->i_buffer, 0 ) != -1 )
+        {
+            i++;
+            continue;
+        }
+#endif
+        /* The packet i failed */
+        if( net_errno != EAGAIN && net_errno != ENOBUFS
+         && net_errno != EWOULDBLOCK && net_errno != ENOMEM )
+        {
+            int type;
+            getsockopt( fd, SOL_SOCKET, SO_TYPE,
+                        &type, &(socklen_t){ sizeof(type) });
+            if( type != SOCK_DGRAM )
+                return false; /* Broken connection */
+
+            /* ICMP soft error: ignore and retry */
+            send( fd, pktv[i]->p_buffer, pktv[i]->i_buffer, 0 );
+        }
+        i++;
+    }
+    return true;
+}
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     vlc_tick_t i_caching = id->i_caching;
+    struct rtp_batch batch = { .pktc = 0, .next = NULL };
 
+    vlc_cleanup_push( rtp_batch_cleanup, &batch );
     for (;;)
     {
-        block_t *out = block_FifoGet( id->p_fifo );
-        block_cleanup_push (out);
+        block_t *out = batch.next;
+        batch.next = NULL;
+        if( out == NULL )
+            out = block_FifoGet( id->p_fifo );
+        batch.pktv[batch.pktc++] = out;
+
+        vlc_tick_wait (out->i_dts + i_caching);
+
+        /* Take every other packet that is due already, so that a whole
+         * access unit is encrypted and sent with a single wake-up */
+        vlc_tick_t now = vlc_tick_now();
+        vlc_fifo_Lock( id->p_fifo );
+        while( batch.pktc < RTP_BATCH_MAX )
+        {
+            block_t *next = vlc_fifo_DequeueUnlocked( id->p_fifo );
+            if( next == NULL )
+                break;
+            if( next->i_dts + i_caching > now )
+            {
+                batch.next = next;
+                break;
+            }
+            batch.pktv[batch.pktc++] = next;
+        }
+        vlc_fifo_Unlock( id->p_fifo );
+
+        int canc = vlc_savecancel ();
 
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
+        {
+            unsigned pktc = 0;
+
+            for( unsigned i = 0; i < batch.pktc; i++ )
             {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
-            }
-            else
+                out = batch.pktv[i];
+
+                size_t len = out->i_buffer;
+                out = block_Realloc( out, 0, len + 10 );
+                if( unlikely(out == NULL) )
+                    continue;
+                out->i_buffer = len;
+
+                int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+                if( val )
+                {
+                    msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                             vlc_strerror_c(val) );
+                    block_Release( out );
+                    continue;
+                }
                 out->i_buffer = len;
+                batch.pktv[pktc++] = out;
+            }
+            batch.pktc = pktc;
         }
-        if (out)
-            vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
-        if (out == NULL)
-            continue;
-#else
-        vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
 #endif
 
-        ssize_t len = out->i_buffer;
-        int canc = vlc_savecancel ();
-
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
         int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
@@ -1446,26 +1546,20 @@ static void* ThreadSend( void *data )
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < batch.pktc; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, batch.pktv[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
-            {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
-            }
+            if( !rtp_sink_send( id->sinkv[i].rtp_fd, batch.pktv, batch.pktc ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        if( batch.pktc > 0 )
+            id->i_seq_sent_next =
+                ntohs(((uint16_t *) batch.pktv[batch.pktc - 1]->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+
+        for( unsigned i = 0; i < batch.pktc; i++ )
+            block_Release( batch.pktv[i] );
+        batch.pktc = 0;
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -1474,6 +1568,7 @@ static void* ThreadSend( void *data )
         }
         vlc_restorecancel (canc);
     }
+    vlc_cleanup_pop ();
     return NULL;
 }
 
@@ -272,7 +272,8 @@ static int fixAccessMux( sout_stream_t *p_stream, char **ppsz_mux,
         {
             if( !strncmp( psz_access, "mmsh", 4 ) )
                 *ppsz_mux = strdup("asfh");
-            else if (!strcmp (psz_access, "udp"))
+            else if (!strcmp (psz_access, "udp")
+                  || !strncmp( psz_access, "hls", 3 ))
                 *ppsz_mux = strdup("ts");
             else if( psz_mux_byext )
                 *ppsz_mux = strdup(psz_mux_byext);
@@ -376,6 +377,14 @@ static int Open( vlc_object_t *p_this )
 
     checkAccessMux( p_stream, psz_access, psz_mux );
 
+    /* HLS segments are cut on the tables the TS muxer then repeats before
+     * each keyframe */
+    if( exactMatch( psz_access, "hls", 3 ) && exactMatch( psz_mux, "ts", 2 ) )
+    {
+        var_Create( p_stream->p_sout, "sout-ts-use-key-frames", VLC_VAR_BOOL );
+        var_SetBool( p_stream->p_sout, "sout-ts-use-key-frames", true );
+    }
+
     p_access = sout_AccessOutNew( p_stream, psz_access, psz_url );
     if( p_access == NULL )
     {
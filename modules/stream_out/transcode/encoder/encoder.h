@@ -45,6 +45,12 @@ typedef struct
                 int          i_priority;
                 uint32_t     pool_size;
             } threads;
+            struct
+            {
+                unsigned int i_count; /* parallel GOP encoders, 0 if off */
+                unsigned int i_frames; /* frames per chunk */
+                unsigned int i_queue; /* max pictures queued to encoders */
+            } chunks;
         } video;
         struct
         {
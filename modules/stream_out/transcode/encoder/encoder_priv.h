@@ -18,6 +18,8 @@
  *****************************************************************************/
 #include <vlc_picture_fifo.h>
 
+typedef struct transcode_chunk_t transcode_chunk_t;
+
 struct transcode_encoder_t
 {
     encoder_t       *p_encoder;
@@ -31,6 +33,16 @@ struct transcode_encoder_t
     /* output buffers */
     block_t         *p_buffers;
     bool b_threaded;
+
+    /* parallel GOP encoding */
+    transcode_chunk_t *p_chunks;
+    unsigned        i_chunks;
+    unsigned        i_chunk_in;      /* chunk receiving pictures */
+    unsigned        i_chunk_out;     /* chunk whose output comes next */
+    unsigned        i_chunk_frames;  /* pictures given to the input chunk */
+    unsigned        i_chunk_max;
+    vlc_tick_t      i_chunk_delay;   /* encoder delay of the first chunk */
+    bool            b_chunk_delay;   /* whether i_chunk_delay is known */
 };
 
 int transcode_encoder_audio_open( transcode_encoder_t *p_enc,
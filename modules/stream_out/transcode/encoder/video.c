@@ -403,9 +403,397 @@ static void* EncoderThread( void *obj )
     return NULL;
 }
 
+/* Parallel GOP encoding: the pictures are split into chunks, each one
+ * encoded from scratch by a fresh encoder instance so that it starts with
+ * a closed GOP. Up to i_chunks chunks are encoded concurrently, and their
+ * output is concatenated in order. The pictures queued to the chunk encoders
+ * are bounded with picture_pool_has_room. */
+enum
+{
+    CHUNK_IDLE,     /* no chunk assigned */
+    CHUNK_OPEN,     /* receiving pictures */
+    CHUNK_CLOSING,  /* no more pictures, encoder to be flushed */
+    CHUNK_DONE,     /* encoder flushed, output left to collect */
+};
+
+struct transcode_chunk_t
+{
+    transcode_encoder_t *p_enc;
+    const transcode_encoder_config_t *p_cfg;
+    encoder_t      *p_encoder;
+    es_format_t     fmt_in;  /* encoder formats to open each chunk with */
+    es_format_t     fmt_out;
+    vlc_thread_t    thread;
+    vlc_cond_t      wait;
+    picture_fifo_t *pp_pics;
+    block_t        *p_blocks;
+    vlc_tick_t      i_start;      /* date of the first picture */
+    vlc_tick_t      i_dts_offset; /* added to the output decoding time */
+    int             i_state;
+    bool            b_started;
+    bool            b_rebased;    /* whether i_dts_offset is known */
+    bool            b_exit;
+};
+
+struct chunk_encoder_owner
+{
+    encoder_t enc;
+    encoder_t *p_parent;
+};
+
+static vlc_decoder_device *chunk_get_encoder_device( encoder_t *enc )
+{
+    encoder_t *p_parent =
+        container_of( enc, struct chunk_encoder_owner, enc )->p_parent;
+
+    if( p_parent->cbs == NULL || p_parent->cbs->video.get_device == NULL )
+        return NULL;
+    return p_parent->cbs->video.get_device( p_parent );
+}
+
+static const struct encoder_owner_callbacks chunk_encoder_cbs = {
+    { chunk_get_encoder_device, }
+};
+
+/* The concatenated chunks share the stream parameter sets */
+static bool ChunkEncoderMatches( const encoder_t *p_encoder,
+                                 const encoder_t *p_parent )
+{
+    const es_format_t *a = &p_encoder->fmt_out, *b = &p_parent->fmt_out;
+
+    return a->i_extra == b->i_extra
+        && (a->i_extra == 0 || memcmp( a->p_extra, b->p_extra, a->i_extra ) == 0);
+}
+
+static void ChunkEncoderClose( transcode_chunk_t *c );
+
+static void ChunkEncoderOpen( transcode_chunk_t *c )
+{
+    encoder_t *p_encoder = c->p_encoder;
+
+    es_format_Clean( &p_encoder->fmt_in );
+    es_format_Clean( &p_encoder->fmt_out );
+    es_format_Copy( &p_encoder->fmt_in, &c->fmt_in );
+    es_format_Copy( &p_encoder->fmt_out, &c->fmt_out );
+    p_encoder->vctx_in = c->p_enc->p_encoder->vctx_in;
+    p_encoder->i_threads = c->p_cfg->video.threads.i_count;
+    p_encoder->p_cfg = c->p_cfg->p_config_chain;
+
+    p_encoder->p_module =
+        module_need( p_encoder, "encoder", c->p_cfg->psz_name, true );
+    if( !p_encoder->p_module )
+        msg_Err( p_encoder, "cannot open encoder, dropping chunk" );
+    else if( !ChunkEncoderMatches( p_encoder, c->p_enc->p_encoder ) )
+    {
+        msg_Err( p_encoder, "encoder parameter sets changed, dropping chunk" );
+        ChunkEncoderClose( c );
+    }
+}
+
+static void ChunkEncoderClose( transcode_chunk_t *c )
+{
+    if( c->p_encoder->p_module )
+    {
+        module_unneed( c->p_encoder, c->p_encoder->p_module );
+        c->p_encoder->p_module = NULL;
+    }
+}
+
+static void* ChunkThread( void *obj )
+{
+    transcode_chunk_t *c = obj;
+    transcode_encoder_t *p_enc = c->p_enc;
+    encoder_t *p_encoder = c->p_encoder;
+    int canc = vlc_savecancel ();
+
+    vlc_mutex_lock( &p_enc->lock_out );
+
+    while( !c->b_exit )
+    {
+        picture_t *p_pic = NULL;
+        block_t *p_block = NULL;
+
+        if( c->i_state == CHUNK_OPEN || c->i_state == CHUNK_CLOSING )
+            p_pic = picture_fifo_Pop( c->pp_pics );
+
+        if( p_pic )
+        {
+            vlc_sem_post( &p_enc->picture_pool_has_room );
+
+            /* release lock while encoding */
+            vlc_mutex_unlock( &p_enc->lock_out );
+            if( !c->b_started )
+            {
+                c->b_started = true;
+                ChunkEncoderOpen( c );
+            }
+            if( p_encoder->p_module )
+                p_block = p_encoder->pf_encode_video( p_encoder, p_pic );
+            picture_Release( p_pic );
+            vlc_mutex_lock( &p_enc->lock_out );
+
+            block_ChainAppend( &c->p_blocks, p_block );
+        }
+        else if( c->i_state == CHUNK_CLOSING )
+        {
+            vlc_mutex_unlock( &p_enc->lock_out );
+            block_t *p_flushed = NULL;
+            if( p_encoder->p_module )
+            {
+                do {
+                    p_block = p_encoder->pf_encode_video( p_encoder, NULL );
+                    block_ChainAppend( &p_flushed, p_block );
+                } while( p_block );
+                ChunkEncoderClose( c );
+            }
+            vlc_mutex_lock( &p_enc->lock_out );
+
+            block_ChainAppend( &c->p_blocks, p_flushed );
+            c->i_state = CHUNK_DONE;
+            vlc_cond_signal( &p_enc->cond );
+        }
+        else
+            vlc_cond_wait( &c->wait, &p_enc->lock_out );
+    }
+
+    vlc_mutex_unlock( &p_enc->lock_out );
+
+    vlc_restorecancel (canc);
+
+    return NULL;
+}
+
+static void ChunkClean( transcode_chunk_t *c )
+{
+    ChunkEncoderClose( c );
+    picture_fifo_Delete( c->pp_pics );
+    block_ChainRelease( c->p_blocks );
+    vlc_cond_destroy( &c->wait );
+    es_format_Clean( &c->fmt_in );
+    es_format_Clean( &c->fmt_out );
+    es_format_Clean( &c->p_encoder->fmt_in );
+    es_format_Clean( &c->p_encoder->fmt_out );
+    vlc_object_delete( c->p_encoder );
+}
+
+static void ChunksDelete( transcode_encoder_t *p_enc )
+{
+    vlc_mutex_lock( &p_enc->lock_out );
+    for( unsigned i = 0; i < p_enc->i_chunks; i++ )
+    {
+        p_enc->p_chunks[i].b_exit = true;
+        vlc_cond_signal( &p_enc->p_chunks[i].wait );
+    }
+    vlc_mutex_unlock( &p_enc->lock_out );
+
+    for( unsigned i = 0; i < p_enc->i_chunks; i++ )
+    {
+        vlc_join( p_enc->p_chunks[i].thread, NULL );
+        ChunkClean( &p_enc->p_chunks[i] );
+    }
+    free( p_enc->p_chunks );
+    p_enc->p_chunks = NULL;
+    p_enc->i_chunks = 0;
+}
+
+static int ChunksNew( transcode_encoder_t *p_enc,
+                      const transcode_encoder_config_t *p_cfg,
+                      const es_format_t *p_fmt_out )
+{
+    unsigned i_count = p_cfg->video.chunks.i_count;
+
+    p_enc->p_chunks = vlc_alloc( i_count, sizeof(*p_enc->p_chunks) );
+    if( !p_enc->p_chunks )
+        return VLC_ENOMEM;
+    p_enc->i_chunks = 0;
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        transcode_chunk_t *c = &p_enc->p_chunks[i];
+        struct chunk_encoder_owner *p_owner = (struct chunk_encoder_owner *)
+            sout_EncoderCreate( p_enc->p_encoder, sizeof(*p_owner) );
+        if( unlikely(p_owner == NULL) )
+            break;
+
+        c->pp_pics = picture_fifo_New();
+        if( unlikely(c->pp_pics == NULL) )
+        {
+            vlc_object_delete( &p_owner->enc );
+            break;
+        }
+
+        p_owner->p_parent = p_enc->p_encoder;
+        p_owner->enc.cbs = &chunk_encoder_cbs;
+        p_owner->enc.p_module = NULL;
+        es_format_Init( &p_owner->enc.fmt_in, VIDEO_ES, 0 );
+        es_format_Init( &p_owner->enc.fmt_out, VIDEO_ES, 0 );
+
+        c->p_enc = p_enc;
+        c->p_cfg = p_cfg;
+        c->p_encoder = &p_owner->enc;
+        es_format_Copy( &c->fmt_in, &p_enc->p_encoder->fmt_in );
+        es_format_Copy( &c->fmt_out, p_fmt_out );
+        vlc_cond_init( &c->wait );
+        c->p_blocks = NULL;
+        c->i_state = CHUNK_IDLE;
+        c->b_started = false;
+        c->b_exit = false;
+
+        if( i == 0 )
+        {   /* Check that the chunks can be concatenated */
+            ChunkEncoderOpen( c );
+            bool b_ok = c->p_encoder->p_module != NULL;
+            ChunkEncoderClose( c );
+            if( !b_ok )
+            {
+                msg_Err( p_enc->p_encoder, "parallel GOP encoding is not "
+                         "possible with this encoder" );
+                ChunkClean( c );
+                break;
+            }
+        }
+
+        if( vlc_clone( &c->thread, ChunkThread, c,
+                       p_cfg->video.threads.i_priority ) )
+        {
+            ChunkClean( c );
+            break;
+        }
+        p_enc->i_chunks++;
+    }
+
+    if( p_enc->i_chunks < i_count )
+    {
+        ChunksDelete( p_enc );
+        return VLC_EGENERIC;
+    }
+
+    p_enc->i_chunk_in = 0;
+    p_enc->i_chunk_out = 0;
+    p_enc->i_chunk_frames = 0;
+    p_enc->i_chunk_max = __MAX( p_cfg->video.chunks.i_frames, 1 );
+    p_enc->b_chunk_delay = false;
+    return VLC_SUCCESS;
+}
+
+/* With B-frames, an encoder starts decoding time stamps before the first
+ * presentation time stamp, by its delay. Each chunk is rebased so that its
+ * decoding time stamps start at its first date minus the delay of the first
+ * chunk, as a single encoder would have output them. */
+static void ChunkFixDts( transcode_encoder_t *p_enc, transcode_chunk_t *c )
+{
+    for( block_t *p_block = c->p_blocks; p_block; p_block = p_block->p_next )
+    {
+        if( p_block->i_dts == VLC_TICK_INVALID )
+            continue;
+        if( !c->b_rebased )
+        {
+            if( !p_enc->b_chunk_delay )
+            {
+                p_enc->i_chunk_delay = c->i_start - p_block->i_dts;
+                p_enc->b_chunk_delay = true;
+            }
+            c->i_dts_offset = c->i_start - p_enc->i_chunk_delay
+                            - p_block->i_dts;
+            c->b_rebased = true;
+        }
+        p_block->i_dts += c->i_dts_offset;
+    }
+}
+
+/* Returns the output of the chunks in order, waiting until p_wait is idle
+ * unless it is NULL. Called with lock_out held. */
+static block_t * ChunksCollect( transcode_encoder_t *p_enc,
+                                const transcode_chunk_t *p_wait )
+{
+    block_t *p_out = NULL;
+
+    for( ;; )
+    {
+        transcode_chunk_t *c = &p_enc->p_chunks[p_enc->i_chunk_out];
+
+        if( c->i_state == CHUNK_IDLE )
+            break;
+
+        /* The oldest chunk output precedes anything else, even partial */
+        ChunkFixDts( p_enc, c );
+        block_ChainAppend( &p_out, c->p_blocks );
+        c->p_blocks = NULL;
+
+        if( c->i_state == CHUNK_DONE )
+        {
+            c->i_state = CHUNK_IDLE;
+            p_enc->i_chunk_out = (p_enc->i_chunk_out + 1) % p_enc->i_chunks;
+            continue;
+        }
+
+        if( p_wait == NULL || p_wait->i_state == CHUNK_IDLE )
+            break;
+        vlc_cond_wait( &p_enc->cond, &p_enc->lock_out );
+    }
+
+    return p_out;
+}
+
+static block_t * ChunksEncode( transcode_encoder_t *p_enc, picture_t *p_pic )
+{
+    /* Wait for the encoders to catch up, rather than queue without bound */
+    vlc_sem_wait( &p_enc->picture_pool_has_room );
+    vlc_mutex_lock( &p_enc->lock_out );
+
+    transcode_chunk_t *c = &p_enc->p_chunks[p_enc->i_chunk_in];
+    if( c->i_state == CHUNK_OPEN && p_enc->i_chunk_frames >= p_enc->i_chunk_max )
+    {
+        c->i_state = CHUNK_CLOSING;
+        vlc_cond_signal( &c->wait );
+        p_enc->i_chunk_in = (p_enc->i_chunk_in + 1) % p_enc->i_chunks;
+        c = &p_enc->p_chunks[p_enc->i_chunk_in];
+    }
+
+    /* The next encoder must be done with its previous chunk */
+    block_t *p_out = ChunksCollect( p_enc, c->i_state != CHUNK_OPEN ? c : NULL );
+
+    if( c->i_state == CHUNK_IDLE )
+    {
+        c->i_state = CHUNK_OPEN;
+        c->b_started = false;
+        c->i_start = p_pic->date;
+        c->b_rebased = false;
+        p_enc->i_chunk_frames = 0;
+    }
+
+    picture_fifo_Push( c->pp_pics, picture_Hold( p_pic ) );
+    p_enc->i_chunk_frames++;
+    vlc_cond_signal( &c->wait );
+
+    vlc_mutex_unlock( &p_enc->lock_out );
+    return p_out;
+}
+
+static void ChunksDrain( transcode_encoder_t *p_enc, block_t **out )
+{
+    vlc_mutex_lock( &p_enc->lock_out );
+
+    transcode_chunk_t *c = &p_enc->p_chunks[p_enc->i_chunk_in];
+    if( c->i_state == CHUNK_OPEN )
+    {
+        c->i_state = CHUNK_CLOSING;
+        vlc_cond_signal( &c->wait );
+    }
+    block_ChainAppend( out, ChunksCollect( p_enc, c ) );
+
+    /* Every chunk is idle now */
+    p_enc->i_chunk_in = p_enc->i_chunk_out;
+    p_enc->i_chunk_frames = 0;
+
+    vlc_mutex_unlock( &p_enc->lock_out );
+}
+
 int transcode_encoder_video_drain( transcode_encoder_t *p_enc, block_t **out )
 {
-    if( !p_enc->b_threaded )
+    if( p_enc->p_chunks )
+        ChunksDrain( p_enc, out );
+    else if( !p_enc->b_threaded )
     {
         block_t *p_block;
         do {
@@ -439,6 +827,9 @@ void transcode_encoder_video_close( transcode_encoder_t *p_enc )
         vlc_join( p_enc->thread, NULL );
     }
 
+    if( p_enc->p_chunks )
+        ChunksDelete( p_enc );
+
     /* Close encoder */
     module_unneed( p_enc->p_encoder, p_enc->p_encoder->p_module );
     p_enc->p_encoder->p_module = NULL;
@@ -453,10 +844,20 @@ int transcode_encoder_video_open( transcode_encoder_t *p_enc,
     p_enc->p_encoder->i_threads = p_cfg->video.threads.i_count;
     p_enc->p_encoder->p_cfg = p_cfg->p_config_chain;
 
+    /* The chunk encoders start from the requested output format, not from
+     * the one completed by the encoder module */
+    es_format_t chunk_fmt_out;
+    if( p_cfg->video.chunks.i_count > 0 )
+        es_format_Copy( &chunk_fmt_out, &p_enc->p_encoder->fmt_out );
+
     p_enc->p_encoder->p_module =
         module_need( p_enc->p_encoder, "encoder", p_cfg->psz_name, true );
     if( !p_enc->p_encoder->p_module )
+    {
+        if( p_cfg->video.chunks.i_count > 0 )
+            es_format_Clean( &chunk_fmt_out );
         return VLC_EGENERIC;
+    }
 
     p_enc->p_encoder->fmt_in.video.i_chroma = p_enc->p_encoder->fmt_in.i_codec;
 
@@ -464,12 +865,30 @@ int transcode_encoder_video_open( transcode_encoder_t *p_enc,
     p_enc->p_encoder->fmt_out.i_codec =
         vlc_fourcc_GetCodec( VIDEO_ES, p_enc->p_encoder->fmt_out.i_codec );
 
-    vlc_sem_init( &p_enc->picture_pool_has_room, p_cfg->video.threads.pool_size );
+    vlc_sem_init( &p_enc->picture_pool_has_room,
+                  p_cfg->video.chunks.i_count > 0
+                      ? __MAX( p_cfg->video.chunks.i_queue, 1 )
+                      : p_cfg->video.threads.pool_size );
     vlc_cond_init( &p_enc->cond );
     p_enc->p_buffers = NULL;
     p_enc->b_abort = false;
 
-    if( p_cfg->video.threads.i_count > 0 )
+    if( p_cfg->video.chunks.i_count > 0 )
+    {
+        /* The chunk encoders run on their own threads instead, this one
+         * only provides the output format */
+        int i_ret = ChunksNew( p_enc, p_cfg, &chunk_fmt_out );
+        es_format_Clean( &chunk_fmt_out );
+        if( i_ret != VLC_SUCCESS )
+        {
+            vlc_cond_destroy( &p_enc->cond );
+            vlc_sem_destroy( &p_enc->picture_pool_has_room );
+            module_unneed( p_enc->p_encoder, p_enc->p_encoder->p_module );
+            p_enc->p_encoder->p_module = NULL;
+            return VLC_EGENERIC;
+        }
+    }
+    else if( p_cfg->video.threads.i_count > 0 )
     {
         if( vlc_clone( &p_enc->thread, EncoderThread, p_enc, p_cfg->video.threads.i_priority ) )
         {
@@ -487,6 +906,9 @@ int transcode_encoder_video_open( transcode_encoder_t *p_enc,
 
 block_t * transcode_encoder_video_encode( transcode_encoder_t *p_enc, picture_t *p_pic )
 {
+    if( p_enc->p_chunks )
+        return p_pic ? ChunksEncode( p_enc, p_pic ) : NULL;
+
     if( !p_enc->b_threaded )
     {
         return p_enc->p_encoder->pf_encode_video( p_enc->p_encoder, p_pic );
@@ -35,6 +35,7 @@
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
 #include <vlc_spu.h>
+#include <vlc_charset.h>
 
 #include "transcode.h"
 
@@ -75,6 +76,14 @@
 #define MAXHEIGHT_TEXT N_("Maximum video height")
 #define MAXHEIGHT_LONGTEXT N_( \
     "Maximum output video height." )
+#define RENDITION_TEXT N_("Additional rendition")
+#define RENDITION_LONGTEXT N_( \
+    "Encodes another rendition of the video from the same decoded " \
+    "pictures, for instance {vb=800,width=640,dst=std{...}}. A rendition " \
+    "accepts the venc, vcodec, vb, scale, width, height, maxwidth and " \
+    "maxheight options, and is output to its own dst chain if specified. " \
+    "This option can be repeated to build a bitrate ladder with a single " \
+    "decoder. The renditions of a video stream share its pool size." )
 #define VFILTER_TEXT N_("Video filter")
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
@@ -129,6 +138,21 @@
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
     "between decoder/encoder threads when threads > 0" )
+#define GOP_PARALLEL_TEXT N_("Parallel GOP encoders")
+#define GOP_PARALLEL_LONGTEXT N_( \
+    "Splits the video into chunks of closed GOPs, encodes this many chunks " \
+    "concurrently with separate encoder instances and concatenates them " \
+    "in order. Meant for offline file transcoding, as the output is " \
+    "delayed by up to one chunk per encoder. 0 disables it." )
+#define GOP_CHUNK_TEXT N_("Frames per parallel GOP chunk")
+#define GOP_CHUNK_LONGTEXT N_( \
+    "Number of frames given to each encoder instance when parallel GOP " \
+    "encoding is enabled." )
+#define GOP_QUEUE_TEXT N_("Parallel GOP queue size")
+#define GOP_QUEUE_LONGTEXT N_( \
+    "Maximum number of pictures waiting for the parallel GOP encoders. " \
+    "Decoding is paused when it is reached. The encoders only run " \
+    "concurrently for as many chunks as the queue can hold." )
 
 
 static const char *const ppsz_deinterlace_type[] =
@@ -177,6 +201,8 @@ vlc_module_begin ()
                  MAXHEIGHT_LONGTEXT, true )
     add_module_list(SOUT_CFG_PREFIX "vfilter", "video filter", NULL,
                     VFILTER_TEXT, VFILTER_LONGTEXT)
+    add_string( SOUT_CFG_PREFIX "rendition", NULL, RENDITION_TEXT,
+                RENDITION_LONGTEXT, true )
 
     set_section( N_("Audio"), NULL )
     add_module(SOUT_CFG_PREFIX "aenc", "encoder", NULL,
@@ -215,6 +241,15 @@ vlc_module_begin ()
         change_integer_range( 1, 1000 )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
+    add_integer( SOUT_CFG_PREFIX "gop-parallel", 0, GOP_PARALLEL_TEXT,
+                 GOP_PARALLEL_LONGTEXT, true )
+        change_integer_range( 0, 32 )
+    add_integer( SOUT_CFG_PREFIX "gop-chunk", 250, GOP_CHUNK_TEXT,
+                 GOP_CHUNK_LONGTEXT, true )
+        change_integer_range( 1, 100000 )
+    add_integer( SOUT_CFG_PREFIX "gop-queue", 100, GOP_QUEUE_TEXT,
+                 GOP_QUEUE_LONGTEXT, true )
+        change_integer_range( 1, 100000 )
 
 vlc_module_end ()
 
@@ -224,7 +259,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "rendition", "gop-parallel", "gop-chunk", "gop-queue", NULL
 };
 
 /*****************************************************************************
@@ -330,6 +365,84 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_OUTPUT;
     else
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_VIDEO;
+
+    p_cfg->video.chunks.i_count = var_GetInteger( p_stream, SOUT_CFG_PREFIX "gop-parallel" );
+    p_cfg->video.chunks.i_frames = var_GetInteger( p_stream, SOUT_CFG_PREFIX "gop-chunk" );
+    p_cfg->video.chunks.i_queue = var_GetInteger( p_stream, SOUT_CFG_PREFIX "gop-queue" );
+}
+
+static void DeleteRendition( transcode_rendition_config_t *p_cfg )
+{
+    free( p_cfg->psz_dst );
+    transcode_encoder_config_clean( &p_cfg->enc_cfg );
+    free( p_cfg );
+}
+
+static transcode_rendition_config_t *CreateRendition( sout_stream_t *p_stream,
+                                                      const char *psz_opts )
+{
+    transcode_rendition_config_t *p_cfg = calloc( 1, sizeof( *p_cfg ) );
+    if( !p_cfg )
+        return NULL;
+
+    /* Inherit the main video settings, but not its dimensions */
+    transcode_encoder_config_init( &p_cfg->enc_cfg );
+    SetVideoEncoderConfig( p_stream, &p_cfg->enc_cfg );
+    p_cfg->enc_cfg.video.f_scale = 0.f;
+    p_cfg->enc_cfg.video.i_width = p_cfg->enc_cfg.video.i_height = 0;
+    p_cfg->enc_cfg.video.i_maxwidth = p_cfg->enc_cfg.video.i_maxheight = 0;
+
+    config_chain_t *p_chain = NULL;
+    config_ChainParseOptions( &p_chain, psz_opts );
+
+    for( const config_chain_t *p = p_chain; p != NULL; p = p->p_next )
+    {
+        const char *psz_value = p->psz_value ? p->psz_value : "";
+
+        if( !strcmp( p->psz_name, "venc" ) )
+        {
+            free( p_cfg->enc_cfg.psz_name );
+            config_ChainDestroy( p_cfg->enc_cfg.p_config_chain );
+            free( config_ChainCreate( &p_cfg->enc_cfg.psz_name,
+                                      &p_cfg->enc_cfg.p_config_chain,
+                                      psz_value ) );
+        }
+        else if( !strcmp( p->psz_name, "vcodec" ) )
+        {
+            char fcc[5] = "    \0";
+            memcpy( fcc, psz_value, __MIN( strlen( psz_value ), 4 ) );
+            p_cfg->enc_cfg.i_codec = vlc_fourcc_GetCodecFromString( VIDEO_ES, fcc );
+        }
+        else if( !strcmp( p->psz_name, "vb" ) )
+        {
+            p_cfg->enc_cfg.video.i_bitrate = strtoul( psz_value, NULL, 10 );
+            if( p_cfg->enc_cfg.video.i_bitrate < 16000 )
+                p_cfg->enc_cfg.video.i_bitrate *= 1000;
+        }
+        else if( !strcmp( p->psz_name, "scale" ) )
+            p_cfg->enc_cfg.video.f_scale = us_atof( psz_value );
+        else if( !strcmp( p->psz_name, "width" ) )
+            p_cfg->enc_cfg.video.i_width = strtoul( psz_value, NULL, 10 );
+        else if( !strcmp( p->psz_name, "height" ) )
+            p_cfg->enc_cfg.video.i_height = strtoul( psz_value, NULL, 10 );
+        else if( !strcmp( p->psz_name, "maxwidth" ) )
+            p_cfg->enc_cfg.video.i_maxwidth = strtoul( psz_value, NULL, 10 );
+        else if( !strcmp( p->psz_name, "maxheight" ) )
+            p_cfg->enc_cfg.video.i_maxheight = strtoul( psz_value, NULL, 10 );
+        else if( !strcmp( p->psz_name, "dst" ) && !p_cfg->psz_dst )
+            p_cfg->psz_dst = strdup( psz_value );
+        else
+            msg_Warn( p_stream, "ignoring unknown rendition option `%s'",
+                      p->psz_name );
+    }
+    config_ChainDestroy( p_chain );
+
+    msg_Dbg( p_stream, "rendition video=%4.4s %ux%u scaling: %f %ukb/s",
+             (char *)&p_cfg->enc_cfg.i_codec,
+             p_cfg->enc_cfg.video.i_width, p_cfg->enc_cfg.video.i_height,
+             p_cfg->enc_cfg.video.f_scale,
+             p_cfg->enc_cfg.video.i_bitrate / 1000 );
+    return p_cfg;
 }
 
 static void SetSPUEncoderConfig( sout_stream_t *p_stream, transcode_encoder_config_t *p_cfg )
@@ -426,6 +539,20 @@ static int Open( vlc_object_t *p_this )
                  p_sys->venc_cfg.video.i_bitrate / 1000 );
     }
 
+    /* Additional renditions of the video */
+    TAB_INIT( p_sys->i_renditions, p_sys->pp_renditions );
+    for( config_chain_t *p_cfg = p_stream->p_cfg; p_cfg; p_cfg = p_cfg->p_next )
+    {
+        if( strcmp( p_cfg->psz_name, "rendition" ) || !p_cfg->psz_value )
+            continue;
+
+        transcode_rendition_config_t *p_rendition =
+            CreateRendition( p_stream, p_cfg->psz_value );
+        if( p_rendition )
+            TAB_APPEND( p_sys->i_renditions, p_sys->pp_renditions,
+                        p_rendition );
+    }
+
     /* Video Filter Parameters */
     sout_filters_config_init( &p_sys->vfilters_cfg );
 
@@ -488,6 +615,9 @@ static void Close( vlc_object_t * p_this )
 
     transcode_encoder_config_clean( &p_sys->venc_cfg );
     sout_filters_config_clean( &p_sys->vfilters_cfg );
+    for( int i = 0; i < p_sys->i_renditions; i++ )
+        DeleteRendition( p_sys->pp_renditions[i] );
+    TAB_CLEAN( p_sys->i_renditions, p_sys->pp_renditions );
 
     transcode_encoder_config_clean( &p_sys->aenc_cfg );
     sout_filters_config_clean( &p_sys->afilters_cfg );
@@ -650,6 +780,10 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     else if( p_fmt->i_cat == VIDEO_ES && id->p_enccfg->i_codec )
     {
         success = !transcode_video_init(p_stream, p_fmt, id);
+        if( success && p_sys->i_renditions > 0 )
+            transcode_video_renditions_init( p_stream, id,
+                                             p_sys->pp_renditions,
+                                             p_sys->i_renditions );
         vlc_mutex_lock( &p_sys->lock );
         if( success && !p_sys->id_video )
             p_sys->id_video = id;
@@ -705,7 +839,7 @@ static void Del( sout_stream_t *p_stream, void *_id )
             if( id == p_sys->id_video )
                 p_sys->id_video = NULL;
             vlc_mutex_unlock( &p_sys->lock );
-            transcode_video_clean( id );
+            transcode_video_clean( p_stream, id );
             break;
         case SPU_ES:
             decoder_Destroy( id->p_decoder );
@@ -1,4 +1,5 @@
 #include <vlc_picture_fifo.h>
+#include <vlc_picture_pool.h>
 #include <vlc_filter.h>
 #include <vlc_codec.h>
 #include "encoder/encoder.h"
@@ -39,6 +40,16 @@ void sout_filters_config_clean( sout_filters_config_t *p_cfg )
     free( p_cfg->video.psz_spu_sources );
 }
 
+typedef struct
+{
+    transcode_encoder_config_t enc_cfg;
+    /* Output chain, created for each video ES, or NULL to output next to
+     * the main rendition */
+    char           *psz_dst;
+} transcode_rendition_config_t;
+
+typedef struct transcode_rendition_t transcode_rendition_t;
+
 typedef struct sout_stream_id_sys_t sout_stream_id_sys_t;
 
 typedef struct
@@ -52,6 +63,9 @@ typedef struct
     /* Video */
     transcode_encoder_config_t venc_cfg;
     sout_filters_config_t vfilters_cfg;
+    /* Additional video renditions, encoded from the same decoder */
+    int             i_renditions;
+    transcode_rendition_config_t **pp_renditions;
 
     /* SPU */
     transcode_encoder_config_t senc_cfg;
@@ -130,6 +144,19 @@ struct sout_stream_id_sys_t
              spu_t           *p_spu;
              vlc_decoder_device *dec_dev;
              vlc_video_context *enc_vctx_in;
+             int              i_renditions;
+             transcode_rendition_t **pp_renditions;
+             picture_pool_t  *p_pool; /**< Pictures in encoder input format */
+             video_format_t   pool_fmt;
+             struct
+             {
+                 uint64_t i_decoded;
+                 uint64_t i_passthrough; /**< decoded pictures encoded as is */
+                 uint64_t i_converted;
+                 uint64_t i_copied;
+                 uint64_t i_pooled;      /**< buffers taken from p_pool */
+                 uint64_t i_allocated;   /**< buffers allocated on the heap */
+             } counters;
          };
          struct
          {
@@ -207,7 +234,7 @@ int  transcode_audio_init   ( sout_stream_t *, const es_format_t *,
 
 /* VIDEO */
 
-void transcode_video_clean  ( sout_stream_id_sys_t * );
+void transcode_video_clean  ( sout_stream_t *, sout_stream_id_sys_t * );
 int  transcode_video_process( sout_stream_t *, sout_stream_id_sys_t *,
                                      block_t *, block_t ** );
 int transcode_video_get_output_dimensions( sout_stream_id_sys_t *,
@@ -215,3 +242,6 @@ int transcode_video_get_output_dimensions( sout_stream_id_sys_t *,
 void transcode_video_push_spu( sout_stream_t *, sout_stream_id_sys_t *, subpicture_t * );
 int  transcode_video_init    ( sout_stream_t *, const es_format_t *,
                                sout_stream_id_sys_t *);
+void transcode_video_renditions_init( sout_stream_t *, sout_stream_id_sys_t *,
+                                      transcode_rendition_config_t *const *,
+                                      int );
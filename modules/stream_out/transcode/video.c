@@ -154,15 +154,73 @@ static int video_update_format_decoder( decoder_t *p_dec, vlc_video_context *vct
     return chain_works;
 }
 
-static picture_t *video_new_buffer_encoder( transcode_encoder_t *p_enc )
+/* Pictures in the encoder input format are taken from a pool, so that the
+ * decoder or the last converter writes straight into a buffer the encoder
+ * takes by reference, rather than into a new allocation for each frame. */
+static picture_t *transcode_video_picture_new( sout_stream_id_sys_t *id,
+                                               const video_format_t *p_fmt )
 {
-    return picture_NewFromFormat( &transcode_encoder_format_in( p_enc )->video );
+    picture_t *p_pic = NULL;
+
+    vlc_mutex_lock( &id->fifo.lock );
+    if( id->p_pool && video_format_IsSimilar( &id->pool_fmt, p_fmt ) )
+        p_pic = picture_pool_Get( id->p_pool );
+    if( p_pic )
+        id->counters.i_pooled++;
+    else
+        id->counters.i_allocated++;
+    vlc_mutex_unlock( &id->fifo.lock );
+
+    if( !p_pic )
+        p_pic = picture_NewFromFormat( p_fmt );
+    return p_pic;
+}
+
+static void transcode_video_pool_update( sout_stream_id_sys_t *id )
+{
+    const video_format_t *p_fmt = &transcode_encoder_format_in( id->encoder )->video;
+
+    if( id->p_pool && video_format_IsSimilar( &id->pool_fmt, p_fmt ) )
+        return;
+
+    /* Enough for the pictures in flight between decoder and encoder, and
+     * for those held by the renditions */
+    unsigned i_count = 3;
+    if( id->p_enccfg->video.threads.i_count > 0 )
+        i_count += id->p_enccfg->video.threads.pool_size;
+    if( id->i_renditions > 0 )
+        i_count += id->p_enccfg->video.threads.pool_size;
+
+    picture_pool_t *p_pool = picture_pool_NewFromFormat( p_fmt, i_count );
+
+    vlc_mutex_lock( &id->fifo.lock );
+    picture_pool_t *p_old = id->p_pool;
+    id->p_pool = p_pool;
+    video_format_Clean( &id->pool_fmt );
+    video_format_Copy( &id->pool_fmt, p_fmt );
+    vlc_mutex_unlock( &id->fifo.lock );
+
+    if( p_old )
+        picture_pool_Release( p_old );
+}
+
+static picture_t *video_new_buffer_decoder( decoder_t *p_dec )
+{
+    struct decoder_owner *p_owner = dec_get_owner( p_dec );
+    return transcode_video_picture_new( p_owner->id, &p_dec->fmt_out.video );
+}
+
+static picture_t *video_new_buffer_encoder( sout_stream_id_sys_t *id )
+{
+    return transcode_video_picture_new( id,
+                        &transcode_encoder_format_in( id->encoder )->video );
 }
 
 static picture_t *transcode_video_filter_buffer_new( filter_t *p_filter )
 {
     p_filter->fmt_out.video.i_chroma = p_filter->fmt_out.i_codec;
-    return picture_NewFromFormat( &p_filter->fmt_out.video );
+    return transcode_video_picture_new( p_filter->owner.sys,
+                                        &p_filter->fmt_out.video );
 }
 
 
@@ -188,6 +246,55 @@ static picture_t *transcode_dequeue_all_pics( sout_stream_id_sys_t *id )
     return p_pics;
 }
 
+static transcode_encoder_t *
+transcode_video_encoder_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                             const transcode_encoder_config_t *p_cfg )
+{
+    /* Should be the same format until encoder loads */
+    es_format_t encoder_tested_fmt_in;
+    es_format_Init( &encoder_tested_fmt_in, id->decoder_out.i_cat, 0 );
+
+    struct encoder_owner *p_enc_owner = (struct encoder_owner*)sout_EncoderCreate(p_stream, sizeof(struct encoder_owner));
+    if ( unlikely(p_enc_owner == NULL))
+    {
+        es_format_Clean( &encoder_tested_fmt_in );
+        return NULL;
+    }
+    p_enc_owner->id = id;
+    p_enc_owner->enc.cbs = &encoder_video_transcode_cbs;
+
+    if( transcode_encoder_test( &p_enc_owner->enc,
+                                p_cfg,
+                                &id->p_decoder->fmt_in,
+                                id->p_decoder->fmt_out.i_codec,
+                                &encoder_tested_fmt_in ) )
+    {
+        es_format_Clean( &encoder_tested_fmt_in );
+        return NULL;
+    }
+
+    p_enc_owner = (struct encoder_owner *)sout_EncoderCreate(p_stream, sizeof(struct encoder_owner));
+    if ( unlikely(p_enc_owner == NULL))
+    {
+        es_format_Clean( &encoder_tested_fmt_in );
+        return NULL;
+    }
+
+    transcode_encoder_t *encoder =
+        transcode_encoder_new( &p_enc_owner->enc, &encoder_tested_fmt_in );
+    if( encoder )
+    {
+        p_enc_owner->id = id;
+        p_enc_owner->enc.cbs = &encoder_video_transcode_cbs;
+
+        /* Will use this format as encoder input for now */
+        transcode_encoder_update_format_in( encoder, &encoder_tested_fmt_in );
+    }
+
+    es_format_Clean( &encoder_tested_fmt_in );
+    return encoder;
+}
+
 int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
                           sout_stream_id_sys_t *id )
 {
@@ -210,6 +317,7 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
         .video = {
             .get_device = video_get_decoder_device,
             .format_update = video_update_format_decoder,
+            .buffer_new = video_new_buffer_decoder,
             .queue = decoder_queue_video,
         },
     };
@@ -240,62 +348,14 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
      * once the first frame is decoded, we actually only test the availability
      * of the encoder here.
      */
-
-    /* Should be the same format until encoder loads */
-    es_format_t encoder_tested_fmt_in;
-    es_format_Init( &encoder_tested_fmt_in, id->decoder_out.i_cat, 0 );
-
-    struct encoder_owner *p_enc_owner = (struct encoder_owner*)sout_EncoderCreate(p_stream, sizeof(struct encoder_owner));
-    if ( unlikely(p_enc_owner == NULL))
-    {
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        es_format_Clean( &id->decoder_out );
-        es_format_Clean( &encoder_tested_fmt_in );
-        return VLC_EGENERIC;
-    }
-    p_enc_owner->id = id;
-    p_enc_owner->enc.cbs = &encoder_video_transcode_cbs;
-
-    if( transcode_encoder_test( &p_enc_owner->enc,
-                                id->p_enccfg,
-                                &id->p_decoder->fmt_in,
-                                id->p_decoder->fmt_out.i_codec,
-                                &encoder_tested_fmt_in ) )
-    {
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        es_format_Clean( &id->decoder_out );
-        es_format_Clean( &encoder_tested_fmt_in );
-        return VLC_EGENERIC;
-    }
-
-    p_enc_owner = (struct encoder_owner *)sout_EncoderCreate(p_stream, sizeof(struct encoder_owner));
-    if ( unlikely(p_enc_owner == NULL))
-    {
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        es_format_Clean( &encoder_tested_fmt_in );
-        es_format_Clean( &id->decoder_out );
-        return VLC_EGENERIC;
-    }
-
-    id->encoder = transcode_encoder_new( &p_enc_owner->enc, &encoder_tested_fmt_in );
+    id->encoder = transcode_video_encoder_new( p_stream, id, id->p_enccfg );
     if( !id->encoder )
     {
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
-        es_format_Clean( &encoder_tested_fmt_in );
         es_format_Clean( &id->decoder_out );
         return VLC_EGENERIC;
     }
-    p_enc_owner->id = id;
-    p_enc_owner->enc.cbs = &encoder_video_transcode_cbs;
-
-    /* Will use this format as encoder input for now */
-    transcode_encoder_update_format_in( id->encoder, &encoder_tested_fmt_in );
-
-    es_format_Clean( &encoder_tested_fmt_in );
 
     return VLC_SUCCESS;
 }
@@ -308,6 +368,8 @@ static const struct filter_video_callbacks transcode_filter_video_cbs =
 /* Take care of the scaling and chroma conversions. */
 static int transcode_video_set_conversions( sout_stream_t *p_stream,
                                             sout_stream_id_sys_t *id,
+                                            filter_chain_t **pp_nonstatic,
+                                            filter_chain_t **pp_static,
                                             const es_format_t **pp_src,
                                             vlc_video_context **pp_src_vctx,
                                             const es_format_t *p_dst,
@@ -350,8 +412,8 @@ static int transcode_video_set_conversions( sout_stream_t *p_stream,
                  b_do_scale, b_do_chroma, b_do_orient );
 
         filter_chain_t **pp_chain = (step == STEP_NONSTATIC)
-                ? &id->p_conv_nonstatic
-                : &id->p_conv_static;
+                ? pp_nonstatic
+                : pp_static;
 
         *pp_chain = filter_chain_NewVideo( p_stream, step == STEP_NONSTATIC, &owner );
         if( !*pp_chain )
@@ -411,8 +473,9 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
     }
 
     /* Chroma and other conversions */
-    if( transcode_video_set_conversions( p_stream, id, &p_src, &src_ctx, p_dst,
-                                         p_cfg->video.b_reorient ) != VLC_SUCCESS )
+    if( transcode_video_set_conversions( p_stream, id, &id->p_conv_nonstatic,
+                                         &id->p_conv_static, &p_src, &src_ctx,
+                                         p_dst, p_cfg->video.b_reorient ) != VLC_SUCCESS )
         return VLC_EGENERIC;
 
     /* User filters */
@@ -441,8 +504,392 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
-void transcode_video_clean( sout_stream_id_sys_t *id )
+static void tag_last_block_with_flag( block_t **out, int i_flag )
+{
+    block_t *p_last = *out;
+    if( p_last )
+    {
+        while( p_last->p_next )
+            p_last = p_last->p_next;
+        p_last->i_flags |= i_flag;
+    }
+}
+
+/*
+ * Renditions: additional encodings of the same decoded pictures.
+ * Each rendition scales and encodes in its own thread, while the encoded
+ * output is sent downstream from the stream output thread.
+ */
+struct transcode_rendition_t
+{
+    const transcode_rendition_config_t *p_cfg;
+    sout_stream_t   *p_first; /**< own output chain, if any */
+    sout_stream_t   *p_last;
+    sout_stream_t   *p_out;
+    void            *downstream_id;
+    transcode_encoder_t *encoder;
+    filter_chain_t  *p_conv_nonstatic;
+    filter_chain_t  *p_conv_static;
+    bool             b_error;
+
+    vlc_thread_t     thread;
+    vlc_mutex_t      lock;
+    vlc_cond_t       wait_pics; /**< signaled when a picture is queued */
+    vlc_cond_t       wait_done; /**< signaled when a picture is encoded */
+    picture_fifo_t  *p_pics;
+    unsigned         i_pics; /**< pictures queued or being encoded */
+    unsigned         i_max_pics;
+    bool             b_exit;
+    block_t         *p_blocks; /**< encoded data to send downstream */
+};
+
+static void transcode_rendition_encode( transcode_rendition_t *r,
+                                        picture_t *p_pic, block_t **out )
+{
+    filter_chain_t *chains[] = { r->p_conv_nonstatic, r->p_conv_static };
+
+    for( size_t i = 0; p_pic && i < ARRAY_SIZE(chains); i++ )
+    {
+        if( chains[i] )
+            p_pic = filter_chain_VideoFilter( chains[i], p_pic );
+    }
+
+    if( p_pic )
+    {
+        block_ChainAppend( out, transcode_encoder_encode( r->encoder, p_pic ) );
+        picture_Release( p_pic );
+    }
+}
+
+static void *RenditionThread( void *data )
 {
+    transcode_rendition_t *r = data;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &r->lock );
+    for( ;; )
+    {
+        picture_t *p_pic;
+
+        while( (p_pic = picture_fifo_Pop( r->p_pics )) == NULL && !r->b_exit )
+            vlc_cond_wait( &r->wait_pics, &r->lock );
+        if( p_pic == NULL )
+            break;
+
+        /* The configuration only changes while no picture is pending */
+        vlc_mutex_unlock( &r->lock );
+
+        block_t *p_out = NULL;
+        transcode_rendition_encode( r, p_pic, &p_out );
+
+        vlc_mutex_lock( &r->lock );
+        block_ChainAppend( &r->p_blocks, p_out );
+        r->i_pics--;
+        vlc_cond_signal( &r->wait_done );
+    }
+    vlc_mutex_unlock( &r->lock );
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+/* Waits until the rendition thread is idle and returns its output. */
+static block_t *transcode_rendition_sync( transcode_rendition_t *r )
+{
+    vlc_mutex_lock( &r->lock );
+    while( r->i_pics > 0 )
+        vlc_cond_wait( &r->wait_done, &r->lock );
+    block_t *p_out = r->p_blocks;
+    r->p_blocks = NULL;
+    vlc_mutex_unlock( &r->lock );
+
+    if( r->p_cfg->enc_cfg.video.threads.i_count >= 1 )
+        block_ChainAppend( &p_out,
+                           transcode_encoder_get_output_async( r->encoder ) );
+    return p_out;
+}
+
+static void transcode_rendition_send( transcode_rendition_t *r, block_t *p_out )
+{
+    if( p_out == NULL )
+        return;
+    if( r->downstream_id )
+        sout_StreamIdSend( r->p_out, r->downstream_id, p_out );
+    else
+        block_ChainRelease( p_out );
+}
+
+static void transcode_rendition_delete( transcode_rendition_t *r )
+{
+    vlc_mutex_lock( &r->lock );
+    r->b_exit = true;
+    vlc_cond_signal( &r->wait_pics );
+    vlc_mutex_unlock( &r->lock );
+    vlc_join( r->thread, NULL );
+
+    block_ChainRelease( r->p_blocks );
+    transcode_encoder_close( r->encoder );
+    transcode_encoder_delete( r->encoder );
+    transcode_remove_filters( &r->p_conv_nonstatic );
+    transcode_remove_filters( &r->p_conv_static );
+    if( r->downstream_id )
+        sout_StreamIdDel( r->p_out, r->downstream_id );
+    if( r->p_first )
+        sout_StreamChainDelete( r->p_first, r->p_last );
+    picture_fifo_Delete( r->p_pics );
+    vlc_cond_destroy( &r->wait_done );
+    vlc_cond_destroy( &r->wait_pics );
+    vlc_mutex_destroy( &r->lock );
+    free( r );
+}
+
+static transcode_rendition_t *
+transcode_rendition_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                         const transcode_rendition_config_t *p_cfg,
+                         unsigned i_max_pics )
+{
+    transcode_rendition_t *r = calloc( 1, sizeof( *r ) );
+    if( unlikely(r == NULL) )
+        return NULL;
+
+    r->p_cfg = p_cfg;
+    r->i_max_pics = i_max_pics;
+    r->p_pics = picture_fifo_New();
+    if( unlikely(r->p_pics == NULL) )
+    {
+        free( r );
+        return NULL;
+    }
+
+    r->encoder = transcode_video_encoder_new( p_stream, id, &p_cfg->enc_cfg );
+    if( r->encoder == NULL )
+    {
+        picture_fifo_Delete( r->p_pics );
+        free( r );
+        return NULL;
+    }
+
+    if( p_cfg->psz_dst )
+    {
+        r->p_first = sout_StreamChainNew( p_stream->p_sout, p_cfg->psz_dst,
+                                          NULL, &r->p_last );
+        if( r->p_first == NULL )
+        {
+            msg_Err( p_stream, "cannot create rendition chain `%s'",
+                     p_cfg->psz_dst );
+            transcode_encoder_delete( r->encoder );
+            picture_fifo_Delete( r->p_pics );
+            free( r );
+            return NULL;
+        }
+    }
+    r->p_out = r->p_first ? r->p_first : p_stream->p_next;
+
+    vlc_mutex_init( &r->lock );
+    vlc_cond_init( &r->wait_pics );
+    vlc_cond_init( &r->wait_done );
+
+    if( vlc_clone( &r->thread, RenditionThread, r,
+                   p_cfg->enc_cfg.video.threads.i_priority ) )
+    {
+        vlc_cond_destroy( &r->wait_done );
+        vlc_cond_destroy( &r->wait_pics );
+        vlc_mutex_destroy( &r->lock );
+        if( r->p_first )
+            sout_StreamChainDelete( r->p_first, r->p_last );
+        transcode_encoder_delete( r->encoder );
+        picture_fifo_Delete( r->p_pics );
+        free( r );
+        return NULL;
+    }
+    return r;
+}
+
+void transcode_video_renditions_init( sout_stream_t *p_stream,
+                                      sout_stream_id_sys_t *id,
+                                      transcode_rendition_config_t *const *pp_cfg,
+                                      int i_cfg )
+{
+    TAB_INIT( id->i_renditions, id->pp_renditions );
+
+    /* The renditions share the pool size of the stream, so that they do not
+     * hold more pictures all together than a single encoder would. */
+    unsigned i_max_pics = id->p_enccfg->video.threads.pool_size / i_cfg;
+    if( i_max_pics == 0 )
+        i_max_pics = 1;
+
+    for( int i = 0; i < i_cfg; i++ )
+    {
+        transcode_rendition_t *r = transcode_rendition_new( p_stream, id,
+                                                            pp_cfg[i],
+                                                            i_max_pics );
+        if( r == NULL )
+        {
+            msg_Err( p_stream, "cannot create video rendition %d", i );
+            continue;
+        }
+        TAB_APPEND( id->i_renditions, id->pp_renditions, r );
+    }
+
+    msg_Dbg( p_stream, "encoding %d additional video rendition(s) from one "
+             "decoder", id->i_renditions );
+}
+
+/* (Re)configures a rendition for the given source, after the main
+ * rendition filters. The rendition thread must be idle. */
+static int transcode_rendition_configure( sout_stream_t *p_stream,
+                                          sout_stream_id_sys_t *id,
+                                          transcode_rendition_t *r,
+                                          const es_format_t *p_src,
+                                          vlc_video_context *src_ctx )
+{
+    const transcode_encoder_config_t *p_cfg = &r->p_cfg->enc_cfg;
+
+    transcode_remove_filters( &r->p_conv_nonstatic );
+    transcode_remove_filters( &r->p_conv_static );
+
+    if( !transcode_encoder_opened( r->encoder ) )
+        transcode_encoder_video_configure( VLC_OBJECT(p_stream),
+                                           &id->p_decoder->fmt_out.video,
+                                           p_cfg, &p_src->video, src_ctx,
+                                           r->encoder );
+
+    if( transcode_video_set_conversions( p_stream, id, &r->p_conv_nonstatic,
+                                         &r->p_conv_static, &p_src, &src_ctx,
+                                         transcode_encoder_format_in( r->encoder ),
+                                         id->p_filterscfg->video.b_reorient ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    if( !transcode_encoder_opened( r->encoder ) &&
+        transcode_encoder_open( r->encoder, p_cfg ) != VLC_SUCCESS )
+    {
+        msg_Err( p_stream, "cannot find rendition video encoder (module:%s "
+                 "fourcc:%4.4s)", p_cfg->psz_name ? p_cfg->psz_name : "any",
+                 (char *)&p_cfg->i_codec );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_stream, "rendition destination %ux%u",
+             transcode_encoder_format_in( r->encoder )->video.i_width,
+             transcode_encoder_format_in( r->encoder )->video.i_height );
+
+    if( !r->downstream_id )
+    {
+        es_format_t fmt;
+        es_format_Init( &fmt, VIDEO_ES, 0 );
+        es_format_Copy( &fmt, transcode_encoder_format_out( r->encoder ) );
+        es_format_SetMeta( &fmt, &id->p_decoder->fmt_in );
+        r->downstream_id = sout_StreamIdAdd( r->p_out, &fmt );
+        es_format_Clean( &fmt );
+        if( !r->downstream_id )
+        {
+            msg_Err( p_stream, "cannot output rendition stream %4.4s",
+                     (char *)&p_cfg->i_codec );
+            return VLC_EGENERIC;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_renditions_configure( sout_stream_t *p_stream,
+                                                  sout_stream_id_sys_t *id )
+{
+    const es_format_t *p_src = filter_chain_GetFmtOut( id->p_f_chain );
+    vlc_video_context *src_ctx = filter_chain_GetVideoCtxOut( id->p_f_chain );
+
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+
+        transcode_rendition_send( r, transcode_rendition_sync( r ) );
+        if( !r->b_error &&
+            transcode_rendition_configure( p_stream, id, r, p_src,
+                                           src_ctx ) != VLC_SUCCESS )
+        {
+            msg_Err( p_stream, "disabling video rendition %d", i );
+            r->b_error = true;
+        }
+    }
+}
+
+static void transcode_video_renditions_push( sout_stream_id_sys_t *id,
+                                             picture_t *p_pic )
+{
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+
+        if( r->b_error || !transcode_encoder_opened( r->encoder ) )
+            continue;
+
+        /* Shallow copy: the planes are shared, but not the queue linkage */
+        picture_t *p_clone = picture_Clone( p_pic );
+        if( unlikely(p_clone == NULL) )
+            continue;
+        picture_CopyProperties( p_clone, p_pic );
+
+        vlc_mutex_lock( &r->lock );
+        while( r->i_pics >= r->i_max_pics )
+            vlc_cond_wait( &r->wait_done, &r->lock );
+        picture_fifo_Push( r->p_pics, p_clone );
+        r->i_pics++;
+        vlc_cond_signal( &r->wait_pics );
+        vlc_mutex_unlock( &r->lock );
+    }
+}
+
+/* Sends the renditions output; optionally drains or closes the encoders. */
+static void transcode_video_renditions_output( sout_stream_id_sys_t *id,
+                                               bool b_drain, bool b_close )
+{
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+        block_t *p_out;
+
+        if( b_drain )
+        {
+            p_out = transcode_rendition_sync( r );
+            if( transcode_encoder_opened( r->encoder ) )
+                transcode_encoder_drain( r->encoder, &p_out );
+        }
+        else
+        {
+            vlc_mutex_lock( &r->lock );
+            p_out = r->p_blocks;
+            r->p_blocks = NULL;
+            vlc_mutex_unlock( &r->lock );
+            if( r->p_cfg->enc_cfg.video.threads.i_count >= 1 &&
+                transcode_encoder_opened( r->encoder ) )
+                block_ChainAppend( &p_out,
+                                   transcode_encoder_get_output_async( r->encoder ) );
+        }
+
+        if( b_close )
+        {
+            transcode_encoder_close( r->encoder );
+            transcode_remove_filters( &r->p_conv_nonstatic );
+            transcode_remove_filters( &r->p_conv_static );
+            tag_last_block_with_flag( &p_out, BLOCK_FLAG_END_OF_SEQUENCE );
+        }
+        transcode_rendition_send( r, p_out );
+    }
+}
+
+void transcode_video_clean( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    msg_Dbg( p_stream, "video pictures: %"PRIu64" decoded, %"PRIu64" encoded "
+             "as decoded, %"PRIu64" converted, %"PRIu64" copied; buffers: "
+             "%"PRIu64" pooled, %"PRIu64" allocated",
+             id->counters.i_decoded, id->counters.i_passthrough,
+             id->counters.i_converted, id->counters.i_copied,
+             id->counters.i_pooled, id->counters.i_allocated );
+
+    /* Close renditions */
+    for( int i = 0; i < id->i_renditions; i++ )
+        transcode_rendition_delete( id->pp_renditions[i] );
+    TAB_CLEAN( id->i_renditions, id->pp_renditions );
+
     /* Close encoder */
     transcode_encoder_close( id->encoder );
     transcode_encoder_delete( id->encoder );
@@ -461,6 +908,9 @@ void transcode_video_clean( sout_stream_id_sys_t *id )
         spu_Destroy( id->p_spu );
     if ( id->dec_dev )
         vlc_decoder_device_Release( id->dec_dev );
+    if( id->p_pool )
+        picture_pool_Release( id->p_pool );
+    video_format_Clean( &id->pool_fmt );
 }
 
 void transcode_video_push_spu( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
@@ -484,7 +934,14 @@ int transcode_video_get_output_dimensions( sout_stream_id_sys_t *id,
     return (*w && *h) ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
-static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic )
+/* Whether the caller holds the only reference to the picture */
+static bool transcode_picture_IsPrivate( picture_t *p_pic )
+{
+    return atomic_load_explicit( &p_pic->refs, memory_order_acquire ) == 1;
+}
+
+static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic,
+                                      bool b_writable )
 {
     if( !id->p_spu )
         return p_pic;
@@ -510,16 +967,17 @@ static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic
     /* Overlay subpicture */
     if( p_subpic )
     {
-        if( filter_chain_IsEmpty( id->p_f_chain ) )
+        if( !b_writable )
         {
             /* We can't modify the picture, we need to duplicate it,
                  * in this point the picture is already p_encoder->fmt.in format*/
-            picture_t *p_tmp = video_new_buffer_encoder( id->encoder );
+            picture_t *p_tmp = video_new_buffer_encoder( id );
             if( likely( p_tmp ) )
             {
                 picture_Copy( p_tmp, p_pic );
                 picture_Release( p_pic );
                 p_pic = p_tmp;
+                id->counters.i_copied++;
             }
         }
         if( unlikely( !id->p_spu_blender ) )
@@ -534,17 +992,6 @@ static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic
     return p_pic;
 }
 
-static void tag_last_block_with_flag( block_t **out, int i_flag )
-{
-    block_t *p_last = *out;
-    if( p_last )
-    {
-        while( p_last->p_next )
-            p_last = p_last->p_next;
-        p_last->i_flags |= i_flag;
-    }
-}
-
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
 {
@@ -572,6 +1019,8 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             picture_Release( p_pic );
             continue;
         }
+        if( p_pic )
+            id->counters.i_decoded++;
 
         if( p_pic && ( unlikely(!transcode_encoder_opened(id->encoder)) ||
               !video_format_IsSimilar( &id->decoder_out.video, &p_pic->format ) ) )
@@ -649,6 +1098,9 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                    (char *) &id->p_enccfg->i_codec );
                 goto error;
             }
+
+            transcode_video_pool_update( id );
+            transcode_video_renditions_configure( p_stream, id );
         }
 
         /* Run the filter and output chains; first with the picture,
@@ -657,15 +1109,40 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
          */
         for ( picture_t *p_in = p_pic; ; p_in = NULL /* drain second time */ )
         {
-            /* Run filter chain */
-            filter_chain_t * primary_chains[] = { id->p_f_chain,
-                                                  id->p_conv_nonstatic,
+            /* Whether the picture is still the decoded one, and whether it
+             * is a new one that nothing else uses and that can be modified */
+            bool b_decoded = true;
+            bool b_private = false;
+
+            /* Run filter chain, which may output more than one picture */
+            if( id->p_f_chain )
+            {
+                picture_t *p_filtered = filter_chain_VideoFilter( id->p_f_chain, p_in );
+                /* Filters may output pictures they still hold, e.g. the fps
+                 * filter: only an unreferenced new picture can be modified */
+                b_private = p_filtered != NULL && p_filtered != p_in
+                         && transcode_picture_IsPrivate( p_filtered );
+                b_decoded = !b_private;
+                p_in = p_filtered;
+            }
+
+            /* Renditions scale and encode the same filtered pictures */
+            if( p_in && id->i_renditions > 0 )
+            {
+                transcode_video_renditions_push( id, p_in );
+                b_private = false;
+            }
+
+            bool b_converted = false;
+            filter_chain_t * primary_chains[] = { id->p_conv_nonstatic,
                                                   id->p_conv_static };
             for( size_t i=0; p_in && i<ARRAY_SIZE(primary_chains); i++ )
             {
                 if( !primary_chains[i] )
                     continue;
-                p_in = filter_chain_VideoFilter( primary_chains[i], p_in );
+                picture_t *p_conv = filter_chain_VideoFilter( primary_chains[i], p_in );
+                b_converted |= p_conv != p_in;
+                p_in = p_conv;
             }
 
             if( !p_in )
@@ -680,17 +1157,26 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                 {
                     if( !secondary_chains[i] )
                         continue;
-                    p_in = filter_chain_VideoFilter( secondary_chains[i], p_in );
+                    picture_t *p_conv = filter_chain_VideoFilter( secondary_chains[i], p_in );
+                    b_converted |= p_conv != p_in;
+                    p_in = p_conv;
                 }
 
                 if( !p_in )
                     break;
 
                 /* Blend subpictures */
-                p_in = RenderSubpictures( id, p_in );
+                picture_t *p_render = RenderSubpictures( id, p_in,
+                                                         b_private || b_converted );
+                b_decoded &= p_render == p_in;
+                p_in = p_render;
 
                 if( p_in )
                 {
+                    if( b_converted )
+                        id->counters.i_converted++;
+                    else if( b_decoded )
+                        id->counters.i_passthrough++;
                     block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
                     if( p_encoded )
                         block_ChainAppend( out, p_encoded );
@@ -712,6 +1198,7 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             transcode_remove_filters( &id->p_uf_chain );
             transcode_remove_filters( &id->p_final_conv_static );
             tag_last_block_with_flag( out, BLOCK_FLAG_END_OF_SEQUENCE );
+            transcode_video_renditions_output( id, true, true );
             b_eos = false;
         }
 
@@ -728,6 +1215,9 @@ error:
         block_ChainAppend( out, transcode_encoder_get_output_async( id->encoder ) );
     }
 
+    /* Pick up, or drain on end of stream, the renditions output */
+    transcode_video_renditions_output( id, unlikely( in == NULL ), false );
+
     /* Drain encoder */
     if( unlikely( !id->b_error && in == NULL ) && transcode_encoder_opened( id->encoder ) )
     {
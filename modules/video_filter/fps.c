@@ -118,6 +118,8 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
     {
         picture_t *p_tmp = NULL;
         p_tmp = picture_NewFromFormat( &p_filter->fmt_out.video );
+        if( unlikely(p_tmp == NULL) )
+            break;
 
         picture_Copy( p_tmp, p_sys->p_previous_pic);
         p_tmp->date = date_Get( &p_sys->next_output_pts );
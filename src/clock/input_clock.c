@@ -98,6 +98,11 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET VLC_TICK_FROM_MS(100)
 
+/* Decay of the arrival jitter estimation, as a fraction of the elapsed time:
+ * 1/32, i.e. about 31ms per second.
+ */
+#define CR_JITTER_DECAY (32)
+
 /* */
 #define INPUT_CLOCK_LATE_COUNT (3)
 
@@ -128,6 +133,9 @@ struct input_clock_t
         unsigned i_index;
     } late;
 
+    /* Slowly decaying maximum of the arrival delays */
+    vlc_tick_t i_arrival_jitter;
+
     /* Reference point */
     clock_point_t ref;
     bool          b_has_reference;
@@ -174,6 +182,7 @@ input_clock_t *input_clock_New( float rate )
     cl->late.i_index = 0;
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
         cl->late.pi_value[i] = 0;
+    cl->i_arrival_jitter = 0;
 
     cl->rate = rate;
     cl->i_pts_delay = 0;
@@ -272,12 +281,19 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     //fprintf( stderr, "input_clock_Update: %d :: %lld\n", b_buffering_allowed, cl->i_buffering_duration/1000 );
 
     /* */
+    const vlc_tick_t i_elapsed = cl->last.system != VLC_TICK_INVALID ?
+                                 __MAX( i_ck_system - cl->last.system, 0 ) : 0;
     cl->last = clock_point_Create( i_ck_system, i_ck_stream );
 
     /* It does not take the decoder latency into account but it is not really
      * the goal of the clock here */
     const vlc_tick_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + AvgGet( &cl->drift ) );
-    const vlc_tick_t i_late = ( i_ck_system - cl->i_pts_delay ) - i_system_expected;
+    const vlc_tick_t i_arrival = i_ck_system - i_system_expected;
+    const vlc_tick_t i_late = i_arrival - cl->i_pts_delay;
+
+    if( !b_can_pace_control )
+        cl->i_arrival_jitter = __MAX( i_arrival, __MAX( cl->i_arrival_jitter
+                                         - i_elapsed / CR_JITTER_DECAY, 0 ) );
     if( i_late > 0 )
     {
         cl->late.pi_value[cl->late.i_index] = i_late;
@@ -537,6 +553,22 @@ void input_clock_SetJitter( input_clock_t *cl,
     vlc_mutex_unlock( &cl->lock );
 }
 
+void input_clock_SetPtsDelay( input_clock_t *cl, vlc_tick_t i_pts_delay )
+{
+    vlc_mutex_lock( &cl->lock );
+    cl->i_pts_delay = i_pts_delay;
+    vlc_mutex_unlock( &cl->lock );
+}
+
+vlc_tick_t input_clock_GetArrivalJitter( input_clock_t *cl )
+{
+    vlc_mutex_lock( &cl->lock );
+    vlc_tick_t i_jitter = cl->i_arrival_jitter;
+    vlc_mutex_unlock( &cl->lock );
+
+    return i_jitter;
+}
+
 vlc_tick_t input_clock_GetJitter( input_clock_t *cl )
 {
     vlc_mutex_lock( &cl->lock );
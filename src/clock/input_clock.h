@@ -129,6 +129,20 @@ int input_clock_GetState( input_clock_t *,
 void input_clock_SetJitter( input_clock_t *,
                             vlc_tick_t i_pts_delay, int i_cr_average );
 
+/**
+ * This function sets the pts_delay, allowing it to decrease, unlike
+ * input_clock_SetJitter().
+ */
+void input_clock_SetPtsDelay( input_clock_t *, vlc_tick_t i_pts_delay );
+
+/**
+ * This function returns the recent maximum of the delay between the arrival
+ * of the clock references and their expected arrival, i.e. the minimal
+ * pts_delay that would have avoided late references. It is only computed
+ * when the pace of the source is not controlled.
+ */
+vlc_tick_t input_clock_GetArrivalJitter( input_clock_t * );
+
 /**
  * This function returns an estimation of the pts_delay needed to avoid rebufferization.
  * XXX in the current implementation, the pts_delay will never be decreased.
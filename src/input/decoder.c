@@ -47,7 +47,9 @@
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
 #include "../clock/clock.h"
+#include "../libvlc.h"
 #include "decoder.h"
+#include "frame_cache.h"
 #include "resource.h"
 
 #include "../video_output/vout_internal.h"
@@ -95,6 +97,17 @@ struct decoder_owner
     /* fifo */
     block_fifo_t *p_fifo;
 
+    /* Blocks dequeued at once by the DecoderThread and not yet decoded. The
+     * chain is only used by the DecoderThread, its count and size are
+     * protected by the fifo lock. */
+    block_t *batch;
+    size_t batch_count, batch_size;
+    /* Set when the fifo is reset: the DecoderThread discards its batch */
+    bool batch_reset;
+    /* Set when the flush, pause, rate or delay state changes, so that the
+     * DecoderThread checks it before decoding the rest of its batch */
+    atomic_bool control_changed;
+
     /* Lock for communication with decoder thread */
     vlc_mutex_t lock;
     vlc_cond_t  wait_request;
@@ -104,6 +117,21 @@ struct decoder_owner
     /* pool to use when the decoder doesn't use its own */
     struct picture_pool_t *out_pool;
 
+    /* Recently decoded pictures, to serve seeks without decoding (video) */
+    frame_cache_t *frame_cache;
+    struct
+    {
+        bool serving; /* blocks are served from the cache */
+        bool replaying;
+        block_t *gop; /* served blocks since the last keyframe */
+        block_t **gop_last;
+        vlc_tick_t shown; /* date of the last served picture */
+        vlc_tick_t last; /* highest date of the served blocks */
+        /* Pictures up to this date were already served before a cache miss,
+         * they are not output again while decoding. Protected by lock. */
+        vlc_tick_t replay_end;
+    } cache;
+
     /*
      * 3 threads can read/write these output variables, the DecoderThread, the
      * input thread, and the ModuleThread. The ModuleThread is either the
@@ -193,6 +221,13 @@ static inline struct decoder_owner *dec_get_owner( decoder_t *p_dec )
     return container_of( p_dec, struct decoder_owner, dec );
 }
 
+/* Must be called with the fifo locked, after changing the control state */
+static inline void DecoderInterruptBatch( struct decoder_owner *p_owner )
+{
+    atomic_store_explicit( &p_owner->control_changed, true,
+                           memory_order_relaxed );
+}
+
 /**
  * Load a decoder module
  */
@@ -225,6 +260,8 @@ static int LoadDecoder( decoder_t *p_dec, bool b_packetizer,
     return 0;
 }
 
+static void DecoderThread_StopServing( struct decoder_owner * );
+
 static int DecoderThread_Reload( struct decoder_owner *p_owner, bool b_packetizer,
                                  const es_format_t *restrict p_fmt, enum reload reload )
 {
@@ -241,6 +278,12 @@ static int DecoderThread_Reload( struct decoder_owner *p_owner, bool b_packetize
     decoder_Clean( p_dec );
     p_owner->error = false;
 
+    if( p_owner->frame_cache != NULL )
+    {   /* The cached pictures belong to the previous format */
+        DecoderThread_StopServing( p_owner );
+        frame_cache_Clear( p_owner->frame_cache );
+    }
+
     if( reload == RELOAD_DECODER_AOUT )
     {
         assert( p_owner->fmt.i_cat == AUDIO_ES );
@@ -397,6 +440,7 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
 
         vlc_fifo_Lock( p_owner->p_fifo );
         p_owner->reset_out_state = true;
+        DecoderInterruptBatch( p_owner );
         vlc_fifo_Unlock( p_owner->p_fifo );
     }
     return 0;
@@ -451,13 +495,15 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
             break;
         }
 
-        p_owner->out_pool = picture_pool_NewFromFormat( &p_dec->fmt_out.video,
-                            dpb_size + p_dec->i_extra_picture_buffers + 1 );
+        /* The DPB size is only an estimate: let the pool grow by as much
+         * again rather than stall a decoder that keeps more references. */
+        unsigned count = dpb_size + p_dec->i_extra_picture_buffers + 1;
+        p_owner->out_pool = picture_pool_NewGrowable( &p_dec->fmt_out.video,
+                                                      count, count + dpb_size );
         if (p_owner->out_pool == NULL)
         {
-            msg_Err(p_dec, "Failed to create a pool of %d %4.4s pictures",
-                           dpb_size + p_dec->i_extra_picture_buffers + 1,
-                           (char*)&p_dec->fmt_out.video.i_chroma);
+            msg_Err(p_dec, "Failed to create a pool of %u %4.4s pictures",
+                           count, (char*)&p_dec->fmt_out.video.i_chroma);
             return -1;
         }
     }
@@ -591,6 +637,7 @@ static int CreateVoutIfNeeded(struct decoder_owner *p_owner,
 
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->reset_out_state = true;
+    DecoderInterruptBatch( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     return 1; // new vout was created
@@ -645,12 +692,23 @@ static vlc_decoder_device * ModuleThread_GetDecoderDevice( decoder_t *p_dec )
     return dec_device;
 }
 
+/* The decoder is starved, rather than slowed down by the video output, if
+ * no picture is queued for display: none would come back to the pool. */
+static bool ModuleThread_IsStarved( void *opaque )
+{
+    struct decoder_owner *p_owner = opaque;
+
+    return vout_IsEmpty( p_owner->p_vout );
+}
+
 static picture_t *ModuleThread_NewVideoBuffer( decoder_t *p_dec )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
     assert( p_owner->p_vout );
 
-    picture_t *pic = picture_pool_Wait( p_owner->out_pool );
+    picture_t *pic = picture_pool_WaitOrGrow( p_owner->out_pool,
+                                              ModuleThread_IsStarved,
+                                              p_owner );
     if (pic)
         picture_Reset( pic );
     return pic;
@@ -1062,12 +1120,15 @@ static int ModuleThread_PlayVideo( struct decoder_owner *p_owner, picture_t *p_p
 
     vlc_mutex_lock( &p_owner->lock );
     bool prerolled = p_owner->i_preroll_end != PREROLL_NONE;
-    if( prerolled && p_owner->i_preroll_end > p_picture->date )
+    if( (prerolled && p_owner->i_preroll_end > p_picture->date)
+     || (p_owner->cache.replay_end != VLC_TICK_INVALID
+      && p_owner->cache.replay_end >= p_picture->date) )
     {
         vlc_mutex_unlock( &p_owner->lock );
         picture_Release( p_picture );
         return VLC_SUCCESS;
     }
+    p_owner->cache.replay_end = VLC_TICK_INVALID;
 
     p_owner->i_preroll_end = PREROLL_NONE;
 
@@ -1126,13 +1187,16 @@ static void ModuleThread_UpdateStatVideo( struct decoder_owner *p_owner,
 {
     unsigned displayed = 0;
     unsigned vout_lost = 0;
+    unsigned judder = 0;
     if( p_owner->p_vout != NULL )
     {
-        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost );
+        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost,
+                                &judder );
     }
     if (lost) vout_lost++;
 
-    decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed);
+    decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed,
+                   judder);
 }
 
 static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
@@ -1140,6 +1204,9 @@ static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
     assert( p_pic );
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+    if( p_owner->frame_cache != NULL )
+        frame_cache_Put( p_owner->frame_cache, p_pic );
+
     int success = ModuleThread_PlayVideo( p_owner, p_pic );
 
     ModuleThread_UpdateStatVideo( p_owner, success != VLC_SUCCESS );
@@ -1338,10 +1405,140 @@ static void ModuleThread_QueueSpu( decoder_t *p_dec, subpicture_t *p_spu )
 }
 
 static void DecoderThread_ProcessInput( struct decoder_owner *p_owner, block_t *p_block );
+static void DecoderThread_DecodeBlock( struct decoder_owner *, block_t * );
+
+/* Outputs the cached pictures dated up to the given date */
+static void DecoderThread_ShowCached( struct decoder_owner *p_owner,
+                                      vlc_tick_t upto )
+{
+    picture_t *p_pic;
+
+    while( (p_pic = frame_cache_Get( p_owner->frame_cache, p_owner->cache.shown,
+                                     upto )) != NULL )
+    {
+        p_owner->cache.shown = p_pic->date;
+
+        int success = ModuleThread_PlayVideo( p_owner, p_pic );
+        ModuleThread_UpdateStatVideo( p_owner, success != VLC_SUCCESS );
+    }
+}
+
+static void DecoderThread_StopServing( struct decoder_owner *p_owner )
+{
+    block_ChainRelease( p_owner->cache.gop );
+    p_owner->cache.gop = NULL;
+    p_owner->cache.gop_last = &p_owner->cache.gop;
+    p_owner->cache.serving = false;
+}
+
+/* Decodes the served blocks again, so that the decoder has the references
+ * needed to continue past the cached range */
+static void DecoderThread_ReplayCached( struct decoder_owner *p_owner )
+{
+    block_t *p_gop = p_owner->cache.gop;
+
+    msg_Dbg( &p_owner->dec, "cache miss, decoding again from the keyframe" );
+    p_owner->cache.gop = NULL;
+    DecoderThread_StopServing( p_owner );
+
+    vlc_mutex_lock( &p_owner->lock );
+    p_owner->cache.replay_end = p_owner->cache.shown;
+    vlc_mutex_unlock( &p_owner->lock );
+
+    p_owner->cache.replaying = true;
+    while( p_gop != NULL )
+    {
+        block_t *p_block = p_gop;
+
+        p_gop = p_block->p_next;
+        p_block->p_next = NULL;
+        DecoderThread_DecodeBlock( p_owner, p_block );
+    }
+    p_owner->cache.replaying = false;
+}
+
+/**
+ * Serves a block from the frame cache
+ *
+ * Starting from a cached keyframe, blocks whose pictures are all cached are
+ * not decoded: the cached pictures are output instead, in date order.
+ *
+ * \return true if the block was consumed
+ */
+static bool DecoderThread_ServeCached( struct decoder_owner *p_owner,
+                                       block_t *p_block )
+{
+    frame_cache_t *cache = p_owner->frame_cache;
+
+    if( p_owner->cache.replaying )
+        return false;
+
+    if( p_block != NULL && (p_block->i_flags & BLOCK_FLAG_DISCONTINUITY) )
+    {   /* Timestamps may restart (e.g. TS PCR wrap): the cached pictures
+         * could be mistaken for the new ones */
+        if( p_owner->cache.serving )
+            DecoderThread_ReplayCached( p_owner );
+        frame_cache_Clear( cache );
+        return false;
+    }
+
+    if( p_block == NULL )
+    {   /* Drain: output the rest of the served pictures */
+        if( p_owner->cache.serving )
+        {
+            DecoderThread_ShowCached( p_owner, p_owner->cache.last );
+            DecoderThread_StopServing( p_owner );
+        }
+        return false;
+    }
+
+    const vlc_tick_t date = p_block->i_pts;
+    const bool keyframe = (p_block->i_flags & BLOCK_FLAG_TYPE_I) != 0;
+    const bool cached = date != VLC_TICK_INVALID
+                     && !(p_block->i_flags & BLOCK_FLAG_CORRUPTED)
+                     && frame_cache_Has( cache, date );
+
+    if( !p_owner->cache.serving )
+    {
+        if( !keyframe || !cached )
+            return false;
+
+        msg_Dbg( &p_owner->dec, "serving decoded pictures from the cache" );
+        p_owner->cache.serving = true;
+        p_owner->cache.shown = date - 1;
+        p_owner->cache.last = date;
+    }
+    else if( !cached )
+    {
+        DecoderThread_ReplayCached( p_owner );
+        return false;
+    }
+    else if( keyframe )
+    {   /* The previous pictures are not needed to decode from here */
+        block_ChainRelease( p_owner->cache.gop );
+        p_owner->cache.gop = NULL;
+        p_owner->cache.gop_last = &p_owner->cache.gop;
+    }
+
+    if( date > p_owner->cache.last )
+        p_owner->cache.last = date;
+    block_ChainLastAppend( &p_owner->cache.gop_last, p_block );
+
+    /* In decoding order, the pictures dated up to the decoding time stamp of
+     * the last block are complete */
+    DecoderThread_ShowCached( p_owner, p_block->i_dts != VLC_TICK_INVALID
+                                       ? p_block->i_dts : date );
+    return true;
+}
+
 static void DecoderThread_DecodeBlock( struct decoder_owner *p_owner, block_t *p_block )
 {
     decoder_t *p_dec = &p_owner->dec;
 
+    if( p_owner->frame_cache != NULL
+     && DecoderThread_ServeCached( p_owner, p_block ) )
+        return;
+
     int ret = p_dec->pf_decode( p_dec, p_block );
     switch( ret )
     {
@@ -1524,7 +1721,11 @@ static void DecoderThread_Flush( struct decoder_owner *p_owner )
     }
 
     p_owner->i_preroll_end = PREROLL_NONE;
+    p_owner->cache.replay_end = VLC_TICK_INVALID;
     vlc_mutex_unlock( &p_owner->lock );
+
+    if( p_owner->frame_cache != NULL )
+        DecoderThread_StopServing( p_owner );
 }
 
 static void DecoderThread_ChangePause( struct decoder_owner *p_owner, bool paused, vlc_tick_t date )
@@ -1631,19 +1832,57 @@ static void *DecoderThread( void *p_data )
     vlc_tick_t delay = 0;
     bool paused = false;
 
+    switch( p_owner->dec.fmt_in.i_cat )
+    {
+        case AUDIO_ES:
+            vlc_thread_ApplyPolicy( VLC_OBJECT(&p_owner->dec),
+                                    VLC_THREAD_AUDIO_DECODER );
+            break;
+        case VIDEO_ES:
+            vlc_thread_ApplyPolicy( VLC_OBJECT(&p_owner->dec),
+                                    VLC_THREAD_VIDEO_DECODER );
+            break;
+        case SPU_ES:
+            vlc_thread_ApplyPolicy( VLC_OBJECT(&p_owner->dec),
+                                    VLC_THREAD_SPU_DECODER );
+            break;
+        default:
+            break;
+    }
+
     /* The decoder's main loop */
     vlc_fifo_Lock( p_owner->p_fifo );
     vlc_fifo_CleanupPush( p_owner->p_fifo );
 
     for( ;; )
     {
+        /* The control state is checked below: changes made from now on will
+         * interrupt the next batch. */
+        atomic_store_explicit( &p_owner->control_changed, false,
+                               memory_order_relaxed );
+
+        if( p_owner->batch_reset )
+        {   /* The fifo was reset: drop the rest of the batch as well */
+            block_ChainRelease( p_owner->batch );
+            p_owner->batch = NULL;
+            p_owner->batch_count = 0;
+            p_owner->batch_reset = false;
+        }
+
         if( p_owner->flushing )
         {   /* Flush before/regardless of pause. We do not want to resume just
              * for the sake of flushing (glitches could otherwise happen). */
             int canc = vlc_savecancel();
+            block_t *batch = p_owner->batch;
 
+            p_owner->batch = NULL;
+            p_owner->batch_count = p_owner->batch_size = 0;
+            p_owner->batch_reset = false;
             vlc_fifo_Unlock( p_owner->p_fifo );
 
+            /* Discard the rest of the interrupted batch */
+            block_ChainRelease( batch );
+
             /* Flush the decoder (and the output) */
             DecoderThread_Flush( p_owner );
 
@@ -1722,8 +1961,23 @@ static void *DecoderThread( void *p_data )
         vlc_cond_signal( &p_owner->wait_fifo );
         vlc_testcancel(); /* forced expedited cancellation in case of stop */
 
-        block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
-        if( p_block == NULL )
+        if( p_owner->batch == NULL )
+        {   /* Take all the queued blocks at once, so that the lock and the
+             * control state are not checked again for each of them. Only
+             * take one block at a time when stepping frame by frame. */
+            size_t count = vlc_fifo_GetCount( p_owner->p_fifo );
+            size_t size = vlc_fifo_GetBytes( p_owner->p_fifo );
+
+            if( paused )
+                p_owner->batch = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+            else
+                p_owner->batch = vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo );
+            p_owner->batch_count = count - vlc_fifo_GetCount( p_owner->p_fifo );
+            p_owner->batch_size = size - vlc_fifo_GetBytes( p_owner->p_fifo );
+        }
+
+        const bool drain = p_owner->batch == NULL;
+        if( drain )
         {
             if( likely(!p_owner->b_draining) )
             {   /* Wait for a block to decode (or a request to drain) */
@@ -1740,24 +1994,55 @@ static void *DecoderThread( void *p_data )
         vlc_fifo_Unlock( p_owner->p_fifo );
 
         int canc = vlc_savecancel();
-        DecoderThread_ProcessInput( p_owner, p_block );
+        if( drain )
+        {
+            DecoderThread_ProcessInput( p_owner, NULL );
+
+            if( p_owner->dec.fmt_out.i_cat == AUDIO_ES )
+            {   /* Draining: the decoder is drained and all decoded buffers
+                 * are queued to the output at this point. Now drain the
+                 * output. */
+                if( p_owner->p_aout != NULL )
+                    aout_DecDrain( p_owner->p_aout );
+            }
+        }
+        else
+        {   /* Decode the batch until it is empty or the control state
+             * changes, e.g. on pause or flush */
+            do
+            {
+                block_t *p_block = p_owner->batch;
 
-        if( p_block == NULL && p_owner->dec.fmt_out.i_cat == AUDIO_ES )
-        {   /* Draining: the decoder is drained and all decoded buffers are
-             * queued to the output at this point. Now drain the output. */
-            if( p_owner->p_aout != NULL )
-                aout_DecDrain( p_owner->p_aout );
+                p_owner->batch = p_block->p_next;
+                p_block->p_next = NULL;
+                DecoderThread_ProcessInput( p_owner, p_block );
+            }
+            while( p_owner->batch != NULL && !paused
+                && !atomic_load_explicit( &p_owner->control_changed,
+                                          memory_order_relaxed ) );
         }
         vlc_restorecancel( canc );
 
         /* TODO? Wait for draining instead of polling. */
         vlc_mutex_lock( &p_owner->lock );
         vlc_fifo_Lock( p_owner->p_fifo );
-        if( p_owner->b_draining && (p_block == NULL) )
+        if( p_owner->b_draining && drain )
         {
             p_owner->b_draining = false;
             p_owner->drained = true;
         }
+        /* If the fifo was reset meanwhile, the batch no longer counts and is
+         * dropped at the next iteration. */
+        if( p_owner->batch != NULL && !p_owner->batch_reset )
+        {   /* Interrupted batch, kept for the next iteration */
+            int count;
+
+            block_ChainProperties( p_owner->batch, &count,
+                                   &p_owner->batch_size, NULL );
+            p_owner->batch_count = count;
+        }
+        else if( p_owner->batch == NULL )
+            p_owner->batch_count = p_owner->batch_size = 0;
         vlc_cond_signal( &p_owner->wait_acknowledge );
         vlc_mutex_unlock( &p_owner->lock );
     }
@@ -1860,7 +2145,17 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
 
     p_owner->error = false;
 
+    p_owner->frame_cache = NULL;
+    p_owner->cache.serving = p_owner->cache.replaying = false;
+    p_owner->cache.gop = NULL;
+    p_owner->cache.gop_last = &p_owner->cache.gop;
+    p_owner->cache.replay_end = VLC_TICK_INVALID;
+
     p_owner->flushing = false;
+    p_owner->batch = NULL;
+    p_owner->batch_count = p_owner->batch_size = 0;
+    p_owner->batch_reset = false;
+    atomic_init( &p_owner->control_changed, false );
     p_owner->b_draining = false;
     p_owner->drained = false;
     atomic_init( &p_owner->reload, RELOAD_NO_REQUEST );
@@ -1909,7 +2204,12 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
     {
         case VIDEO_ES:
             if( !b_thumbnailing )
+            {
                 p_dec->cbs = &dec_video_cbs;
+                int64_t cache_size = var_InheritInteger( p_dec, "video-frame-cache" );
+                if( p_sout == NULL && cache_size > 0 )
+                    p_owner->frame_cache = frame_cache_New( cache_size << 20 );
+            }
             else
                 p_dec->cbs = &dec_thumbnailer_cbs;
             break;
@@ -1984,7 +2284,14 @@ static void DeleteDecoder( decoder_t * p_dec )
     if (p_owner->vctx)
         vlc_video_context_Release( p_owner->vctx );
 
+    if( p_owner->frame_cache != NULL )
+    {
+        block_ChainRelease( p_owner->cache.gop );
+        frame_cache_Delete( p_owner->frame_cache );
+    }
+
     /* Free all packets still in the decoder fifo. */
+    block_ChainRelease( p_owner->batch );
     block_FifoRelease( p_owner->p_fifo );
 
     /* Cleanup */
@@ -2185,6 +2492,7 @@ void input_DecoderDelete( decoder_t *p_dec )
 
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->flushing = true;
+    DecoderInterruptBatch( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     /* Make sure we aren't waiting/decoding anymore */
@@ -2235,12 +2543,22 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
     {
         /* FIXME: ideally we would check the time amount of data
          * in the FIFO instead of its size. */
-        /* 400 MiB, i.e. ~ 50mb/s for 60s */
-        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > 400*1024*1024 )
+        /* 400 MiB, i.e. ~ 50mb/s for 60s, including the blocks dequeued
+         * but not yet decoded by the DecoderThread */
+        if( vlc_fifo_GetBytes( p_owner->p_fifo ) + p_owner->batch_size
+              > 400*1024*1024 )
         {
             msg_Warn( p_dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
             block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            if( p_owner->batch_size > 0 )
+            {   /* The DecoderThread drops its batch after the current block;
+                 * it no longer counts towards the limit. */
+                p_owner->batch_reset = true;
+                p_owner->batch_size = 0;
+                atomic_store_explicit( &p_owner->control_changed, true,
+                                       memory_order_relaxed );
+            }
             p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
     }
@@ -2264,7 +2582,8 @@ bool input_DecoderIsEmpty( decoder_t * p_dec )
     assert( !p_owner->b_waiting );
 
     vlc_fifo_Lock( p_owner->p_fifo );
-    if( !vlc_fifo_IsEmpty( p_owner->p_fifo ) || p_owner->b_draining )
+    if( !vlc_fifo_IsEmpty( p_owner->p_fifo ) || p_owner->batch_count > 0
+     || p_owner->b_draining )
     {
         vlc_fifo_Unlock( p_owner->p_fifo );
         return false;
@@ -2326,6 +2645,7 @@ void input_DecoderFlush( decoder_t *p_dec )
      * dequeued by DecoderThread and there is no need to flush a second time in
      * a row. */
     p_owner->flushing = true;
+    DecoderInterruptBatch( p_owner );
 
     /* Flush video/spu decoder when paused: increment frames_countdown in order
      * to display one frame/subtitle */
@@ -2471,6 +2791,7 @@ void input_DecoderChangePause( decoder_t *p_dec, bool b_paused, vlc_tick_t i_dat
     p_owner->paused = b_paused;
     p_owner->pause_date = i_date;
     p_owner->frames_countdown = 0;
+    DecoderInterruptBatch( p_owner );
     vlc_fifo_Signal( p_owner->p_fifo );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
@@ -2481,6 +2802,7 @@ void input_DecoderChangeRate( decoder_t *dec, float rate )
 
     vlc_fifo_Lock( owner->p_fifo );
     owner->request_rate = rate;
+    DecoderInterruptBatch( owner );
     vlc_fifo_Unlock( owner->p_fifo );
 }
 
@@ -2490,6 +2812,7 @@ void input_DecoderChangeDelay( decoder_t *dec, vlc_tick_t delay )
 
     vlc_fifo_Lock( owner->p_fifo );
     owner->delay = delay;
+    DecoderInterruptBatch( owner );
     vlc_fifo_Unlock( owner->p_fifo );
 }
 
@@ -2596,7 +2919,10 @@ size_t input_DecoderGetFifoSize( decoder_t *p_dec )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
-    return block_FifoSize( p_owner->p_fifo );
+    vlc_fifo_Lock( p_owner->p_fifo );
+    size_t size = vlc_fifo_GetBytes( p_owner->p_fifo ) + p_owner->batch_size;
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    return size;
 }
 
 void input_DecoderSetVoutMouseEvent( decoder_t *dec, vlc_mouse_event mouse_event,
@@ -40,7 +40,7 @@ struct input_decoder_callbacks {
 
     void (*on_new_video_stats)(decoder_t *decoder, unsigned decoded,
                                unsigned lost, unsigned displayed,
-                               void *userdata);
+                               unsigned judder, void *userdata);
     void (*on_new_audio_stats)(decoder_t *decoder, unsigned decoded,
                                unsigned lost, unsigned played, void *userdata);
 
@@ -141,6 +141,15 @@ struct es_out_id_t
     /* ID for the meta data */
     int         i_meta_id;
 
+    /* Packets kept while unselected, for fast track switching */
+    struct
+    {
+        bool        b_active;
+        block_t     *p_first;
+        block_t     **pp_last;
+        size_t      i_size;
+    } prebuffer;
+
     struct vlc_list node;
 
     vlc_mouse_event mouse_event_cb;
@@ -218,6 +227,33 @@ typedef struct
     /* Used only to limit debugging output */
     int         i_prev_stream_level;
 
+    /* Alternate tracks pre-buffering */
+    struct
+    {
+        unsigned    i_max;      /* maximum number of pre-buffered tracks */
+        unsigned    i_count;    /* current number of pre-buffered tracks */
+        size_t      i_size;     /* maximum size per track */
+
+        /* Last output clock point, used to estimate the playback time. It is
+         * updated by the decoder threads, hence its own lock. */
+        vlc_mutex_t lock;
+        vlc_tick_t  i_system;
+        vlc_tick_t  i_stream;
+        double      rate;
+    } prebuffer;
+
+    /* Automatic caching of live streams */
+    struct
+    {
+        bool        b_enabled;
+        vlc_tick_t  i_min;
+        vlc_tick_t  i_max;
+        vlc_tick_t  i_delay;        /* current caching */
+        vlc_tick_t  i_last_update;  /* system date of the last adjustment */
+        vlc_tick_t  i_last_raise;   /* system date of the last growth need */
+        float       correction;     /* playback rate correction */
+    } auto_delay;
+
     es_out_t out;
 } es_out_sys_t;
 
@@ -336,7 +372,7 @@ decoder_on_thumbnail_ready(decoder_t *decoder, picture_t *pic, void *userdata)
 
 static void
 decoder_on_new_video_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
-                           unsigned displayed, void *userdata)
+                           unsigned displayed, unsigned judder, void *userdata)
 {
     (void) decoder;
 
@@ -357,6 +393,8 @@ decoder_on_new_video_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
                               memory_order_relaxed);
     atomic_fetch_add_explicit(&stats->displayed_pictures, displayed,
                               memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->judder_pictures, judder,
+                              memory_order_relaxed);
 }
 
 static void
@@ -522,14 +560,57 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, float rate )
     p_sys->i_preroll_end = -1;
     p_sys->i_prev_stream_level = -1;
 
+    if( !input_priv(p_input)->b_preparsing
+     && !input_priv(p_input)->b_thumbnailing )
+    {
+        p_sys->prebuffer.i_max = var_InheritInteger( p_input, "prebuffer-tracks" );
+        p_sys->prebuffer.i_size =
+            (size_t)var_InheritInteger( p_input, "prebuffer-track-size" ) * 1024;
+    }
+    p_sys->prebuffer.i_count = 0;
+    vlc_mutex_init( &p_sys->prebuffer.lock );
+    p_sys->prebuffer.i_system = VLC_TICK_INVALID;
+
+    if( !input_priv(p_input)->b_preparsing
+     && !input_priv(p_input)->b_thumbnailing )
+        p_sys->auto_delay.b_enabled = var_InheritBool( p_input, "clock-auto-delay" );
+    p_sys->auto_delay.i_min =
+        VLC_TICK_FROM_MS( var_InheritInteger( p_input, "clock-auto-delay-min" ) );
+    p_sys->auto_delay.i_max =
+        __MIN( p_sys->auto_delay.i_min + VLC_TICK_FROM_MS(
+               var_InheritInteger( p_input, "clock-jitter" ) ), INPUT_PTS_DELAY_MAX );
+    p_sys->auto_delay.i_max = __MAX( p_sys->auto_delay.i_max, p_sys->auto_delay.i_min );
+    p_sys->auto_delay.i_delay = p_sys->auto_delay.i_min;
+    p_sys->auto_delay.i_last_update = VLC_TICK_INVALID;
+    p_sys->auto_delay.i_last_raise = VLC_TICK_INVALID;
+    p_sys->auto_delay.correction = 1.f;
+
     return &p_sys->out;
 }
 
 /*****************************************************************************
  *
  *****************************************************************************/
+static void EsOutPrebufferClear( es_out_sys_t *p_sys, es_out_id_t *es )
+{
+    if( !es->prebuffer.b_active )
+        return;
+
+    block_ChainRelease( es->prebuffer.p_first );
+    es->prebuffer.b_active = false;
+    es->prebuffer.p_first = NULL;
+    es->prebuffer.pp_last = &es->prebuffer.p_first;
+    es->prebuffer.i_size = 0;
+
+    assert( p_sys->prebuffer.i_count > 0 );
+    p_sys->prebuffer.i_count--;
+}
+
 static void EsTerminate(es_out_id_t *es)
 {
+    es_out_sys_t *p_sys = container_of(es->out, es_out_sys_t, out);
+
+    EsOutPrebufferClear( p_sys, es );
     vlc_list_remove(&es->node);
 
     es->b_terminated = true;
@@ -598,6 +679,7 @@ static void EsOutDelete( es_out_t *out )
     EsOutPropsCleanup( &p_sys->audio );
     EsOutPropsCleanup( &p_sys->sub );
 
+    vlc_mutex_destroy( &p_sys->prebuffer.lock );
     vlc_mutex_destroy( &p_sys->lock );
 
     free( p_sys );
@@ -868,10 +950,16 @@ static void EsOutChangePause( es_out_t *out, bool b_paused, vlc_tick_t i_date )
         EsOutProgramChangePause( out, false, i_date );
         EsOutDecodersChangePause( out, false, i_date );
 
+        vlc_mutex_lock( &p_sys->prebuffer.lock );
+        if( p_sys->prebuffer.i_system != VLC_TICK_INVALID && p_sys->b_paused )
+            p_sys->prebuffer.i_system += i_date - p_sys->i_pause_date;
+        vlc_mutex_unlock( &p_sys->prebuffer.lock );
+
         EsOutProgramsChangeRate( out );
     }
     p_sys->b_paused = b_paused;
     p_sys->i_pause_date = i_date;
+    p_sys->auto_delay.i_last_update = VLC_TICK_INVALID;
 }
 
 static void EsOutChangeRate( es_out_t *out, float rate )
@@ -884,7 +972,99 @@ static void EsOutChangeRate( es_out_t *out, float rate )
 
     foreach_es_then_es_slaves(es)
         if( es->p_dec != NULL )
-            input_DecoderChangeRate( es->p_dec, rate );
+            input_DecoderChangeRate( es->p_dec,
+                                     rate * p_sys->auto_delay.correction );
+}
+
+/*****************************************************************************
+ * Automatic caching
+ *****************************************************************************/
+/* Safety margin above the measured jitter */
+#define AUTO_DELAY_MARGIN VLC_TICK_FROM_MS(20)
+/* Excess of caching tolerated before shrinking */
+#define AUTO_DELAY_HYSTERESIS VLC_TICK_FROM_MS(50)
+/* Time without growth need before shrinking */
+#define AUTO_DELAY_SHRINK_PERIOD VLC_TICK_FROM_SEC(10)
+/* Playback rate correction while adjusting, small enough to be unnoticed
+ * with the audio time-stretching */
+#define AUTO_DELAY_CORRECTION (0.05f)
+
+static bool EsOutAutoDelayIsActive( es_out_sys_t *p_sys )
+{
+    input_thread_private_t *priv = input_priv(p_sys->p_input);
+
+    /* Only live streams, not paced by us, are concerned */
+    return p_sys->auto_delay.b_enabled && !priv->b_can_pace_control
+        && priv->p_sout == NULL && !priv->b_low_delay;
+}
+
+static void EsOutAutoDelaySetCorrection( es_out_t *out, float correction )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+    es_out_id_t *es;
+
+    if( correction == p_sys->auto_delay.correction )
+        return;
+    p_sys->auto_delay.correction = correction;
+
+    foreach_es_then_es_slaves(es)
+        if( es->p_dec != NULL )
+            input_DecoderChangeRate( es->p_dec, p_sys->rate * correction );
+}
+
+/* Grows or shrinks the caching toward the measured input jitter, by
+ * playing slightly slower or faster, without interruption. */
+static void EsOutAutoDelayUpdate( es_out_t *out, es_out_pgrm_t *p_pgrm,
+                                  vlc_tick_t i_now )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+
+    if( p_sys->b_paused )
+        return;
+
+    if( p_sys->auto_delay.i_last_update == VLC_TICK_INVALID )
+    {
+        p_sys->auto_delay.i_last_update =
+        p_sys->auto_delay.i_last_raise = i_now;
+        return;
+    }
+
+    /* The data received while playing slower (or faster) than the source
+     * is added to (or removed from) the buffer */
+    const vlc_tick_t i_elapsed = i_now - p_sys->auto_delay.i_last_update;
+    p_sys->auto_delay.i_last_update = i_now;
+    vlc_tick_t i_delay = p_sys->auto_delay.i_delay
+                       + i_elapsed * (1.f - p_sys->auto_delay.correction);
+    i_delay = VLC_CLIP( i_delay, p_sys->auto_delay.i_min, p_sys->auto_delay.i_max );
+
+    const vlc_tick_t i_jitter = input_clock_GetArrivalJitter( p_pgrm->p_input_clock );
+    const vlc_tick_t i_target = VLC_CLIP( i_jitter + i_jitter / 4 + AUTO_DELAY_MARGIN,
+                                          p_sys->auto_delay.i_min,
+                                          p_sys->auto_delay.i_max );
+
+    const bool b_shrinking = p_sys->auto_delay.correction > 1.f;
+    float correction = 1.f;
+    if( i_delay < i_target )
+    {
+        correction = 1.f - AUTO_DELAY_CORRECTION;
+        p_sys->auto_delay.i_last_raise = i_now;
+    }
+    else if( i_now - p_sys->auto_delay.i_last_raise > AUTO_DELAY_SHRINK_PERIOD
+          && i_delay > i_target + ( b_shrinking ? 0 : AUTO_DELAY_HYSTERESIS ) )
+        correction = 1.f + AUTO_DELAY_CORRECTION;
+
+    if( correction != p_sys->auto_delay.correction )
+        msg_Dbg( p_sys->p_input, "automatic caching: %"PRId64" ms, target %"
+                 PRId64" ms, rate correction %.2f", MS_FROM_VLC_TICK(i_delay),
+                 MS_FROM_VLC_TICK(i_target), correction );
+    EsOutAutoDelaySetCorrection( out, correction );
+
+    if( i_delay != p_sys->auto_delay.i_delay )
+    {
+        p_sys->auto_delay.i_delay = i_delay;
+        EsOutControlLocked( out, ES_OUT_SET_JITTER, p_sys->i_pts_delay,
+                            p_sys->i_pts_jitter, p_sys->i_cr_average );
+    }
 }
 
 static void EsOutChangePosition( es_out_t *out, bool b_flush )
@@ -895,6 +1075,10 @@ static void EsOutChangePosition( es_out_t *out, bool b_flush )
     input_SendEventCache( p_sys->p_input, 0.0 );
 
     foreach_es_then_es_slaves(p_es)
+    {
+        /* The packets of the previous position are useless */
+        EsOutPrebufferClear( p_sys, p_es );
+
         if( p_es->p_dec != NULL )
         {
             if( b_flush )
@@ -906,6 +1090,15 @@ static void EsOutChangePosition( es_out_t *out, bool b_flush )
                     input_DecoderStartWait( p_es->p_dec_record );
             }
         }
+    }
+
+    vlc_mutex_lock( &p_sys->prebuffer.lock );
+    p_sys->prebuffer.i_system = VLC_TICK_INVALID;
+    vlc_mutex_unlock( &p_sys->prebuffer.lock );
+
+    /* The buffer is refilled up to the current caching */
+    EsOutAutoDelaySetCorrection( out, 1.f );
+    p_sys->auto_delay.i_last_update = VLC_TICK_INVALID;
 
     es_out_pgrm_t *pgrm;
     vlc_list_foreach(pgrm, &p_sys->programs, node)
@@ -1269,7 +1462,10 @@ static void EsOutProgramSelect( es_out_t *out, es_out_pgrm_t *p_pgrm )
              && p_sys->i_mode != ES_OUT_MODE_ALL)
                 EsOutUnselectEs(out, es, true);
             if (es->p_pgrm == old)
+            {
+                EsOutPrebufferClear( p_sys, es );
                 EsOutSendEsEvent( out, es, VLC_INPUT_ES_DELETED );
+            }
         }
 
         p_sys->audio.p_main_es = NULL;
@@ -1962,6 +2158,10 @@ static es_out_id_t *EsOutAddSlaveLocked( es_out_t *out, const es_format_t *fmt,
     es->mouse_event_cb = NULL;
     es->mouse_event_userdata = NULL;
     es->delay = INT64_MAX;
+    es->prebuffer.b_active = false;
+    es->prebuffer.p_first = NULL;
+    es->prebuffer.pp_last = &es->prebuffer.p_first;
+    es->prebuffer.i_size = 0;
 
     vlc_list_append(&es->node, es->p_master ? &p_sys->es_slaves : &p_sys->es);
 
@@ -2017,10 +2217,135 @@ static void ClockUpdate(vlc_tick_t system_ts, vlc_tick_t ts, double rate,
     es_out_id_t *es = data;
     es_out_sys_t *p_sys = container_of(es->out, es_out_sys_t, out);
 
+    /* Clock resets, e.g. when the playing track is unselected, are ignored:
+     * the playback time is still extrapolated from the last point */
+    if( p_sys->prebuffer.i_max > 0
+     && system_ts != VLC_TICK_INVALID && system_ts != INT64_MAX )
+    {
+        vlc_mutex_lock( &p_sys->prebuffer.lock );
+        p_sys->prebuffer.i_system = system_ts;
+        p_sys->prebuffer.i_stream = ts;
+        p_sys->prebuffer.rate = rate;
+        vlc_mutex_unlock( &p_sys->prebuffer.lock );
+    }
+
     input_SendEventOutputClock(p_sys->p_input, &es->id, es->master, system_ts,
                                ts, rate, frame_rate, frame_rate_base);
 }
 
+/**
+ * Estimates the stream time being played, from the last output clock update
+ *
+ * \return the stream time, or VLC_TICK_INVALID if unknown
+ */
+static vlc_tick_t EsOutGetPlaybackTime( es_out_sys_t *p_sys )
+{
+    const vlc_tick_t i_now = p_sys->b_paused ? p_sys->i_pause_date
+                                             : vlc_tick_now();
+    vlc_tick_t i_time = VLC_TICK_INVALID;
+
+    vlc_mutex_lock( &p_sys->prebuffer.lock );
+    if( p_sys->prebuffer.i_system != VLC_TICK_INVALID )
+        i_time = p_sys->prebuffer.i_stream
+               + (i_now - p_sys->prebuffer.i_system) * p_sys->prebuffer.rate;
+    vlc_mutex_unlock( &p_sys->prebuffer.lock );
+    return i_time;
+}
+
+static vlc_tick_t EsBlockDate( const block_t *p_block )
+{
+    return p_block->i_pts != VLC_TICK_INVALID ? p_block->i_pts
+                                              : p_block->i_dts;
+}
+
+/**
+ * Keeps a packet of an unselected track, if it can be pre-buffered
+ *
+ * Packets that have already been played, and the oldest packets beyond the
+ * size limit, are discarded so that the buffer starts around the current
+ * playback time.
+ *
+ * \return true if the packet was kept
+ */
+static bool EsOutPrebuffer( es_out_t *out, es_out_id_t *es, block_t *p_block )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+
+    if( !es->prebuffer.b_active )
+    {
+        if( p_sys->prebuffer.i_count >= p_sys->prebuffer.i_max
+         || es->p_master != NULL || es->p_pgrm != p_sys->p_pgrm
+         || ( es->fmt.i_cat != AUDIO_ES && es->fmt.i_cat != SPU_ES ) )
+            return false;
+
+        es->prebuffer.b_active = true;
+        p_sys->prebuffer.i_count++;
+        msg_Dbg( p_sys->p_input, "pre-buffering ES 0x%x", es->fmt.i_id );
+    }
+
+    if( p_block->i_buffer > p_sys->prebuffer.i_size )
+        return false;
+
+    *es->prebuffer.pp_last = p_block;
+    es->prebuffer.pp_last = &p_block->p_next;
+    es->prebuffer.i_size += p_block->i_buffer;
+
+    /* Keep the last played packet, as it may still be displayed (subtitles)
+     * or be needed to decode the next one (audio) */
+    const vlc_tick_t i_time = EsOutGetPlaybackTime( p_sys );
+    block_t *p_first = es->prebuffer.p_first;
+
+    while( es->prebuffer.i_size > p_sys->prebuffer.i_size
+        || ( i_time != VLC_TICK_INVALID && p_first->p_next != NULL
+          && EsBlockDate( p_first->p_next ) <= i_time ) )
+    {
+        es->prebuffer.p_first = p_first->p_next;
+        es->prebuffer.i_size -= p_first->i_buffer;
+        block_Release( p_first );
+        p_first = es->prebuffer.p_first;
+    }
+    return true;
+}
+
+/**
+ * Sends the pre-buffered packets of a track to its new decoder
+ *
+ * Packets that end before the current playback time are only used to
+ * initialize the decoder.
+ */
+static void EsOutPrebufferFeed( es_out_t *out, es_out_id_t *es )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+    block_t *p_block = es->prebuffer.p_first;
+
+    if( !es->prebuffer.b_active )
+        return;
+
+    es->prebuffer.p_first = NULL;
+    EsOutPrebufferClear( p_sys, es );
+
+    const vlc_tick_t i_time = p_sys->b_buffering ? VLC_TICK_INVALID
+                                                 : EsOutGetPlaybackTime( p_sys );
+    unsigned i_count = 0;
+
+    while( p_block != NULL )
+    {
+        block_t *p_next = p_block->p_next;
+
+        p_block->p_next = NULL;
+        if( i_time != VLC_TICK_INVALID
+         && EsBlockDate( p_block ) + p_block->i_length <= i_time )
+            p_block->i_flags |= BLOCK_FLAG_PREROLL;
+        input_DecoderDecode( es->p_dec, p_block,
+                             input_priv(p_sys->p_input)->b_out_pace_control );
+        p_block = p_next;
+        i_count++;
+    }
+
+    msg_Dbg( p_sys->p_input, "ES 0x%x: sent %u pre-buffered packets",
+             es->fmt.i_id, i_count );
+}
+
 static void EsOutCreateDecoder( es_out_t *out, es_out_id_t *p_es )
 {
     es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
@@ -2060,7 +2385,7 @@ static void EsOutCreateDecoder( es_out_t *out, es_out_id_t *p_es )
                             priv->b_thumbnailing, &decoder_cbs, p_es );
     if( dec != NULL )
     {
-        input_DecoderChangeRate( dec, p_sys->rate );
+        input_DecoderChangeRate( dec, p_sys->rate * p_sys->auto_delay.correction );
 
         if( p_sys->b_buffering )
             input_DecoderStartWait( dec );
@@ -2087,6 +2412,9 @@ static void EsOutCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     p_es->p_dec = dec;
 
     EsOutDecoderChangeDelay( out, p_es );
+
+    if( dec != NULL )
+        EsOutPrebufferFeed( out, p_es );
 }
 static void EsOutDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
 {
@@ -2535,7 +2863,8 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
 
     if( !es->p_dec )
     {
-        block_Release( p_block );
+        if( !EsOutPrebuffer( out, es, p_block ) )
+            block_Release( p_block );
         vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
@@ -3037,13 +3366,14 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
         }
 
         /* TODO do not use vlc_tick_now() but proper stream acquisition date */
+        const vlc_tick_t i_now = vlc_tick_now();
         const bool b_low_delay = input_priv(p_sys->p_input)->b_low_delay;
         bool b_extra_buffering_allowed = !b_low_delay && EsOutIsExtraBufferingAllowed( out );
         vlc_tick_t i_late = input_clock_Update(
                             p_pgrm->p_input_clock, VLC_OBJECT(p_sys->p_input),
                             input_priv(p_sys->p_input)->b_can_pace_control || p_sys->b_buffering,
                             b_extra_buffering_allowed,
-                            i_pcr, vlc_tick_now() );
+                            i_pcr, i_now );
 
         if( !p_sys->p_pgrm )
             return VLC_SUCCESS;
@@ -3057,7 +3387,29 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
         {
             /* Last pcr/clock update was late. We need to compensate by offsetting
                from the clock the rendering dates */
-            if( i_late > 0 && ( !input_priv(p_sys->p_input)->p_sout ||
+            if( i_late > 0 && EsOutAutoDelayIsActive( p_sys ) )
+            {
+                /* Underrun: grow the caching at once, the smooth adjustment
+                 * cannot catch up */
+                struct input_stats *stats = input_priv(p_sys->p_input)->stats;
+                if( stats != NULL )
+                    atomic_fetch_add_explicit( &stats->clock_underruns, 1,
+                                               memory_order_relaxed );
+
+                p_sys->auto_delay.i_delay =
+                    __MIN( p_sys->auto_delay.i_delay + i_late + AUTO_DELAY_MARGIN,
+                           p_sys->auto_delay.i_max );
+                msg_Warn( p_sys->p_input,
+                          "ES_OUT_SET_(GROUP_)PCR  is called %d ms late (automatic caching increased to %d ms)",
+                          (int)MS_FROM_VLC_TICK(i_late),
+                          (int)MS_FROM_VLC_TICK(p_sys->auto_delay.i_delay) );
+
+                EsOutControlLocked( out, ES_OUT_RESET_PCR );
+                EsOutControlLocked( out, ES_OUT_SET_JITTER,
+                                    p_sys->i_pts_delay, p_sys->i_pts_jitter,
+                                    p_sys->i_cr_average );
+            }
+            else if( i_late > 0 && ( !input_priv(p_sys->p_input)->p_sout ||
                             !input_priv(p_sys->p_input)->b_out_pace_control ) )
             {
                 /* input_clock_GetJitter returns compound delay:
@@ -3113,6 +3465,8 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
                                     i_new_jitter,
                                     p_sys->i_cr_average );
             }
+            else if( EsOutAutoDelayIsActive( p_sys ) )
+                EsOutAutoDelayUpdate( out, p_pgrm, i_now );
         }
         return VLC_SUCCESS;
     }
@@ -3151,6 +3505,7 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
             return ret;
         EsOutFillEsFmt( out, &es->fmt );
         EsOutUpdateEsLanguageTitle(es, &es->fmt);
+        EsOutPrebufferClear( p_sys, es );
 
         const bool b_was_selected = EsIsSelected( es );
         if( es->p_dec )
@@ -3379,6 +3734,14 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
         int     i_cr_average = va_arg( args, int );
         es_out_pgrm_t *pgrm;
 
+        /* The caching of live streams is then measured, not configured */
+        const bool b_auto_delay = EsOutAutoDelayIsActive( p_sys );
+        if( b_auto_delay )
+        {
+            i_pts_delay = p_sys->auto_delay.i_delay;
+            i_pts_jitter = 0;
+        }
+
         const vlc_tick_t i_tracks_pts_delay = EsOutGetTracksDelay(out);
         bool b_change_clock =
             i_pts_delay != p_sys->i_pts_delay ||
@@ -3400,8 +3763,15 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
             {
                 input_clock_SetJitter(pgrm->p_input_clock, i_pts_delay,
                                       i_cr_average);
+                if (b_auto_delay)
+                    input_clock_SetPtsDelay(pgrm->p_input_clock, i_pts_delay);
                 vlc_clock_main_SetInputDejitter(pgrm->p_main_clock, i_pts_delay);
             }
+
+            struct input_stats *stats = input_priv(p_sys->p_input)->stats;
+            if (stats != NULL)
+                atomic_store_explicit(&stats->pts_delay, i_pts_delay,
+                                      memory_order_relaxed);
         }
         return VLC_SUCCESS;
     }
@@ -75,6 +75,9 @@ enum es_out_query_private_e
     /* Set next frame */
     ES_OUT_SET_FRAME_NEXT,                          /*                          res=can fail */
 
+    /* Skip the given duration of the delayed (timeshifted) data */
+    ES_OUT_JUMP_DELAYED,                            /* arg1=vlc_tick_t i_duration res=can fail */
+
     /* Set position/time/length */
     ES_OUT_SET_TIMES,                               /* arg1=double f_position arg2=vlc_tick_t i_time arg3=vlc_tick_t i_normal_time arg4=vlc_tick_t i_length res=cannot fail */
 
@@ -28,6 +28,7 @@
 #endif
 
 #include <stdlib.h>
+#include <limits.h>
 #include <stdio.h>
 #include <assert.h>
 #include <errno.h>
@@ -35,7 +36,16 @@
 #  include <direct.h>
 #endif
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
+#if defined (_WIN32) && !VLC_WINSTORE_APP
+#  include <windows.h>
+#  include <io.h>
+#  define TS_STORAGE_MAPPED_FILE 1
+#elif defined (HAVE_MMAP)
+#  include <sys/mman.h>
+#  define TS_STORAGE_MAPPED_FILE 1
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -82,7 +92,7 @@ typedef struct attribute_packed
 {
     es_out_id_t *p_es;
     block_t *p_block;
-    int     i_offset;  /* We do not use file > INT_MAX */
+    int     i_offset;  /* We do not use storage > INT_MAX */
 } ts_cmd_send_t;
 
 typedef struct attribute_packed
@@ -160,26 +170,43 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
-typedef struct ts_storage_t ts_storage_t;
-struct ts_storage_t
+/* Header of the block records stored in the ring */
+typedef struct
 {
-    ts_storage_t *p_next;
+    vlc_tick_t i_dts;
+    vlc_tick_t i_pts;
+    vlc_tick_t i_length;
+    uint32_t   i_flags;
+    unsigned   i_nb_samples;
+    size_t     i_buffer;
+} ts_storage_block_t;
 
-    /* */
-#ifdef _WIN32
-    char    *psz_file;  /* Filename */
-#endif
-    size_t  i_file_max; /* Max size in bytes */
-    int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
+#define TS_STORAGE_ALIGN(size) \
+    (((size) + sizeof(vlc_tick_t) - 1) & ~(sizeof(vlc_tick_t) - 1))
 
-    /* */
+/* Rings up to this size are kept in anonymous memory, larger ones in a
+ * memory-mapped temporary file where supported */
+#define TS_STORAGE_MEMORY_MAX (16*1024*1024)
+
+typedef struct
+{
+    /* Ring of block records, in queuing order. The records are contiguous:
+     * when one does not fit at the end of the ring, it is stored at the
+     * start. */
+    uint8_t *p_ring;
+    size_t  i_ring_size;
+    bool    b_mapped;
+    char    *psz_file;  /* mapped file to delete once unmapped, if any */
+    size_t  i_ring_r;   /* end of the last popped record */
+    size_t  i_ring_w;   /* end of the last pushed record */
+    int     i_blocks;   /* number of stored records */
+
+    /* Queue of commands (circular) */
     int      i_cmd_r;
-    int      i_cmd_w;
+    int      i_cmd_count;
     int      i_cmd_max;
     ts_cmd_t *p_cmd;
-};
+} ts_storage_t;
 
 typedef struct
 {
@@ -207,16 +234,25 @@ typedef struct
     vlc_tick_t     i_buffering_delay;
 
     /* */
-    ts_storage_t   *p_storage_r;
-    ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage;
+    bool           b_storage_full;
 
     vlc_tick_t     i_cmd_delay;
 
+    /* Forward jump within the stored commands */
+    vlc_tick_t     i_jump;          /* requested, not started yet */
+    vlc_tick_t     i_jump_date;     /* commands before this date are skipped */
+    bool           b_jump_reset;    /* the output must be reset after it */
+
 } ts_thread_t;
 
 struct es_out_id_t
 {
     es_out_id_t *p_es;
+
+    /* Data was dropped since the last stored block (protected by the
+     * timeshift thread lock) */
+    bool        b_discontinuity;
 };
 
 typedef struct
@@ -225,7 +261,7 @@ typedef struct
     es_out_t       *p_out;
 
     /* Configuration */
-    int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    int64_t        i_tmp_size_max;    /* Storage size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -260,15 +296,15 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
+static int          TsJump( ts_thread_t *, vlc_tick_t i_duration );
 
 static void         *TsRun( void * );
 
 static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
 static void         TsStorageDelete( ts_storage_t * );
-static void         TsStoragePack( ts_storage_t *p_storage );
-static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
+static const ts_cmd_t *TsStoragePeekCmd( ts_storage_t * );
+static int          TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
 
 static void CmdClean( ts_cmd_t * );
@@ -291,7 +327,11 @@ static void CmdExecuteDel    ( es_out_t *, ts_cmd_t * );
 static int  CmdExecuteControl( es_out_t *, ts_cmd_t * );
 
 /* File helpers */
+#ifdef TS_STORAGE_MAPPED_FILE
 static int GetTmpFile( char **ppsz_file, const char *psz_path );
+static uint8_t *MapTmpFile( int fd, size_t i_size );
+static void UnmapTmpFile( uint8_t *p_data, size_t i_size );
+#endif
 
 static const struct es_out_callbacks es_out_timeshift_cbs;
 
@@ -322,13 +362,11 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     TAB_INIT( p_sys->i_es, p_sys->pp_es );
 
     /* */
-    const int i_tmp_size_max = var_CreateGetInteger( p_input, "input-timeshift-granularity" );
-    if( i_tmp_size_max < 0 )
-        p_sys->i_tmp_size_max = 50*1024*1024;
-    else
-        p_sys->i_tmp_size_max = __MAX( i_tmp_size_max, 1*1024*1024 );
-    msg_Dbg( p_input, "using timeshift granularity of %d MiB",
-             (int)p_sys->i_tmp_size_max/(1024*1024) );
+    const int64_t i_tmp_size_max = var_InheritInteger( p_input, "input-timeshift-size" );
+    p_sys->i_tmp_size_max = VLC_CLIP( i_tmp_size_max, 1, INT_MAX / (1024*1024) )
+                          * 1024*1024;
+    msg_Dbg( p_input, "using timeshift storage of %d MiB",
+             (int)(p_sys->i_tmp_size_max/(1024*1024)) );
 
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
@@ -417,6 +455,7 @@ static es_out_id_t *Add( es_out_t *p_out, const es_format_t *p_fmt )
     es_out_id_t *p_es = malloc( sizeof( *p_es ) );
     if( !p_es )
         return NULL;
+    p_es->b_discontinuity = false;
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -716,6 +755,14 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
     {
         return ControlLockedSetFrameNext( p_out );
     }
+    case ES_OUT_JUMP_DELAYED:
+    {
+        const vlc_tick_t i_duration = va_arg( args, vlc_tick_t );
+
+        if( !p_sys->b_delayed || i_duration <= 0 )
+            return VLC_EGENERIC;
+        return TsJump( p_sys->p_ts, i_duration );
+    }
 
     case ES_OUT_GET_PCR_SYSTEM:
         if( p_sys->b_delayed )
@@ -812,8 +859,11 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
-    p_ts->p_storage_r = NULL;
-    p_ts->p_storage_w = NULL;
+    p_ts->p_storage = NULL;
+    p_ts->b_storage_full = false;
+    p_ts->i_jump = 0;
+    p_ts->i_jump_date = VLC_TICK_INVALID;
+    p_ts->b_jump_reset = false;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -855,9 +905,8 @@ static void TsStop( ts_thread_t *p_ts )
 
         CmdClean( &cmd );
     }
-    assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_storage )
+        TsStorageDelete( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -866,32 +915,40 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    if( !p_ts->p_storage )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
-
-        if( !p_storage )
+        p_ts->p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        if( !p_ts->p_storage )
         {
+            msg_Err( p_ts->p_input, "cannot create timeshift storage" );
             CmdClean( p_cmd );
             vlc_mutex_unlock( &p_ts->lock );
-            /* TODO warn the user (but only once) */
             return;
         }
+    }
 
-        if( !p_ts->p_storage_w )
-        {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
-        }
-        else
-        {
-            TsStoragePack( p_ts->p_storage_w );
-            p_ts->p_storage_w->p_next = p_storage;
-            p_ts->p_storage_w = p_storage;
-        }
+    if( p_cmd->i_type == C_SEND && p_cmd->u.send.p_es->b_discontinuity )
+        p_cmd->u.send.p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+
+    if( TsStoragePushCmd( p_ts->p_storage, p_cmd ) )
+    {
+        /* The timeshift window is full: the new data is lost */
+        if( !p_ts->b_storage_full )
+            msg_Warn( p_ts->p_input, "timeshift storage full, dropping data" );
+        p_ts->b_storage_full = true;
+
+        if( p_cmd->i_type == C_SEND )
+            p_cmd->u.send.p_es->b_discontinuity = true;
+        CmdClean( p_cmd );
+        vlc_mutex_unlock( &p_ts->lock );
+        return;
     }
 
-    /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    if( p_cmd->i_type == C_SEND )
+    {
+        p_ts->b_storage_full = false;
+        p_cmd->u.send.p_es->b_discontinuity = false;
+    }
 
     vlc_cond_signal( &p_ts->wait );
 
@@ -901,21 +958,10 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 {
     vlc_mutex_assert( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+    if( TsStorageIsEmpty( p_ts->p_storage ) )
         return VLC_EGENERIC;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
-
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
-    {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
-            break;
-
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
-    }
-
+    TsStoragePopCmd( p_ts->p_storage, p_cmd, b_flush );
     return VLC_SUCCESS;
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
@@ -923,7 +969,7 @@ static bool TsHasCmd( ts_thread_t *p_ts )
     bool b_cmd;
 
     vlc_mutex_lock( &p_ts->lock );
-    b_cmd = !TsStorageIsEmpty( p_ts->p_storage_r );
+    b_cmd = !TsStorageIsEmpty( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_cmd;
@@ -935,7 +981,7 @@ static bool TsIsUnused( ts_thread_t *p_ts )
     vlc_mutex_lock( &p_ts->lock );
     b_unused = !p_ts->b_paused &&
                p_ts->rate == p_ts->rate_source &&
-               TsStorageIsEmpty( p_ts->p_storage_r );
+               TsStorageIsEmpty( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_unused;
@@ -990,6 +1036,87 @@ static int TsChangeRate( ts_thread_t *p_ts, float src_rate, float rate )
     return i_ret;
 }
 
+static int TsJump( ts_thread_t *p_ts, vlc_tick_t i_duration )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_ts->lock );
+    /* Only the stored commands can be skipped: played data is gone */
+    if( !TsStorageIsEmpty( p_ts->p_storage ) )
+    {
+        p_ts->i_jump += i_duration;
+        vlc_cond_signal( &p_ts->wait );
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_ts->lock );
+    return i_ret;
+}
+
+/* Whether the next stored command is skipped by a jump */
+static bool TsIsSkippedLocked( ts_thread_t *p_ts )
+{
+    const ts_cmd_t *p_cmd = TsStoragePeekCmd( p_ts->p_storage );
+
+    if( p_cmd == NULL )
+        return false;
+
+    if( p_ts->i_jump > 0 )
+    {
+        /* The delay is reduced by the skipped time, or up to the live
+         * edge if the jump goes beyond the stored commands */
+        p_ts->i_jump_date = p_cmd->i_date + p_ts->i_jump;
+        p_ts->i_cmd_delay = __MAX( p_ts->i_cmd_delay - p_ts->i_jump, 0 );
+        p_ts->i_jump = 0;
+        p_ts->b_jump_reset = true;
+    }
+    return p_ts->i_jump_date != VLC_TICK_INVALID
+        && p_cmd->i_date < p_ts->i_jump_date;
+}
+
+/* Skips the stored commands jumped over, if any. Like any other command,
+ * they are popped with the lock held but executed with it released. */
+static void TsSkipLocked( ts_thread_t *p_ts )
+{
+    ts_cmd_t cmd;
+
+    while( TsIsSkippedLocked( p_ts ) )
+    {
+        /* The data of the skipped blocks is not even read. The state of the
+         * output is kept, but not the clock references. */
+        TsPopCmdLocked( p_ts, &cmd, true );
+        vlc_mutex_unlock( &p_ts->lock );
+
+        switch( cmd.i_type )
+        {
+        case C_ADD:
+            CmdExecuteAdd( p_ts->p_out, &cmd );
+            break;
+        case C_DEL:
+            CmdExecuteDel( p_ts->p_out, &cmd );
+            break;
+        case C_CONTROL:
+            if( cmd.u.control.i_query != ES_OUT_SET_PCR
+             && cmd.u.control.i_query != ES_OUT_SET_GROUP_PCR )
+                CmdExecuteControl( p_ts->p_out, &cmd );
+            break;
+        }
+        CmdClean( &cmd );
+
+        vlc_mutex_lock( &p_ts->lock );
+    }
+
+    if( p_ts->b_jump_reset )
+    {
+        /* Decoders and clock restart from the first command kept */
+        p_ts->i_jump_date = VLC_TICK_INVALID;
+        p_ts->b_jump_reset = false;
+
+        vlc_mutex_unlock( &p_ts->lock );
+        es_out_Control( p_ts->p_out, ES_OUT_RESET_PCR );
+        vlc_mutex_lock( &p_ts->lock );
+    }
+}
+
 static void *TsRun( void *p_data )
 {
     ts_thread_t *p_ts = p_data;
@@ -1010,6 +1137,8 @@ static void *TsRun( void *p_data )
             const int canc = vlc_savecancel();
             b_buffering = es_out_GetBuffering( p_ts->p_out );
 
+            TsSkipLocked( p_ts );
+
             if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false ) )
             {
                 vlc_restorecancel( canc );
@@ -1118,64 +1247,75 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     if( unlikely(p_storage == NULL) )
         return NULL;
 
-    char *psz_file;
-    int fd = GetTmpFile( &psz_file, psz_tmp_path );
-    if( fd == -1 )
-    {
-        free( p_storage );
-        return NULL;
-    }
+    p_storage->i_ring_size = i_tmp_size_max;
+    p_storage->b_mapped = false;
+    p_storage->p_ring = NULL;
+    p_storage->psz_file = NULL;
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
+#ifdef TS_STORAGE_MAPPED_FILE
+    if( p_storage->i_ring_size > TS_STORAGE_MEMORY_MAX )
     {
+        char *psz_file;
+        int fd = GetTmpFile( &psz_file, psz_tmp_path );
+        if( fd == -1 )
+        {
+            free( p_storage );
+            return NULL;
+        }
+
+        p_storage->p_ring = MapTmpFile( fd, p_storage->i_ring_size );
+        p_storage->b_mapped = p_storage->p_ring != NULL;
         vlc_close( fd );
-        vlc_unlink( psz_file );
-        goto error;
-    }
+#ifdef _WIN32
+        /* A mapped file cannot be deleted: it is deleted after unmapping */
+        if( p_storage->b_mapped )
+            p_storage->psz_file = psz_file;
+        else
+#endif
+        {
+            vlc_unlink( psz_file );
+            free( psz_file );
+        }
 
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
-    {
-        fclose( p_storage->p_filew );
-        vlc_unlink( psz_file );
-        goto error;
+        if( !p_storage->b_mapped )
+        {
+            free( p_storage );
+            return NULL;
+        }
     }
-
-#ifndef _WIN32
-    vlc_unlink( psz_file );
-    free( psz_file );
+    else
 #else
-    p_storage->psz_file = psz_file;
+    VLC_UNUSED(psz_tmp_path);
 #endif
-    p_storage->p_next = NULL;
+    {
+        p_storage->p_ring = malloc( p_storage->i_ring_size );
+        if( p_storage->p_ring == NULL )
+        {
+            free( p_storage );
+            return NULL;
+        }
+    }
 
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
+    p_storage->i_ring_r = 0;
+    p_storage->i_ring_w = 0;
+    p_storage->i_blocks = 0;
 
     /* */
-    p_storage->i_cmd_w = 0;
     p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
+    p_storage->i_cmd_count = 0;
+    p_storage->i_cmd_max = 1024;
     p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
-
     if( !p_storage->p_cmd )
     {
         TsStorageDelete( p_storage );
         return NULL;
     }
     return p_storage;
-error:
-    free( psz_file );
-    free( p_storage );
-    return NULL;
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
 {
-    while( p_storage->i_cmd_r < p_storage->i_cmd_w )
+    while( !TsStorageIsEmpty( p_storage ) )
     {
         ts_cmd_t cmd;
 
@@ -1185,107 +1325,147 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
-#ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
+#ifdef TS_STORAGE_MAPPED_FILE
+    if( p_storage->b_mapped )
+        UnmapTmpFile( p_storage->p_ring, p_storage->i_ring_size );
+    else
 #endif
+        free( p_storage->p_ring );
+    if( p_storage->psz_file != NULL )
+    {
+        vlc_unlink( p_storage->psz_file );
+        free( p_storage->psz_file );
+    }
     free( p_storage );
 }
 
-static void TsStoragePack( ts_storage_t *p_storage )
+static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
-    /* Try to release a bit of memory */
-    if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
-        return;
-
-    p_storage->i_cmd_max = __MAX( p_storage->i_cmd_w, 1 );
+    return !p_storage || p_storage->i_cmd_count <= 0;
+}
 
-    ts_cmd_t *p_new = realloc( p_storage->p_cmd, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
-    if( p_new )
-        p_storage->p_cmd = p_new;
+static const ts_cmd_t *TsStoragePeekCmd( ts_storage_t *p_storage )
+{
+    if( TsStorageIsEmpty( p_storage ) )
+        return NULL;
+    return &p_storage->p_cmd[p_storage->i_cmd_r];
 }
-static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+
+/* Finds room for a contiguous record in the ring, or returns -1 */
+static ssize_t TsStorageAllocRecord( ts_storage_t *p_storage, size_t i_size )
 {
-    if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
-    {
-        size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
+    if( p_storage->i_blocks == 0 )
+        p_storage->i_ring_r = p_storage->i_ring_w = 0;
 
-        if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
-            return true;
+    if( p_storage->i_ring_r <= p_storage->i_ring_w )
+    {
+        /* Free space is after the write position and before the read one */
+        if( i_size <= p_storage->i_ring_size - p_storage->i_ring_w )
+            return p_storage->i_ring_w;
+        if( i_size < p_storage->i_ring_r )
+            return 0;
     }
-    return p_storage->i_cmd_w >= p_storage->i_cmd_max;
-}
-static bool TsStorageIsEmpty( ts_storage_t *p_storage )
-{
-    return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
+    else if( i_size < p_storage->i_ring_r - p_storage->i_ring_w )
+    {
+        /* The ring has wrapped: free space is between both positions */
+        return p_storage->i_ring_w;
+    }
+    return -1;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+
+static int TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     ts_cmd_t cmd = *p_cmd;
 
-    assert( !TsStorageIsFull( p_storage, p_cmd ) );
+    if( p_storage->i_cmd_count >= p_storage->i_cmd_max )
+    {
+        ts_cmd_t *p_new = vlc_reallocarray( p_storage->p_cmd,
+                                            2 * p_storage->i_cmd_max,
+                                            sizeof(*p_storage->p_cmd) );
+        if( !p_new )
+            return VLC_ENOMEM;
+
+        /* Unwrap the queued commands */
+        memcpy( &p_new[p_storage->i_cmd_max], p_new,
+                p_storage->i_cmd_r * sizeof(*p_new) );
+        p_storage->p_cmd = p_new;
+        p_storage->i_cmd_max *= 2;
+    }
 
     if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
-
-        cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
-
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
-        {
-            block_Release( p_block );
-            return;
-        }
-        p_storage->i_file_size += sizeof(*p_block);
+        const size_t i_size = TS_STORAGE_ALIGN( sizeof(ts_storage_block_t)
+                                                + p_block->i_buffer );
+        const ssize_t i_offset = TsStorageAllocRecord( p_storage, i_size );
+
+        if( i_offset < 0 )
+            return VLC_ENOMEM;
+
+        uint8_t *p_record = &p_storage->p_ring[i_offset];
+        const ts_storage_block_t header = {
+            .i_dts = p_block->i_dts,
+            .i_pts = p_block->i_pts,
+            .i_length = p_block->i_length,
+            .i_flags = p_block->i_flags,
+            .i_nb_samples = p_block->i_nb_samples,
+            .i_buffer = p_block->i_buffer,
+        };
+
+        memcpy( p_record, &header, sizeof(header) );
         if( p_block->i_buffer > 0 )
-        {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
-        }
-        p_storage->i_file_size += p_block->i_buffer;
+            memcpy( p_record + sizeof(header), p_block->p_buffer,
+                    p_block->i_buffer );
         block_Release( p_block );
 
-        if( b_flush )
-            fflush( p_storage->p_filew );
+        cmd.u.send.p_block = NULL;
+        cmd.u.send.i_offset = i_offset;
+        p_storage->i_ring_w = i_offset + i_size;
+        p_storage->i_blocks++;
     }
-    p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+
+    const int i_cmd_w = (p_storage->i_cmd_r + p_storage->i_cmd_count)
+                      % p_storage->i_cmd_max;
+    p_storage->p_cmd[i_cmd_w] = cmd;
+    p_storage->i_cmd_count++;
+    return VLC_SUCCESS;
 }
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
-    *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
+    *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r];
+    p_storage->i_cmd_r = (p_storage->i_cmd_r + 1) % p_storage->i_cmd_max;
+    p_storage->i_cmd_count--;
+
     if( p_cmd->i_type == C_SEND )
     {
-        block_t block;
+        const uint8_t *p_record = &p_storage->p_ring[p_cmd->u.send.i_offset];
+        ts_storage_block_t header;
+        block_t *p_block = NULL;
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+        memcpy( &header, p_record, sizeof(header) );
+        if( !b_flush )
         {
-            block_t *p_block = block_Alloc( block.i_buffer );
+            p_block = block_Alloc( header.i_buffer );
             if( p_block )
             {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+                p_block->i_dts      = header.i_dts;
+                p_block->i_pts      = header.i_pts;
+                p_block->i_flags    = header.i_flags;
+                p_block->i_length   = header.i_length;
+                p_block->i_nb_samples = header.i_nb_samples;
+                if( header.i_buffer > 0 )
+                    memcpy( p_block->p_buffer, p_record + sizeof(header),
+                            header.i_buffer );
             }
-            p_cmd->u.send.p_block = p_block;
-        }
-        else
-        {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
         }
+        p_cmd->u.send.p_block = p_block;
+
+        /* Records are popped in the order they were pushed */
+        p_storage->i_ring_r = p_cmd->u.send.i_offset
+            + TS_STORAGE_ALIGN( sizeof(header) + header.i_buffer );
+        p_storage->i_blocks--;
     }
 }
 
@@ -1654,6 +1834,7 @@ static void CmdCleanControl( ts_cmd_t *p_cmd )
     }
 }
 
+#ifdef TS_STORAGE_MAPPED_FILE
 static int GetTmpFile( char **filename, const char *dirname )
 {
     if( dirname != NULL
@@ -1680,3 +1861,47 @@ static int GetTmpFile( char **filename, const char *dirname )
     free( *filename );
     return -1;
 }
+
+/* Maps the whole file, extended to the given size. Fails if the disk space
+ * cannot be allocated, so that the storage is not created. */
+static uint8_t *MapTmpFile( int fd, size_t i_size )
+{
+#ifdef _WIN32
+    HANDLE h_map = CreateFileMapping( (HANDLE)_get_osfhandle( fd ), NULL,
+                                      PAGE_READWRITE,
+                                      (uint64_t)i_size >> 32,
+                                      i_size & 0xffffffff, NULL );
+    if( h_map == NULL )
+        return NULL;
+
+    /* The view keeps the mapping open */
+    void *p_data = MapViewOfFile( h_map, FILE_MAP_WRITE, 0, 0, i_size );
+    CloseHandle( h_map );
+    return p_data;
+#else
+#ifdef HAVE_POSIX_FALLOCATE
+    /* The disk space is reserved up front: storing into a hole of the
+     * mapping on a full file system would raise SIGBUS */
+    if( posix_fallocate( fd, 0, i_size ) )
+        return NULL;
+#else
+    if( ftruncate( fd, i_size ) )
+        return NULL;
+#endif
+
+    void *p_data = mmap( NULL, i_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         fd, 0 );
+    return p_data != MAP_FAILED ? p_data : NULL;
+#endif
+}
+
+static void UnmapTmpFile( uint8_t *p_data, size_t i_size )
+{
+#ifdef _WIN32
+    VLC_UNUSED(i_size);
+    UnmapViewOfFile( p_data );
+#else
+    munmap( p_data, i_size );
+#endif
+}
+#endif
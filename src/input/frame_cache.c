@@ -0,0 +1,215 @@
+/*****************************************************************************
+ * frame_cache.c: decoded video frames cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+#include <vlc_picture.h>
+#include <vlc_vector.h>
+#include "frame_cache.h"
+
+struct frame_cache_entry
+{
+    picture_t *picture;
+    size_t size;
+    uint64_t seq; /* storage order, for eviction */
+};
+
+struct frame_cache
+{
+    vlc_mutex_t lock;
+    video_format_t fmt;
+    bool has_fmt;
+    size_t budget;
+    size_t size;
+    uint64_t seq;
+    /* sorted by date */
+    struct VLC_VECTOR(struct frame_cache_entry) entries;
+};
+
+frame_cache_t *frame_cache_New(size_t budget)
+{
+    frame_cache_t *cache = malloc(sizeof (*cache));
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    vlc_mutex_init(&cache->lock);
+    cache->has_fmt = false;
+    cache->budget = budget;
+    cache->size = 0;
+    cache->seq = 0;
+    vlc_vector_init(&cache->entries);
+    return cache;
+}
+
+static void frame_cache_ClearLocked(frame_cache_t *cache)
+{
+    for (size_t i = 0; i < cache->entries.size; i++)
+        picture_Release(cache->entries.data[i].picture);
+    vlc_vector_clear(&cache->entries);
+    cache->size = 0;
+
+    if (cache->has_fmt)
+    {
+        video_format_Clean(&cache->fmt);
+        cache->has_fmt = false;
+    }
+}
+
+void frame_cache_Delete(frame_cache_t *cache)
+{
+    frame_cache_ClearLocked(cache);
+    vlc_vector_destroy(&cache->entries);
+    vlc_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+void frame_cache_Clear(frame_cache_t *cache)
+{
+    vlc_mutex_lock(&cache->lock);
+    frame_cache_ClearLocked(cache);
+    vlc_mutex_unlock(&cache->lock);
+}
+
+/* Index of the first entry with a date strictly greater than the given one */
+static size_t frame_cache_UpperBound(const frame_cache_t *cache,
+                                     vlc_tick_t date)
+{
+    size_t lo = 0, hi = cache->entries.size;
+
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+
+        if (cache->entries.data[mid].picture->date <= date)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static bool frame_cache_HasLocked(const frame_cache_t *cache, vlc_tick_t date)
+{
+    size_t i = frame_cache_UpperBound(cache, date);
+
+    return i > 0 && cache->entries.data[i - 1].picture->date == date;
+}
+
+static void frame_cache_EvictOldest(frame_cache_t *cache)
+{
+    size_t oldest = 0;
+
+    assert(cache->entries.size > 0);
+    for (size_t i = 1; i < cache->entries.size; i++)
+        if (cache->entries.data[i].seq < cache->entries.data[oldest].seq)
+            oldest = i;
+
+    cache->size -= cache->entries.data[oldest].size;
+    picture_Release(cache->entries.data[oldest].picture);
+    vlc_vector_remove(&cache->entries, oldest);
+}
+
+void frame_cache_Put(frame_cache_t *cache, const picture_t *pic)
+{
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(pic->format.i_chroma);
+
+    if (pic->context != NULL || dsc == NULL || dsc->plane_count == 0
+     || pic->date == VLC_TICK_INVALID)
+        return; /* opaque picture or no date */
+
+    size_t size = 0;
+    for (int i = 0; i < pic->i_planes; i++)
+        size += (size_t)pic->p[i].i_pitch * pic->p[i].i_lines;
+    if (size > cache->budget)
+        return;
+
+    vlc_mutex_lock(&cache->lock);
+    if (cache->has_fmt && !video_format_IsSimilar(&cache->fmt, &pic->format))
+        frame_cache_ClearLocked(cache);
+    if (!cache->has_fmt)
+    {
+        if (video_format_Copy(&cache->fmt, &pic->format))
+            goto out;
+        cache->has_fmt = true;
+    }
+
+    if (frame_cache_HasLocked(cache, pic->date))
+        goto out;
+
+    while (cache->size + size > cache->budget)
+        frame_cache_EvictOldest(cache);
+
+    picture_t *copy = picture_NewFromFormat(&pic->format);
+    if (unlikely(copy == NULL))
+        goto out;
+    picture_Copy(copy, pic);
+
+    struct frame_cache_entry entry = {
+        .picture = copy,
+        .size = size,
+        .seq = cache->seq++,
+    };
+
+    size_t index = frame_cache_UpperBound(cache, pic->date);
+
+    if (vlc_vector_insert(&cache->entries, index, entry))
+        cache->size += size;
+    else
+        picture_Release(copy);
+out:
+    vlc_mutex_unlock(&cache->lock);
+}
+
+bool frame_cache_Has(frame_cache_t *cache, vlc_tick_t date)
+{
+    vlc_mutex_lock(&cache->lock);
+    bool ret = frame_cache_HasLocked(cache, date);
+    vlc_mutex_unlock(&cache->lock);
+    return ret;
+}
+
+picture_t *frame_cache_Get(frame_cache_t *cache, vlc_tick_t after,
+                           vlc_tick_t upto)
+{
+    picture_t *pic = NULL;
+
+    vlc_mutex_lock(&cache->lock);
+    size_t i = frame_cache_UpperBound(cache, after);
+    if (i < cache->entries.size)
+    {
+        picture_t *cached = cache->entries.data[i].picture;
+
+        if (cached->date <= upto)
+        {   /* The output may change the picture properties, not the pixels */
+            pic = picture_Clone(cached);
+            if (likely(pic != NULL))
+                picture_CopyProperties(pic, cached);
+        }
+    }
+    vlc_mutex_unlock(&cache->lock);
+    return pic;
+}
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * frame_cache.h: decoded video frames cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_INPUT_FRAME_CACHE_H
+#define LIBVLC_INPUT_FRAME_CACHE_H 1
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+/**
+ * Cache of recently decoded video frames, indexed by date.
+ *
+ * The cache keeps copies of decoded pictures, within a memory budget, so
+ * that seeking back into a recently decoded range does not require decoding
+ * again. When the budget is exceeded, the least recently stored pictures are
+ * evicted first. Dates are only meaningful within a timeline: the cache must
+ * be cleared on discontinuities. All functions are thread-safe.
+ */
+typedef struct frame_cache frame_cache_t;
+
+/**
+ * Creates a cache.
+ *
+ * \param budget maximum size of the cached pixels, in bytes
+ */
+frame_cache_t *frame_cache_New(size_t budget);
+
+void frame_cache_Delete(frame_cache_t *);
+
+/**
+ * Stores a copy of a decoded picture.
+ *
+ * Pictures in opaque (hardware) formats are not cached. Storing a picture of
+ * a different format than the cached ones clears the cache first.
+ */
+void frame_cache_Put(frame_cache_t *, const picture_t *);
+
+/**
+ * Checks whether a picture with the given date is cached.
+ */
+bool frame_cache_Has(frame_cache_t *, vlc_tick_t date);
+
+/**
+ * Gets the cached picture with the lowest date in ]after, upto].
+ *
+ * \param after exclusive lower bound, or VLC_TICK_INVALID for none
+ * \param upto inclusive upper bound
+ * \return a new picture sharing the cached pixels, or NULL if none
+ */
+picture_t *frame_cache_Get(frame_cache_t *, vlc_tick_t after, vlc_tick_t upto);
+
+/**
+ * Removes all the cached pictures.
+ */
+void frame_cache_Clear(frame_cache_t *);
+
+#endif
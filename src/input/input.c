@@ -1858,6 +1858,15 @@ static bool Control( input_thread_t *p_input,
                 break;
             }
 
+            /* Jump forward within the timeshifted data, if any */
+            if( !absolute && param.time.i_val > 0
+             && es_out_Control( priv->p_es_out, ES_OUT_JUMP_DELAYED,
+                                param.time.i_val ) == VLC_SUCCESS )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_Control( priv->p_es_out, ES_OUT_RESET_PCR );
 
@@ -688,6 +688,9 @@ struct input_stats {
     atomic_uintmax_t lost_abuffers;
     atomic_uintmax_t displayed_pictures;
     atomic_uintmax_t lost_pictures;
+    atomic_uintmax_t judder_pictures;
+    atomic_uintmax_t pts_delay;
+    atomic_uintmax_t clock_underruns;
 };
 
 struct input_stats *input_stats_Create(void);
@@ -67,6 +67,9 @@ struct input_stats *input_stats_Create(void)
     atomic_init(&stats->lost_abuffers, 0);
     atomic_init(&stats->displayed_pictures, 0);
     atomic_init(&stats->lost_pictures, 0);
+    atomic_init(&stats->judder_pictures, 0);
+    atomic_init(&stats->pts_delay, 0);
+    atomic_init(&stats->clock_underruns, 0);
     return stats;
 }
 
@@ -110,6 +113,14 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+    st->i_judder_pictures = atomic_load_explicit(&stats->judder_pictures,
+                                                 memory_order_relaxed);
+
+    /* Clock */
+    st->i_pts_delay = atomic_load_explicit(&stats->pts_delay,
+                                           memory_order_relaxed);
+    st->i_clock_underruns = atomic_load_explicit(&stats->clock_underruns,
+                                                 memory_order_relaxed);
 }
 
 /** Update a counter element with new values
@@ -490,6 +490,19 @@ static const char *const screensaver_texts[] = {
     "This drops frames that are late (arrive to the video output after " \
     "their intended display date)." )
 
+#define VSYNC_PACING_TEXT N_("Pace frames on the display refresh")
+#define VSYNC_PACING_LONGTEXT N_( \
+    "This learns the display refresh rate from the presentation dates, " \
+    "and presents each frame on the refresh nearest to its display date. " \
+    "This gives a regular cadence with displays synchronized on the " \
+    "vertical refresh.")
+
+#define VIDEO_FILTER_THREAD_TEXT N_("Run video filters ahead of display")
+#define VIDEO_FILTER_THREAD_LONGTEXT N_( \
+    "This runs the deinterlacing and post-processing filters on a " \
+    "separate thread, a few frames ahead of display, so that their cost " \
+    "does not delay the presentation of the frames.")
+
 #define QUIET_SYNCHRO_TEXT N_("Quiet synchro")
 #define QUIET_SYNCHRO_LONGTEXT N_( \
     "This avoids flooding the message log with debug output from the " \
@@ -545,6 +558,17 @@ static const char *const screensaver_texts[] = {
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define CLOCK_AUTO_DELAY_TEXT N_("Automatic caching for live streams")
+#define CLOCK_AUTO_DELAY_LONGTEXT N_( \
+    "Start live streams with a minimal caching, then adapt it to the " \
+    "measured network jitter and buffer underruns. Changes are made by " \
+    "playing slightly slower or faster." )
+
+#define CLOCK_AUTO_DELAY_MIN_TEXT N_("Minimal automatic caching (ms)")
+#define CLOCK_AUTO_DELAY_MIN_LONGTEXT N_( \
+    "Caching used when starting a live stream in automatic caching mode, " \
+    "and below which it is never reduced." )
+
 #define CLOCK_MASTER_TEXT N_("Clock master source")
 
 static const int pi_clock_master_values[] = {
@@ -687,6 +711,22 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_FAST_SEEK_LONGTEXT N_( \
     "Favor speed over precision while seeking" )
 
+#define VIDEO_FRAME_CACHE_TEXT N_("Decoded video cache size (MiB)")
+#define VIDEO_FRAME_CACHE_LONGTEXT N_( \
+    "Keep recently decoded video frames in memory, up to this size, so " \
+    "that seeking back into them, e.g. when scrubbing, does not require " \
+    "decoding again. Zero disables the cache.")
+
+#define PREBUFFER_TRACKS_TEXT N_("Pre-buffered alternate tracks")
+#define PREBUFFER_TRACKS_LONGTEXT N_( \
+    "Keep the packets of up to this number of unselected audio and " \
+    "subtitle tracks, so that switching to one of them starts from the " \
+    "current playback time without waiting for the input.")
+
+#define PREBUFFER_TRACK_SIZE_TEXT N_("Alternate track buffer size (KiB)")
+#define PREBUFFER_TRACK_SIZE_LONGTEXT N_( \
+    "Maximum amount of packets kept for each pre-buffered alternate track.")
+
 #define INPUT_RATE_TEXT N_("Playback speed")
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
@@ -727,10 +767,12 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_TIMESHIFT_PATH_LONGTEXT N_( \
     "Directory used to store the timeshift temporary files." )
 
-#define INPUT_TIMESHIFT_GRANULARITY_TEXT N_("Timeshift granularity")
-#define INPUT_TIMESHIFT_GRANULARITY_LONGTEXT N_( \
-    "This is the maximum size in bytes of the temporary files " \
-    "that will be used to store the timeshifted streams." )
+#define INPUT_TIMESHIFT_SIZE_TEXT N_("Timeshift storage size")
+#define INPUT_TIMESHIFT_SIZE_LONGTEXT N_( \
+    "Total size in MiB of the storage used for the timeshifted streams, " \
+    "in memory or in a temporary file of the timeshift directory. " \
+    "When it is full, the new data is dropped, and playback skips it " \
+    "once it catches up." )
 
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
@@ -861,7 +903,9 @@ static const char *const ppsz_prefres[] = {
 
 #define TIMEOUT_TEXT N_("TCP connection timeout")
 #define TIMEOUT_LONGTEXT N_( \
-    "Default TCP connection timeout (in milliseconds)." )
+    "Default TCP connection timeout (in milliseconds), for each address " \
+    "of the server. Addresses are tried in parallel, a new one every " \
+    "250 milliseconds." )
 
 #define HTTP_HOST_TEXT N_( "HTTP server address" )
 #define HOST_LONGTEXT N_( \
@@ -1109,6 +1153,34 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define HUGEPAGES_TEXT N_("Use huge pages for large buffers")
+#define HUGEPAGES_LONGTEXT N_( \
+    "Allocate large pictures and data blocks, such as ultra high " \
+    "definition video frames, from huge memory pages. This reduces the " \
+    "address translation overhead of processing them, at the cost of " \
+    "some memory. This applies to the whole process.")
+
+#define THREAD_CPUS_LONGTEXT N_( \
+    "Comma-separated list of the CPUs, or CPU ranges, that these threads " \
+    "may run on, e.g. \"0-3,8\". By default, they may run on any CPU.")
+#define THREAD_PRIORITY_LONGTEXT N_( \
+    "Scheduling class of these threads. High priority usually requires " \
+    "privileges. Real-time priority can lock up your whole machine, you " \
+    "should only use it if you know what you are doing.")
+#define ADEC_CPUS_TEXT N_("Audio decoder CPUs")
+#define ADEC_PRIORITY_TEXT N_("Audio decoder priority")
+#define VDEC_CPUS_TEXT N_("Video decoder CPUs")
+#define VDEC_PRIORITY_TEXT N_("Video decoder priority")
+#define SDEC_CPUS_TEXT N_("Subtitles decoder CPUs")
+#define SDEC_PRIORITY_TEXT N_("Subtitles decoder priority")
+#define VOUT_CPUS_TEXT N_("Video output CPUs")
+#define VOUT_PRIORITY_TEXT N_("Video output priority")
+
+static const char *const ppsz_thread_priority[] = {
+    "", "low", "normal", "high", "realtime" };
+static const char *const ppsz_thread_priority_text[] = {
+    N_("Default"), N_("Low"), N_("Normal"), N_("High"), N_("Real-time") };
+
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
      "reading a stream")
@@ -1668,6 +1740,8 @@ vlc_module_begin ()
         change_private ()
     add_bool( "drop-late-frames", 1, DROP_LATE_FRAMES_TEXT,
               DROP_LATE_FRAMES_LONGTEXT, true )
+    add_bool( "vsync-pacing", false, VSYNC_PACING_TEXT,
+              VSYNC_PACING_LONGTEXT, true )
     /* Used in vout_synchro */
     add_bool( "skip-frames", 1, SKIP_FRAMES_TEXT,
               SKIP_FRAMES_LONGTEXT, true )
@@ -1765,6 +1839,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list("video-filter", "video filter", NULL,
                     VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT)
+    add_bool( "video-filter-thread", false, VIDEO_FILTER_THREAD_TEXT,
+              VIDEO_FILTER_THREAD_LONGTEXT, true )
 
 #if 0
     add_string( "pixel-ratio", "1", PIXEL_RATIO_TEXT, PIXEL_RATIO_TEXT )
@@ -1886,6 +1962,15 @@ vlc_module_begin ()
     add_bool( "input-fast-seek", false,
               INPUT_FAST_SEEK_TEXT, INPUT_FAST_SEEK_LONGTEXT, false )
         change_safe ()
+    add_integer( "video-frame-cache", 0,
+                 VIDEO_FRAME_CACHE_TEXT, VIDEO_FRAME_CACHE_LONGTEXT, true )
+        change_integer_range( 0, 65536 )
+    add_integer( "prebuffer-tracks", 0,
+                 PREBUFFER_TRACKS_TEXT, PREBUFFER_TRACKS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
+    add_integer( "prebuffer-track-size", 1024,
+                 PREBUFFER_TRACK_SIZE_TEXT, PREBUFFER_TRACK_SIZE_LONGTEXT, true )
+        change_integer_range( 16, 65536 )
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT, false )
 
@@ -2035,6 +2120,13 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_bool( "clock-auto-delay", false, CLOCK_AUTO_DELAY_TEXT,
+              CLOCK_AUTO_DELAY_LONGTEXT, true )
+        change_safe()
+    add_integer( "clock-auto-delay-min", 100, CLOCK_AUTO_DELAY_MIN_TEXT,
+                 CLOCK_AUTO_DELAY_MIN_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
     add_integer( "clock-master", VLC_CLOCK_MASTER_DEFAULT,
                  CLOCK_MASTER_TEXT, NULL, true )
         change_integer_list( pi_clock_master_values, ppsz_clock_master_descriptions )
@@ -2049,8 +2141,10 @@ vlc_module_begin ()
 
     add_directory("input-timeshift-path", NULL,
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
-    add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
-                 INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-size", 256, INPUT_TIMESHIFT_SIZE_TEXT,
+                 INPUT_TIMESHIFT_SIZE_LONGTEXT, true )
+        change_integer_range( 1, 2047 )
+    add_obsolete_integer( "input-timeshift-granularity" ) /* since 4.0.0 */
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -2175,6 +2269,33 @@ vlc_module_begin ()
                  RT_OFFSET_LONGTEXT, true )
 #endif
 
+#ifdef __linux__
+    add_bool( "hugepages", false, HUGEPAGES_TEXT,
+              HUGEPAGES_LONGTEXT, true )
+
+    /* The audio decoder thread also feeds the audio output */
+    add_string( "audio-decoder-cpus", NULL, ADEC_CPUS_TEXT,
+                THREAD_CPUS_LONGTEXT, true )
+    add_string( "audio-decoder-priority", "", ADEC_PRIORITY_TEXT,
+                THREAD_PRIORITY_LONGTEXT, true )
+        change_string_list( ppsz_thread_priority, ppsz_thread_priority_text )
+    add_string( "video-decoder-cpus", NULL, VDEC_CPUS_TEXT,
+                THREAD_CPUS_LONGTEXT, true )
+    add_string( "video-decoder-priority", "", VDEC_PRIORITY_TEXT,
+                THREAD_PRIORITY_LONGTEXT, true )
+        change_string_list( ppsz_thread_priority, ppsz_thread_priority_text )
+    add_string( "spu-decoder-cpus", NULL, SDEC_CPUS_TEXT,
+                THREAD_CPUS_LONGTEXT, true )
+    add_string( "spu-decoder-priority", "", SDEC_PRIORITY_TEXT,
+                THREAD_PRIORITY_LONGTEXT, true )
+        change_string_list( ppsz_thread_priority, ppsz_thread_priority_text )
+    add_string( "vout-cpus", NULL, VOUT_CPUS_TEXT,
+                THREAD_CPUS_LONGTEXT, true )
+    add_string( "vout-priority", "", VOUT_PRIORITY_TEXT,
+                THREAD_PRIORITY_LONGTEXT, true )
+        change_string_list( ppsz_thread_priority, ppsz_thread_priority_text )
+#endif
+
 #if defined(HAVE_DBUS)
     add_obsolete_bool( "inhibit" ) /* since 3.0.0 */
 #endif
@@ -65,6 +65,7 @@
 #include <vlc_thumbnailer.h>
 
 #include "libvlc.h"
+#include "misc/hugepage.h"
 
 #include <vlc_vlm.h>
 
@@ -165,6 +166,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
         goto error;
 
     vlc_LogInit(p_libvlc);
+    vlc_hugepage_setup (var_InheritBool (p_libvlc, "hugepages"));
 
     /*
      * Support for gettext
@@ -439,6 +441,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
 
+    vlc_hugepage_cleanup ();
+    vlc_net_CleanupAddrInfo ();
     vlc_LogDestroy(p_libvlc->obj.logger);
     /* Free module bank. It is refcounted, so we call this each time  */
     module_EndBank (true);
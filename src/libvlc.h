@@ -51,6 +51,27 @@ int vlc_set_priority( vlc_thread_t, int );
 
 void vlc_threads_setup (libvlc_int_t *);
 
+/**
+ * Threads whose CPU affinity and priority class can be configured.
+ */
+enum vlc_thread_role
+{
+    VLC_THREAD_AUDIO_DECODER, /**< Audio decoder, also feeding the output */
+    VLC_THREAD_VIDEO_DECODER,
+    VLC_THREAD_SPU_DECODER,
+    VLC_THREAD_VIDEO_OUTPUT,
+};
+
+/**
+ * Applies the scheduling policy configured for a thread role, as inherited
+ * from the given object, to the calling thread.
+ */
+#ifdef __linux__
+void vlc_thread_ApplyPolicy(vlc_object_t *, enum vlc_thread_role);
+#else
+# define vlc_thread_ApplyPolicy(obj, role) ((void)(obj), (void)(role))
+#endif
+
 void vlc_trace (const char *fn, const char *file, unsigned line);
 #define vlc_backtrace() vlc_trace(__func__, __FILE__, __LINE__)
 
@@ -230,6 +251,62 @@ int vlc_MetadataRequest(libvlc_int_t *libvlc, input_item_t *item,
                         void *cbs_userdata,
                         int timeout, void *id);
 
+/*
+ * Network
+ */
+struct addrinfo;
+
+/**
+ * Resolves a host name, through the resolver cache.
+ *
+ * This is the same as vlc_getaddrinfo_i11e(), except that results are reused
+ * for a little while.
+ *
+ * @return 0 on success, a getaddrinfo() error otherwise.
+ * On success, *res must be freed with vlc_net_FreeAddrInfo().
+ */
+int vlc_net_GetAddrInfo(const char *node, unsigned port,
+                        const struct addrinfo *hints, struct addrinfo **res);
+
+/**
+ * Frees a socket addresses list from vlc_net_GetAddrInfo().
+ */
+void vlc_net_FreeAddrInfo(struct addrinfo *res);
+
+/**
+ * Empties the resolver cache.
+ */
+void vlc_net_CleanupAddrInfo(void);
+
+/**
+ * Removes a socket address from the resolver cache.
+ *
+ * This should be called when connecting to an address failed, so that it is
+ * not tried again until the host name is resolved anew.
+ */
+void vlc_net_EvictAddrInfo(const struct addrinfo *ai);
+
+/**
+ * Connects a socket to any of a list of addresses.
+ *
+ * Connection attempts are staggered over the addresses, alternating address
+ * families, as per RFC 8305.
+ *
+ * This function is interruptible.
+ *
+ * Addresses that fail to connect, or that are still pending when the timeout
+ * expires, are evicted from the resolver cache.
+ *
+ * @param timeout how long to wait for a connection to each address,
+ *                or a negative value to wait indefinitely
+ * @param winner where to store the connected address from the list [OUT]
+ *               (or NULL to ignore)
+ * @return a connected socket on success, or -1 on error (errno is set).
+ */
+int vlc_net_ConnectAddrInfo(vlc_object_t *obj, const struct addrinfo *res,
+                            vlc_tick_t timeout,
+                            const struct addrinfo **winner);
+
 /*
  * Variables stuff
  */
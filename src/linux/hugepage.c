@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * hugepage.c: huge page backed buffers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include "misc/hugepage.h"
+
+/* Default huge page size of x86 and most ARM systems */
+#define HUGEPAGE_SIZE ((size_t)2 << 20)
+/* Smaller buffers would waste too much memory in rounding */
+#define HUGEPAGE_MIN (4u << 20)
+/* Limits of the cache of freed buffers */
+#define HUGEPAGE_CACHE_COUNT 16
+#define HUGEPAGE_CACHE_BYTES (256u << 20)
+/* Buffers not recycled within that delay are returned to the system */
+#define HUGEPAGE_CACHE_DELAY VLC_TICK_FROM_SEC(2)
+
+struct hugepage_buffer
+{
+    void *base;
+    size_t size;
+    int fd;
+    vlc_tick_t date;
+};
+
+static atomic_bool enabled = false;
+static atomic_bool hugetlb_failed = false;
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned count;
+    size_t bytes;
+    struct hugepage_buffer tab[HUGEPAGE_CACHE_COUNT];
+    vlc_timer_t timer; /**< trims the cache while nothing is allocated */
+    bool has_timer;
+} cache = { .lock = VLC_STATIC_MUTEX };
+
+void vlc_hugepage_setup(bool enable)
+{
+    static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+    static bool initialized = false;
+
+    vlc_mutex_lock(&lock);
+    /* The allocator of a buffer depends on this setting: it must not change
+     * once buffers exist, so it is read just once per process. */
+    if (!initialized)
+    {
+        if (enable)
+            atomic_store_explicit(&enabled, true, memory_order_relaxed);
+        initialized = true;
+    }
+    vlc_mutex_unlock(&lock);
+}
+
+bool vlc_hugepage_Usable(size_t size)
+{
+    return size >= HUGEPAGE_MIN
+        && atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+static size_t vlc_hugepage_Round(size_t size)
+{
+    return (size + HUGEPAGE_SIZE - 1) & ~(HUGEPAGE_SIZE - 1);
+}
+
+static void vlc_hugepage_Unmap(const struct hugepage_buffer *buf)
+{
+    munmap(buf->base, buf->size);
+    if (buf->fd != -1)
+        vlc_close(buf->fd);
+}
+
+/**
+ * Releases the cached buffers freed before the given date.
+ */
+static void vlc_hugepage_Trim(vlc_tick_t deadline)
+{
+    vlc_mutex_assert(&cache.lock);
+
+    for (unsigned i = 0; i < cache.count;)
+    {
+        if (cache.tab[i].date <= deadline)
+        {
+            vlc_hugepage_Unmap(&cache.tab[i]);
+            cache.bytes -= cache.tab[i].size;
+            cache.tab[i] = cache.tab[--cache.count];
+        }
+        else
+            i++;
+    }
+}
+
+/**
+ * Arms the timer for the oldest cached buffer, if any.
+ */
+static void vlc_hugepage_Schedule(void)
+{
+    vlc_mutex_assert(&cache.lock);
+
+    if (!cache.has_timer)
+        return;
+    if (cache.count == 0)
+    {
+        vlc_timer_disarm(cache.timer);
+        return;
+    }
+
+    vlc_tick_t date = cache.tab[0].date;
+    for (unsigned i = 1; i < cache.count; i++)
+        if (cache.tab[i].date < date)
+            date = cache.tab[i].date;
+    vlc_timer_schedule(cache.timer, true, date + HUGEPAGE_CACHE_DELAY, 0);
+}
+
+static void vlc_hugepage_Expire(void *data)
+{
+    (void) data;
+    vlc_mutex_lock(&cache.lock);
+    vlc_hugepage_Trim(vlc_tick_now() - HUGEPAGE_CACHE_DELAY);
+    vlc_hugepage_Schedule();
+    vlc_mutex_unlock(&cache.lock);
+}
+
+void vlc_hugepage_cleanup(void)
+{
+    vlc_mutex_lock(&cache.lock);
+    vlc_hugepage_Trim(INT64_MAX);
+    assert(cache.count == 0 && cache.bytes == 0);
+
+    bool has_timer = cache.has_timer;
+    vlc_timer_t timer = cache.timer;
+    cache.has_timer = false;
+    vlc_mutex_unlock(&cache.lock);
+
+    /* Not under the lock: this waits for the timer callback */
+    if (has_timer)
+        vlc_timer_destroy(timer);
+}
+
+void *vlc_hugepage_Alloc(size_t size, int *restrict fdp)
+{
+    size = vlc_hugepage_Round(size);
+
+    /* Recycle a freed buffer of the same size if any: this saves the
+     * system calls, and above all clearing the pages again. */
+    vlc_mutex_lock(&cache.lock);
+    vlc_hugepage_Trim(vlc_tick_now() - HUGEPAGE_CACHE_DELAY);
+    for (unsigned i = 0; i < cache.count; i++)
+        if (cache.tab[i].size == size)
+        {
+            void *base = cache.tab[i].base;
+
+            *fdp = cache.tab[i].fd;
+            cache.tab[i] = cache.tab[--cache.count];
+            cache.bytes -= size;
+            vlc_hugepage_Schedule();
+            vlc_mutex_unlock(&cache.lock);
+            return base;
+        }
+    vlc_mutex_unlock(&cache.lock);
+
+#if defined (HAVE_MEMFD_CREATE) && defined (MFD_HUGETLB)
+    /* Explicit huge pages, if the administrator reserved any. Those can be
+     * shared with the display server like other picture buffers. */
+    if (!atomic_load_explicit(&hugetlb_failed, memory_order_relaxed))
+    {
+        int fd = memfd_create("vlc-hugepage", MFD_CLOEXEC | MFD_HUGETLB);
+
+        if (fd != -1)
+        {
+            if (ftruncate(fd, size) == 0)
+            {
+                void *base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED, fd, 0);
+                if (base != MAP_FAILED)
+                {
+                    *fdp = fd;
+                    return base;
+                }
+            }
+            vlc_close(fd);
+        }
+        /* Do not retry on every allocation */
+        atomic_store_explicit(&hugetlb_failed, true, memory_order_relaxed);
+    }
+#endif
+
+    /* Transparent huge pages: align the mapping on a huge page boundary so
+     * that it can be backed by huge pages throughout. */
+    size_t length = size + HUGEPAGE_SIZE;
+    unsigned char *base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    size_t head = (-(uintptr_t)base) & (HUGEPAGE_SIZE - 1);
+    if (head > 0)
+        munmap(base, head);
+    munmap(base + head + size, HUGEPAGE_SIZE - head);
+    base += head;
+#ifdef MADV_HUGEPAGE
+    madvise(base, size, MADV_HUGEPAGE);
+#endif
+    *fdp = -1;
+    return base;
+}
+
+void vlc_hugepage_Free(void *base, size_t size, int fd)
+{
+    struct hugepage_buffer buf = {
+        base, vlc_hugepage_Round(size), fd, vlc_tick_now(),
+    };
+
+    vlc_mutex_lock(&cache.lock);
+    vlc_hugepage_Trim(buf.date - HUGEPAGE_CACHE_DELAY);
+    /* The cache is also trimmed by a timer, so that an idle process does
+     * not keep the buffers. Without a timer, do not cache at all. */
+    if (!cache.has_timer
+     && vlc_timer_create(&cache.timer, vlc_hugepage_Expire, NULL) == 0)
+        cache.has_timer = true;
+    if (cache.has_timer && cache.count < HUGEPAGE_CACHE_COUNT
+     && cache.bytes + buf.size <= HUGEPAGE_CACHE_BYTES)
+    {
+        cache.tab[cache.count++] = buf;
+        cache.bytes += buf.size;
+        vlc_hugepage_Schedule();
+        vlc_mutex_unlock(&cache.lock);
+        return;
+    }
+    vlc_mutex_unlock(&cache.lock);
+
+    vlc_hugepage_Unmap(&buf);
+}
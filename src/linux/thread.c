@@ -25,8 +25,12 @@
 #include <errno.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
 #include <sys/syscall.h>
 #include <linux/futex.h>
 
@@ -36,6 +40,7 @@
 #endif
 
 #include <vlc_common.h>
+#include "libvlc.h"
 
 unsigned long vlc_thread_id(void)
 {
@@ -94,3 +99,140 @@ bool vlc_atomic_timedwait(void *addr, unsigned val, vlc_tick_t delay)
 
     return (vlc_futex_wait(addr, val, &ts) == 0 || errno != ETIMEDOUT);
 }
+
+/*** Scheduling policy ***/
+
+static const char *const thread_roles[] = {
+    [VLC_THREAD_AUDIO_DECODER] = "audio-decoder",
+    [VLC_THREAD_VIDEO_DECODER] = "video-decoder",
+    [VLC_THREAD_SPU_DECODER] = "spu-decoder",
+    [VLC_THREAD_VIDEO_OUTPUT] = "vout",
+};
+
+/* Parses a list of CPU numbers and ranges, e.g. "0-3,8" */
+static int vlc_cpuset_parse(cpu_set_t *set, const char *str)
+{
+    CPU_ZERO(set);
+
+    for (;;)
+    {
+        char *end;
+        unsigned long first = strtoul(str, &end, 10), last = first;
+
+        if (end == str)
+            return -1;
+        if (*end == '-')
+        {
+            str = end + 1;
+            last = strtoul(str, &end, 10);
+            if (end == str)
+                return -1;
+        }
+        if (first > last || last >= CPU_SETSIZE)
+            return -1;
+
+        for (unsigned long cpu = first; cpu <= last; cpu++)
+            CPU_SET(cpu, set);
+
+        if (*end == '\0')
+            return 0;
+        if (*end != ',')
+            return -1;
+        str = end + 1;
+    }
+}
+
+static int vlc_thread_set_class(const char *name)
+{
+    struct sched_param sp = { .sched_priority = 0 };
+    int policy = SCHED_OTHER, nice;
+
+    if (!strcmp(name, "low"))
+        nice = 10;
+    else if (!strcmp(name, "normal"))
+        nice = 0;
+    else if (!strcmp(name, "high"))
+        nice = -10;
+    else if (!strcmp(name, "realtime"))
+    {   /* Lowest real-time priority: above every normal thread, but below
+         * the real-time threads of the system, e.g. the sound server. */
+        policy = SCHED_FIFO;
+        sp.sched_priority = sched_get_priority_min(SCHED_FIFO);
+        nice = 0;
+    }
+    else
+        return EINVAL;
+
+    int val = pthread_setschedparam(pthread_self(), policy, &sp);
+    if (val != 0)
+        return val;
+    /* On Linux, the nice value applies to the calling thread only. */
+    if (policy == SCHED_OTHER
+     && setpriority(PRIO_PROCESS, vlc_thread_id(), nice))
+        return errno;
+    return 0;
+}
+
+void vlc_thread_ApplyPolicy(vlc_object_t *obj, enum vlc_thread_role role)
+{
+    const char *prefix = thread_roles[role];
+    char name[32];
+
+    snprintf(name, sizeof (name), "%s-cpus", prefix);
+    char *cpus = var_InheritString(obj, name);
+    snprintf(name, sizeof (name), "%s-priority", prefix);
+    char *priority = var_InheritString(obj, name);
+
+    /* Empty values leave the defaults */
+    if (cpus != NULL && cpus[0] == '\0')
+    {
+        free(cpus);
+        cpus = NULL;
+    }
+    if (priority != NULL && priority[0] == '\0')
+    {
+        free(priority);
+        priority = NULL;
+    }
+
+    if (cpus != NULL)
+    {
+        cpu_set_t set;
+        int val;
+
+        /* On Linux, PID zero is the calling thread. Unlike
+         * pthread_setaffinity_np(), this is also available on Android. */
+        if (vlc_cpuset_parse(&set, cpus))
+            val = EINVAL;
+        else if (sched_setaffinity(0, sizeof (set), &set))
+            val = errno;
+        else
+            val = 0;
+        if (val != 0)
+        {
+            msg_Warn(obj, "cannot bind %s thread to CPUs %s: %s", prefix, cpus,
+                     vlc_strerror_c(val));
+            free(cpus);
+            cpus = NULL;
+        }
+    }
+
+    if (priority != NULL)
+    {
+        int val = vlc_thread_set_class(priority);
+        if (val != 0)
+        {
+            msg_Warn(obj, "cannot set %s thread priority to %s: %s", prefix,
+                     priority, vlc_strerror_c(val));
+            free(priority);
+            priority = NULL;
+        }
+    }
+
+    if (cpus != NULL || priority != NULL)
+        msg_Dbg(obj, "%s thread %lu policy: CPUs %s, priority %s", prefix,
+                vlc_thread_id(), (cpus != NULL) ? cpus : "any",
+                (priority != NULL) ? priority : "default");
+    free(priority);
+    free(cpus);
+}
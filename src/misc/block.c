@@ -32,8 +32,10 @@
 #include <fcntl.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include "hugepage.h"
 
 #ifndef NDEBUG
 static void block_Check (block_t *block)
@@ -105,6 +107,43 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+typedef struct
+{
+    block_t self;
+    void *base;
+    size_t size;
+    int fd;
+} block_hugepage_t;
+
+static void block_hugepage_Release (block_t *block)
+{
+    block_hugepage_t *hb = container_of(block, block_hugepage_t, self);
+
+    vlc_hugepage_Free (hb->base, hb->size, hb->fd);
+    free (hb);
+}
+
+static const struct vlc_block_callbacks block_hugepage_cbs =
+{
+    block_hugepage_Release,
+};
+
+static block_t *block_hugepage_Alloc (size_t alloc)
+{
+    block_hugepage_t *hb = malloc (sizeof (*hb));
+    if (unlikely(hb == NULL))
+        return NULL;
+
+    hb->base = vlc_hugepage_Alloc (alloc, &hb->fd);
+    if (unlikely(hb->base == NULL))
+    {
+        free (hb);
+        return NULL;
+    }
+    hb->size = alloc;
+    return block_Init (&hb->self, &block_hugepage_cbs, hb->base, alloc);
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -119,11 +158,22 @@ block_t *block_Alloc (size_t size)
     if (unlikely(alloc <= size))
         return NULL;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+    block_t *b;
+
+    if (vlc_hugepage_Usable (alloc))
+    {   /* Large buffer, e.g. a raw ultra high definition video frame */
+        b = block_hugepage_Alloc (alloc - sizeof (*b));
+        if (unlikely(b == NULL))
+            return NULL;
+    }
+    else
+    {
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+        block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+    }
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
@@ -141,6 +191,109 @@ void block_Release(block_t *block)
     block->cbs->free(block);
 }
 
+struct block_share
+{
+    vlc_atomic_rc_t rc;
+    block_t *block; /**< underlying block owning the payload */
+};
+
+struct block_shared
+{
+    block_t self;
+    struct block_share *share;
+};
+
+static void block_shared_Release (block_t *block)
+{
+    struct block_shared *ref = container_of(block, struct block_shared, self);
+    struct block_share *share = ref->share;
+
+    if (vlc_atomic_rc_dec(&share->rc))
+    {
+        block_Release(share->block);
+        free(share);
+    }
+    free(ref);
+}
+
+static const struct vlc_block_callbacks block_shared_cbs =
+{
+    block_shared_Release,
+};
+
+static bool block_IsShared(const block_t *block)
+{
+    return block->cbs == &block_shared_cbs;
+}
+
+int block_Share(block_t *block, block_t **refs, unsigned count)
+{
+    struct block_share *share;
+    bool shared = block_IsShared(block);
+
+    assert(count > 0);
+    assert(block->p_next == NULL);
+    block_Check(block);
+
+    if (shared)
+        share = container_of(block, struct block_shared, self)->share;
+    else
+    {
+        share = malloc(sizeof (*share));
+        if (unlikely(share == NULL))
+            return VLC_ENOMEM;
+        vlc_atomic_rc_init(&share->rc);
+        share->block = block;
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        struct block_shared *ref = malloc(sizeof (*ref));
+        if (unlikely(ref == NULL))
+        {
+            while (i > 0)
+                free(container_of(refs[--i], struct block_shared, self));
+            if (!shared)
+                free(share);
+            return VLC_ENOMEM;
+        }
+
+        block_Init(&ref->self, &block_shared_cbs, block->p_start,
+                   block->i_size);
+        ref->self.p_buffer = block->p_buffer;
+        ref->self.i_buffer = block->i_buffer;
+        BlockMetaCopy(&ref->self, block);
+        ref->share = share;
+        refs[i] = &ref->self;
+    }
+
+    /* The new share inherits the reference of the input block, while an
+     * existing share loses the reference of the input block. */
+    for (unsigned i = 1; i < count; i++)
+        vlc_atomic_rc_inc(&share->rc);
+    if (shared)
+    {
+        vlc_atomic_rc_inc(&share->rc);
+        block_Release(block);
+    }
+    return VLC_SUCCESS;
+}
+
+bool block_IsWritable(const block_t *block)
+{
+    return !block_IsShared(block);
+}
+
+block_t *block_MakeWritable(block_t *block)
+{
+    if (!block_IsShared(block))
+        return block;
+
+    block_t *dup = block_Duplicate(block);
+    block_Release(block);
+    return dup;
+}
+
 block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 {
     block_Check( p_block );
@@ -174,10 +327,12 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
         p_block->i_buffer = i_body;
 
     size_t requested = i_prebody + i_body;
+    /* Shared payload must not be written to: copy on expansion */
+    bool shared = block_IsShared( p_block );
 
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && (!shared || requested == 0) )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -202,7 +357,8 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     /* Second, reallocate the buffer if we lack space. */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || (shared && (i_prebody > 0 || i_body > p_block->i_buffer)) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea == NULL )
@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * hugepage.h: huge page backed buffers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_HUGEPAGE_H
+# define LIBVLC_HUGEPAGE_H 1
+
+# include <stdbool.h>
+# include <stddef.h>
+
+# ifdef __linux__
+/**
+ * Enables huge page buffers, as requested by the "hugepages" option.
+ * This is decided only once per process, by the first LibVLC instance.
+ */
+void vlc_hugepage_setup(bool enable);
+
+/**
+ * Releases the cached freed buffers back to the system.
+ * Buffers still in use are not affected. Otherwise, cached buffers are
+ * released once unused for a couple of seconds.
+ */
+void vlc_hugepage_cleanup(void);
+
+/**
+ * Checks whether a buffer of the given size should be allocated from huge
+ * pages. The caller must remember which allocator each buffer came from.
+ */
+bool vlc_hugepage_Usable(size_t size);
+
+/**
+ * Allocates a buffer from huge pages, or recycles a previously freed one.
+ * @param fdp storage for a shareable memory file descriptor, or -1 if the
+ *            buffer cannot be shared with other processes
+ * @return the buffer base address, or NULL on error
+ */
+void *vlc_hugepage_Alloc(size_t size, int *restrict fdp);
+
+/**
+ * Releases a buffer allocated with vlc_hugepage_Alloc().
+ */
+void vlc_hugepage_Free(void *base, size_t size, int fd);
+# else
+static inline void vlc_hugepage_setup(bool enable)
+{
+    (void) enable;
+}
+
+static inline void vlc_hugepage_cleanup(void)
+{
+}
+
+static inline bool vlc_hugepage_Usable(size_t size)
+{
+    (void) size;
+    return false;
+}
+
+static inline void *vlc_hugepage_Alloc(size_t size, int *restrict fdp)
+{
+    (void) size; (void) fdp;
+    return NULL;
+}
+
+static inline void vlc_hugepage_Free(void *base, size_t size, int fd)
+{
+    (void) base; (void) size; (void) fd;
+}
+# endif
+#endif
@@ -35,6 +35,7 @@
 
 #include <vlc_common.h>
 #include "picture.h"
+#include "hugepage.h"
 #include <vlc_image.h>
 #include <vlc_block.h>
 
@@ -60,6 +61,12 @@ static void picture_DestroyDummy( picture_t *p_picture )
     (void) p_picture;
 }
 
+struct picture_priv_buffer_t {
+    picture_priv_t   priv;
+    picture_buffer_t res;
+    bool             hugepage;
+};
+
 /**
  * Destroys a picture allocated with picture_NewFromFormat().
  */
@@ -67,7 +74,15 @@ static void picture_DestroyFromFormat(picture_t *pic)
 {
     picture_buffer_t *res = pic->p_sys;
 
-    if (res != NULL)
+    if (res == NULL)
+        return;
+
+    struct picture_priv_buffer_t *privbuf =
+        container_of(res, struct picture_priv_buffer_t, res);
+
+    if (privbuf->hugepage)
+        vlc_hugepage_Free(res->base, res->size, res->fd);
+    else
         picture_Deallocate(res->fd, res->base, res->size);
 }
 
@@ -251,11 +266,6 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
 
 #define PICTURE_SW_SIZE_MAX (UINT32_C(1) << 28) /* 256MB: 8K * 8K * 4*/
 
-struct picture_priv_buffer_t {
-    picture_priv_t   priv;
-    picture_buffer_t res;
-};
-
 picture_t *picture_NewFromFormat(const video_format_t *restrict fmt)
 {
     static_assert(offsetof(struct picture_priv_buffer_t, priv)==0,
@@ -299,7 +309,13 @@ picture_t *picture_NewFromFormat(const video_format_t *restrict fmt)
     if (unlikely(pic_size >= PICTURE_SW_SIZE_MAX))
         goto error;
 
-    unsigned char *buf = picture_Allocate(&res->fd, pic_size);
+    unsigned char *buf;
+
+    privbuf->hugepage = vlc_hugepage_Usable(pic_size);
+    if (privbuf->hugepage)
+        buf = vlc_hugepage_Alloc(pic_size, &res->fd);
+    else
+        buf = picture_Allocate(&res->fd, pic_size);
     if (unlikely(buf == NULL))
         goto error;
 
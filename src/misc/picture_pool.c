@@ -36,16 +36,23 @@
 
 #define POOL_MAX (CHAR_BIT * sizeof (unsigned long long))
 
+/* How often picture_pool_WaitOrGrow() checks whether its caller is starved
+ * while no picture comes back */
+#define POOL_STARVED_PERIOD VLC_TICK_FROM_MS(20)
+
 static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
 
 struct picture_pool_t {
-    vlc_mutex_t lock;
-    vlc_cond_t  wait;
+    vlc_mutex_t lock; /**< serializes growth */
+    video_format_t fmt; /**< format of grown pictures */
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_ullong      available; /**< bit mask of free pictures */
+    atomic_uint        wait; /**< bumped whenever a waiter may proceed */
+    atomic_uint        waiters;
+    atomic_bool        canceled;
     atomic_ushort      refs;
-    unsigned short     picture_count;
+    atomic_ushort      picture_count;
+    unsigned short     picture_max;
     picture_t  *picture[];
 };
 
@@ -55,14 +62,17 @@ static void picture_pool_Destroy(picture_pool_t *pool)
         return;
 
     atomic_thread_fence(memory_order_acquire);
-    vlc_cond_destroy(&pool->wait);
+    video_format_Clean(&pool->fmt);
     vlc_mutex_destroy(&pool->lock);
     aligned_free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
-    for (unsigned i = 0; i < pool->picture_count; i++)
+    unsigned count = atomic_load_explicit(&pool->picture_count,
+                                          memory_order_relaxed);
+
+    for (unsigned i = 0; i < count; i++)
         picture_Release(pool->picture[i]);
     picture_pool_Destroy(pool);
 }
@@ -77,11 +87,17 @@ static void picture_pool_ReleasePicture(picture_t *clone)
 
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+    unsigned long long mask = 1ULL << offset;
+    mask = atomic_fetch_or(&pool->available, mask) & mask;
+    assert(mask == 0);
+    (void) mask;
+
+    /* Only issue a wake-up if there is someone to wake up */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        atomic_fetch_add(&pool->wait, 1);
+        vlc_atomic_notify_one(&pool->wait);
+    }
 
     picture_pool_Destroy(pool);
 }
@@ -92,17 +108,74 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
     picture_t *picture = pool->picture[offset];
     uintptr_t sys = ((uintptr_t)pool) + offset;
 
-    return picture_InternalClone(picture, picture_pool_ReleasePicture,
-                                 (void*)sys);
+    picture_t *clone = picture_InternalClone(picture,
+                                             picture_pool_ReleasePicture,
+                                             (void*)sys);
+    if (clone != NULL) {
+        assert(clone->p_next == NULL);
+        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    }
+    else
+        atomic_fetch_or(&pool->available, 1ULL << offset);
+    return clone;
 }
 
-picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
+/**
+ * Claims a free picture slot without locking.
+ * @return the slot offset, or -1 if all pictures are in use
+ */
+static int picture_pool_Take(picture_pool_t *pool)
 {
-    if (unlikely(count > POOL_MAX))
-        return NULL;
+    unsigned long long available = atomic_load(&pool->available);
+
+    while (available != 0)
+    {
+        int i = ctz(available);
+
+        if (atomic_compare_exchange_weak_explicit(&pool->available,
+                                                  &available,
+                                                  available & ~(1ULL << i),
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+            return i;
+    }
+    return -1;
+}
 
+/**
+ * Allocates one more picture in a growable pool, and claims its slot.
+ * @return the slot offset, or -1 if the pool cannot grow
+ */
+static int picture_pool_Grow(picture_pool_t *pool)
+{
+    int i = -1;
+
+    if (atomic_load_explicit(&pool->picture_count, memory_order_relaxed)
+         >= pool->picture_max)
+        return -1;
+
+    vlc_mutex_lock(&pool->lock);
+    unsigned count = atomic_load_explicit(&pool->picture_count,
+                                          memory_order_relaxed);
+    if (count < pool->picture_max)
+    {
+        picture_t *picture = picture_NewFromFormat(&pool->fmt);
+        if (picture != NULL)
+        {
+            pool->picture[count] = picture;
+            atomic_store_explicit(&pool->picture_count, count + 1,
+                                  memory_order_release);
+            i = count;
+        }
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return i;
+}
+
+static picture_pool_t *picture_pool_Alloc(unsigned count, unsigned max)
+{
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + count * sizeof (picture_t *);
+    size_t size = sizeof (*pool) + max * sizeof (picture_t *);
 
     size += (-size) & (POOL_MAX - 1);
     pool = aligned_alloc(POOL_MAX, size);
@@ -110,15 +183,30 @@ picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
         return NULL;
 
     vlc_mutex_init(&pool->lock);
-    vlc_cond_init(&pool->wait);
+    video_format_Init(&pool->fmt, 0);
     if (count == POOL_MAX)
-        pool->available = ~0ULL;
+        atomic_init(&pool->available, ~0ULL);
     else
-        pool->available = (1ULL << count) - 1;
+        atomic_init(&pool->available, (1ULL << count) - 1);
+    atomic_init(&pool->wait, 0);
+    atomic_init(&pool->waiters, 0);
+    atomic_init(&pool->canceled, false);
     atomic_init(&pool->refs,  1);
-    pool->picture_count = count;
+    atomic_init(&pool->picture_count, count);
+    pool->picture_max = max;
+    return pool;
+}
+
+picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
+{
+    if (unlikely(count > POOL_MAX))
+        return NULL;
+
+    picture_pool_t *pool = picture_pool_Alloc(count, count);
+    if (unlikely(pool == NULL))
+        return NULL;
+
     memcpy(pool->picture, tab, count * sizeof (picture_t *));
-    pool->canceled = false;
     return pool;
 }
 
@@ -169,76 +257,123 @@ error:
     return NULL;
 }
 
-picture_t *picture_pool_Get(picture_pool_t *pool)
+picture_pool_t *picture_pool_NewGrowable(const video_format_t *fmt,
+                                         unsigned count, unsigned max)
 {
-    unsigned long long available;
-
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    available = pool->available;
-
-    while (available != 0)
-    {
-        int i = ctz(available);
+    if (max > POOL_MAX)
+        max = POOL_MAX;
+    if (unlikely(count > max))
+        return NULL;
 
-        if (unlikely(pool->canceled))
-            break;
+    picture_pool_t *pool = picture_pool_Alloc(count, max);
+    if (unlikely(pool == NULL))
+        return NULL;
 
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
+    video_format_Copy(&pool->fmt, fmt);
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    for (unsigned i = 0; i < count; i++) {
+        pool->picture[i] = picture_NewFromFormat(fmt);
+        if (pool->picture[i] == NULL) {
+            atomic_store_explicit(&pool->picture_count, i,
+                                  memory_order_relaxed);
+            picture_pool_Release(pool);
+            return NULL;
         }
-        return clone;
     }
+    return pool;
+}
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+picture_t *picture_pool_Get(picture_pool_t *pool)
+{
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
+
+    if (unlikely(atomic_load(&pool->canceled)))
+        return NULL;
+
+    int i = picture_pool_Take(pool);
+    if (i < 0)
+        i = picture_pool_Grow(pool);
+    if (i < 0)
+        return NULL;
+
+    return picture_pool_ClonePicture(pool, i);
 }
 
-picture_t *picture_pool_Wait(picture_pool_t *pool)
+static picture_t *picture_pool_WaitInternal(picture_pool_t *pool,
+                                            bool (*starved)(void *),
+                                            void *opaque)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    while (pool->available == 0)
+    int i = picture_pool_Take(pool);
+    if (i < 0)
     {
-        if (pool->canceled)
+        atomic_fetch_add(&pool->waiters, 1);
+        for (;;)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            unsigned seq = atomic_load(&pool->wait);
+
+            if (atomic_load(&pool->canceled))
+                break;
+
+            i = picture_pool_Take(pool);
+            if (i >= 0)
+                break;
+
+            if (starved != NULL
+             && atomic_load_explicit(&pool->picture_count,
+                                     memory_order_relaxed)
+                 < pool->picture_max)
+            {   /* Grow only if the caller holds all the pictures that could
+                 * come back: the pool is normally drained by downstream
+                 * back-pressure, however slow. */
+                if (starved(opaque))
+                {
+                    i = picture_pool_Grow(pool);
+                    if (i >= 0)
+                        break;
+                }
+                /* The caller may become starved without any picture coming
+                 * back, e.g. when the last queued one is displayed. */
+                vlc_atomic_timedwait(&pool->wait, seq, POOL_STARVED_PERIOD);
+            }
+            else
+                vlc_atomic_wait(&pool->wait, seq);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+
+        if (i < 0)
+            return NULL;
     }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
-    vlc_mutex_unlock(&pool->lock);
+    return picture_pool_ClonePicture(pool, i);
+}
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
-    }
-    return clone;
+picture_t *picture_pool_Wait(picture_pool_t *pool)
+{
+    return picture_pool_WaitInternal(pool, NULL, NULL);
+}
+
+picture_t *picture_pool_WaitOrGrow(picture_pool_t *pool,
+                                   bool (*starved)(void *), void *opaque)
+{
+    return picture_pool_WaitInternal(pool, starved, opaque);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
-        vlc_cond_broadcast(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+    {
+        atomic_fetch_add(&pool->wait, 1);
+        vlc_atomic_notify_all(&pool->wait);
+    }
 }
 
 unsigned picture_pool_GetSize(const picture_pool_t *pool)
 {
-    return pool->picture_count;
+    return atomic_load_explicit(&((picture_pool_t *)pool)->picture_count,
+                                memory_order_relaxed);
 }
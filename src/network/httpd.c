@@ -42,6 +42,7 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
 #include <string.h>
@@ -54,6 +55,12 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#ifdef HAVE_EPOLL_CREATE1
+# include <sys/epoll.h>
+#endif
+#ifdef HAVE_EVENTFD
+# include <sys/eventfd.h>
+#endif
 
 #if defined(_WIN32)
 #   include <winsock2.h>
@@ -68,8 +75,12 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
-static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+/* maximum number of stream blocks a client sends at once */
+#define HTTPD_CL_MAX_BLOCKS 16
+
+static void httpd_ClientDestroy(httpd_host_t *host, httpd_client_t *cl);
+static void httpd_ClientQueue(httpd_client_t *cl, struct vlc_list *queue);
+static void httpd_HostWake(httpd_host_t *host);
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -98,6 +109,19 @@ struct httpd_host_t
     size_t client_count;
     struct vlc_list clients;
 
+    /* clients whose state machine must run */
+    struct vlc_list pending;
+    /* clients waiting for stream data */
+    struct vlc_list waiting;
+    vlc_tick_t i_expiry_date; /* next check for inactive clients */
+
+#ifdef HAVE_EPOLL_CREATE1
+    int epfd; /* epoll instance for the listening sockets and the clients */
+#endif
+#ifdef HAVE_EVENTFD
+    int wakefd; /* event to wake the host thread up for new stream data */
+#endif
+
     /* TLS data */
     vlc_tls_server_t *p_tls;
 };
@@ -137,12 +161,31 @@ enum
     HTTPD_CLIENT_TLS_HS_OUT
 };
 
+/* Stream data block, shared by the stream and its clients */
+typedef struct httpd_stream_block_t
+{
+    vlc_atomic_rc_t rc;
+    int64_t     i_pos;      /* absolute position of the first byte */
+    block_t     *p_block;
+} httpd_stream_block_t;
+
+static void httpd_StreamBlockRelease(httpd_stream_block_t *b)
+{
+    if (vlc_atomic_rc_dec(&b->rc)) {
+        block_Release(b->p_block);
+        free(b);
+    }
+}
+
 struct httpd_client_t
 {
     httpd_url_t *url;
     vlc_tls_t   *sock;
 
     struct vlc_list node;
+    struct vlc_list qnode; /* node in the pending or waiting client list */
+    struct vlc_list *queue; /* list the client is queued in, if any */
+    short   i_events; /* events polled for, or -1 if not registered */
 
     bool    b_stream_mode;
     uint8_t i_state;
@@ -155,6 +198,11 @@ struct httpd_client_t
     int     i_buffer;
     uint8_t *p_buffer;
 
+    /* stream data to send after the buffer, without copying */
+    httpd_stream_block_t *p_blocks[HTTPD_CL_MAX_BLOCKS];
+    unsigned i_blocks;
+    size_t   i_block_offset; /* bytes of the first block already sent */
+
     /*
      * If waiting for a keyframe, this is the position (in bytes) of the
      * last keyframe the stream saw before this client connected.
@@ -434,15 +482,12 @@ httpd_HandlerCallBack(httpd_callback_sys_t *p_sys, httpd_client_t *cl,
         char *p = (char *)answer->p_body;
 
         /* Looks for end of header (i.e. one empty line) */
-        while ((p = strchr(p, '\r')))
+        for (; (p = strchr(p, '\r')) != NULL; p++)
             if (p[1] == '\n' && p[2] == '\r' && p[3] == '\n')
                 break;
 
-        if (p) {
-            p[4] = '\0';
-            answer->i_body = strlen((char*)answer->p_body) + 1;
-            answer->p_body = xrealloc(answer->p_body, answer->i_body);
-        }
+        if (p) /* do not send the body (nor a nul terminator) */
+            answer->i_body = p + 4 - (char *)answer->p_body;
     }
 
     if (strncmp((char *)answer->p_body, "HTTP/1.", 7)) {
@@ -585,6 +630,133 @@ void httpd_RedirectDelete(httpd_redirect_t *rdir)
     free(rdir);
 }
 
+/*****************************************************************************
+ * High Level Functions: httpd_block_t
+ *****************************************************************************/
+struct httpd_block_t
+{
+    httpd_url_t *url;
+    httpd_stream_block_t *data; /* shared with the clients being served */
+
+    httpd_header *p_headers;
+    size_t       i_headers;
+    char         mime[1];
+};
+
+static int httpd_BlockCallBack(httpd_callback_sys_t *p_sys,
+                                httpd_client_t *cl, httpd_message_t *answer,
+                                const httpd_message_t *query)
+{
+    httpd_block_t *blk = (httpd_block_t*)p_sys;
+
+    if (!answer || !query)
+        return VLC_SUCCESS;
+
+    answer->i_proto  = HTTPD_PROTO_HTTP;
+    answer->i_version= 1;
+    answer->i_type   = HTTPD_MSG_ANSWER;
+    answer->i_status = 200;
+
+    httpd_MsgAdd(answer, "Content-Type", "%s", blk->mime);
+    for (size_t i = 0; i < blk->i_headers; i++)
+        httpd_MsgAdd(answer, blk->p_headers[i].name, "%s",
+                      blk->p_headers[i].value);
+
+    if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+        httpd_MsgAdd(answer, "Connection", "close");
+
+    httpd_MsgAdd(answer, "Content-Length", "%zu",
+                  blk->data->p_block->i_buffer);
+
+    if (query->i_type != HTTPD_MSG_HEAD) {
+        /* The data is written from the block itself, as for streams */
+        assert(cl->i_blocks == 0);
+        vlc_atomic_rc_inc(&blk->data->rc);
+        cl->p_blocks[0] = blk->data;
+        cl->i_blocks = 1;
+        cl->i_block_offset = 0;
+    }
+
+    return VLC_SUCCESS;
+}
+
+httpd_block_t *httpd_BlockNew(httpd_host_t *host, const char *psz_url,
+                               const char *psz_mime,
+                               const httpd_header *p_headers,
+                               size_t i_headers, block_t *p_block)
+{
+    const char *mime = psz_mime;
+    if (mime == NULL || mime[0] == '\0')
+        mime = vlc_mime_Ext2Mime(psz_url);
+
+    size_t mimelen = strlen(mime);
+    httpd_block_t *blk = malloc(sizeof(*blk) + mimelen);
+    httpd_stream_block_t *data = malloc(sizeof(*data));
+    if (unlikely(blk == NULL || data == NULL))
+        goto error;
+
+    assert(p_block->p_next == NULL);
+    vlc_atomic_rc_init(&data->rc);
+    data->i_pos = 0;
+    data->p_block = p_block;
+    blk->data = data;
+    memcpy(blk->mime, mime, mimelen + 1);
+
+    blk->i_headers = 0;
+    blk->p_headers = NULL;
+    if (i_headers > 0) {
+        blk->p_headers = vlc_alloc(i_headers, sizeof(httpd_header));
+        if (unlikely(blk->p_headers == NULL))
+            goto error;
+    }
+
+    for (size_t i = 0; i < i_headers; i++) {
+        httpd_header *h = &blk->p_headers[blk->i_headers];
+
+        h->name = strdup(p_headers[i].name);
+        h->value = strdup(p_headers[i].value);
+        blk->i_headers++;
+        if (unlikely(h->name == NULL || h->value == NULL))
+            goto error_headers;
+    }
+
+    blk->url = httpd_UrlNew(host, psz_url, NULL, NULL);
+    if (!blk->url)
+        goto error_headers;
+
+    httpd_UrlCatch(blk->url, HTTPD_MSG_HEAD, httpd_BlockCallBack,
+                    (httpd_callback_sys_t*)blk);
+    httpd_UrlCatch(blk->url, HTTPD_MSG_GET, httpd_BlockCallBack,
+                    (httpd_callback_sys_t*)blk);
+    return blk;
+
+error_headers:
+    for (size_t i = 0; i < blk->i_headers; i++) {
+        free(blk->p_headers[i].name);
+        free(blk->p_headers[i].value);
+    }
+    free(blk->p_headers);
+error:
+    free(data);
+    free(blk);
+    block_Release(p_block);
+    return NULL;
+}
+
+void httpd_BlockDelete(httpd_block_t *blk)
+{
+    httpd_UrlDelete(blk->url);
+    /* Clients still being served keep a reference to the data */
+    httpd_StreamBlockRelease(blk->data);
+
+    for (size_t i = 0; i < blk->i_headers; i++) {
+        free(blk->p_headers[i].name);
+        free(blk->p_headers[i].value);
+    }
+    free(blk->p_headers);
+    free(blk);
+}
+
 /*****************************************************************************
  * High Level Funtions: httpd_stream_t
  *****************************************************************************/
@@ -607,9 +779,13 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* ring of shared blocks, oldest first */
+    httpd_stream_block_t **pp_ring;
+    size_t      i_ring_alloc;       /* ring capacity, grows as needed */
+    size_t      i_ring_start;       /* index of the oldest block */
+    size_t      i_ring_count;       /* number of blocks */
+    int64_t     i_ring_bytes;       /* number of bytes in the blocks */
+    int64_t     i_buffer_size;      /* bytes kept for clients lagging behind */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
@@ -618,6 +794,33 @@ struct httpd_stream_t
     httpd_header * p_http_headers;
 };
 
+/* Beyond the nominal buffer size, the ring keeps the blocks since the last
+ * keyframe (so that new clients can start with it), up to this factor. */
+#define HTTPD_STREAM_GROWTH 8
+
+static httpd_stream_block_t *httpd_StreamRing(const httpd_stream_t *stream,
+                                              size_t i)
+{
+    assert(i < stream->i_ring_count);
+    return stream->pp_ring[(stream->i_ring_start + i) % stream->i_ring_alloc];
+}
+
+/* Finds the ring block containing a stream position */
+static size_t httpd_StreamFind(const httpd_stream_t *stream, int64_t pos)
+{
+    size_t lo = 0, hi = stream->i_ring_count;
+
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+
+        if (httpd_StreamRing(stream, mid)->i_pos <= pos)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -628,47 +831,51 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        vlc_mutex_lock(&stream->lock);
 
         if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
+            goto wait;  /* no data available */
 
         if (cl->i_keyframe_wait_to_pass >= 0) {
             if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
                 /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+                goto wait;
 
             /* seek to the new keyframe */
             answer->i_body_offset = stream->i_last_keyframe_seen_pos;
             cl->i_keyframe_wait_to_pass = -1;
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
+        if (answer->i_body_offset < httpd_StreamRing(stream, 0)->i_pos)
             answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+        /* Hand references to the blocks over to the client: the data is
+         * written from the blocks, shared by all clients. */
+        size_t i = httpd_StreamFind(stream, answer->i_body_offset);
 
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+        assert(cl->i_blocks == 0);
+        cl->i_block_offset = answer->i_body_offset
+                             - httpd_StreamRing(stream, i)->i_pos;
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+        for (; i < stream->i_ring_count && cl->i_blocks < HTTPD_CL_MAX_BLOCKS;
+             i++) {
+            httpd_stream_block_t *b = httpd_StreamRing(stream, i);
+
+            vlc_atomic_rc_inc(&b->rc);
+            cl->p_blocks[cl->i_blocks++] = b;
+            answer->i_body_offset = b->i_pos + b->p_block->i_buffer;
+        }
+        vlc_mutex_unlock(&stream->lock);
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
-
-        answer->i_body_offset += i_write;
-
         return VLC_SUCCESS;
+wait:
+        vlc_mutex_unlock(&stream->lock);
+        return VLC_EGENERIC;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -752,7 +959,6 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
         return NULL;
 
     stream->psz_mime = NULL;
-    stream->p_buffer = NULL;
 
     stream->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
     if (!stream->url)
@@ -768,12 +974,13 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
 
     stream->i_header = 0;
     stream->p_header = NULL;
+    stream->pp_ring = NULL;
+    stream->i_ring_alloc = 0;
+    stream->i_ring_start = 0;
+    stream->i_ring_count = 0;
+    stream->i_ring_bytes = 0;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
 
-    stream->p_buffer = malloc(stream->i_buffer_size);
-    if (stream->p_buffer == NULL)
-        goto error;
-
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -819,31 +1026,65 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+/* Drops the oldest blocks, as long as the ring exceeds the buffer size */
+static void httpd_StreamTrim(httpd_stream_t *stream)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
-
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
+    while (stream->i_ring_count > 1
+        && stream->i_ring_bytes > stream->i_buffer_size) {
+        httpd_stream_block_t *b = httpd_StreamRing(stream, 0);
+
+        /* keep the last keyframe for new clients, if not too large */
+        if (stream->b_has_keyframes
+         && b->i_pos >= stream->i_last_keyframe_seen_pos
+         && stream->i_ring_bytes
+              <= HTTPD_STREAM_GROWTH * stream->i_buffer_size)
+            break;
 
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+        stream->i_ring_start = (stream->i_ring_start + 1) % stream->i_ring_alloc;
+        stream->i_ring_count--;
+        stream->i_ring_bytes -= b->p_block->i_buffer;
+        httpd_StreamBlockRelease(b);
     }
-
-    stream->i_buffer_pos += i_data;
 }
 
-int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
+int httpd_StreamSendBlock(httpd_stream_t *stream, block_t *p_block)
 {
-    if (!p_block || !p_block->p_buffer)
+    if (p_block->i_buffer == 0) {
+        block_Release(p_block);
         return VLC_SUCCESS;
+    }
+
+    httpd_stream_block_t *b = malloc(sizeof (*b));
+    if (unlikely(b == NULL)) {
+        block_Release(p_block);
+        return VLC_ENOMEM;
+    }
+
+    vlc_atomic_rc_init(&b->rc);
+    b->p_block = p_block;
 
     vlc_mutex_lock(&stream->lock);
 
+    if (stream->i_ring_count == stream->i_ring_alloc) {
+        /* grow the ring, oldest block first */
+        size_t alloc = stream->i_ring_alloc ? 2 * stream->i_ring_alloc : 64;
+        httpd_stream_block_t **ring = vlc_alloc(alloc, sizeof (*ring));
+
+        if (unlikely(ring == NULL)) {
+            vlc_mutex_unlock(&stream->lock);
+            block_Release(p_block);
+            free(b);
+            return VLC_ENOMEM;
+        }
+
+        for (size_t i = 0; i < stream->i_ring_count; i++)
+            ring[i] = httpd_StreamRing(stream, i);
+        free(stream->pp_ring);
+        stream->pp_ring = ring;
+        stream->i_ring_alloc = alloc;
+        stream->i_ring_start = 0;
+    }
+
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
 
@@ -852,12 +1093,33 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    b->i_pos = stream->i_buffer_pos;
+    stream->pp_ring[(stream->i_ring_start + stream->i_ring_count)
+                    % stream->i_ring_alloc] = b;
+    stream->i_ring_count++;
+    stream->i_ring_bytes += p_block->i_buffer;
+    stream->i_buffer_pos += p_block->i_buffer;
+    httpd_StreamTrim(stream);
 
     vlc_mutex_unlock(&stream->lock);
+    httpd_HostWake(stream->url->host);
     return VLC_SUCCESS;
 }
 
+int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
+{
+    if (!p_block || !p_block->p_buffer)
+        return VLC_SUCCESS;
+
+    block_t *copy = block_Alloc(p_block->i_buffer);
+    if (unlikely(copy == NULL))
+        return VLC_ENOMEM;
+
+    memcpy(copy->p_buffer, p_block->p_buffer, p_block->i_buffer);
+    copy->i_flags = p_block->i_flags;
+    return httpd_StreamSendBlock(stream, copy);
+}
+
 void httpd_StreamDelete(httpd_stream_t *stream)
 {
     httpd_UrlDelete(stream->url);
@@ -869,7 +1131,9 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    for (size_t i = 0; i < stream->i_ring_count; i++)
+        httpd_StreamBlockRelease(httpd_StreamRing(stream, i));
+    free(stream->pp_ring);
     free(stream);
 }
 
@@ -972,8 +1236,40 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_list_init(&host->urls);
     host->client_count = 0;
     vlc_list_init(&host->clients);
+    vlc_list_init(&host->pending);
+    vlc_list_init(&host->waiting);
+    host->i_expiry_date = VLC_TICK_0;
     host->p_tls    = p_tls;
 
+#ifdef HAVE_EVENTFD
+    host->wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+#ifdef HAVE_EPOLL_CREATE1
+    host->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (host->epfd == -1) {
+        msg_Err(p_this, "cannot create event polling: %s",
+                vlc_strerror_c(errno));
+        goto error;
+    }
+
+    for (unsigned i = 0; i < host->nfd; i++) {
+        struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data.ptr = &host->fds[i],
+        };
+        epoll_ctl(host->epfd, EPOLL_CTL_ADD, host->fds[i], &ev);
+    }
+# ifdef HAVE_EVENTFD
+    if (host->wakefd != -1) {
+        struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data.ptr = &host->wakefd,
+        };
+        epoll_ctl(host->epfd, EPOLL_CTL_ADD, host->wakefd, &ev);
+    }
+# endif
+#endif
+
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
                    VLC_THREAD_PRIORITY_LOW)) {
@@ -991,6 +1287,16 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        if (host->fds != NULL) {
+#ifdef HAVE_EPOLL_CREATE1
+            if (host->epfd != -1)
+                vlc_close(host->epfd);
+#endif
+#ifdef HAVE_EVENTFD
+            if (host->wakefd != -1)
+                vlc_close(host->wakefd);
+#endif
+        }
         net_ListenClose(host->fds);
         vlc_cond_destroy(&host->wait);
         vlc_mutex_destroy(&host->lock);
@@ -1022,12 +1328,20 @@ void httpd_HostDelete(httpd_host_t *host)
     msg_Dbg(host, "HTTP host removed");
 
     vlc_list_foreach(client, &host->clients, node) {
-        msg_Warn(host, "client still connected");
-        httpd_ClientDestroy(client);
+        if (client->i_state != HTTPD_CLIENT_DEAD)
+            msg_Warn(host, "client still connected");
+        httpd_ClientDestroy(host, client);
     }
 
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
+#ifdef HAVE_EPOLL_CREATE1
+    vlc_close(host->epfd);
+#endif
+#ifdef HAVE_EVENTFD
+    if (host->wakefd != -1)
+        vlc_close(host->wakefd);
+#endif
     net_ListenClose(host->fds);
     vlc_cond_destroy(&host->wait);
     vlc_mutex_destroy(&host->lock);
@@ -1128,11 +1442,14 @@ void httpd_UrlDelete(httpd_url_t *url)
 
         /* TODO complete it */
         msg_Warn(host, "force closing connections");
-        host->client_count--;
-        httpd_ClientDestroy(client);
+        /* The host thread destroys the client, as it may be polling it. */
+        client->url = NULL;
+        client->i_state = HTTPD_CLIENT_DEAD;
+        httpd_ClientQueue(client, &host->pending);
     }
     free(url);
     vlc_mutex_unlock(&host->lock);
+    httpd_HostWake(host);
 }
 
 static void httpd_MsgInit(httpd_message_t *msg)
@@ -1212,6 +1529,8 @@ static void httpd_ClientInit(httpd_client_t *cl, vlc_tick_t now)
     cl->i_buffer_size = HTTPD_CL_BUFSIZE;
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc(cl->i_buffer_size);
+    cl->i_blocks = 0;
+    cl->i_block_offset = 0;
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
 
@@ -1229,17 +1548,40 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
     return net_GetSockAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
 }
 
-static void httpd_ClientDestroy(httpd_client_t *cl)
+static void httpd_ClientDestroy(httpd_host_t *host, httpd_client_t *cl)
 {
     vlc_list_remove(&cl->node);
+    if (cl->queue != NULL)
+        vlc_list_remove(&cl->qnode);
+#ifdef HAVE_EPOLL_CREATE1
+    if (cl->i_events != -1)
+        epoll_ctl(host->epfd, EPOLL_CTL_DEL, vlc_tls_GetFD(cl->sock), NULL);
+#endif
+    host->client_count--;
     vlc_tls_Close(cl->sock);
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
+    for (unsigned i = 0; i < cl->i_blocks; i++)
+        httpd_StreamBlockRelease(cl->p_blocks[i]);
     free(cl->p_buffer);
     free(cl);
 }
 
+/**
+ * Queues a client in the pending or the waiting list, or dequeues it (NULL).
+ */
+static void httpd_ClientQueue(httpd_client_t *cl, struct vlc_list *queue)
+{
+    if (cl->queue == queue)
+        return;
+    if (cl->queue != NULL)
+        vlc_list_remove(&cl->qnode);
+    if (queue != NULL)
+        vlc_list_append(&cl->qnode, queue);
+    cl->queue = queue;
+}
+
 static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock, vlc_tick_t now)
 {
     httpd_client_t *cl = malloc(sizeof(httpd_client_t));
@@ -1248,6 +1590,8 @@ static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock, vlc_tick_t now)
 
     cl->sock    = sock;
     cl->url     = NULL;
+    cl->queue   = NULL;
+    cl->i_events = -1;
 
     httpd_ClientInit(cl, now);
     return cl;
@@ -1576,6 +1920,29 @@ static void httpd_ClientRecv(httpd_client_t *cl)
         cl->i_activity_timeout = 0;
 }
 
+/* Releases the stream blocks that have been sent */
+static void httpd_ClientConsumeBlocks(httpd_client_t *cl, size_t len)
+{
+    unsigned i = 0;
+
+    while (i < cl->i_blocks) {
+        size_t left = cl->p_blocks[i]->p_block->i_buffer - cl->i_block_offset;
+
+        if (len < left) {
+            cl->i_block_offset += len;
+            break;
+        }
+
+        len -= left;
+        httpd_StreamBlockRelease(cl->p_blocks[i++]);
+        cl->i_block_offset = 0;
+    }
+
+    memmove(cl->p_blocks, cl->p_blocks + i,
+            (cl->i_blocks - i) * sizeof (*cl->p_blocks));
+    cl->i_blocks -= i;
+}
+
 static void httpd_ClientSend(httpd_client_t *cl)
 {
     int i_len;
@@ -1611,12 +1978,35 @@ static void httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer_size = (uint8_t*)p - cl->p_buffer;
     }
 
-    i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
-                           cl->i_buffer_size - cl->i_buffer);
+    /* Gather the buffer and the shared stream blocks */
+    struct iovec iov[1 + HTTPD_CL_MAX_BLOCKS];
+    unsigned iovcnt = 0;
+
+    if (cl->i_buffer < cl->i_buffer_size) {
+        iov[0].iov_base = &cl->p_buffer[cl->i_buffer];
+        iov[0].iov_len = cl->i_buffer_size - cl->i_buffer;
+        iovcnt++;
+    }
+
+    for (unsigned i = 0; i < cl->i_blocks; i++) {
+        const block_t *block = cl->p_blocks[i]->p_block;
+        size_t offset = (i == 0) ? cl->i_block_offset : 0;
+
+        iov[iovcnt].iov_base = block->p_buffer + offset;
+        iov[iovcnt].iov_len = block->i_buffer - offset;
+        iovcnt++;
+    }
+
+    i_len = (iovcnt > 0) ? cl->sock->ops->writev(cl->sock, iov, iovcnt) : 0;
     if (i_len >= 0) {
-        cl->i_buffer += i_len;
+        size_t len = i_len;
+        size_t copied = __MIN(len, (size_t)(cl->i_buffer_size - cl->i_buffer));
+
+        cl->i_buffer += copied;
+        len -= copied;
+        httpd_ClientConsumeBlocks(cl, len);
 
-        if (cl->i_buffer >= cl->i_buffer_size) {
+        if (cl->i_buffer >= cl->i_buffer_size && cl->i_blocks == 0) {
             if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
                 /* catch more body data */
                 int     i_msg = cl->query.i_type;
@@ -1638,6 +2028,12 @@ static void httpd_ClientSend(httpd_client_t *cl)
 
                 cl->answer.i_body = 0;
                 cl->answer.p_body = NULL;
+            } else if (cl->i_blocks > 0) {
+                /* send the stream blocks */
+                free(cl->p_buffer);
+                cl->p_buffer = NULL;
+                cl->i_buffer_size = 0;
+                cl->i_buffer = 0;
             } else /* send finished */
                 cl->i_state = HTTPD_CLIENT_SEND_DONE;
         }
@@ -1705,356 +2101,507 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+/**
+ * Runs the state machine of a client after I/O or for new stream data.
+ */
+static void httpd_ClientProcess(httpd_host_t *host, httpd_client_t *cl)
 {
-    struct pollfd ufd[host->nfd + host->client_count];
-    unsigned nfd;
-    for (nfd = 0; nfd < host->nfd; nfd++) {
-        ufd[nfd].fd = host->fds[nfd];
-        ufd[nfd].events = POLLIN;
-        ufd[nfd].revents = 0;
-    }
+    int64_t i_offset;
+
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVE_DONE: {
+            httpd_message_t *answer = &cl->answer;
+            httpd_message_t *query  = &cl->query;
+
+            httpd_MsgInit(answer);
+
+            /* Handle what we received */
+            switch (query->i_type) {
+                case HTTPD_MSG_ANSWER:
+                    cl->url     = NULL;
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                    break;
+
+                case HTTPD_MSG_OPTIONS:
+                    answer->i_type   = HTTPD_MSG_ANSWER;
+                    answer->i_proto  = query->i_proto;
+                    answer->i_status = 200;
+                    answer->i_body = 0;
+                    answer->p_body = NULL;
+
+                    httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
+                    httpd_MsgAdd(answer, "Content-Length", "0");
+
+                    switch(query->i_proto) {
+                    case HTTPD_PROTO_HTTP:
+                        answer->i_version = 1;
+                        httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
+                        break;
 
-    vlc_mutex_lock(&host->lock);
-    /* add all socket that should be read/write and close dead connection */
-    while (vlc_list_is_empty(&host->urls)) {
-        mutex_cleanup_push(&host->lock);
-        vlc_cond_wait(&host->wait, &host->lock);
-        vlc_cleanup_pop();
-    }
+                    case HTTPD_PROTO_RTSP:
+                        answer->i_version = 0;
 
-    vlc_tick_t now = vlc_tick_now();
-    bool b_low_delay = false;
-    httpd_client_t *cl;
+                        const char *p = httpd_MsgGet(query, "Cseq");
+                        if (p)
+                            httpd_MsgAdd(answer, "Cseq", "%s", p);
+                        p = httpd_MsgGet(query, "Timestamp");
+                        if (p)
+                            httpd_MsgAdd(answer, "Timestamp", "%s", p);
 
-    int canc = vlc_savecancel();
-    vlc_list_foreach(cl, &host->clients, node) {
-        int64_t i_offset;
+                        p = httpd_MsgGet(query, "Require");
+                        if (p) {
+                            answer->i_status = 551;
+                            httpd_MsgAdd(query, "Unsupported", "%s", p);
+                        }
 
-        if (cl->i_state == HTTPD_CLIENT_DEAD
-         || (cl->i_activity_timeout > 0
-          && cl->i_activity_date + cl->i_activity_timeout < now)) {
-            host->client_count--;
-            httpd_ClientDestroy(cl);
-            continue;
-        }
+                        httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
+                                "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
+                        break;
+                    }
 
-        struct pollfd *pufd = ufd + nfd;
-        assert (pufd < ufd + (sizeof (ufd) / sizeof (ufd[0])));
+                    if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-        pufd->events = pufd->revents = 0;
+                    cl->i_buffer = -1;  /* Force the creation of the answer in
+                                         * httpd_ClientSend */
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                    break;
 
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING:
-            case HTTPD_CLIENT_TLS_HS_IN:
-                pufd->events = POLLIN;
-                break;
+                case HTTPD_MSG_NONE:
+                    if (query->i_proto == HTTPD_PROTO_NONE) {
+                        cl->url = NULL;
+                        cl->i_state = HTTPD_CLIENT_DEAD;
+                    } else {
+                        /* unimplemented */
+                        answer->i_proto  = query->i_proto ;
+                        answer->i_type   = HTTPD_MSG_ANSWER;
+                        answer->i_version= 0;
+                        answer->i_status = 501;
 
-            case HTTPD_CLIENT_SENDING:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                pufd->events = POLLOUT;
-                break;
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, 501, NULL);
+                        answer->p_body = (uint8_t *)p;
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-            case HTTPD_CLIENT_RECEIVE_DONE: {
-                httpd_message_t *answer = &cl->answer;
-                httpd_message_t *query  = &cl->query;
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                        cl->i_state = HTTPD_CLIENT_SENDING;
+                    }
+                    break;
 
-                httpd_MsgInit(answer);
+                default: {
+                    httpd_url_t *url;
+                    int i_msg = query->i_type;
+                    bool b_auth_failed = false;
 
-                /* Handle what we received */
-                switch (query->i_type) {
-                    case HTTPD_MSG_ANSWER:
-                        cl->url     = NULL;
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                        break;
+                    /* Search the url and trigger callbacks */
+                    vlc_list_foreach(url, &host->urls, node) {
+                        if (strcmp(url->psz_url, query->psz_url))
+                            continue;
+                        if (!url->catch[i_msg].cb)
+                            continue;
 
-                    case HTTPD_MSG_OPTIONS:
-                        answer->i_type   = HTTPD_MSG_ANSWER;
-                        answer->i_proto  = query->i_proto;
-                        answer->i_status = 200;
-                        answer->i_body = 0;
-                        answer->p_body = NULL;
+                        if (answer) {
+                            b_auth_failed = !httpdAuthOk(url->psz_user,
+                               url->psz_password,
+                               httpd_MsgGet(query, "Authorization")); /* BASIC id */
+                            if (b_auth_failed)
+                               break;
+                        }
 
-                        httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
-                        httpd_MsgAdd(answer, "Content-Length", "0");
+                        if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
+                            continue;
 
-                        switch(query->i_proto) {
-                        case HTTPD_PROTO_HTTP:
-                            answer->i_version = 1;
-                            httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
-                            break;
+                        if (answer->i_proto == HTTPD_PROTO_NONE)
+                            cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
+                        else
+                            cl->i_buffer = -1;
 
-                        case HTTPD_PROTO_RTSP:
-                            answer->i_version = 0;
+                        /* only one url can answer */
+                        answer = NULL;
+                        if (!cl->url)
+                            cl->url = url;
+                    }
 
-                            const char *p = httpd_MsgGet(query, "Cseq");
-                            if (p)
-                                httpd_MsgAdd(answer, "Cseq", "%s", p);
-                            p = httpd_MsgGet(query, "Timestamp");
-                            if (p)
-                                httpd_MsgAdd(answer, "Timestamp", "%s", p);
+                    if (answer) {
+                        answer->i_proto  = query->i_proto;
+                        answer->i_type   = HTTPD_MSG_ANSWER;
+                        answer->i_version= 0;
+
+                       if (b_auth_failed) {
+                            httpd_MsgAdd(answer, "WWW-Authenticate",
+                                    "Basic realm=\"VLC stream\"");
+                            answer->i_status = 401;
+                        } else
+                            answer->i_status = 404; /* no url registered */
+
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, answer->i_status,
+                                query->psz_url);
+                        answer->p_body = (uint8_t *)p;
+
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
+                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+                            httpd_MsgAdd(answer, "Connection", "close");
+                    }
 
-                            p = httpd_MsgGet(query, "Require");
-                            if (p) {
-                                answer->i_status = 551;
-                                httpd_MsgAdd(query, "Unsupported", "%s", p);
-                            }
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                }
+            }
+            break;
+        }
 
-                            httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
-                                    "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
-                            break;
-                        }
+        case HTTPD_CLIENT_SEND_DONE:
+            if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
+                bool do_close = false;
 
-                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                            httpd_MsgAdd(answer, "Connection", "close");
+                cl->url = NULL;
 
-                        cl->i_buffer = -1;  /* Force the creation of the answer in
-                                             * httpd_ClientSend */
-                        cl->i_state = HTTPD_CLIENT_SENDING;
-                        break;
+                if (cl->query.i_proto != HTTPD_PROTO_HTTP
+                 || cl->query.i_version > 0)
+                {
+                    const char *psz_connection = httpd_MsgGet(&cl->answer,
+                                                             "Connection");
+                    if (psz_connection != NULL)
+                        do_close = !strcasecmp(psz_connection, "close");
+                }
+                else
+                    do_close = true;
 
-                    case HTTPD_MSG_NONE:
-                        if (query->i_proto == HTTPD_PROTO_NONE) {
-                            cl->url = NULL;
-                            cl->i_state = HTTPD_CLIENT_DEAD;
-                        } else {
-                            /* unimplemented */
-                            answer->i_proto  = query->i_proto ;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-                            answer->i_status = 501;
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, 501, NULL);
-                            answer->p_body = (uint8_t *)p;
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
-                            httpd_MsgAdd(answer, "Connection", "close");
+                if (!do_close) {
+                    httpd_MsgClean(&cl->query);
+                    httpd_MsgInit(&cl->query);
 
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            cl->i_state = HTTPD_CLIENT_SENDING;
-                        }
-                        break;
+                    cl->i_buffer = 0;
+                    cl->i_buffer_size = 1000;
+                    free(cl->p_buffer);
+                    // Allocate an extra byte for the null terminating byte
+                    cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
+                    cl->i_state = HTTPD_CLIENT_RECEIVING;
+                } else
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                httpd_MsgClean(&cl->answer);
+            } else {
+                i_offset = cl->answer.i_body_offset;
+                httpd_MsgClean(&cl->answer);
 
-                    default: {
-                        httpd_url_t *url;
-                        int i_msg = query->i_type;
-                        bool b_auth_failed = false;
-
-                        /* Search the url and trigger callbacks */
-                        vlc_list_foreach(url, &host->urls, node) {
-                            if (strcmp(url->psz_url, query->psz_url))
-                                continue;
-                            if (!url->catch[i_msg].cb)
-                                continue;
-
-                            if (answer) {
-                                b_auth_failed = !httpdAuthOk(url->psz_user,
-                                   url->psz_password,
-                                   httpd_MsgGet(query, "Authorization")); /* BASIC id */
-                                if (b_auth_failed)
-                                   break;
-                            }
-
-                            if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
-                                continue;
-
-                            if (answer->i_proto == HTTPD_PROTO_NONE)
-                                cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
-                            else
-                                cl->i_buffer = -1;
-
-                            /* only one url can answer */
-                            answer = NULL;
-                            if (!cl->url)
-                                cl->url = url;
-                        }
+                cl->answer.i_body_offset = i_offset;
+                free(cl->p_buffer);
+                cl->p_buffer = NULL;
+                cl->i_buffer = 0;
+                cl->i_buffer_size = 0;
 
-                        if (answer) {
-                            answer->i_proto  = query->i_proto;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-
-                           if (b_auth_failed) {
-                                httpd_MsgAdd(answer, "WWW-Authenticate",
-                                        "Basic realm=\"VLC stream\"");
-                                answer->i_status = 401;
-                            } else
-                                answer->i_status = 404; /* no url registered */
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, answer->i_status,
-                                    query->psz_url);
-                            answer->p_body = (uint8_t *)p;
-
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
-                            httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
-                            if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                                httpd_MsgAdd(answer, "Connection", "close");
-                        }
+                cl->i_state = HTTPD_CLIENT_WAITING;
+            }
+            break;
 
-                        cl->i_state = HTTPD_CLIENT_SENDING;
-                    }
-                }
-                break;
+        case HTTPD_CLIENT_WAITING:
+            i_offset = cl->answer.i_body_offset;
+            int i_msg = cl->query.i_type;
+
+            httpd_MsgInit(&cl->answer);
+            cl->answer.i_body_offset = i_offset;
+
+            cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
+                    &cl->answer, &cl->query);
+            if (cl->answer.i_type != HTTPD_MSG_NONE) {
+                /* we have new data, so re-enter send mode */
+                cl->i_buffer      = 0;
+                cl->p_buffer      = cl->answer.p_body;
+                cl->i_buffer_size = cl->answer.i_body;
+                cl->answer.p_body = NULL;
+                cl->answer.i_body = 0;
+                cl->i_state = HTTPD_CLIENT_SENDING;
             }
+    }
+}
 
-            case HTTPD_CLIENT_SEND_DONE:
-                if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
-                    bool do_close = false;
+/**
+ * Updates the events to poll for a client, depending on its state.
+ */
+static void httpd_ClientPoll(httpd_host_t *host, httpd_client_t *cl)
+{
+    short events = 0;
 
-                    cl->url = NULL;
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING:
+        case HTTPD_CLIENT_TLS_HS_IN:
+            events = POLLIN;
+            break;
 
-                    if (cl->query.i_proto != HTTPD_PROTO_HTTP
-                     || cl->query.i_version > 0)
-                    {
-                        const char *psz_connection = httpd_MsgGet(&cl->answer,
-                                                                 "Connection");
-                        if (psz_connection != NULL)
-                            do_close = !strcasecmp(psz_connection, "close");
-                    }
-                    else
-                        do_close = true;
-
-                    if (!do_close) {
-                        httpd_MsgClean(&cl->query);
-                        httpd_MsgInit(&cl->query);
-
-                        cl->i_buffer = 0;
-                        cl->i_buffer_size = 1000;
-                        free(cl->p_buffer);
-                        // Allocate an extra byte for the null terminating byte
-                        cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
-                        cl->i_state = HTTPD_CLIENT_RECEIVING;
-                    } else
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                    httpd_MsgClean(&cl->answer);
-                } else {
-                    i_offset = cl->answer.i_body_offset;
-                    httpd_MsgClean(&cl->answer);
+        case HTTPD_CLIENT_SENDING:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            events = POLLOUT;
+            break;
+    }
 
-                    cl->answer.i_body_offset = i_offset;
-                    free(cl->p_buffer);
-                    cl->p_buffer = NULL;
-                    cl->i_buffer = 0;
-                    cl->i_buffer_size = 0;
+    int fd = vlc_tls_GetPollFD(cl->sock, &events);
 
-                    cl->i_state = HTTPD_CLIENT_WAITING;
-                }
-                break;
+#ifdef HAVE_EPOLL_CREATE1
+    if (events == cl->i_events)
+        return;
 
-            case HTTPD_CLIENT_WAITING:
-                i_offset = cl->answer.i_body_offset;
-                int i_msg = cl->query.i_type;
+    /* Clients stay registered (for errors) even if no events are needed. */
+    struct epoll_event ev = {
+        .events = ((events & POLLIN) ? EPOLLIN : 0)
+                | ((events & POLLOUT) ? EPOLLOUT : 0),
+        .data.ptr = cl,
+    };
 
-                httpd_MsgInit(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
+    if (epoll_ctl(host->epfd,
+                  (cl->i_events != -1) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                  fd, &ev)) {
+        msg_Err(host, "cannot poll client: %s", vlc_strerror_c(errno));
+        cl->i_state = HTTPD_CLIENT_DEAD;
+        return;
+    }
+#else
+    (void) host; (void) fd;
+#endif
+    cl->i_events = events;
+}
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                        &cl->answer, &cl->query);
-                if (cl->answer.i_type != HTTPD_MSG_NONE) {
-                    /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
-                    cl->i_state = HTTPD_CLIENT_SENDING;
-                }
+/**
+ * Handles I/O readiness of a client.
+ */
+static void httpd_ClientIO(httpd_host_t *host, httpd_client_t *cl,
+                           short revents, vlc_tick_t now)
+{
+    if (revents == 0)
+        return; // no event received
+
+    cl->i_activity_date = now;
+
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
+        case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+        case HTTPD_CLIENT_TLS_HS_IN:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            httpd_ClientTlsHandshake(host, cl);
+            break;
+        case HTTPD_CLIENT_DEAD:
+            break;
+        default:
+            /* Not polling for I/O, e.g. waiting for stream data */
+            if (!(revents & (POLLERR|POLLHUP)))
+                return;
+            cl->i_state = HTTPD_CLIENT_DEAD;
+    }
+    httpd_ClientQueue(cl, &host->pending);
+}
+
+/**
+ * Accepts a new connection on a listening socket.
+ */
+static void httpd_HostAccept(httpd_host_t *host, int fd, vlc_tick_t now)
+{
+    fd = vlc_accept (fd, NULL, NULL, true);
+    if (fd == -1)
+        return;
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
+            &(int){ 1 }, sizeof(int));
+
+    vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
+    if (unlikely(sk == NULL))
+    {
+        vlc_close(fd);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+    {
+        const char *alpn[] = { "http/1.1", NULL };
+        vlc_tls_t *tls;
+
+        tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
+        if (tls == NULL)
+        {
+            vlc_tls_SessionDelete(sk);
+            return;
         }
+        sk = tls;
+    }
+
+    httpd_client_t *cl = httpd_ClientNew(sk, now);
+    if (unlikely(cl == NULL))
+    {
+        vlc_tls_Close(sk);
+        return;
+    }
 
-        pufd->fd = vlc_tls_GetPollFD(cl->sock, &pufd->events);
+    if (host->p_tls != NULL)
+        cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
 
-        if (pufd->events != 0)
-            nfd++;
-        else
-            b_low_delay = true;
+    host->client_count++;
+    vlc_list_append(&cl->node, &host->clients);
+    httpd_ClientQueue(cl, &host->pending);
+}
+
+/**
+ * Wakes the host thread up to serve the clients waiting for stream data.
+ */
+static void httpd_HostWake(httpd_host_t *host)
+{
+#ifdef HAVE_EVENTFD
+    if (host->wakefd != -1) {
+        uint64_t val = 1;
+        /* If the counter is saturated, the thread is woken up anyway. */
+        ssize_t ret = write(host->wakefd, &val, sizeof (val));
+        (void) ret;
+    }
+#else
+    (void) host;
+#endif
+}
+
+static bool httpd_HostCanWake(const httpd_host_t *host)
+{
+#if defined (HAVE_EPOLL_CREATE1) && defined (HAVE_EVENTFD)
+    return host->wakefd != -1;
+#else
+    (void) host;
+    return false;
+#endif
+}
+
+static void httpdLoop(httpd_host_t *host)
+{
+    vlc_mutex_lock(&host->lock);
+    while (vlc_list_is_empty(&host->urls)) {
+        mutex_cleanup_push(&host->lock);
+        vlc_cond_wait(&host->wait, &host->lock);
+        vlc_cleanup_pop();
     }
+
+    vlc_tick_t now = vlc_tick_now();
+    httpd_client_t *cl;
+
+    int canc = vlc_savecancel();
+
+    /* Close inactive connections (this walks all clients, not too often) */
+    if (now >= host->i_expiry_date) {
+        vlc_list_foreach(cl, &host->clients, node)
+            if (cl->i_activity_timeout > 0
+             && cl->i_activity_date + cl->i_activity_timeout < now) {
+                cl->i_state = HTTPD_CLIENT_DEAD;
+                httpd_ClientQueue(cl, &host->pending);
+            }
+        host->i_expiry_date = now + VLC_TICK_FROM_SEC(1);
+    }
+
+    /* Only run the state machine of the clients that need it */
+    vlc_list_foreach(cl, &host->pending, qnode) {
+        httpd_ClientProcess(host, cl);
+
+        if (cl->i_state != HTTPD_CLIENT_DEAD)
+            httpd_ClientPoll(host, cl);
+
+        if (cl->i_state == HTTPD_CLIENT_DEAD)
+            httpd_ClientDestroy(host, cl);
+        else if (cl->i_events != 0)
+            httpd_ClientQueue(cl, NULL); /* wait for I/O */
+        else if (cl->i_state == HTTPD_CLIENT_WAITING && httpd_HostCanWake(host))
+            httpd_ClientQueue(cl, &host->waiting); /* wait for data */
+    }
+
+    /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
+    int timeout = -1;
+    if (!vlc_list_is_empty(&host->pending))
+        timeout = 20;
+    else if (host->client_count > 0)
+        timeout = 1000;
+
+#ifdef HAVE_EPOLL_CREATE1
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
 
-    /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-    while (poll(ufd, nfd, b_low_delay ? 20 : -1) < 0)
-    {
+    struct epoll_event ev[64];
+    int n = epoll_wait(host->epfd, ev, ARRAY_SIZE(ev), timeout);
+    if (n < 0) {
         if (errno != EINTR)
             msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+        n = 0;
     }
 
     canc = vlc_savecancel();
     vlc_mutex_lock(&host->lock);
-
-    /* Handle client sockets */
     now = vlc_tick_now();
-    nfd = host->nfd;
-
-    vlc_list_foreach(cl, &host->clients, node) {
-        const struct pollfd *pufd = &ufd[nfd];
 
-        assert(pufd < &ufd[sizeof(ufd) / sizeof(ufd[0])]);
+    for (int i = 0; i < n; i++) {
+        void *ptr = ev[i].data.ptr;
 
-        if (vlc_tls_GetFD(cl->sock) != pufd->fd)
-            continue; // we were not waiting for this client
-        ++nfd;
-        if (pufd->revents == 0)
-            continue; // no event received
+        if (ptr == &host->wakefd) {
+            uint64_t val;
 
-        cl->i_activity_date = now;
+            if (read(host->wakefd, &val, sizeof (val)) > 0)
+                vlc_list_foreach(cl, &host->waiting, qnode)
+                    httpd_ClientQueue(cl, &host->pending);
+            continue;
+        }
 
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
-            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
-            case HTTPD_CLIENT_TLS_HS_IN:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                httpd_ClientTlsHandshake(host, cl);
-                break;
+        if (ptr >= (void *)host->fds && ptr < (void *)(host->fds + host->nfd)) {
+            httpd_HostAccept(host, *(int *)ptr, now);
+            continue;
         }
+
+        uint32_t events = ev[i].events;
+        short revents = ((events & EPOLLIN) ? POLLIN : 0)
+                      | ((events & EPOLLOUT) ? POLLOUT : 0)
+                      | ((events & EPOLLERR) ? POLLERR : 0)
+                      | ((events & EPOLLHUP) ? POLLHUP : 0);
+
+        httpd_ClientIO(host, ptr, revents, now);
     }
+#else
+    struct pollfd ufd[host->nfd + host->client_count];
+    httpd_client_t *clients[host->client_count + 1];
+    unsigned nfd, ncl = 0;
 
-    /* Handle server sockets (accept new connections) */
     for (nfd = 0; nfd < host->nfd; nfd++) {
-        int fd = ufd[nfd].fd;
-
-        assert (fd == host->fds[nfd]);
+        ufd[nfd].fd = host->fds[nfd];
+        ufd[nfd].events = POLLIN;
+        ufd[nfd].revents = 0;
+    }
 
-        if (ufd[nfd].revents == 0)
+    vlc_list_foreach(cl, &host->clients, node) {
+        if (cl->i_events <= 0)
             continue;
 
-        /* */
-        fd = vlc_accept (fd, NULL, NULL, true);
-        if (fd == -1)
-            continue;
-        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
-                &(int){ 1 }, sizeof(int));
+        ufd[nfd].events = cl->i_events;
+        ufd[nfd].fd = vlc_tls_GetPollFD(cl->sock, &ufd[nfd].events);
+        ufd[nfd].revents = 0;
+        clients[ncl++] = cl;
+        nfd++;
+    }
 
-        vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
-        if (unlikely(sk == NULL))
-        {
-            vlc_close(fd);
-            continue;
-        }
+    vlc_mutex_unlock(&host->lock);
+    vlc_restorecancel(canc);
 
-        if (host->p_tls != NULL)
-        {
-            const char *alpn[] = { "http/1.1", NULL };
-            vlc_tls_t *tls;
-
-            tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
-            if (tls == NULL)
-            {
-                vlc_tls_SessionDelete(sk);
-                continue;
-            }
-            sk = tls;
-        }
+    while (poll(ufd, nfd, timeout) < 0)
+    {
+        if (errno != EINTR)
+            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+    }
 
-        cl = httpd_ClientNew(sk, now);
+    canc = vlc_savecancel();
+    vlc_mutex_lock(&host->lock);
 
-        if (host->p_tls != NULL)
-            cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+    /* Handle client sockets */
+    now = vlc_tick_now();
 
-        host->client_count++;
-        vlc_list_append(&cl->node, &host->clients);
+    for (unsigned i = 0; i < ncl; i++)
+        httpd_ClientIO(host, clients[i], ufd[host->nfd + i].revents, now);
+
+    /* Handle server sockets (accept new connections) */
+    for (nfd = 0; nfd < host->nfd; nfd++) {
+        assert (ufd[nfd].fd == host->fds[nfd]);
+
+        if (ufd[nfd].revents != 0)
+            httpd_HostAccept(host, ufd[nfd].fd, now);
     }
+#endif
 
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
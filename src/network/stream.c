@@ -49,6 +49,7 @@
 #include <vlc_common.h>
 #include <vlc_tls.h>
 #include <vlc_interrupt.h>
+#include "libvlc.h"
 
 ssize_t vlc_tls_Read(vlc_tls_t *session, void *buf, size_t len, bool waitall)
 {
@@ -225,6 +226,7 @@ static const struct vlc_tls_operations vlc_tls_socket_ops =
     vlc_tls_SocketWrite,
     vlc_tls_SocketShutdown,
     vlc_tls_SocketClose,
+    NULL,
 };
 
 static vlc_tls_t *vlc_tls_SocketAlloc(int fd,
@@ -401,6 +403,7 @@ static const struct vlc_tls_operations vlc_tls_socket_fastopen_ops =
     vlc_tls_ConnectWrite,
     vlc_tls_SocketShutdown,
     vlc_tls_SocketClose,
+    NULL,
 };
 
 vlc_tls_t *vlc_tls_SocketOpenAddrInfo(const struct addrinfo *restrict info,
@@ -438,7 +441,7 @@ vlc_tls_t *vlc_tls_SocketOpenTCP(vlc_object_t *obj, const char *name,
     assert(name != NULL);
     msg_Dbg(obj, "resolving %s ...", name);
 
-    int val = vlc_getaddrinfo_i11e(name, port, &hints, &res);
+    int val = vlc_net_GetAddrInfo(name, port, &hints, &res);
     if (val != 0)
     {   /* TODO: C locale for gai_strerror() */
         msg_Err(obj, "cannot resolve %s port %u: %s", name, port,
@@ -448,20 +451,18 @@ vlc_tls_t *vlc_tls_SocketOpenTCP(vlc_object_t *obj, const char *name,
 
     msg_Dbg(obj, "connecting to %s port %u ...", name, port);
 
-    /* TODO: implement RFC8305 */
-    for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
+    int fd = vlc_net_ConnectAddrInfo(obj, res, -1, NULL);
+    vlc_net_FreeAddrInfo(res);
+    if (fd == -1)
     {
-        vlc_tls_t *tls = vlc_tls_SocketOpenAddrInfo(p, false);
-        if (tls == NULL)
-        {
-            msg_Err(obj, "connection error: %s", vlc_strerror_c(errno));
-            continue;
-        }
-
-        freeaddrinfo(res);
-        return tls;
+        msg_Err(obj, "connection error: %s", vlc_strerror_c(errno));
+        return NULL;
     }
 
-    freeaddrinfo(res);
-    return NULL;
+    setsockopt(fd, SOL_TCP, TCP_NODELAY, &(int){ 1 }, sizeof (int));
+
+    vlc_tls_t *tls = vlc_tls_SocketOpen(fd);
+    if (unlikely(tls == NULL))
+        net_Close(fd);
+    return tls;
 }
@@ -29,12 +29,23 @@
 # include "config.h"
 #endif
 
-#include <vlc_common.h>
-
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#ifdef HAVE_POLL
+# include <poll.h>
+#endif
 
+#include <vlc_common.h>
 #include <vlc_network.h>
 #include <vlc_interrupt.h>
+#include "libvlc.h"
+#if defined (_WIN32)
+#   undef EINPROGRESS
+#   define EINPROGRESS WSAEWOULDBLOCK
+#endif
 
 /*****************************************************************************
  * SocksNegotiate:
@@ -294,3 +305,443 @@ int (net_ConnectTCP)(vlc_object_t *obj, const char *host, int serv)
 
     return fd;
 }
+
+/*****************************************************************************
+ * Resolver cache
+ *****************************************************************************
+ * Host name resolutions are kept for a short while, so that reconnections
+ * and subsequent requests to a same server do not wait for the resolver.
+ * The system resolver does not expose the records time-to-live, so entries
+ * are kept for a fixed duration at most. Addresses that fail to connect are
+ * evicted, so that they are not tried again before the next resolution.
+ *****************************************************************************/
+#define DNS_CACHE_SIZE 16
+#define DNS_CACHE_TTL  VLC_TICK_FROM_SEC(60)
+
+static struct
+{
+    char *host;
+    unsigned port;
+    int flags;
+    int family;
+    int socktype;
+    int protocol;
+    vlc_tick_t expiry;
+    struct addrinfo *res;
+} dns_cache[DNS_CACHE_SIZE];
+static vlc_mutex_t dns_lock = VLC_STATIC_MUTEX;
+
+struct vlc_addrinfo_copy
+{
+    struct addrinfo info;
+    struct sockaddr_storage addr;
+};
+
+void vlc_net_FreeAddrInfo(struct addrinfo *res)
+{
+    while (res != NULL)
+    {
+        struct addrinfo *next = res->ai_next;
+
+        free(container_of(res, struct vlc_addrinfo_copy, info));
+        res = next;
+    }
+}
+
+static struct addrinfo *vlc_net_CopyAddrInfo(const struct addrinfo *res)
+{
+    struct addrinfo *head = NULL, **pp = &head;
+
+    for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
+    {
+        if (unlikely(p->ai_addrlen > sizeof (struct sockaddr_storage)))
+            continue;
+
+        struct vlc_addrinfo_copy *copy = malloc(sizeof (*copy));
+        if (unlikely(copy == NULL))
+        {
+            vlc_net_FreeAddrInfo(head);
+            return NULL;
+        }
+
+        copy->info = *p;
+        copy->info.ai_addr = (struct sockaddr *)&copy->addr;
+        copy->info.ai_canonname = NULL;
+        copy->info.ai_next = NULL;
+        memcpy(&copy->addr, p->ai_addr, p->ai_addrlen);
+        *pp = &copy->info;
+        pp = &copy->info.ai_next;
+    }
+    return head;
+}
+
+/**
+ * Finds the cache entry for a request, or else the entry to replace.
+ */
+static size_t vlc_net_FindDNS(const char *node, unsigned port,
+                              const struct addrinfo *hints, bool *restrict hit)
+{
+    size_t victim = 0;
+
+    *hit = true;
+
+    for (size_t i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        if (dns_cache[i].host != NULL
+         && strcmp(dns_cache[i].host, node) == 0
+         && dns_cache[i].port == port
+         && dns_cache[i].flags == hints->ai_flags
+         && dns_cache[i].family == hints->ai_family
+         && dns_cache[i].socktype == hints->ai_socktype
+         && dns_cache[i].protocol == hints->ai_protocol)
+            return i;
+
+        if (dns_cache[i].expiry < dns_cache[victim].expiry)
+            victim = i;
+    }
+    *hit = false;
+    return victim;
+}
+
+int vlc_net_GetAddrInfo(const char *node, unsigned port,
+                        const struct addrinfo *hints, struct addrinfo **res)
+{
+    static const struct addrinfo no_hints = { .ai_family = AF_UNSPEC };
+    struct addrinfo *info;
+
+    if (hints == NULL)
+        hints = &no_hints;
+
+    if (node == NULL || (hints->ai_flags & AI_PASSIVE))
+    {   /* Not worth caching */
+        int val = vlc_getaddrinfo_i11e(node, port, hints, &info);
+        if (val)
+            return val;
+        goto out;
+    }
+
+    bool hit;
+
+    vlc_mutex_lock(&dns_lock);
+    size_t i = vlc_net_FindDNS(node, port, hints, &hit);
+
+    if (hit && dns_cache[i].expiry > vlc_tick_now())
+    {
+        *res = vlc_net_CopyAddrInfo(dns_cache[i].res);
+        vlc_mutex_unlock(&dns_lock);
+        return (*res != NULL) ? 0 : EAI_MEMORY;
+    }
+    vlc_mutex_unlock(&dns_lock);
+
+    int val = vlc_getaddrinfo_i11e(node, port, hints, &info);
+    if (val)
+        return val;
+
+    char *host = strdup(node);
+    if (likely(host != NULL))
+    {
+        vlc_mutex_lock(&dns_lock);
+        i = vlc_net_FindDNS(node, port, hints, &hit);
+        free(dns_cache[i].host);
+        vlc_net_FreeAddrInfo(dns_cache[i].res);
+
+        dns_cache[i].host = host;
+        dns_cache[i].port = port;
+        dns_cache[i].flags = hints->ai_flags;
+        dns_cache[i].family = hints->ai_family;
+        dns_cache[i].socktype = hints->ai_socktype;
+        dns_cache[i].protocol = hints->ai_protocol;
+        dns_cache[i].expiry = vlc_tick_now() + DNS_CACHE_TTL;
+        dns_cache[i].res = vlc_net_CopyAddrInfo(info);
+        if (dns_cache[i].res == NULL)
+        {
+            free(host);
+            dns_cache[i].host = NULL;
+        }
+        vlc_mutex_unlock(&dns_lock);
+    }
+
+out:
+    *res = vlc_net_CopyAddrInfo(info);
+    freeaddrinfo(info);
+    return (*res != NULL) ? 0 : EAI_MEMORY;
+}
+
+void vlc_net_CleanupAddrInfo(void)
+{
+    vlc_mutex_lock(&dns_lock);
+    for (size_t i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        free(dns_cache[i].host);
+        vlc_net_FreeAddrInfo(dns_cache[i].res);
+        dns_cache[i].host = NULL;
+        dns_cache[i].res = NULL;
+        dns_cache[i].expiry = 0;
+    }
+    vlc_mutex_unlock(&dns_lock);
+}
+
+void vlc_net_EvictAddrInfo(const struct addrinfo *ai)
+{
+    vlc_mutex_lock(&dns_lock);
+    for (size_t i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        if (dns_cache[i].host == NULL)
+            continue;
+
+        for (struct addrinfo **pp = &dns_cache[i].res; *pp != NULL;)
+        {
+            struct addrinfo *p = *pp;
+
+            if (p->ai_addrlen == ai->ai_addrlen
+             && p->ai_socktype == ai->ai_socktype
+             && p->ai_protocol == ai->ai_protocol
+             && memcmp(p->ai_addr, ai->ai_addr, ai->ai_addrlen) == 0)
+            {
+                *pp = p->ai_next;
+                p->ai_next = NULL;
+                vlc_net_FreeAddrInfo(p);
+            }
+            else
+                pp = &p->ai_next;
+        }
+
+        if (dns_cache[i].res == NULL)
+        {   /* Nothing left: resolve again next time */
+            free(dns_cache[i].host);
+            dns_cache[i].host = NULL;
+            dns_cache[i].expiry = VLC_TICK_0;
+        }
+    }
+    vlc_mutex_unlock(&dns_lock);
+}
+
+/*****************************************************************************
+ * Connection establishment (RFC 8305 "Happy Eyeballs")
+ *****************************************************************************
+ * Connection attempts to the different addresses are started in turn,
+ * without waiting for the previous attempts to fail, alternating address
+ * families. The first successful connection wins. If the first preferred
+ * address family did not win, the other family is preferred for a while.
+ *****************************************************************************/
+#define CONNECTION_ATTEMPT_DELAY VLC_TICK_FROM_MS(250)
+#define FAMILY_HISTORY_DELAY     VLC_TICK_FROM_SEC(600)
+
+static int preferred_family = AF_UNSPEC;
+static vlc_tick_t preferred_expiry = VLC_TICK_0;
+
+/**
+ * Orders addresses for connection attempts (RFC 8305 §4).
+ */
+static void vlc_net_SortAddrInfo(const struct addrinfo *res,
+                                 const struct addrinfo **tab, size_t count)
+{
+    int family = res->ai_family;
+
+    vlc_mutex_lock(&dns_lock);
+    if (preferred_family != AF_UNSPEC && preferred_expiry > vlc_tick_now())
+        for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
+            if (p->ai_family == preferred_family)
+            {
+                family = preferred_family;
+                break;
+            }
+    vlc_mutex_unlock(&dns_lock);
+
+    /* Interleave the first family with the other ones. */
+    const struct addrinfo *first = res, *other = res;
+    size_t n = 0;
+
+    while (n < count)
+    {
+        while (first != NULL && first->ai_family != family)
+            first = first->ai_next;
+        if (first != NULL)
+        {
+            tab[n++] = first;
+            first = first->ai_next;
+        }
+
+        while (other != NULL && other->ai_family == family)
+            other = other->ai_next;
+        if (other != NULL)
+        {
+            tab[n++] = other;
+            other = other->ai_next;
+        }
+    }
+}
+
+int vlc_net_ConnectAddrInfo(vlc_object_t *obj, const struct addrinfo *res,
+                            vlc_tick_t timeout,
+                            const struct addrinfo **restrict winnerp)
+{
+    size_t count = 0;
+
+    for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
+        count++;
+
+    if (count == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const struct addrinfo *tab[count], *pending[count];
+    struct pollfd ufd[count];
+    vlc_tick_t deadlines[count];
+    const struct addrinfo *winner = NULL;
+    vlc_tick_t next_attempt = VLC_TICK_0;
+    size_t next = 0;
+    unsigned active = 0;
+    int fd = -1, err = ECONNREFUSED;
+
+    vlc_net_SortAddrInfo(res, tab, count);
+
+    while (!vlc_killed())
+    {
+        vlc_tick_t now = vlc_tick_now();
+
+        /* Start the next attempt if the pending ones are taking too long */
+        if (next < count && (active == 0 || now >= next_attempt))
+        {
+            const struct addrinfo *ptr = tab[next++];
+            int sfd = net_Socket(obj, ptr->ai_family, ptr->ai_socktype,
+                                 ptr->ai_protocol);
+            if (sfd == -1)
+            {
+                err = net_errno;
+                msg_Dbg(obj, "socket error: %s", vlc_strerror_c(err));
+                continue;
+            }
+
+            if (connect(sfd, ptr->ai_addr, ptr->ai_addrlen) == 0)
+            {
+                fd = sfd;
+                winner = ptr;
+                break;
+            }
+
+            if (net_errno != EINPROGRESS && errno != EINTR)
+            {
+                err = net_errno;
+                msg_Dbg(obj, "connection failed: %s", vlc_strerror_c(err));
+                net_Close(sfd);
+                vlc_net_EvictAddrInfo(ptr);
+                continue;
+            }
+
+            ufd[active].fd = sfd;
+            ufd[active].events = POLLOUT;
+            pending[active] = ptr;
+            /* Each address gets the whole timeout, as when they were tried
+             * one after the other */
+            deadlines[active] = (timeout >= 0) ? now + timeout : INT64_MAX;
+            active++;
+            next_attempt = now + CONNECTION_ATTEMPT_DELAY;
+            continue;
+        }
+
+        vlc_tick_t wakeup = INT64_MAX;
+
+        for (unsigned i = 0; i < active; i++)
+        {
+            if (now >= deadlines[i])
+            {
+                msg_Warn(obj, "connection timed out");
+                err = ETIMEDOUT;
+                /* Do not try the unresponsive address again */
+                net_Close(ufd[i].fd);
+                vlc_net_EvictAddrInfo(pending[i]);
+                active--;
+                ufd[i] = ufd[active];
+                pending[i] = pending[active];
+                deadlines[i] = deadlines[active];
+                i--;
+            }
+            else if (deadlines[i] < wakeup)
+                wakeup = deadlines[i];
+        }
+
+        if (active == 0)
+        {
+            if (next < count)
+                continue; /* try the next address at once */
+            break; /* all attempts failed */
+        }
+
+        if (next < count && next_attempt < wakeup)
+            wakeup = next_attempt;
+
+        int val = vlc_poll_i11e(ufd, active,
+                                (wakeup != INT64_MAX)
+                                    ? MS_FROM_VLC_TICK(wakeup - now) : -1);
+        if (val == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            err = net_errno;
+            msg_Err(obj, "polling error: %s", vlc_strerror_c(err));
+            break;
+        }
+
+        for (unsigned i = 0; i < active && val > 0; i++)
+        {
+            if (ufd[i].revents == 0)
+                continue;
+            val--;
+
+            /* There is NO WAY around checking SO_ERROR.
+             * Don't ifdef it out!!! */
+            int sockerr;
+            if (getsockopt(ufd[i].fd, SOL_SOCKET, SO_ERROR, &sockerr,
+                           &(socklen_t){ sizeof (sockerr) }))
+                sockerr = net_errno;
+
+            if (sockerr == 0)
+            {
+                fd = ufd[i].fd;
+                winner = pending[i];
+                ufd[i] = ufd[--active];
+                pending[i] = pending[active];
+                deadlines[i] = deadlines[active];
+                break;
+            }
+
+            err = sockerr;
+            msg_Dbg(obj, "connection failed: %s", vlc_strerror_c(err));
+            net_Close(ufd[i].fd);
+            vlc_net_EvictAddrInfo(pending[i]);
+            ufd[i] = ufd[--active];
+            pending[i] = pending[active];
+            deadlines[i] = deadlines[active];
+            i--;
+        }
+
+        if (fd != -1)
+            break;
+    }
+
+    /* Abort the losing attempts */
+    for (unsigned i = 0; i < active; i++)
+        net_Close(ufd[i].fd);
+
+    if (fd == -1)
+    {
+        errno = vlc_killed() ? EINTR : err;
+        return -1;
+    }
+
+    vlc_mutex_lock(&dns_lock);
+    if (winner->ai_family != tab[0]->ai_family)
+    {
+        preferred_family = winner->ai_family;
+        preferred_expiry = vlc_tick_now() + FAMILY_HISTORY_DELAY;
+    }
+    vlc_mutex_unlock(&dns_lock);
+
+    if (winnerp != NULL)
+        *winnerp = winner;
+    msg_Dbg(obj, "connection succeeded (socket = %d)", fd);
+    return fd;
+}
@@ -33,6 +33,9 @@
 #endif
 #include <assert.h>
 #include <errno.h>
+#ifdef HAVE_NETINET_TCP_H
+# include <netinet/tcp.h>
+#endif
 #ifndef SOL_TCP
 # define SOL_TCP IPPROTO_TCP
 #endif
@@ -230,7 +233,7 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
 
     msg_Dbg(creds, "resolving %s ...", name);
 
-    int val = vlc_getaddrinfo_i11e(name, port, &hints, &res);
+    int val = vlc_net_GetAddrInfo(name, port, &hints, &res);
     if (val != 0)
     {   /* TODO: C locale for gai_strerror() */
         msg_Err(creds, "cannot resolve %s port %u: %s", name, port,
@@ -238,28 +241,62 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
         return NULL;
     }
 
-    for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
+    vlc_tls_t *tls = NULL;
+
+    /* Try the addresses until a TLS handshake succeeds. */
+    while (res != NULL)
     {
-        vlc_tls_t *tcp = vlc_tls_SocketOpenAddrInfo(p, true);
-        if (tcp == NULL)
-        {
-            msg_Err(creds, "socket error: %s", vlc_strerror_c(errno));
-            continue;
+        const struct addrinfo *winner = res;
+        vlc_tls_t *tcp;
+
+        if (res->ai_next == NULL)
+            /* Single address: connect on the first send (TCP Fast Open) */
+            tcp = vlc_tls_SocketOpenAddrInfo(res, true);
+        else
+        {   /* Several addresses: race them (RFC 8305) */
+            int fd = vlc_net_ConnectAddrInfo(VLC_OBJECT(creds), res, -1,
+                                             &winner);
+
+            if (fd == -1)
+            {
+                msg_Err(creds, "connection error: %s", vlc_strerror_c(errno));
+                break; /* all addresses failed */
+            }
+
+            setsockopt(fd, SOL_TCP, TCP_NODELAY, &(int){ 1 }, sizeof (int));
+            tcp = vlc_tls_SocketOpen(fd);
+            if (unlikely(tcp == NULL))
+            {
+                net_Close(fd);
+                break;
+            }
         }
 
-        vlc_tls_t *tls = vlc_tls_ClientSessionCreate(creds, tcp, name, service,
-                                                     alpn, alp);
-        if (tls != NULL)
-        {   /* Success! */
-            freeaddrinfo(res);
-            return tls;
+        if (tcp != NULL)
+        {
+            tls = vlc_tls_ClientSessionCreate(creds, tcp, name, service,
+                                              alpn, alp);
+            if (tls != NULL)
+                break; /* Success! */
+
+            vlc_tls_SessionDelete(tcp);
         }
 
         msg_Err(creds, "connection error: %s", vlc_strerror_c(errno));
-        vlc_tls_SessionDelete(tcp);
+
+        /* Do not try the failed address again */
+        vlc_net_EvictAddrInfo(winner);
+
+        struct addrinfo **pp = &res;
+        while (*pp != winner)
+            pp = &(*pp)->ai_next;
+
+        struct addrinfo *failed = *pp;
+        *pp = failed->ai_next;
+        failed->ai_next = NULL;
+        vlc_net_FreeAddrInfo(failed);
     }
 
-    /* Failure! */
-    freeaddrinfo(res);
-    return NULL;
+    vlc_net_FreeAddrInfo(res);
+    return tls;
 }
@@ -86,11 +86,102 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Share (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    block_t *refs[3], *more[2];
+    assert (block != NULL);
+
+    memcpy (block->p_buffer, text, sizeof (text));
+    block->i_pts = VLC_TICK_0;
+    block->i_flags = BLOCK_FLAG_TYPE_I;
+    assert (block_Share (block, refs, 3) == VLC_SUCCESS);
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        assert (refs[i]->p_buffer == refs[0]->p_buffer);
+        assert (refs[i]->i_buffer == sizeof (text));
+        assert (refs[i]->i_pts == VLC_TICK_0);
+        assert (refs[i]->i_flags == BLOCK_FLAG_TYPE_I);
+    }
+
+    /* Sharing a reference shares the same payload */
+    assert (block_Share (refs[2], more, 2) == VLC_SUCCESS);
+    assert (more[0]->p_buffer == refs[0]->p_buffer);
+    assert (more[1]->p_buffer == refs[0]->p_buffer);
+
+    /* Shrinking does not copy */
+    refs[1] = block_Realloc (refs[1], -5, sizeof (text));
+    assert (refs[1] != NULL);
+    assert (refs[1]->p_buffer == refs[0]->p_buffer + 5);
+    assert (refs[1]->i_buffer == sizeof (text) - 5);
+
+    /* Expanding copies on write */
+    refs[0] = block_Realloc (refs[0], 4, sizeof (text) + 4);
+    assert (refs[0] != NULL);
+    assert (refs[0]->p_buffer + 4 != more[0]->p_buffer);
+    memset (refs[0]->p_buffer, 'A', 4);
+    assert (!memcmp (refs[0]->p_buffer + 4, text, sizeof (text)));
+    assert (!memcmp (more[0]->p_buffer, text, sizeof (text)));
+    assert (!memcmp (refs[1]->p_buffer, text + 5, sizeof (text) - 5));
+
+    block_Release (more[1]);
+    block_Release (refs[0]);
+    block_Release (refs[1]);
+    assert (!memcmp (more[0]->p_buffer, text, sizeof (text)));
+    block_Release (more[0]);
+}
+
+/* Writing to a reference never shows through the other references */
+static void test_block_ShareWrite (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    block_t *refs[3];
+    assert (block != NULL);
+
+    memcpy (block->p_buffer, text, sizeof (text));
+    assert (block_IsWritable (block));
+    assert (block_Share (block, refs, 3) == VLC_SUCCESS);
+
+    for (unsigned i = 0; i < 3; i++)
+        assert (!block_IsWritable (refs[i]));
+
+    /* In place, as when replacing start codes */
+    refs[0] = block_MakeWritable (refs[0]);
+    assert (refs[0] != NULL);
+    assert (block_IsWritable (refs[0]));
+    assert (refs[0]->i_buffer == sizeof (text));
+    memset (refs[0]->p_buffer, 'A', 4);
+
+    /* Same size reallocation, then in place */
+    refs[1] = block_Realloc (refs[1], 0, sizeof (text));
+    assert (refs[1] != NULL);
+    refs[1] = block_MakeWritable (refs[1]);
+    assert (refs[1] != NULL);
+    memset (refs[1]->p_buffer + 4, 'B', 4);
+
+    assert (!memcmp (refs[2]->p_buffer, text, sizeof (text)));
+    assert (!memcmp (refs[0]->p_buffer, "AAAA", 4));
+    assert (!memcmp (refs[0]->p_buffer + 4, text + 4, sizeof (text) - 4));
+    assert (!memcmp (refs[1]->p_buffer, text, 4));
+    assert (!memcmp (refs[1]->p_buffer + 4, "BBBB", 4));
+
+    /* The last reference is still shared, but only with itself */
+    block_Release (refs[0]);
+    block_Release (refs[1]);
+    refs[2] = block_MakeWritable (refs[2]);
+    assert (refs[2] != NULL);
+    assert (!memcmp (refs[2]->p_buffer, text, sizeof (text)));
+    block_Release (refs[2]);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Share ();
+    test_block_ShareWrite ();
     return 0;
 }
 
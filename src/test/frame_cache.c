@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * frame_cache.c: test cases for the decoded video frames cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+#include <vlc_picture.h>
+#include "../input/frame_cache.h"
+
+static picture_t *NewPicture(const video_format_t *fmt, vlc_tick_t date)
+{
+    picture_t *pic = picture_NewFromFormat(fmt);
+    assert(pic != NULL);
+    pic->date = date;
+    memset(pic->p[0].p_pixels, date & 0xff,
+           pic->p[0].i_pitch * pic->p[0].i_lines);
+    return pic;
+}
+
+int main(void)
+{
+    video_format_t fmt, other;
+
+    video_format_Init(&fmt, VLC_CODEC_I420);
+    video_format_Init(&other, VLC_CODEC_I420);
+    video_format_Setup(&fmt, VLC_CODEC_I420, 64, 64, 64, 64, 1, 1);
+    video_format_Setup(&other, VLC_CODEC_I420, 32, 32, 32, 32, 1, 1);
+
+    picture_t *pic = NewPicture(&fmt, VLC_TICK_0);
+    size_t size = 0;
+    for (int i = 0; i < pic->i_planes; i++)
+        size += pic->p[i].i_pitch * pic->p[i].i_lines;
+    picture_Release(pic);
+
+    /* Room for 4 pictures */
+    frame_cache_t *cache = frame_cache_New(4 * size);
+    assert(cache != NULL);
+
+    /* Store out of order, as after a backward seek */
+    static const vlc_tick_t dates[] = { 50, 60, 70, 10, 20 };
+    for (size_t i = 0; i < ARRAY_SIZE(dates); i++)
+    {
+        pic = NewPicture(&fmt, dates[i]);
+        frame_cache_Put(cache, pic);
+        picture_Release(pic);
+    }
+
+    /* The first stored picture was evicted */
+    assert(!frame_cache_Has(cache, 50));
+    assert(frame_cache_Has(cache, 10));
+    assert(frame_cache_Has(cache, 70));
+    assert(!frame_cache_Has(cache, 15));
+
+    /* Pictures are returned in date order, with their pixels */
+    pic = frame_cache_Get(cache, VLC_TICK_INVALID, 100);
+    assert(pic != NULL && pic->date == 10);
+    assert(pic->p[0].p_pixels[0] == 10);
+    picture_Release(pic);
+    pic = frame_cache_Get(cache, 10, 100);
+    assert(pic != NULL && pic->date == 20);
+    picture_Release(pic);
+    pic = frame_cache_Get(cache, 20, 100);
+    assert(pic != NULL && pic->date == 60);
+    picture_Release(pic);
+    assert(frame_cache_Get(cache, 20, 59) == NULL);
+    assert(frame_cache_Get(cache, 70, 100) == NULL);
+
+    /* Returned pictures do not alias the cached properties */
+    pic = frame_cache_Get(cache, 60, 70);
+    assert(pic != NULL);
+    pic->date = 1000;
+    picture_Release(pic);
+    assert(frame_cache_Has(cache, 70));
+
+    /* A new format replaces the cached pictures */
+    pic = NewPicture(&other, 30);
+    frame_cache_Put(cache, pic);
+    picture_Release(pic);
+    assert(!frame_cache_Has(cache, 10));
+    assert(frame_cache_Has(cache, 30));
+
+    frame_cache_Clear(cache);
+    assert(!frame_cache_Has(cache, 30));
+    frame_cache_Delete(cache);
+    video_format_Clean(&fmt);
+    video_format_Clean(&other);
+    return 0;
+}
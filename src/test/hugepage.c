@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * hugepage.c: Test for huge page backed buffers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <vlc_common.h>
+#include "misc/hugepage.h"
+
+const char vlc_module_name[] = "test_hugepage";
+
+#define SIZE_2M ((size_t)2 << 20)
+
+static bool is_mapped(void *base, size_t size)
+{
+    if (msync(base, size, MS_ASYNC) == 0)
+        return true;
+    assert(errno == ENOMEM);
+    return false;
+}
+
+static unsigned char *alloc_check(size_t size, int *fdp)
+{
+    unsigned char *base = vlc_hugepage_Alloc(size, fdp);
+
+    assert(base != NULL);
+    assert(((uintptr_t)base % SIZE_2M) == 0);
+    /* Either a shareable huge page file, or anonymous transparent pages */
+    assert(*fdp == -1 || fcntl(*fdp, F_GETFD) != -1);
+    memset(base, 0x5A, size);
+    return base;
+}
+
+int main(void)
+{
+    const size_t size = 3 * SIZE_2M + 4096;
+    int fd, fd2;
+
+    /* Disabled by default: callers use their normal allocator */
+    assert(!vlc_hugepage_Usable(size));
+
+    vlc_hugepage_setup(true);
+    assert(vlc_hugepage_Usable(size));
+    assert(!vlc_hugepage_Usable(SIZE_2M));
+    /* The setting is fixed by the first instance */
+    vlc_hugepage_setup(false);
+    assert(vlc_hugepage_Usable(size));
+
+    /* Freed buffers are recycled for the same rounded size */
+    unsigned char *base = alloc_check(size, &fd);
+    vlc_hugepage_Free(base, size, fd);
+
+    unsigned char *base2 = alloc_check(size + 4096, &fd2);
+    assert(base2 == base && fd2 == fd);
+
+    /* But not for another size */
+    unsigned char *base3 = alloc_check(2 * size, &fd);
+    assert(base3 != base2);
+    vlc_hugepage_Free(base3, 2 * size, fd);
+    vlc_hugepage_Free(base2, size + 4096, fd2);
+    assert(is_mapped(base3, 2 * size));
+    assert(is_mapped(base2, size));
+
+    /* Cleanup returns the cached buffers to the system */
+    vlc_hugepage_cleanup();
+    assert(!is_mapped(base3, 2 * size));
+    assert(!is_mapped(base2, size));
+    assert(fd2 == -1 || fcntl(fd2, F_GETFD) == -1);
+
+    /* Allocation still works afterwards, whichever backing is available */
+    for (unsigned i = 0; i < 3; i++)
+    {
+        base = alloc_check(size, &fd);
+        vlc_hugepage_Free(base, size, fd);
+    }
+
+    /* The cache is trimmed even if nothing is allocated nor freed anymore */
+    vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_SEC(10);
+    while (is_mapped(base, size))
+    {
+        assert(vlc_tick_now() < deadline);
+        vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(100));
+    }
+    vlc_hugepage_cleanup();
+    return 0;
+}
@@ -22,7 +22,10 @@
 # include "config.h"
 #endif
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #undef NDEBUG
 #include <assert.h>
 
@@ -108,6 +111,113 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+/* Starved on the second check only, as if the last queued picture had been
+ * taken meanwhile */
+static bool starved(void *data)
+{
+    unsigned *checks = data;
+
+    return ++*checks >= 2;
+}
+
+static void test_growable(void)
+{
+    picture_t *pics[2 * PICTURES];
+
+    pool = picture_pool_NewGrowable(&fmt, PICTURES / 2, PICTURES);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == PICTURES / 2);
+
+    /* Get grows the pool immediately, up to the maximum */
+    for (unsigned i = 0; i < PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_GetSize(pool) == PICTURES);
+    assert(picture_pool_Get(pool) == NULL);
+
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+
+    /* WaitOrGrow grows the pool only once the caller is starved */
+    unsigned checks = 0;
+
+    pool = picture_pool_NewGrowable(&fmt, 1, 2);
+    assert(pool != NULL);
+    pics[0] = picture_pool_WaitOrGrow(pool, starved, &checks);
+    assert(pics[0] != NULL && checks == 0);
+    pics[1] = picture_pool_WaitOrGrow(pool, starved, &checks);
+    assert(pics[1] != NULL && checks == 2);
+    assert(picture_pool_GetSize(pool) == 2);
+
+    /* Pictures outlive their pool, including grown ones */
+    picture_pool_Release(pool);
+    picture_Release(pics[1]);
+    picture_Release(pics[0]);
+}
+
+/* Contention test: threads take pictures from a pool smaller than their
+ * number. A picture is never handed to two threads at once, and the pool
+ * never hands out more pictures than it has. */
+#define CONTENTION_THREADS 4
+#define CONTENTION_LOOPS 1000
+
+static atomic_uint in_use;
+
+static void *contention_thread(void *data)
+{
+    const unsigned char tag = (uintptr_t)data;
+
+    for (unsigned i = 0; i < CONTENTION_LOOPS; i++) {
+        picture_t *pic = picture_pool_Wait(pool);
+        assert(pic != NULL);
+
+        unsigned count = atomic_fetch_add(&in_use, 1) + 1;
+        assert(count <= CONTENTION_THREADS / 2);
+
+        /* Nobody else writes to the picture while it is held */
+        const plane_t *plane = &pic->p[0];
+        size_t size = plane->i_pitch * plane->i_lines;
+
+        memset(plane->p_pixels, tag, size);
+        for (size_t j = 0; j < size; j++)
+            assert(plane->p_pixels[j] == tag);
+
+        atomic_fetch_sub(&in_use, 1);
+        picture_Release(pic);
+    }
+    return NULL;
+}
+
+static void test_contention(void)
+{
+    vlc_thread_t th[CONTENTION_THREADS];
+
+    pool = picture_pool_NewFromFormat(&fmt, CONTENTION_THREADS / 2);
+    assert(pool != NULL);
+
+    for (unsigned i = 0; i < CONTENTION_THREADS; i++)
+        assert(vlc_clone(&th[i], contention_thread, (void *)(uintptr_t)i,
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    for (unsigned i = 0; i < CONTENTION_THREADS; i++)
+        vlc_join(th[i], NULL);
+
+    assert(atomic_load(&in_use) == 0);
+    assert(picture_pool_GetSize(pool) == CONTENTION_THREADS / 2);
+
+    /* All the pictures are back in the pool */
+    picture_t *pics[CONTENTION_THREADS / 2];
+    for (unsigned i = 0; i < ARRAY_SIZE(pics); i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+    for (unsigned i = 0; i < ARRAY_SIZE(pics); i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -124,6 +234,8 @@ int main(void)
 
     test(false);
     test(true);
+    test_growable();
+    test_contention();
 
     return 0;
 }
@@ -59,6 +59,7 @@
 #include "window.h"
 #include "../misc/variables.h"
 #include "../clock/clock.h"
+#include "../libvlc.h"
 
 /* Maximum delay between 2 displayed pictures.
  * XXX it is needed for now but should be removed in the long term.
@@ -217,10 +218,10 @@ static void vout_UpdateWindowSizeLocked(vout_thread_t *vout)
 
 /* */
 void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
-                            unsigned *restrict lost)
+                            unsigned *restrict lost, unsigned *restrict judder)
 {
     assert(!vout->p->dummy);
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, judder );
 }
 
 bool vout_IsEmpty(vout_thread_t *vout)
@@ -233,6 +234,18 @@ bool vout_IsEmpty(vout_thread_t *vout)
     if (picture)
         picture_Release(picture);
 
+    if (!picture && vout->p->filter_thread.enabled) {
+        vout_thread_sys_t *sys = vout->p;
+
+        vlc_mutex_lock(&sys->filter_thread.lock);
+        const bool empty = !sys->filter_thread.busy
+                        && sys->filter_thread.count == 0
+                        && sys->filter_thread.reuse == NULL
+                        && sys->filter_thread.pending == NULL
+                        && sys->filter_thread.reconfigure == NULL;
+        vlc_mutex_unlock(&sys->filter_thread.lock);
+        return empty;
+    }
     return !picture;
 }
 
@@ -350,6 +363,11 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
     assert(!vout->p->dummy);
     picture->p_next = NULL;
     picture_fifo_Push(vout->p->decoder_fifo, picture);
+    if (vout->p->filter_thread.enabled) {
+        vlc_mutex_lock(&vout->p->filter_thread.lock);
+        vlc_cond_signal(&vout->p->filter_thread.wait);
+        vlc_mutex_unlock(&vout->p->filter_thread.lock);
+    }
     vout_control_Wake(&vout->p->control);
 }
 
@@ -388,12 +406,23 @@ int vout_GetSnapshot(vout_thread_t *vout,
     return VLC_SUCCESS;
 }
 
+/* The refresh estimation must be restarted on display changes */
+static void vout_ResetVsync(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->display_lock);
+    sys->vsync_reset = true;
+    vlc_mutex_unlock(&sys->display_lock);
+}
+
 /* vout_Control* are usable by anyone at anytime */
 void vout_ChangeFullscreen(vout_thread_t *vout, const char *id)
 {
     assert(!vout->p->dummy);
     vlc_mutex_lock(&vout->p->window_lock);
     vout_window_SetFullScreen(vout->p->display_cfg.window, id);
+    vout_ResetVsync(vout);
     vlc_mutex_unlock(&vout->p->window_lock);
 }
 
@@ -403,6 +432,7 @@ void vout_ChangeWindowed(vout_thread_t *vout)
     vlc_mutex_lock(&vout->p->window_lock);
     vout_thread_sys_t *sys = vout->p;
     vout_window_UnsetFullScreen(sys->display_cfg.window);
+    vout_ResetVsync(vout);
     /* Attempt to reset the intended window size */
     vout_UpdateWindowSizeLocked(vout);
     vlc_mutex_unlock(&vout->p->window_lock);
@@ -427,6 +457,7 @@ void vout_ChangeDisplaySize(vout_thread_t *vout,
     vlc_mutex_lock(&sys->display_lock);
     if (sys->display != NULL)
         vout_display_SetSize(sys->display, width, height);
+    sys->vsync_reset = true;
     vlc_mutex_unlock(&sys->display_lock);
 }
 
@@ -712,6 +743,10 @@ static picture_t *VoutVideoFilterStaticNewPicture(filter_t *filter)
 {
     vout_thread_t *vout = filter->owner.sys;
 
+    // pictures filtered ahead of display would exhaust the display module pool
+    if (vout->p->filter_thread.enabled)
+        return picture_NewFromFormat(&filter->fmt_out.video);
+
     vlc_mutex_assert(&vout->p->filter.lock);
     if (filter_chain_IsEmpty(vout->p->filter.chain_interactive))
         // we may be using the last filter of both chains, so we get the picture
@@ -721,6 +756,77 @@ static picture_t *VoutVideoFilterStaticNewPicture(filter_t *filter)
     return picture_NewFromFormat(&filter->fmt_out.video);
 }
 
+/* Stops the filter thread after the picture being filtered, if any */
+static void ThreadFilterSuspend(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    if (!sys->filter_thread.enabled)
+        return;
+
+    vlc_mutex_lock(&sys->filter_thread.lock);
+    sys->filter_thread.suspended++;
+    while (sys->filter_thread.busy)
+        vlc_cond_wait(&sys->filter_thread.idle, &sys->filter_thread.lock);
+    vlc_mutex_unlock(&sys->filter_thread.lock);
+}
+
+static void ThreadFilterResume(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    if (!sys->filter_thread.enabled)
+        return;
+
+    vlc_mutex_lock(&sys->filter_thread.lock);
+    assert(sys->filter_thread.suspended > 0);
+    if (--sys->filter_thread.suspended == 0)
+        vlc_cond_signal(&sys->filter_thread.wait);
+    vlc_mutex_unlock(&sys->filter_thread.lock);
+}
+
+/* Puts the pictures filtered ahead of display back to the filter input, the
+ * last displayed one first, as after a flush of the filters they must be
+ * filtered again. */
+static void ThreadFilterRequeue(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *head = NULL, **tail = &head;
+    picture_t *prev = sys->displayed.decoded;
+
+    vlc_mutex_assert(&sys->filter_thread.lock);
+    assert(sys->filter_thread.suspended > 0 && !sys->filter_thread.busy);
+
+    if (sys->filter_thread.reuse != NULL)
+        picture_Release(sys->filter_thread.reuse);
+    sys->filter_thread.reuse = prev != NULL ? picture_Hold(prev) : NULL;
+
+    for (; sys->filter_thread.count > 0; sys->filter_thread.count--) {
+        struct vout_filtered_picture *entry =
+            &sys->filter_thread.queue[sys->filter_thread.first];
+
+        sys->filter_thread.first = (sys->filter_thread.first + 1)
+                                 % ARRAY_SIZE(sys->filter_thread.queue);
+        picture_Release(entry->filtered);
+        if (entry->decoded == prev) {
+            /* another output of the same decoded picture */
+            picture_Release(entry->decoded);
+            continue;
+        }
+        prev = entry->decoded;
+        *tail = prev;
+        tail = &prev->p_next;
+    }
+
+    if (sys->filter_thread.reconfigure != NULL) {
+        *tail = sys->filter_thread.reconfigure;
+        tail = &sys->filter_thread.reconfigure->p_next;
+        sys->filter_thread.reconfigure = NULL;
+    }
+    *tail = sys->filter_thread.pending;
+    sys->filter_thread.pending = head;
+}
+
 static void ThreadFilterFlush(vout_thread_t *vout, bool is_locked)
 {
     if (vout->p->displayed.current)
@@ -735,12 +841,23 @@ static void ThreadFilterFlush(vout_thread_t *vout, bool is_locked)
         vout->p->displayed.next = NULL;
     }
 
+    if (vout->p->filter_thread.enabled) {
+        /* the filter thread may be waiting for the lock */
+        assert(!is_locked);
+        ThreadFilterSuspend(vout);
+        vlc_mutex_lock(&vout->p->filter_thread.lock);
+        ThreadFilterRequeue(vout);
+        vlc_mutex_unlock(&vout->p->filter_thread.lock);
+    }
+
     if (!is_locked)
         vlc_mutex_lock(&vout->p->filter.lock);
     filter_chain_VideoFlush(vout->p->filter.chain_static);
     filter_chain_VideoFlush(vout->p->filter.chain_interactive);
     if (!is_locked)
         vlc_mutex_unlock(&vout->p->filter.lock);
+
+    ThreadFilterResume(vout);
 }
 
 typedef struct {
@@ -753,6 +870,7 @@ static void ThreadChangeFilters(vout_thread_t *vout,
                                 const bool *new_deinterlace,
                                 bool is_locked)
 {
+    ThreadFilterSuspend(vout);
     ThreadFilterFlush(vout, is_locked);
     ThreadDelAllFilterCallbacks(vout);
 
@@ -869,15 +987,348 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 
     if (!is_locked)
         vlc_mutex_unlock(&vout->p->filter.lock);
+
+    ThreadFilterResume(vout);
+}
+
+/*****************************************************************************
+ * FilterThread: runs the static filters ahead of display
+ *****************************************************************************/
+static bool FilterThreadHasInput(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_assert(&sys->filter_thread.lock);
+    if (sys->filter_thread.suspended > 0
+     || sys->filter_thread.reconfigure != NULL)
+        return false;
+    if (sys->filter_thread.reuse != NULL || sys->filter_thread.pending != NULL)
+        return true;
+
+    picture_t *picture = picture_fifo_Peek(sys->decoder_fifo);
+    if (picture == NULL)
+        return false;
+    picture_Release(picture);
+    return true;
+}
+
+static picture_t *FilterThreadPop(vout_thread_t *vout, bool *reused)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *decoded;
+
+    vlc_mutex_assert(&sys->filter_thread.lock);
+    *reused = false;
+    if (sys->filter_thread.suspended > 0
+     || sys->filter_thread.reconfigure != NULL
+     || sys->filter_thread.count >= VOUT_FILTER_QUEUE)
+        return NULL;
+
+    if (sys->filter_thread.reuse != NULL) {
+        decoded = sys->filter_thread.reuse;
+        sys->filter_thread.reuse = NULL;
+        *reused = true;
+    } else if (sys->filter_thread.pending != NULL) {
+        decoded = sys->filter_thread.pending;
+        sys->filter_thread.pending = decoded->p_next;
+        decoded->p_next = NULL;
+    } else
+        decoded = picture_fifo_Pop(sys->decoder_fifo);
+    return decoded;
 }
 
+static void *FilterThread(void *object)
+{
+    vout_thread_t *vout = object;
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->filter_thread.lock);
+    for (;;) {
+        picture_t *decoded;
+        bool reused;
+
+        while (!sys->filter_thread.stop
+            && (decoded = FilterThreadPop(vout, &reused)) == NULL)
+            vlc_cond_wait(&sys->filter_thread.wait, &sys->filter_thread.lock);
+        if (sys->filter_thread.stop)
+            break;
+        sys->filter_thread.busy = true;
+        vlc_mutex_unlock(&sys->filter_thread.lock);
+
+        /* The queue has room for the outputs of at least one picture */
+        picture_t *filtered[VOUT_FILTER_QUEUE + 1];
+        size_t count = 0;
+
+        /* The static filters and the source format are only changed while
+         * this thread is suspended, so they are used without filter.lock:
+         * the vout thread never waits for a static filter to render. */
+
+        /* A new format is applied by the vout thread, once the pictures of the
+         * previous format are displayed */
+        const bool reconfigure = !reused &&
+            !VideoFormatIsCropArEqual(&decoded->format, &sys->filter.src_fmt);
+        if (!reconfigure) {
+            picture_t *picture = filter_chain_VideoFilter(sys->filter.chain_static,
+                                                          picture_Hold(decoded));
+            while (picture != NULL) {
+                if (count < ARRAY_SIZE(filtered))
+                    filtered[count++] = picture;
+                else {
+                    picture_Release(picture);
+                    vout_statistic_AddLost(&sys->statistic, 1);
+                }
+                picture = filter_chain_VideoFilter(sys->filter.chain_static, NULL);
+            }
+        }
+
+        vlc_mutex_lock(&sys->filter_thread.lock);
+        if (reconfigure)
+            sys->filter_thread.reconfigure = picture_Hold(decoded);
+        for (size_t i = 0; i < count; i++) {
+            const size_t index = (sys->filter_thread.first + sys->filter_thread.count++)
+                               % ARRAY_SIZE(sys->filter_thread.queue);
+
+            assert(sys->filter_thread.count <= ARRAY_SIZE(sys->filter_thread.queue));
+            sys->filter_thread.queue[index] = (struct vout_filtered_picture) {
+                .decoded = picture_Hold(decoded),
+                .filtered = filtered[i],
+                .first = i == 0,
+                .reused = reused,
+            };
+        }
+        sys->filter_thread.busy = false;
+        vlc_cond_broadcast(&sys->filter_thread.idle);
+        vlc_mutex_unlock(&sys->filter_thread.lock);
+
+        picture_Release(decoded);
+        vout_control_Wake(&sys->control);
+
+        vlc_mutex_lock(&sys->filter_thread.lock);
+    }
+    vlc_mutex_unlock(&sys->filter_thread.lock);
+    return NULL;
+}
+
+static void FilterThreadStart(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    sys->filter_thread.stop = false;
+    sys->filter_thread.busy = false;
+    sys->filter_thread.suspended = 0;
+    sys->filter_thread.reuse = NULL;
+    sys->filter_thread.pending = NULL;
+    sys->filter_thread.reconfigure = NULL;
+    sys->filter_thread.first = 0;
+    sys->filter_thread.count = 0;
+
+    sys->filter_thread.enabled = var_InheritBool(vout, "video-filter-thread");
+    if (sys->filter_thread.enabled
+     && vlc_clone(&sys->filter_thread.thread, FilterThread, vout,
+                  VLC_THREAD_PRIORITY_VIDEO)) {
+        msg_Warn(vout, "cannot run the video filters ahead of display");
+        sys->filter_thread.enabled = false;
+    }
+}
+
+static void FilterThreadStop(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    if (!sys->filter_thread.enabled)
+        return;
+
+    vlc_mutex_lock(&sys->filter_thread.lock);
+    sys->filter_thread.stop = true;
+    vlc_cond_signal(&sys->filter_thread.wait);
+    vlc_mutex_unlock(&sys->filter_thread.lock);
+    vlc_join(sys->filter_thread.thread, NULL);
+    sys->filter_thread.enabled = false;
+
+    for (; sys->filter_thread.count > 0; sys->filter_thread.count--) {
+        struct vout_filtered_picture *entry =
+            &sys->filter_thread.queue[sys->filter_thread.first];
+
+        sys->filter_thread.first = (sys->filter_thread.first + 1)
+                                 % ARRAY_SIZE(sys->filter_thread.queue);
+        picture_Release(entry->filtered);
+        picture_Release(entry->decoded);
+    }
+    if (sys->filter_thread.reuse != NULL)
+        picture_Release(sys->filter_thread.reuse);
+    if (sys->filter_thread.reconfigure != NULL)
+        picture_Release(sys->filter_thread.reconfigure);
+    while (sys->filter_thread.pending != NULL) {
+        picture_t *picture = sys->filter_thread.pending;
+
+        sys->filter_thread.pending = picture->p_next;
+        picture->p_next = NULL;
+        picture_Release(picture);
+    }
+}
+
+/* Tells whether a decoded picture is too late to be displayed */
+static bool ThreadIsPictureLate(vout_thread_t *vout, const picture_t *decoded,
+                                bool *paused)
+{
+    vout_thread_sys_t *sys = vout->p;
+    const vlc_tick_t date = vlc_tick_now();
+    const vlc_tick_t system_pts =
+        vlc_clock_ConvertToSystem(sys->clock, date, decoded->date, sys->rate);
+
+    vlc_tick_t late;
+    if (system_pts == INT64_MAX)
+    {
+        /* The clock is paused, notify it (so that the current
+         * picture is displayed but not the next one), this
+         * current picture can't be be late. */
+        *paused = true;
+        late = 0;
+    }
+    else
+        late = date - system_pts;
+
+    vlc_tick_t late_threshold;
+    if (decoded->format.i_frame_rate && decoded->format.i_frame_rate_base)
+        late_threshold = VLC_TICK_FROM_MS(500) * decoded->format.i_frame_rate_base / decoded->format.i_frame_rate;
+    else
+        late_threshold = VOUT_DISPLAY_LATE_THRESHOLD;
+    if (late > late_threshold) {
+        msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", MS_FROM_VLC_TICK(late));
+        return true;
+    } else if (late > 0) {
+        msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", MS_FROM_VLC_TICK(late));
+    }
+    return false;
+}
+
+/* Takes the next picture filtered ahead of display, waiting for the filter
+ * thread if it has pending input and wait is set. */
+static bool ThreadFilterQueuePop(vout_thread_t *vout,
+                                 struct vout_filtered_picture *entry, bool wait)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->filter_thread.lock);
+    if (wait)
+        while (sys->filter_thread.count == 0
+            && (sys->filter_thread.busy || FilterThreadHasInput(vout)))
+            vlc_cond_wait(&sys->filter_thread.idle, &sys->filter_thread.lock);
+
+    const bool ok = sys->filter_thread.count > 0;
+    if (ok) {
+        *entry = sys->filter_thread.queue[sys->filter_thread.first];
+        sys->filter_thread.first = (sys->filter_thread.first + 1)
+                                 % ARRAY_SIZE(sys->filter_thread.queue);
+        sys->filter_thread.count--;
+        vlc_cond_signal(&sys->filter_thread.wait);
+    }
+    vlc_mutex_unlock(&sys->filter_thread.lock);
+    return ok;
+}
+
+/* Resets the filters for a picture of a new format, once all the pictures of
+ * the previous format were taken */
+static bool ThreadFilterReconfigure(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->filter_thread.lock);
+    picture_t *decoded = sys->filter_thread.count == 0 ?
+                         sys->filter_thread.reconfigure : NULL;
+    if (decoded != NULL) {
+        /* the filter thread stopped after setting the picture aside */
+        assert(!sys->filter_thread.busy);
+        sys->filter_thread.reconfigure = NULL;
+        /* do not filter the next pictures with the previous filters */
+        sys->filter_thread.suspended++;
+    }
+    vlc_mutex_unlock(&sys->filter_thread.lock);
+
+    if (decoded == NULL)
+        return false;
+
+    vlc_video_context *pic_vctx = picture_GetVideoContext(decoded);
+
+    vlc_mutex_lock(&sys->filter.lock);
+    video_format_Clean(&sys->filter.src_fmt);
+    video_format_Copy(&sys->filter.src_fmt, &decoded->format);
+    if (sys->filter.src_vctx)
+        vlc_video_context_Release(sys->filter.src_vctx);
+    sys->filter.src_vctx = pic_vctx ? vlc_video_context_Hold(pic_vctx) : NULL;
+    vlc_mutex_unlock(&sys->filter.lock);
+
+    /* the picture is filtered again first, after the filters reset */
+    if (sys->displayed.decoded)
+        picture_Release(sys->displayed.decoded);
+    sys->displayed.decoded       = decoded;
+    sys->displayed.timestamp     = decoded->date;
+    sys->displayed.is_interlaced = !decoded->b_progressive;
+
+    ThreadChangeFilters(vout, NULL, NULL, false);
+    ThreadFilterResume(vout);
+    return true;
+}
+
+static int ThreadDisplayPrepareFiltered(vout_thread_t *vout,
+                                        bool frame_by_frame, bool *paused)
+{
+    vout_thread_sys_t *sys = vout->p;
+    bool is_late_dropped = sys->is_late_dropped && !sys->pause.is_on && !frame_by_frame;
+    const picture_t *dropped = NULL;
+    struct vout_filtered_picture entry;
+
+    for (;;) {
+        if (!ThreadFilterQueuePop(vout, &entry, frame_by_frame)) {
+            if (ThreadFilterReconfigure(vout))
+                continue;
+            return VLC_EGENERIC;
+        }
+
+        if (!entry.first && entry.decoded == dropped) {
+            picture_Release(entry.filtered);
+            picture_Release(entry.decoded);
+            continue;
+        }
+        if (entry.first && !entry.reused && is_late_dropped
+         && !entry.decoded->b_force
+         && ThreadIsPictureLate(vout, entry.decoded, paused)) {
+            /* drop the other outputs of the picture as well */
+            dropped = entry.decoded;
+            picture_Release(entry.filtered);
+            picture_Release(entry.decoded);
+            vout_statistic_AddLost(&sys->statistic, 1);
+            continue;
+        }
+        break;
+    }
+
+    if (sys->displayed.decoded != entry.decoded) {
+        if (sys->displayed.decoded)
+            picture_Release(sys->displayed.decoded);
+        sys->displayed.decoded       = entry.decoded;
+        sys->displayed.timestamp     = entry.decoded->date;
+        sys->displayed.is_interlaced = !entry.decoded->b_progressive;
+    } else
+        picture_Release(entry.decoded);
+
+    assert(!sys->displayed.next);
+    if (!sys->displayed.current)
+        sys->displayed.current = entry.filtered;
+    else
+        sys->displayed.next    = entry.filtered;
+    return VLC_SUCCESS;
+}
 
 /* */
 static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse,
                                        bool frame_by_frame, bool *paused)
 {
     bool is_late_dropped = vout->p->is_late_dropped && !vout->p->pause.is_on && !frame_by_frame;
-    vout_thread_sys_t *sys = vout->p;
+
+    if (vout->p->filter_thread.enabled)
+        /* the last decoded picture was put back to the filter thread */
+        return ThreadDisplayPrepareFiltered(vout, frame_by_frame, paused);
 
     vlc_mutex_lock(&vout->p->filter.lock);
 
@@ -892,37 +1343,11 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse,
             decoded = picture_fifo_Pop(vout->p->decoder_fifo);
 
             if (decoded) {
-                if (is_late_dropped && !decoded->b_force) {
-                    const vlc_tick_t date = vlc_tick_now();
-                    const vlc_tick_t system_pts =
-                        vlc_clock_ConvertToSystem(vout->p->clock, date,
-                                                  decoded->date, sys->rate);
-
-                    vlc_tick_t late;
-                    if (system_pts == INT64_MAX)
-                    {
-                        /* The clock is paused, notify it (so that the current
-                         * picture is displayed but not the next one), this
-                         * current picture can't be be late. */
-                        *paused = true;
-                        late = 0;
-                    }
-                    else
-                        late = date - system_pts;
-
-                    vlc_tick_t late_threshold;
-                    if (decoded->format.i_frame_rate && decoded->format.i_frame_rate_base)
-                        late_threshold = VLC_TICK_FROM_MS(500) * decoded->format.i_frame_rate_base / decoded->format.i_frame_rate;
-                    else
-                        late_threshold = VOUT_DISPLAY_LATE_THRESHOLD;
-                    if (late > late_threshold) {
-                        msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", MS_FROM_VLC_TICK(late));
-                        picture_Release(decoded);
-                        vout_statistic_AddLost(&vout->p->statistic, 1);
-                        continue;
-                    } else if (late > 0) {
-                        msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", MS_FROM_VLC_TICK(late));
-                    }
+                if (is_late_dropped && !decoded->b_force
+                 && ThreadIsPictureLate(vout, decoded, paused)) {
+                    picture_Release(decoded);
+                    vout_statistic_AddLost(&vout->p->statistic, 1);
+                    continue;
                 }
                 vlc_video_context *pic_vctx = picture_GetVideoContext(decoded);
                 if (!VideoFormatIsCropArEqual(&decoded->format, &vout->p->filter.src_fmt))
@@ -1030,6 +1455,80 @@ static picture_t *ConvertRGB32AndBlend(vout_thread_t *vout, picture_t *pic,
     return NULL;
 }
 
+/* Refresh on which a picture due at the given date should be presented, or
+ * VLC_TICK_INVALID if the display refresh is not known */
+static vlc_tick_t ThreadVsyncSlot(vout_thread_sys_t *sys, vlc_tick_t system_pts)
+{
+    if (!sys->vsync_pacing || !vout_vsync_IsLocked(&sys->vsync))
+        return VLC_TICK_INVALID;
+    return vout_vsync_Quantize(&sys->vsync, system_pts);
+}
+
+/* Date at which to present a picture due at the given date. A display
+ * synchronized on the refresh shows it on the next refresh, so present it a
+ * bit before the nearest one. */
+static vlc_tick_t ThreadVsyncPresentDate(vout_thread_sys_t *sys,
+                                         vlc_tick_t system_pts)
+{
+    const vlc_tick_t slot = ThreadVsyncSlot(sys, system_pts);
+
+    if (slot == VLC_TICK_INVALID)
+        return system_pts;
+    return slot - sys->vsync.period / 4;
+}
+
+/* Drops the next picture if it would be presented on the same refresh as the
+ * current one, when the frame rate is higher than the refresh rate */
+static void ThreadVsyncDropNext(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *current = sys->displayed.current;
+    picture_t *next = sys->displayed.next;
+
+    if (next == NULL || next->b_force || !sys->is_late_dropped)
+        return;
+
+    const vlc_tick_t system_now = vlc_tick_now();
+    const vlc_tick_t current_pts =
+        vlc_clock_ConvertToSystem(sys->clock, system_now, current->date,
+                                  sys->rate);
+    const vlc_tick_t next_pts =
+        vlc_clock_ConvertToSystem(sys->clock, system_now, next->date,
+                                  sys->rate);
+    if (current_pts == INT64_MAX || next_pts == INT64_MAX)
+        return;
+
+    const vlc_tick_t current_slot = ThreadVsyncSlot(sys, current_pts);
+    if (current_slot == VLC_TICK_INVALID
+     || ThreadVsyncSlot(sys, next_pts) > current_slot)
+        return;
+
+    picture_Release(next);
+    sys->displayed.next = NULL;
+    vout_statistic_AddLost(&sys->statistic, 1);
+}
+
+static void ThreadVsyncPresented(vout_thread_t *vout, vlc_tick_t slot)
+{
+    vout_thread_sys_t *sys = vout->p;
+    const vlc_tick_t date = vlc_tick_now();
+    const bool was_locked = vout_vsync_IsLocked(&sys->vsync);
+
+    /* A picture presented on another refresh than its own one breaks the
+     * cadence */
+    if (slot != VLC_TICK_INVALID && llabs(date - slot) > sys->vsync.period / 2)
+        vout_statistic_AddJudder(&sys->statistic, 1);
+
+    vout_vsync_Present(&sys->vsync, date);
+
+    const bool locked = vout_vsync_IsLocked(&sys->vsync);
+    if (locked && !was_locked)
+        msg_Dbg(vout, "display refresh period: %"PRId64" us",
+                US_FROM_VLC_TICK(sys->vsync.period));
+    else if (!locked && was_locked)
+        msg_Dbg(vout, "display refresh period lost");
+}
+
 static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 {
     vout_thread_sys_t *sys = vout->p;
@@ -1052,6 +1551,11 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     vlc_mutex_lock(&sys->display_lock);
 
+    if (sys->vsync_reset) {
+        sys->vsync_reset = false;
+        vout_vsync_Reset(&sys->vsync);
+    }
+
     /*
      * Get the subpicture to be displayed
      */
@@ -1217,6 +1721,11 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     const unsigned frame_rate = todisplay->format.i_frame_rate;
     const unsigned frame_rate_base = todisplay->format.i_frame_rate_base;
 
+    const vlc_tick_t slot = is_forced ? VLC_TICK_INVALID
+                                      : ThreadVsyncSlot(sys, system_pts);
+    const vlc_tick_t present_date = slot != VLC_TICK_INVALID ?
+        slot - sys->vsync.period / 4 : system_pts;
+
     if (vd->prepare != NULL)
         vd->prepare(vd, todisplay, do_dr_spu ? subpic : NULL, system_pts);
 
@@ -1239,11 +1748,13 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
              * rendered late. */
             system_pts = system_now;
         }
-        else
+        else if (system_now <= present_date)
         {
-            /* Wait to reach system_pts */
-            vlc_clock_Wait(sys->clock, system_now, pts, sys->rate,
-                           VOUT_REDISPLAY_DELAY);
+            /* Wait to reach the presentation date, i.e. system_pts unless
+             * paced on the display refresh */
+            vlc_clock_Wait(sys->clock, system_now,
+                           pts + (present_date - system_pts) * sys->rate,
+                           sys->rate, VOUT_REDISPLAY_DELAY);
 
             /* Don't touch system_pts. Tell the clock that the pts was rendered
              * at the expected date */
@@ -1261,6 +1772,8 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout_display_Display(vd, todisplay);
+    if (sys->vsync_pacing)
+        ThreadVsyncPresented(vout, slot);
     vlc_mutex_unlock(&sys->display_lock);
 
     if (subpic)
@@ -1287,7 +1800,8 @@ static int ThreadDisplayPicture(vout_thread_t *vout, vlc_tick_t *deadline)
     if (!paused || frame_by_frame)
         while (!sys->displayed.next
             && !ThreadDisplayPreparePicture(vout, false, frame_by_frame, &paused))
-            ;
+            if (!frame_by_frame)
+                ThreadVsyncDropNext(vout);
 
     const vlc_tick_t system_now = vlc_tick_now();
     const vlc_tick_t render_delay = vout_chrono_GetHigh(&sys->render) + VOUT_MWAIT_TOLERANCE;
@@ -1306,7 +1820,8 @@ static int ThreadDisplayPicture(vout_thread_t *vout, vlc_tick_t *deadline)
             paused = true;
         }
         {
-            date_next = next_system_pts - render_delay;
+            date_next = ThreadVsyncPresentDate(sys, next_system_pts)
+                      - render_delay;
             if (date_next <= system_now)
                 drop_next_frame = true;
         }
@@ -1387,6 +1902,7 @@ static void vout_FlushUnlocked(vout_thread_t *vout, bool below,
     sys->step.timestamp = VLC_TICK_INVALID;
     sys->step.last      = VLC_TICK_INVALID;
 
+    ThreadFilterSuspend(vout);
     ThreadFilterFlush(vout, false); /* FIXME too much */
 
     picture_t *last = sys->displayed.decoded;
@@ -1402,11 +1918,35 @@ static void vout_FlushUnlocked(vout_thread_t *vout, bool below,
         }
     }
 
+    if (sys->filter_thread.enabled) {
+        /* the pictures put back to the filter thread are flushed likewise */
+        vlc_mutex_lock(&sys->filter_thread.lock);
+        if (sys->filter_thread.reuse != NULL && sys->displayed.decoded == NULL) {
+            picture_Release(sys->filter_thread.reuse);
+            sys->filter_thread.reuse = NULL;
+        }
+        for (picture_t **pp = &sys->filter_thread.pending; *pp != NULL;) {
+            picture_t *picture = *pp;
+
+            if ((date == VLC_TICK_INVALID) ||
+                ( below && picture->date <= date) ||
+                (!below && picture->date >= date)) {
+                *pp = picture->p_next;
+                picture->p_next = NULL;
+                picture_Release(picture);
+            } else
+                pp = &picture->p_next;
+        }
+        vlc_mutex_unlock(&sys->filter_thread.lock);
+    }
+
     picture_fifo_Flush(sys->decoder_fifo, date, below);
+    ThreadFilterResume(vout);
 
     assert(sys->display != NULL);
     vlc_mutex_lock(&sys->display_lock);
     vout_FilterFlush(sys->display);
+    sys->vsync_reset = true;
     vlc_mutex_unlock(&sys->display_lock);
 
     vlc_clock_Reset(sys->clock);
@@ -1497,6 +2037,9 @@ static void ThreadProcessMouseState(vout_thread_t *vout,
 
     /* Then pass up the filter chains. */
     m = &vid_mouse;
+    /* The static filters may be running on the filter thread. The chain is
+     * not changed meanwhile, and their mouse callbacks only depend on their
+     * configuration. */
     vlc_mutex_lock(&vout->p->filter.lock);
     if (vout->p->filter.chain_static && vout->p->filter.chain_interactive) {
         if (!filter_chain_MouseFilter(vout->p->filter.chain_interactive,
@@ -1627,6 +2170,9 @@ static int vout_Start(vout_thread_t *vout, vlc_video_context *vctx, const vout_c
     sys->displayed.timestamp     = VLC_TICK_INVALID;
     sys->displayed.is_interlaced = false;
 
+    vout_vsync_Init(&sys->vsync);
+    sys->vsync_reset = false;
+
     sys->step.last               = VLC_TICK_INVALID;
     sys->step.timestamp          = VLC_TICK_INVALID;
 
@@ -1636,6 +2182,8 @@ static int vout_Start(vout_thread_t *vout, vlc_video_context *vctx, const vout_c
     sys->spu_blend_chroma        = 0;
     sys->spu_blend               = NULL;
 
+    FilterThreadStart(vout);
+
     video_format_Print(VLC_OBJECT(vout), "original format", &sys->original);
     return VLC_SUCCESS;
 error:
@@ -1698,6 +2246,8 @@ noreturn static void *Thread(void *object)
     vlc_tick_t deadline = VLC_TICK_INVALID;
     bool wait = false;
 
+    vlc_thread_ApplyPolicy(VLC_OBJECT(vout), VLC_THREAD_VIDEO_OUTPUT);
+
     for (;;) {
         vout_control_cmd_t cmd;
 
@@ -1734,6 +2284,8 @@ static void vout_ReleaseDisplay(vout_thread_t *vout)
     if (sys->spu_blend != NULL)
         filter_DeleteBlend(sys->spu_blend);
 
+    FilterThreadStop(vout);
+
     /* Destroy the rendering display */
     if (sys->display_pool != NULL)
         vout_FlushUnlocked(vout, true, INT64_MAX);
@@ -1848,6 +2400,9 @@ void vout_Release(vout_thread_t *vout)
     /* Destroy the locks */
     vlc_mutex_destroy(&sys->window_lock);
     vlc_mutex_destroy(&sys->filter.lock);
+    vlc_mutex_destroy(&sys->filter_thread.lock);
+    vlc_cond_destroy(&sys->filter_thread.wait);
+    vlc_cond_destroy(&sys->filter_thread.idle);
 
     if (sys->dec_device)
         vlc_decoder_device_Release(sys->dec_device);
@@ -1940,8 +2495,13 @@ vout_thread_t *vout_Create(vlc_object_t *object)
     vout_InitInterlacingSupport(vout);
 
     sys->is_late_dropped = var_InheritBool(vout, "drop-late-frames");
+    sys->vsync_pacing = var_InheritBool(vout, "vsync-pacing");
 
     vlc_mutex_init(&sys->filter.lock);
+    vlc_mutex_init(&sys->filter_thread.lock);
+    vlc_cond_init(&sys->filter_thread.wait);
+    vlc_cond_init(&sys->filter_thread.idle);
+    sys->filter_thread.enabled = false;
 
     /* Display */
     sys->display = NULL;
@@ -32,6 +32,7 @@
 #include "vout_wrapper.h"
 #include "statistic.h"
 #include "chrono.h"
+#include "vsync.h"
 #include "../clock/clock.h"
 #include "../input/input_internal.h"
 
@@ -43,6 +44,9 @@
  */
 #define VOUT_MAX_PICTURES (20)
 
+/* Number of pictures filtered ahead of display by the filter thread */
+#define VOUT_FILTER_QUEUE (3)
+
 /**
  * Vout configuration
  */
@@ -164,6 +168,31 @@ struct vout_thread_sys_t
         bool            has_deint;
     } filter;
 
+    /* Static filters run ahead of display (video-filter-thread). Unless it is
+     * suspended, the thread uses filter.chain_static and filter.src_fmt
+     * without filter.lock. */
+    struct {
+        bool            enabled;
+        vlc_thread_t    thread;
+        vlc_mutex_t     lock;
+        vlc_cond_t      wait;
+        vlc_cond_t      idle;
+        bool            stop;
+        bool            busy;
+        unsigned        suspended;
+        picture_t       *reuse;       // last decoded picture, to filter again
+        picture_t       *pending;     // decoded pictures to filter before the decoder_fifo ones
+        picture_t       *reconfigure; // decoded picture of a new format, waiting for the filters
+        struct vout_filtered_picture {
+            picture_t   *decoded;
+            picture_t   *filtered;
+            bool        first;        // first output for the decoded picture
+            bool        reused;
+        } queue[2 * VOUT_FILTER_QUEUE];
+        size_t          first;
+        size_t          count;
+    } filter_thread;
+
     /* */
     vlc_mouse_t     mouse;
     vlc_mouse_event mouse_event;
@@ -184,6 +213,11 @@ struct vout_thread_sys_t
     picture_fifo_t  *decoder_fifo;
     vout_chrono_t   render;           /**< picture render time estimator */
 
+    /* Presentation on the display refresh */
+    bool            vsync_pacing;
+    bool            vsync_reset; /* display changed, under display_lock */
+    vout_vsync_t    vsync;
+
     atomic_uintptr_t refs;
 };
 
@@ -327,7 +361,7 @@ void vout_MouseState(vout_thread_t *, const vlc_mouse_t *);
  * This function will return and reset internal statistics.
  */
 void vout_GetResetStatistic( vout_thread_t *p_vout, unsigned *pi_displayed,
-                             unsigned *pi_lost );
+                             unsigned *pi_lost, unsigned *pi_judder );
 
 /**
  * This function will force to display the next picture while paused
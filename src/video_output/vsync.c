@@ -0,0 +1,215 @@
+/*****************************************************************************
+ * vsync.c: display refresh estimation
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef TEST_VSYNC
+# undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include "vsync.h"
+
+/* Supported refresh rates, from 300 Hz down to 23 Hz */
+#define VSYNC_PERIOD_MIN VLC_TICK_FROM_US(3333)
+#define VSYNC_PERIOD_MAX VLC_TICK_FROM_US(43479)
+
+/* Wake up jitter tolerated when searching a common period */
+#define VSYNC_JITTER VLC_TICK_FROM_MS(1)
+
+/* Consistent presentations needed to trust the estimation */
+#define VSYNC_LOCK_COUNT (16)
+/* Inconsistent presentations after which the estimation is dropped */
+#define VSYNC_MISS_COUNT (8)
+
+void vout_vsync_Init(vout_vsync_t *vsync)
+{
+    vout_vsync_Reset(vsync);
+}
+
+void vout_vsync_Reset(vout_vsync_t *vsync)
+{
+    vsync->period = VLC_TICK_INVALID;
+    vsync->last = VLC_TICK_INVALID;
+    vsync->hits = 0;
+    vsync->misses = 0;
+}
+
+/* Largest period of which both durations are multiples, up to the jitter */
+static vlc_tick_t vout_vsync_CommonPeriod(vlc_tick_t a, vlc_tick_t b)
+{
+    if (a < b) {
+        vlc_tick_t t = a;
+        a = b;
+        b = t;
+    }
+
+    while (b >= VSYNC_PERIOD_MIN) {
+        vlc_tick_t r = a % b;
+
+        if (r <= VSYNC_JITTER || b - r <= VSYNC_JITTER)
+            return b;
+        a = b;
+        b = r;
+    }
+    return VLC_TICK_INVALID;
+}
+
+unsigned vout_vsync_Present(vout_vsync_t *vsync, vlc_tick_t date)
+{
+    const vlc_tick_t last = vsync->last;
+
+    vsync->last = date;
+    if (last == VLC_TICK_INVALID || date <= last)
+        return 0;
+
+    const vlc_tick_t duration = date - last;
+
+    if (vsync->period == VLC_TICK_INVALID) {
+        /* The first duration may span several refresh periods, it is
+         * refined by the next ones */
+        if (duration < VSYNC_PERIOD_MIN)
+            return 0;
+        vsync->period = duration;
+        return 1;
+    }
+
+    const vlc_tick_t n = (duration + vsync->period / 2) / vsync->period;
+    const vlc_tick_t error = duration - n * vsync->period;
+
+    if (n > 0 && llabs(error) <= vsync->period / 8) {
+        vsync->period += error / (8 * n);
+        if (vsync->hits < VSYNC_LOCK_COUNT)
+            vsync->hits++;
+        vsync->misses = 0;
+        return n;
+    }
+
+    if (vout_vsync_IsLocked(vsync)) {
+        /* Tolerate a few outliers, a late wake up for instance */
+        if (++vsync->misses >= VSYNC_MISS_COUNT)
+            vout_vsync_Reset(vsync);
+        return 0;
+    }
+
+    /* The estimation may be a multiple of the refresh period, as when no
+     * pictures were presented on consecutive refreshes so far */
+    const vlc_tick_t period = vout_vsync_CommonPeriod(vsync->period, duration);
+
+    vsync->hits = 0;
+    if (period == VLC_TICK_INVALID) {
+        vsync->period = duration >= VSYNC_PERIOD_MIN ? duration
+                                                     : VLC_TICK_INVALID;
+        return 0;
+    }
+    vsync->period = period;
+    return (duration + period / 2) / period;
+}
+
+bool vout_vsync_IsLocked(const vout_vsync_t *vsync)
+{
+    return vsync->hits >= VSYNC_LOCK_COUNT
+        && vsync->period <= VSYNC_PERIOD_MAX;
+}
+
+vlc_tick_t vout_vsync_Quantize(const vout_vsync_t *vsync, vlc_tick_t date)
+{
+    assert(vout_vsync_IsLocked(vsync));
+
+    const vlc_tick_t delta = date - vsync->last;
+    const vlc_tick_t n = (delta >= 0 ? delta + vsync->period / 2
+                                     : delta - vsync->period / 2)
+                       / vsync->period;
+
+    return vsync->last + n * vsync->period;
+}
+
+#ifdef TEST_VSYNC
+
+/* Presents pictures of the given frame period on a display of the given
+ * refresh period, with some wake up jitter */
+static void Simulate(vout_vsync_t *vsync, vlc_tick_t refresh,
+                     vlc_tick_t frame, unsigned count)
+{
+    vlc_tick_t pts = VLC_TICK_FROM_SEC(1);
+    unsigned seed = 42;
+
+    for (unsigned i = 0; i < count; i++) {
+        /* A synchronized display presents on the next refresh */
+        vlc_tick_t vblank = (pts + refresh - 1) / refresh * refresh;
+
+        seed = seed * 1103515245 + 12345;
+        vout_vsync_Present(vsync, vblank + (seed >> 16) % 500);
+        pts += frame;
+    }
+}
+
+int main(void)
+{
+    vout_vsync_t vsync;
+    const vlc_tick_t hz60 = VLC_TICK_FROM_US(16667);
+    const vlc_tick_t hz50 = VLC_TICK_FROM_MS(20);
+
+    /* 24 fps on 60 Hz: pictures are never presented on consecutive
+     * refreshes, the period is still found */
+    vout_vsync_Init(&vsync);
+    assert(!vout_vsync_IsLocked(&vsync));
+    Simulate(&vsync, hz60, VLC_TICK_FROM_US(41667), 100);
+    assert(vout_vsync_IsLocked(&vsync));
+    assert(llabs(vsync.period - hz60) < VLC_TICK_FROM_US(100));
+
+    /* Dates are rounded to the nearest refresh */
+    vlc_tick_t slot = vout_vsync_Quantize(&vsync, vsync.last + hz60 * 2 / 5);
+    assert(llabs(slot - vsync.last) < VLC_TICK_FROM_US(100));
+    slot = vout_vsync_Quantize(&vsync, vsync.last + hz60 * 8 / 5);
+    assert(llabs(slot - vsync.last - 2 * hz60) < VLC_TICK_FROM_US(200));
+    slot = vout_vsync_Quantize(&vsync, vsync.last - hz60 * 3 / 5);
+    assert(llabs(slot - vsync.last + hz60) < VLC_TICK_FROM_US(100));
+
+    /* 25 fps on 50 Hz: every other refresh is used, which cannot be told
+     * apart from a 25 Hz display, and does not matter for the pacing */
+    vout_vsync_Reset(&vsync);
+    Simulate(&vsync, hz50, VLC_TICK_FROM_MS(40), 100);
+    assert(vout_vsync_IsLocked(&vsync));
+    assert(llabs(vsync.period - 2 * hz50) < VLC_TICK_FROM_US(100));
+
+    /* An outlier does not unlock the estimation */
+    vout_vsync_Present(&vsync, vsync.last + VLC_TICK_FROM_MS(27));
+    assert(vout_vsync_IsLocked(&vsync));
+    assert(llabs(vsync.period - 2 * hz50) < VLC_TICK_FROM_US(100));
+
+    /* Presentations not synchronized on any refresh */
+    vout_vsync_Init(&vsync);
+    vlc_tick_t date = VLC_TICK_FROM_SEC(1);
+    unsigned seed = 1;
+    for (unsigned i = 0; i < 100; i++) {
+        seed = seed * 1103515245 + 12345;
+        date += VLC_TICK_FROM_MS(30) + (seed >> 16) % VLC_TICK_FROM_MS(20);
+        vout_vsync_Present(&vsync, date);
+    }
+    assert(!vout_vsync_IsLocked(&vsync));
+    return 0;
+}
+#endif
@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * vsync.h: display refresh estimation
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_VOUT_VSYNC_H
+#define LIBVLC_VOUT_VSYNC_H
+
+#include <vlc_common.h>
+
+/**
+ * Estimation of the display refresh period and phase.
+ *
+ * The estimator is fed with the dates at which pictures were presented.
+ * With a display synchronized on the vertical refresh, these dates are
+ * multiples of the refresh period, even when pictures are not presented on
+ * every refresh (24 fps on a 60 Hz display for instance).
+ */
+typedef struct {
+    vlc_tick_t period; /* VLC_TICK_INVALID if unknown */
+    vlc_tick_t last;   /* last presentation date */
+    unsigned   hits;   /* presentations consistent with the period */
+    unsigned   misses; /* consecutive inconsistent presentations */
+} vout_vsync_t;
+
+void vout_vsync_Init(vout_vsync_t *);
+
+/**
+ * Forgets the refresh estimation and the last presentation date, after a
+ * display change or a flush for instance.
+ */
+void vout_vsync_Reset(vout_vsync_t *);
+
+/**
+ * Feeds the date at which a picture was presented.
+ *
+ * \return the number of refresh periods since the previous presentation,
+ * or 0 if unknown
+ */
+unsigned vout_vsync_Present(vout_vsync_t *, vlc_tick_t date);
+
+/**
+ * Tells whether the refresh period is known with enough confidence.
+ */
+bool vout_vsync_IsLocked(const vout_vsync_t *);
+
+/**
+ * Returns the refresh date nearest to the given date.
+ *
+ * The estimation must be locked.
+ */
+vlc_tick_t vout_vsync_Quantize(const vout_vsync_t *, vlc_tick_t date);
+
+#endif
@@ -25,6 +25,7 @@
 #undef NDEBUG
 #include <assert.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -43,6 +44,7 @@
 
 static vlc_tls_server_t *server_creds;
 static vlc_tls_client_t *client_creds;
+static atomic_uint resumptions; /* by the server */
 
 static void *tls_echo(void *data)
 {
@@ -68,6 +70,9 @@ static void *tls_echo(void *data)
     if (val < 0)
         goto error;
 
+    if (vlc_tls_SessionIsResumed(tls))
+        atomic_fetch_add(&resumptions, 1);
+
     while ((val = vlc_tls_Read(tls, buf, sizeof (buf), false)) > 0)
         if (vlc_tls_Write(tls, buf, val) < val)
             goto error;
@@ -174,6 +179,7 @@ int main(void)
         return 77;
     }
     obj = VLC_OBJECT(vlc->p_libvlc_int);
+    atomic_init(&resumptions, 0);
 
     server_creds = vlc_tls_ServerCreate(obj, CERTFILE, NULL);
     assert(server_creds != NULL);
@@ -290,6 +296,32 @@ int main(void)
     vlc_tls_Close(tls);
     vlc_join(th, NULL);
 
+    /* Test session resumption */
+    for (unsigned i = 0; i < 3; i++)
+    {
+        unsigned resumed = atomic_load(&resumptions);
+
+        tls = securepair(&th, alpn, alpn, &alp);
+        assert(tls != NULL);
+        assert(alp != NULL);
+        assert(strcmp(alp, alpn[0]) == 0);
+        free(alp);
+        /* The first session is new, the next ones resume it */
+        assert(vlc_tls_SessionIsResumed(tls) == (i > 0));
+
+        /* Receive the session ticket, if any, along with data */
+        val = vlc_tls_Write(tls, "Hello", 5);
+        assert(val == 5);
+        val = vlc_tls_Read(tls, buf, 5, true);
+        assert(val == 5);
+        assert(!memcmp(buf, "Hello", 5));
+        vlc_tls_Shutdown(tls, false);
+        vlc_join(th, NULL);
+        vlc_tls_Close(tls);
+
+        assert(atomic_load(&resumptions) == resumed + (i > 0));
+    }
+
     vlc_tls_ClientDelete(client_creds);
     vlc_tls_ServerDelete(server_creds);
     libvlc_release(vlc);
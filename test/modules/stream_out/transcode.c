@@ -0,0 +1,233 @@
+/*****************************************************************************
+ * transcode.c: transcode stream output renditions test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#define MODULE_NAME test_transcode
+#define MODULE_STRING "test_transcode"
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_codec.h>
+#include <vlc_sout.h>
+
+#define TRACKS 2
+#define MAX_OUTPUTS 8
+
+/* Every instance of the output stream records what it received */
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned count;
+    struct output
+    {
+        unsigned es;         /* ES added */
+        unsigned es_active;  /* ES not deleted yet */
+        unsigned blocks[TRACKS];
+        bool closed;
+    } outputs[MAX_OUTPUTS];
+} state = {
+    .lock = VLC_STATIC_MUTEX,
+};
+
+struct output_id
+{
+    struct output *out;
+    unsigned index;
+};
+
+/*** Encoder ***/
+static block_t *EncodeVideo(encoder_t *enc, picture_t *pic)
+{
+    (void) enc;
+    if (pic == NULL)
+        return NULL;
+
+    block_t *block = block_Alloc(1);
+    if (block == NULL)
+        return NULL;
+    block->i_dts = block->i_pts = pic->date;
+    return block;
+}
+
+static int OpenEncoder(vlc_object_t *obj)
+{
+    encoder_t *enc = (encoder_t *)obj;
+
+    if (enc->fmt_out.i_cat != VIDEO_ES)
+        return VLC_EGENERIC;
+
+    enc->pf_encode_video = EncodeVideo;
+    return VLC_SUCCESS;
+}
+
+/*** Stream output ***/
+static void *Add(sout_stream_t *stream, const es_format_t *fmt)
+{
+    struct output *out = stream->p_sys;
+    struct output_id *id = malloc(sizeof (*id));
+
+    assert(fmt->i_cat == VIDEO_ES);
+    if (id == NULL)
+        return NULL;
+
+    vlc_mutex_lock(&state.lock);
+    assert(out->es < TRACKS);
+    id->out = out;
+    id->index = out->es++;
+    out->es_active++;
+    vlc_mutex_unlock(&state.lock);
+    return id;
+}
+
+static void Del(sout_stream_t *stream, void *opaque)
+{
+    struct output_id *id = opaque;
+
+    (void) stream;
+    vlc_mutex_lock(&state.lock);
+    id->out->es_active--;
+    vlc_mutex_unlock(&state.lock);
+    free(id);
+}
+
+static int Send(sout_stream_t *stream, void *opaque, block_t *block)
+{
+    struct output_id *id = opaque;
+
+    (void) stream;
+    vlc_mutex_lock(&state.lock);
+    for (block_t *b = block; b != NULL; b = b->p_next)
+        id->out->blocks[id->index]++;
+    vlc_mutex_unlock(&state.lock);
+    block_ChainRelease(block);
+    return VLC_SUCCESS;
+}
+
+static int OpenOutput(vlc_object_t *obj)
+{
+    sout_stream_t *stream = (sout_stream_t *)obj;
+
+    vlc_mutex_lock(&state.lock);
+    assert(state.count < MAX_OUTPUTS);
+    stream->p_sys = &state.outputs[state.count++];
+    vlc_mutex_unlock(&state.lock);
+
+    stream->pf_add = Add;
+    stream->pf_del = Del;
+    stream->pf_send = Send;
+    stream->pace_nocontrol = true;
+    return VLC_SUCCESS;
+}
+
+static void CloseOutput(vlc_object_t *obj)
+{
+    sout_stream_t *stream = (sout_stream_t *)obj;
+    struct output *out = stream->p_sys;
+
+    vlc_mutex_lock(&state.lock);
+    assert(out->es_active == 0);
+    out->closed = true;
+    vlc_mutex_unlock(&state.lock);
+}
+
+vlc_module_begin()
+    set_capability("encoder", 0)
+    add_shortcut("test_enc")
+    set_callback(OpenEncoder)
+    add_submodule()
+        set_capability("sout stream", 0)
+        add_shortcut("test_out")
+        set_callbacks(OpenOutput, CloseOutput)
+vlc_module_end()
+
+typedef int (*vlc_plugin_cb)(int (*)(void *, void *, int, ...), void *);
+
+VLC_EXPORT vlc_plugin_cb vlc_static_modules[] = {
+    vlc_entry__test_transcode,
+    NULL
+};
+
+static void on_event(const struct libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    libvlc_media_t *md = libvlc_media_new_location(vlc,
+        "mock://video_track_count=2;video_width=64;video_height=48;"
+        "length=2000000");
+    assert(md != NULL);
+    libvlc_media_add_option(md, ":sout-all");
+    /* Each video ES gets its own rendition output, next to the main one */
+    libvlc_media_add_option(md, ":sout=#transcode{vcodec=I420,venc=test_enc,"
+                            "pool-size=3,rendition={dst=test_out}}:test_out");
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(md);
+    assert(mp != NULL);
+    libvlc_media_release(md);
+
+    vlc_sem_t sem;
+    vlc_sem_init(&sem, 0);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    int res = libvlc_event_attach(em, libvlc_MediaPlayerEndReached,
+                                  on_event, &sem);
+    assert(!res);
+
+    res = libvlc_media_player_play(mp);
+    assert(!res);
+    vlc_sem_wait(&sem);
+
+    libvlc_event_detach(em, libvlc_MediaPlayerEndReached, on_event, &sem);
+    libvlc_media_player_stop_async(mp);
+    libvlc_media_player_release(mp);
+    libvlc_release(vlc);
+
+    /* The main output is created first, with both video ES. Then every ES
+     * gets its own rendition output, with the same pictures. */
+    assert(state.count == 1 + TRACKS);
+    const struct output *main_out = &state.outputs[0];
+    assert(main_out->es == TRACKS);
+
+    unsigned main_total = 0, renditions_total = 0;
+    for (unsigned i = 0; i < TRACKS; i++)
+    {
+        const struct output *out = &state.outputs[1 + i];
+
+        assert(out->es == 1);
+        assert(out->blocks[0] > 0);
+        main_total += main_out->blocks[i];
+        renditions_total += out->blocks[0];
+    }
+    assert(main_total == renditions_total);
+
+    for (unsigned i = 0; i < state.count; i++)
+        assert(state.outputs[i].closed);
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*****************************************************************************
+ * decoder_batch.c: decoder input queue test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#define MODULE_NAME test_decoder_batch
+#define MODULE_STRING "test_decoder_batch"
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_codec.h>
+
+/* The demuxer queues blocks much faster than they are decoded while the
+ * decoder is held, so that the decoder thread dequeues them in batches. */
+#define LENGTH VLC_TICK_FROM_SEC(2)
+#define PACKET VLC_TICK_FROM_MS(10)
+
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    vlc_tick_t first_dts;   /* of the blocks decoded since the last flush */
+    vlc_tick_t last_dts;
+    vlc_tick_t held_dts;
+    unsigned flushes;
+    unsigned seek_buffering; /* buffering events since the decoder is held */
+    bool held;
+    bool drained;
+} state = {
+    .lock = VLC_STATIC_MUTEX,
+    .wait = VLC_STATIC_COND,
+    .first_dts = VLC_TICK_INVALID,
+    .held_dts = VLC_TICK_INVALID,
+};
+
+static int Decode(decoder_t *dec, block_t *block)
+{
+    (void) dec;
+    vlc_mutex_lock(&state.lock);
+    /* The end of the stream may be reached, and draining requested, before
+     * the seek back: the decoder may be drained more than once. */
+    state.drained = block == NULL;
+    if (block == NULL)
+    {
+        vlc_mutex_unlock(&state.lock);
+        return VLCDEC_SUCCESS;
+    }
+
+    /* The blocks queued before the seek, in the FIFO or in the batch of the
+     * decoder thread, are all discarded by the flush */
+    assert(state.held_dts == VLC_TICK_INVALID || state.flushes > 0);
+
+    /* Blocks are decoded in order, without gaps nor duplicates */
+    if (state.first_dts == VLC_TICK_INVALID)
+    {
+        state.first_dts = block->i_dts;
+        if (state.flushes > 0)
+            assert(block->i_dts < state.held_dts);
+    }
+    else
+        assert(block->i_dts == state.last_dts + PACKET);
+    state.last_dts = block->i_dts;
+
+    if (state.flushes == 0 && block->i_dts >= LENGTH / 2
+     && state.held_dts == VLC_TICK_INVALID)
+    {   /* Hold the decoder while the input queues more blocks and seeks */
+        state.held_dts = block->i_dts;
+        state.held = true;
+        vlc_cond_signal(&state.wait);
+        while (state.held)
+            vlc_cond_wait(&state.wait, &state.lock);
+    }
+    vlc_mutex_unlock(&state.lock);
+    block_Release(block);
+    return VLCDEC_SUCCESS;
+}
+
+static void Flush(decoder_t *dec)
+{
+    (void) dec;
+    vlc_mutex_lock(&state.lock);
+    state.flushes++;
+    state.first_dts = VLC_TICK_INVALID;
+    vlc_mutex_unlock(&state.lock);
+}
+
+static int OpenDecoder(vlc_object_t *obj)
+{
+    decoder_t *dec = (decoder_t *)obj;
+
+    if (dec->fmt_in.i_cat != AUDIO_ES)
+        return VLC_EGENERIC;
+
+    dec->pf_decode = Decode;
+    dec->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin()
+    set_capability("audio decoder", 10000)
+    set_callback(OpenDecoder)
+vlc_module_end()
+
+typedef int (*vlc_plugin_cb)(int (*)(void *, void *, int, ...), void *);
+
+VLC_EXPORT vlc_plugin_cb vlc_static_modules[] = {
+    vlc_entry__test_decoder_batch,
+    NULL
+};
+
+static void on_event(const struct libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+static void on_buffering(const struct libvlc_event_t *event, void *data)
+{
+    (void) data;
+    vlc_mutex_lock(&state.lock);
+    /* The seek restarts buffering from zero, then flushes the decoders
+     * before reading again: any later progress follows the flush. */
+    if (event->u.media_player_buffering.new_cache == 0.f
+     || state.seek_buffering > 0)
+    {
+        state.seek_buffering++;
+        vlc_cond_signal(&state.wait);
+    }
+    vlc_mutex_unlock(&state.lock);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    char url[256];
+    snprintf(url, sizeof (url), "mock://audio_track_count=1;"
+             "audio_sample_length=%"PRId64";length=%"PRId64, PACKET, LENGTH);
+
+    libvlc_media_t *md = libvlc_media_new_location(vlc, url);
+    assert(md != NULL);
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(md);
+    assert(mp != NULL);
+    libvlc_media_release(md);
+
+    vlc_sem_t sem;
+    vlc_sem_init(&sem, 0);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    int res = libvlc_event_attach(em, libvlc_MediaPlayerEndReached,
+                                  on_event, &sem);
+    assert(!res);
+
+    res = libvlc_media_player_play(mp);
+    assert(!res);
+
+    /* Seek back to the start while the decoder is held in the middle */
+    vlc_mutex_lock(&state.lock);
+    while (!state.held)
+        vlc_cond_wait(&state.wait, &state.lock);
+    vlc_mutex_unlock(&state.lock);
+
+    res = libvlc_event_attach(em, libvlc_MediaPlayerBuffering,
+                              on_buffering, NULL);
+    assert(!res);
+    res = libvlc_media_player_set_time(mp, 0, false);
+    assert(!res);
+
+    vlc_mutex_lock(&state.lock);
+    while (state.seek_buffering < 2)
+        vlc_cond_wait(&state.wait, &state.lock);
+    state.held = false;
+    vlc_cond_signal(&state.wait);
+    vlc_mutex_unlock(&state.lock);
+
+    vlc_sem_wait(&sem);
+
+    vlc_mutex_lock(&state.lock);
+    assert(state.flushes == 1);
+    /* Decoded up to the end again, then drained */
+    assert(state.last_dts > state.held_dts);
+    assert(state.drained);
+    vlc_mutex_unlock(&state.lock);
+
+    libvlc_event_detach(em, libvlc_MediaPlayerBuffering, on_buffering, NULL);
+    libvlc_event_detach(em, libvlc_MediaPlayerEndReached, on_event, &sem);
+    libvlc_media_player_stop_async(mp);
+    libvlc_media_player_release(mp);
+    libvlc_release(vlc);
+    return 0;
+}
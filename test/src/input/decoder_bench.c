@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * decoder_bench.c: decoder input queue throughput benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+
+/* 10 seconds of 192 kHz audio in 250 µs packets, i.e. 40000 packets per
+ * track. The dummy stream output consumes the packets as fast as possible,
+ * so that the decoder threads are only bound by their input queue. */
+#define LENGTH VLC_TICK_FROM_SEC(10)
+#define PACKET VLC_TICK_FROM_US(250)
+
+static void on_event(const struct libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+static void bench(unsigned tracks)
+{
+    const char *argv[] = { "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    char url[256];
+    snprintf(url, sizeof (url), "mock://audio_track_count=%u;"
+             "audio_rate=192000;audio_sample_length=%"PRId64";length=%"PRId64,
+             tracks, PACKET, LENGTH);
+
+    libvlc_media_t *md = libvlc_media_new_location(vlc, url);
+    assert(md != NULL);
+    libvlc_media_add_option(md, ":sout=#dummy");
+    libvlc_media_add_option(md, ":sout-all");
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(md);
+    assert(mp != NULL);
+    libvlc_media_release(md);
+
+    vlc_sem_t sem;
+    vlc_sem_init(&sem, 0);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    int res = libvlc_event_attach(em, libvlc_MediaPlayerEndReached,
+                                  on_event, &sem);
+    assert(!res);
+
+    vlc_tick_t start = vlc_tick_now();
+    res = libvlc_media_player_play(mp);
+    assert(!res);
+    vlc_sem_wait(&sem);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    const unsigned long packets = tracks * (LENGTH / PACKET);
+    test_log("%u track(s): %lu packets in %"PRId64" ms, %.2f µs per packet\n",
+             tracks, packets, MS_FROM_VLC_TICK(elapsed),
+             (double)elapsed / packets);
+
+    libvlc_event_detach(em, libvlc_MediaPlayerEndReached, on_event, &sem);
+    libvlc_media_player_stop_async(mp);
+    libvlc_media_player_release(mp);
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    test_init();
+
+    bench(1);
+    bench(8);
+    return 0;
+}
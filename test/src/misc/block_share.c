@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * block_share.c: block fan-out benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+/* 1024 TS packets per block, to 4 branches, as the duplicate
+ * stream output does */
+#define BRANCHES 4
+#define BLOCKS   256
+#define SIZE     (188 * 1024)
+
+/* Fans blocks out to the branches, which each read the payload, by copy or
+ * by reference. Returns the elapsed time. */
+static vlc_tick_t fanout(bool share, size_t *copied)
+{
+    block_t *refs[BRANCHES];
+    unsigned sum = 0;
+
+    *copied = 0;
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < BLOCKS; i++)
+    {
+        block_t *block = block_Alloc(SIZE);
+        assert(block != NULL);
+        memset(block->p_buffer, i, SIZE);
+
+        if (share)
+            assert(block_Share(block, refs, BRANCHES) == VLC_SUCCESS);
+        else
+        {
+            for (unsigned j = 0; j < BRANCHES - 1; j++)
+            {
+                refs[j] = block_Duplicate(block);
+                assert(refs[j] != NULL);
+                *copied += refs[j]->i_buffer;
+            }
+            refs[BRANCHES - 1] = block;
+        }
+
+        for (unsigned j = 0; j < BRANCHES; j++)
+        {
+            for (size_t k = 0; k < refs[j]->i_buffer; k += 64)
+                sum += refs[j]->p_buffer[k];
+            block_Release(refs[j]);
+        }
+    }
+    assert(sum != 0);
+    return vlc_tick_now() - start;
+}
+
+int main(void)
+{
+    size_t dup_bytes, share_bytes;
+
+    test_init();
+
+    vlc_tick_t dup = fanout(false, &dup_bytes);
+    vlc_tick_t share = fanout(true, &share_bytes);
+
+    assert(share_bytes == 0);
+    test_log("fan-out to %u branches, %u blocks of %u bytes:\n",
+             BRANCHES, BLOCKS, SIZE);
+    test_log(" duplicate: %zu MiB copied in %.1f ms\n", dup_bytes >> 20,
+             (double)dup / VLC_TICK_FROM_MS(1));
+    test_log(" share:     %zu MiB copied in %.1f ms\n", share_bytes >> 20,
+             (double)share / VLC_TICK_FROM_MS(1));
+    return 0;
+}
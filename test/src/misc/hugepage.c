@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * hugepage.c: huge page buffers chroma conversion benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/perf_event.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_image.h>
+
+/* One 8K 10-bits frame is about 100 MiB */
+#define WIDTH 7680
+#define HEIGHT 4320
+#define FRAMES 8
+
+/* Opens a data TLB read miss counter for this thread, if permitted */
+static int tlb_open(void)
+{
+    struct perf_event_attr attr = {
+        .type = PERF_TYPE_HW_CACHE,
+        .size = sizeof (attr),
+        .config = PERF_COUNT_HW_CACHE_DTLB
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        .exclude_kernel = 1,
+        .exclude_hv = 1,
+    };
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static unsigned long anon_huge_kib(void)
+{
+    FILE *stream = fopen("/proc/self/smaps_rollup", "r");
+    unsigned long kib = 0;
+    char line[256];
+
+    if (stream == NULL)
+        return 0;
+    while (fgets(line, sizeof (line), stream) != NULL)
+        if (sscanf(line, "AnonHugePages: %lu kB", &kib) == 1)
+            break;
+    fclose(stream);
+    return kib;
+}
+
+static void bench(bool hugepages)
+{
+    const char *argv[] = { hugepages ? "--hugepages" : "--no-hugepages" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    image_handler_t *ih = image_HandlerCreate(vlc->p_libvlc_int);
+    assert(ih != NULL);
+
+    video_format_t in, out;
+    video_format_Init(&in, VLC_CODEC_I420_10L);
+    video_format_Setup(&in, VLC_CODEC_I420_10L, WIDTH, HEIGHT,
+                       WIDTH, HEIGHT, 1, 1);
+    video_format_Init(&out, VLC_CODEC_P010);
+    video_format_Setup(&out, VLC_CODEC_P010, WIDTH, HEIGHT,
+                       WIDTH, HEIGHT, 1, 1);
+
+    picture_t *src = picture_NewFromFormat(&in);
+    assert(src != NULL);
+    for (int i = 0; i < src->i_planes; i++)
+        memset(src->p[i].p_pixels, 0x40 + i,
+               src->p[i].i_pitch * src->p[i].i_lines);
+
+    /* Warm up: load the converter and fault the first output in */
+    picture_t *dst = image_Convert(ih, src, &in, &out);
+    assert(dst != NULL);
+    picture_Release(dst);
+
+    int fd = tlb_open();
+    uint64_t misses = 0;
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        dst = image_Convert(ih, src, &in, &out);
+        assert(dst != NULL);
+        assert(dst->format.i_chroma == VLC_CODEC_P010);
+        picture_Release(dst);
+    }
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    if (fd != -1)
+    {
+        if (read(fd, &misses, sizeof (misses)) != sizeof (misses))
+            misses = 0;
+        close(fd);
+    }
+
+    char tlb[32] = "n/a";
+    if (fd != -1)
+        snprintf(tlb, sizeof (tlb), "%"PRIu64, misses / FRAMES);
+
+    test_log("%s pages: %.1f ms per frame, %s DTLB misses per frame, "
+             "%lu KiB of transparent huge pages\n",
+             hugepages ? "huge" : "normal",
+             (double)elapsed / (FRAMES * VLC_TICK_FROM_MS(1)), tlb,
+             anon_huge_kib());
+
+    picture_Release(src);
+    image_HandlerDelete(ih);
+    libvlc_release(vlc);
+}
+
+/* The page size setting is per process: run each case in a child */
+static void run(bool hugepages)
+{
+    fflush(NULL);
+    pid_t pid = fork();
+    assert(pid != -1);
+
+    if (pid == 0)
+    {
+        bench(hugepages);
+        exit(0);
+    }
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_log("converting %ux%u I420 10-bits to P010\n", WIDTH, HEIGHT);
+    run(false);
+    run(true);
+    return 0;
+}
@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * picture_pool.c: picture pool contention benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_picture_pool.h>
+
+/* Threads take pictures from a pool smaller than their number, and release
+ * them at once, so that they mostly contend on the pool. */
+#define THREADS 4
+#define LOOPS 100000
+
+static void *bench_thread(void *data)
+{
+    picture_pool_t *pool = data;
+
+    for (unsigned i = 0; i < LOOPS; i++)
+    {
+        picture_t *pic = picture_pool_Wait(pool);
+        assert(pic != NULL);
+        pic->date = i;
+        picture_Release(pic);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    video_format_t fmt;
+    vlc_thread_t th[THREADS];
+
+    test_init();
+
+    video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
+    picture_pool_t *pool = picture_pool_NewFromFormat(&fmt, THREADS / 2);
+    assert(pool != NULL);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < THREADS; i++)
+        assert(vlc_clone(&th[i], bench_thread, pool,
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    for (unsigned i = 0; i < THREADS; i++)
+        vlc_join(th[i], NULL);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    assert(picture_pool_GetSize(pool) == THREADS / 2);
+    picture_pool_Release(pool);
+
+    test_log("%u threads, %u pictures: %.1f ns per picture\n",
+             THREADS, THREADS / 2,
+             (double)elapsed * 1000 / (VLC_TICK_FROM_US(1) * THREADS * LOOPS));
+    return 0;
+}
@@ -0,0 +1,363 @@
+/*****************************************************************************
+ * httpd.c: HTTP server load test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_httpd.h>
+#include <vlc_network.h>
+
+/* Number of concurrent clients, can be overridden with HTTPD_TEST_CLIENTS
+ * to load the server with thousands of connections. */
+#define DEFAULT_CLIENTS 256
+#define BLOCK_SIZE 16384
+#define BLOCK_COUNT 32
+
+static const char stream_header[] = "HEADER";
+
+struct client
+{
+    int fd;
+    size_t headers; /**< bytes of the HTTP response headers */
+    size_t received; /**< bytes of the response body */
+    size_t base; /**< stream position of the first data byte */
+    char buf[512];
+};
+
+static unsigned char pattern(size_t offset)
+{
+    return (offset * 13) ^ (offset >> 10);
+}
+
+/* Reads whatever is available; returns false at end of stream */
+static bool client_read(struct client *c)
+{
+    unsigned char buf[BLOCK_SIZE];
+    ssize_t val = recv(c->fd, buf, sizeof (buf), 0);
+
+    if (val < 0)
+    {
+        assert(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        return true;
+    }
+    if (val == 0)
+        return false;
+
+    size_t len = val;
+    unsigned char *p = buf;
+
+    if (c->headers == 0)
+    {   /* Accumulate the response headers */
+        size_t have = strlen(c->buf);
+        size_t copy = __MIN(len, sizeof (c->buf) - 1 - have);
+
+        memcpy(c->buf + have, p, copy);
+        c->buf[have + copy] = '\0';
+
+        char *end = strstr(c->buf, "\r\n\r\n");
+        if (end == NULL)
+        {
+            assert(have + copy < sizeof (c->buf) - 1);
+            return true;
+        }
+        assert(!strncmp(c->buf, "HTTP/1.0 200 ", 13));
+        c->headers = end + 4 - c->buf;
+
+        size_t consumed = c->headers - have;
+        p += consumed;
+        len -= consumed;
+    }
+
+    for (size_t i = 0; i < len; i++, c->received++)
+    {
+        size_t offset = c->received;
+
+        if (offset < sizeof (stream_header) - 1)
+            assert(p[i] == (unsigned char)stream_header[offset]);
+        else
+            assert(p[i] == pattern(c->base + offset
+                                   - (sizeof (stream_header) - 1)));
+    }
+    return true;
+}
+
+/* Reads from all clients until each has received a given amount */
+static void clients_wait(struct client *tab, struct pollfd *ufd,
+                         unsigned n, size_t expected)
+{
+    unsigned left;
+
+    do
+    {
+        left = 0;
+        for (unsigned i = 0; i < n; i++)
+            if (tab[i].received < expected)
+            {
+                ufd[left].fd = tab[i].fd;
+                ufd[left].events = POLLIN;
+                left++;
+            }
+            else
+                assert(tab[i].received == expected);
+
+        if (left == 0)
+            break;
+
+        int val = poll(ufd, left, -1);
+        assert(val > 0 || errno == EINTR);
+
+        for (unsigned i = 0, j = 0; i < n && j < left; i++)
+        {
+            if (tab[i].fd != ufd[j].fd)
+                continue;
+            if (ufd[j].revents)
+                assert(client_read(&tab[i]));
+            j++;
+        }
+    }
+    while (left > 0);
+}
+
+static int client_connect(unsigned port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    static const char request[] = "GET /stream HTTP/1.0\r\n\r\n";
+
+    int fd = vlc_socket(PF_INET, SOCK_STREAM, 0, false);
+    assert(fd != -1);
+    assert(connect(fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    assert(send(fd, request, sizeof (request) - 1, 0)
+           == sizeof (request) - 1);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+/* Sends the given block of the test pattern */
+static void stream_send(httpd_stream_t *stream, size_t index, bool keyframe)
+{
+    block_t *block = block_Alloc(BLOCK_SIZE);
+    assert(block != NULL);
+
+    for (size_t j = 0; j < BLOCK_SIZE; j++)
+        block->p_buffer[j] = pattern(index * BLOCK_SIZE + j);
+    if (keyframe)
+        block->i_flags |= BLOCK_FLAG_TYPE_I;
+    assert(httpd_StreamSendBlock(stream, block) == VLC_SUCCESS);
+}
+
+/* Fetches a URL with HTTP/1.0, returns the length of the response */
+static size_t client_fetch(unsigned port, const char *method, const char *url,
+                           char *buf, size_t size)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    char request[64];
+    int len = snprintf(request, sizeof (request), "%s %s HTTP/1.0\r\n\r\n",
+                       method, url);
+    assert(len > 0 && (size_t)len < sizeof (request));
+
+    int fd = vlc_socket(PF_INET, SOCK_STREAM, 0, false);
+    assert(fd != -1);
+    assert(connect(fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    assert(send(fd, request, len, 0) == len);
+
+    size_t total = 0;
+    ssize_t val;
+
+    while ((val = recv(fd, buf + total, size - total, 0)) > 0)
+    {
+        total += val;
+        assert(total < size);
+    }
+    assert(val == 0 || errno == EINTR);
+    vlc_close(fd);
+    return total;
+}
+
+/* Serves a block by reference, for GET and HEAD */
+static void test_block(httpd_host_t *host, unsigned port)
+{
+    static const char body[] = "segment data";
+    static const httpd_header headers[] = {
+        { (char *)"Cache-Control", (char *)"max-age=60" },
+    };
+    block_t *block = block_Alloc(sizeof (body) - 1);
+    assert(block != NULL);
+    memcpy(block->p_buffer, body, sizeof (body) - 1);
+
+    httpd_block_t *blk = httpd_BlockNew(host, "/block", "video/MP2T",
+                                        headers, ARRAY_SIZE(headers), block);
+    assert(blk != NULL);
+
+    char buf[1024];
+    size_t len = client_fetch(port, "GET", "/block", buf, sizeof (buf));
+    buf[len] = '\0';
+
+    char *end = strstr(buf, "\r\n\r\n");
+    assert(end != NULL);
+    assert(!strncmp(buf, "HTTP/1.1 200 ", 13));
+    assert(strstr(buf, "\r\nContent-Type: video/MP2T\r\n") != NULL);
+    assert(strstr(buf, "\r\nCache-Control: max-age=60\r\n") != NULL);
+    assert(strstr(buf, "\r\nContent-Length: 12\r\n") != NULL);
+    assert(!strcmp(end + 4, body));
+
+    /* Same headers, no body */
+    len = client_fetch(port, "HEAD", "/block", buf, sizeof (buf));
+    buf[len] = '\0';
+    end = strstr(buf, "\r\n\r\n");
+    assert(end != NULL && end[4] == '\0');
+    assert(strstr(buf, "\r\nContent-Length: 12\r\n") != NULL);
+
+    httpd_BlockDelete(blk);
+}
+
+static double cpu_time(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec
+           + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+int main(void)
+{
+    unsigned n = DEFAULT_CLIENTS;
+    const char *str = getenv("HTTPD_TEST_CLIENTS");
+    if (str != NULL)
+        n = strtoul(str, NULL, 10);
+
+    /* Each connection uses two file descriptors in this process */
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+        if (rl.rlim_cur != RLIM_INFINITY && n > (rl.rlim_cur - 64) / 2)
+        {
+            n = (rl.rlim_cur - 64) / 2;
+            test_log("limiting to %u clients\n", n);
+        }
+    }
+    assert(n > 0);
+
+    test_init();
+
+    /* Pick a port from the process ID, retry a few if it is in use */
+    libvlc_instance_t *vlc = NULL;
+    httpd_host_t *host = NULL;
+    unsigned port;
+
+    for (unsigned i = 0; host == NULL && i < 16; i++)
+    {
+        char portarg[32];
+        const char *argv[] = { "--http-host=127.0.0.1", portarg };
+
+        if (vlc != NULL)
+            libvlc_release(vlc);
+
+        port = 20000 + ((unsigned)getpid() + 997 * i) % 20000;
+        snprintf(portarg, sizeof (portarg), "--http-port=%u", port);
+        vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+        assert(vlc != NULL);
+        host = vlc_http_HostNew(VLC_OBJECT(vlc->p_libvlc_int));
+    }
+    assert(host != NULL);
+
+    httpd_stream_t *stream = httpd_StreamNew(host, "/stream",
+                                             "application/octet-stream",
+                                             NULL, NULL);
+    assert(stream != NULL);
+    httpd_StreamHeader(stream, (uint8_t *)stream_header,
+                       sizeof (stream_header) - 1);
+
+    struct client *tab = calloc(n, sizeof (*tab));
+    struct pollfd *ufd = calloc(n, sizeof (*ufd));
+    assert(tab != NULL && ufd != NULL);
+
+    test_log("connecting %u clients to port %u\n", n, port);
+    for (unsigned i = 0; i < n; i++)
+        tab[i].fd = client_connect(port);
+
+    /* Wait until all clients have received the stream header */
+    clients_wait(tab, ufd, n, sizeof (stream_header) - 1);
+
+    double start = cpu_time();
+    vlc_tick_t begin = vlc_tick_now();
+
+    for (size_t i = 0; i < BLOCK_COUNT; i++)
+        stream_send(stream, i, false);
+
+    clients_wait(tab, ufd, n, sizeof (stream_header) - 1
+                              + BLOCK_COUNT * BLOCK_SIZE);
+
+    double cpu = cpu_time() - start;
+    vlc_tick_t elapsed = vlc_tick_now() - begin;
+
+    test_log("%u clients, %u KiB each in %"PRId64" ms\n", n,
+             BLOCK_COUNT * BLOCK_SIZE / 1024, MS_FROM_VLC_TICK(elapsed));
+    test_log("CPU time: %.3f ms total, %.1f us per client\n",
+             cpu * 1e3, cpu * 1e6 / n);
+
+    /* A late client starts with the next keyframe */
+    struct client late = { .base = (BLOCK_COUNT + 2) * BLOCK_SIZE };
+
+    stream_send(stream, BLOCK_COUNT, true);
+    late.fd = client_connect(port);
+    clients_wait(&late, ufd, 1, sizeof (stream_header) - 1);
+    stream_send(stream, BLOCK_COUNT + 1, false);
+    stream_send(stream, BLOCK_COUNT + 2, true);
+    stream_send(stream, BLOCK_COUNT + 3, false);
+    clients_wait(&late, ufd, 1, sizeof (stream_header) - 1 + 2 * BLOCK_SIZE);
+    vlc_close(late.fd);
+
+    for (unsigned i = 0; i < n; i++)
+        vlc_close(tab[i].fd);
+    free(ufd);
+    free(tab);
+
+    httpd_StreamDelete(stream);
+
+    test_block(host, port);
+
+    httpd_HostDelete(host);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*****************************************************************************
+ * filter_thread.c: static video filters run ahead of display test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#define MODULE_NAME test_filter_thread
+#define MODULE_STRING "test_filter_thread"
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_codec.h>
+#include <vlc_filter.h>
+#include <vlc_vout_display.h>
+
+/* Frames of the stream, and what happens to them on the way to display */
+#define FRAME      VLC_TICK_FROM_MS(40)
+#define FRAMES     100
+#define BLOCK_AT   10   /* the static filter waits for the display */
+#define SEEK_FROM  30   /* once displayed, seek back to SEEK_TO */
+#define SEEK_TO    15
+#define REFORMAT   50   /* the decoded pictures get a new aspect ratio */
+#define SLOW_FROM  70   /* the static filter is slower than real time */
+#define SLOW_TO    78
+
+#define MARK 0xA5 /* written by the static filter */
+
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    unsigned displayed;
+    unsigned last;            /* index of the last displayed picture */
+    unsigned flushes;         /* displayed index going back */
+    unsigned slow_displayed;  /* pictures displayed in [SLOW_FROM, SLOW_TO) */
+    unsigned reformat_opens;  /* static filters opened for the new format */
+    bool blocked;             /* whether the static filter waited */
+    bool displayed_blocked;   /* something was displayed meanwhile */
+    bool seeking;
+} state = {
+    .lock = VLC_STATIC_MUTEX,
+};
+
+static unsigned PictureIndex(vlc_tick_t date)
+{
+    assert(date >= VLC_TICK_0);
+    return (date - VLC_TICK_0 + FRAME / 2) / FRAME;
+}
+
+/*** Decoder ***/
+static int Decode(decoder_t *dec, block_t *block)
+{
+    if (block == NULL)
+        return VLCDEC_SUCCESS;
+
+    if (decoder_UpdateVideoFormat(dec) == 0)
+    {
+        picture_t *pic = decoder_NewPicture(dec);
+        if (pic != NULL)
+        {
+            pic->date = block->i_pts;
+            pic->b_progressive = true;
+            /* Only the aspect ratio changes: the vout keeps running, and
+             * its static filters are reset */
+            pic->format.i_sar_num =
+                PictureIndex(block->i_pts) >= REFORMAT ? 2 : 1;
+            pic->format.i_sar_den = 1;
+            decoder_QueueVideo(dec, pic);
+        }
+    }
+    block_Release(block);
+    return VLCDEC_SUCCESS;
+}
+
+static int OpenDecoder(vlc_object_t *obj)
+{
+    decoder_t *dec = (decoder_t *)obj;
+
+    if (dec->fmt_in.i_cat != VIDEO_ES)
+        return VLC_EGENERIC;
+
+    es_format_Copy(&dec->fmt_out, &dec->fmt_in);
+    dec->fmt_out.i_codec = dec->fmt_out.video.i_chroma = VLC_CODEC_I420;
+    dec->fmt_out.video.i_sar_num = dec->fmt_out.video.i_sar_den = 1;
+    dec->pf_decode = Decode;
+    return VLC_SUCCESS;
+}
+
+/*** Static filter ***/
+static picture_t *Filter(filter_t *filter, picture_t *src)
+{
+    const unsigned index = PictureIndex(src->date);
+
+    /* The pictures of a new format never go through the previous filters */
+    assert(src->format.i_sar_num == filter->fmt_in.video.i_sar_num);
+
+    vlc_mutex_lock(&state.lock);
+    if (index == BLOCK_AT && !state.blocked)
+    {   /* The pictures filtered ahead are displayed meanwhile */
+        const unsigned displayed = state.displayed;
+        const vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_SEC(5);
+
+        state.blocked = true;
+        while (state.displayed == displayed
+            && vlc_cond_timedwait(&state.wait, &state.lock, deadline) == 0);
+        state.displayed_blocked = state.displayed > displayed;
+    }
+    vlc_mutex_unlock(&state.lock);
+
+    if (index >= SLOW_FROM && index < SLOW_TO)
+        vlc_tick_wait(vlc_tick_now() + 5 * FRAME / 2);
+
+    picture_t *dst = filter_NewPicture(filter);
+    if (dst != NULL)
+    {
+        picture_CopyPixels(dst, src);
+        picture_CopyProperties(dst, src);
+        dst->p[0].p_pixels[0] = MARK;
+    }
+    picture_Release(src);
+    return dst;
+}
+
+static int OpenFilter(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+
+    if (filter->fmt_in.video.i_chroma != VLC_CODEC_I420
+     || !video_format_IsSimilar(&filter->fmt_in.video,
+                                &filter->fmt_out.video))
+        return VLC_EGENERIC;
+
+    vlc_mutex_lock(&state.lock);
+    if (filter->fmt_in.video.i_sar_num == 2)
+        state.reformat_opens++;
+    vlc_mutex_unlock(&state.lock);
+
+    filter->pf_video_filter = Filter;
+    return VLC_SUCCESS;
+}
+
+/*** Display ***/
+static void Display(vout_display_t *vd, picture_t *pic)
+{
+    const unsigned index = PictureIndex(pic->date);
+
+    (void) vd;
+    /* Every picture went through the static filter */
+    assert(pic->p[0].p_pixels[0] == MARK);
+
+    vlc_mutex_lock(&state.lock);
+    if (state.displayed > 0 && index < state.last)
+    {   /* Only a flush goes back, to the pictures after the seek point */
+        assert(state.seeking);
+        assert(index + 1 >= SEEK_TO);
+        state.seeking = false;
+        state.flushes++;
+    }
+    if (index >= SLOW_FROM && index < SLOW_TO && index != state.last)
+        state.slow_displayed++;
+    state.last = index;
+    state.displayed++;
+    vlc_cond_broadcast(&state.wait);
+    vlc_mutex_unlock(&state.lock);
+}
+
+static int Control(vout_display_t *vd, int query, va_list args)
+{
+    (void) vd; (void) query; (void) args;
+    return VLC_SUCCESS;
+}
+
+static int OpenDisplay(vout_display_t *vd, const vout_display_cfg_t *cfg,
+                       video_format_t *fmtp, vlc_video_context *context)
+{
+    (void) cfg; (void) fmtp; (void) context;
+    vd->prepare = NULL;
+    vd->display = Display;
+    vd->control = Control;
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin()
+    set_capability("video decoder", 10000)
+    set_callback(OpenDecoder)
+    add_submodule()
+        set_capability("video filter", 10000)
+        add_shortcut("postproc")
+        set_callback(OpenFilter)
+    add_submodule()
+        set_callback_display(OpenDisplay, 0)
+        add_shortcut("test_display")
+vlc_module_end()
+
+/* Used by the inline helpers to log, only defined for dynamic plugins */
+const char vlc_module_name[] = MODULE_STRING;
+
+typedef int (*vlc_plugin_cb)(int (*)(void *, void *, int, ...), void *);
+
+VLC_EXPORT vlc_plugin_cb vlc_static_modules[] = {
+    vlc_entry__test_filter_thread,
+    NULL
+};
+
+static void on_event(const struct libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+static void wait_displayed(unsigned index)
+{
+    vlc_mutex_lock(&state.lock);
+    while (state.last < index)
+        vlc_cond_wait(&state.wait, &state.lock);
+    vlc_mutex_unlock(&state.lock);
+}
+
+int main(void)
+{
+    test_init();
+    /* initialized for timed waits on the vlc_tick_now() clock */
+    vlc_cond_init(&state.wait);
+
+    static const char *args[] = {
+        "-v", "--vout=test_display", "--no-osd",
+        "--deinterlace=0", "--video-filter=postproc", "--video-filter-thread",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+
+    char url[256];
+    snprintf(url, sizeof (url), "mock://video_track_count=1;video_width=64;"
+             "video_height=48;pts_delay=100;length=%"PRId64, FRAMES * FRAME);
+
+    libvlc_media_t *md = libvlc_media_new_location(vlc, url);
+    assert(md != NULL);
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(md);
+    assert(mp != NULL);
+
+    vlc_sem_t sem;
+    vlc_sem_init(&sem, 0);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    int res = libvlc_event_attach(em, libvlc_MediaPlayerEndReached,
+                                  on_event, &sem);
+    assert(!res);
+
+    res = libvlc_media_player_play(mp);
+    assert(!res);
+
+    /* Seek back while pictures are filtered ahead: they are flushed, and the
+     * last displayed one is filtered again */
+    wait_displayed(SEEK_FROM);
+    vlc_mutex_lock(&state.lock);
+    state.seeking = true;
+    vlc_mutex_unlock(&state.lock);
+    res = libvlc_media_player_set_time(mp, MS_FROM_VLC_TICK(SEEK_TO * FRAME),
+                                       false);
+    assert(!res);
+
+    /* Late pictures are dropped when the static filter falls behind */
+    wait_displayed(SLOW_FROM - 5);
+    libvlc_media_stats_t stats;
+    assert(libvlc_media_get_stats(md, &stats));
+    const int lost = stats.i_lost_pictures;
+
+    vlc_sem_wait(&sem);
+
+    assert(libvlc_media_get_stats(md, &stats));
+    assert(stats.i_lost_pictures > lost);
+
+    vlc_mutex_lock(&state.lock);
+    /* The display never waits for a static filter */
+    assert(state.blocked && state.displayed_blocked);
+    assert(state.flushes == 1);
+    assert(state.reformat_opens > 0);
+    assert(state.slow_displayed < SLOW_TO - SLOW_FROM);
+    assert(state.last + 1 >= FRAMES - 1);
+    vlc_mutex_unlock(&state.lock);
+
+    libvlc_event_detach(em, libvlc_MediaPlayerEndReached, on_event, &sem);
+    libvlc_media_player_stop_async(mp);
+    libvlc_media_player_release(mp);
+    libvlc_media_release(md);
+    libvlc_release(vlc);
+    return 0;
+}